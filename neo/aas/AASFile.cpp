@@ -571,6 +571,8 @@ idAASFileLocal::idAASFileLocal
 ================
 */
 idAASFileLocal::idAASFileLocal() {
+	reachabilityBlock = NULL;
+	numBlockReachabilities = 0;
 	planeList.SetGranularity( AAS_PLANE_GRANULARITY );
 	vertices.SetGranularity( AAS_VERTEX_GRANULARITY );
 	edges.SetGranularity( AAS_EDGE_GRANULARITY );
@@ -596,9 +598,12 @@ idAASFileLocal::~idAASFileLocal() {
 	for ( i = 0; i < areas.Num(); i++ ) {
 		for ( reach = areas[i].reach; reach; reach = next ) {
 			next = reach->next;
-			delete reach;
+			if ( !IsBlockReachability( reach ) ) {
+				delete reach;
+			}
 		}
 	}
+	delete[] reachabilityBlock;
 }
 
 /*
@@ -1092,6 +1097,403 @@ void idAASFileLocal::FinishAreas() {
 	}
 }
 
+/*
+===============================================================================
+
+	Binary AAS files
+
+	The generated binary file holds every table of the AAS file in native
+	byte order. Tables are addressed by offset from the start of the file and
+	never contain pointers: the first reachability of an area and the next
+	reachability of a reachability are indices into the reachability table,
+	and special reachabilities refer to their key/value pairs by offset into
+	the string table. Area centers and bounds are stored, so FinishAreas
+	isn't needed after loading.
+
+	The file is used straight from a memory mapped resource container or a
+	memory mapped loose file, every table is copied out with a single copy
+	because the game changes travel flags and portal travel times at run time.
+
+===============================================================================
+*/
+
+static const byte BAAS_VERSION = 1;
+static const unsigned int BAAS_MAGIC = ( 'B' << 24 ) | ( 'A' << 16 ) | ( 'S' << 8 ) | BAAS_VERSION;
+
+idCVar aas_binaryLoad( "aas_binaryLoad", "1", CVAR_SYSTEM | CVAR_BOOL, "load AAS files from generated binary files, and write them when they are missing or out of date" );
+
+enum {
+	BAAS_PLANES,
+	BAAS_VERTICES,
+	BAAS_EDGES,
+	BAAS_EDGEINDEX,
+	BAAS_FACES,
+	BAAS_FACEINDEX,
+	BAAS_AREAS,
+	BAAS_NODES,
+	BAAS_PORTALS,
+	BAAS_PORTALINDEX,
+	BAAS_CLUSTERS,
+	BAAS_REACHABILITIES,
+	BAAS_STRINGS,
+	BAAS_SETTINGS,
+	BAAS_NUM_TABLES
+};
+
+typedef struct aasBinaryTable_s {
+	int							offset;				// offset from the start of the file, 16 byte aligned
+	int							num;				// number of elements
+	int							elementSize;		// size of an element in the build that wrote the file
+} aasBinaryTable_t;
+
+typedef struct aasBinaryHeader_s {
+	unsigned int				magic;
+	unsigned int				mapFileCRC;
+	int64						timeStamp;			// time stamp of the source .aas file
+	int							fileSize;
+	aasBinaryTable_t			tables[BAAS_NUM_TABLES];
+} aasBinaryHeader_t;
+
+typedef struct aasBinaryReachability_s {
+	int							travelType;
+	short						toAreaNum;
+	short						fromAreaNum;
+	idVec3						start;
+	idVec3						end;
+	int							edgeNum;
+	unsigned short				travelTime;
+	byte						number;
+	byte						disableCount;
+	int							next;				// next reachability of the area, -1 ends the list
+	int							firstKeyVal;		// offset of the key/value strings of a special reachability, -1 if none
+	int							numKeyVals;
+} aasBinaryReachability_t;
+
+/*
+================
+AAS_BinaryFileName
+================
+*/
+static void AAS_BinaryFileName( const idStr &fileName, idStr &binaryName ) {
+	idStr extension;
+	fileName.ExtractFileExtension( extension );
+	binaryName = "generated/";
+	binaryName += fileName;
+	binaryName.SetFileExtension( va( "b%s", extension.c_str() ) );
+}
+
+/*
+================
+AAS_CopyBinaryTable
+================
+*/
+template< class listType >
+static void AAS_CopyBinaryTable( const byte *data, const aasBinaryTable_t &table, listType &list ) {
+	list.SetNum( table.num );
+	if ( table.num > 0 ) {
+		memcpy( list.Ptr(), data + table.offset, table.num * table.elementSize );
+	}
+}
+
+/*
+================
+idAASFileLocal::IsBlockReachability
+================
+*/
+bool idAASFileLocal::IsBlockReachability( const idReachability *reach ) const {
+	return ( reach >= reachabilityBlock && reach < reachabilityBlock + numBlockReachabilities );
+}
+
+/*
+================
+idAASFileLocal::LoadBinary
+================
+*/
+bool idAASFileLocal::LoadBinary( const idStr &binaryName, unsigned int mapFileCRC, ID_TIME_T sourceTimeStamp ) {
+	// prefer a view of the file inside a memory mapped resource container, then a mapping of
+	// the loose generated file and only read the file when neither can be mapped
+	int length = 0;
+	const byte * mapped = NULL;
+	void * buffer = NULL;
+	const byte * data = fileSystem->ReadFileMapped( binaryName, length );
+	if ( data == NULL ) {
+		int64 mappedLength = 0;
+		mapped = Sys_MapFileRead( fileSystem->RelativePathToOSPath( binaryName, "fs_basepath" ), mappedLength );
+		if ( mapped != NULL && mappedLength <= INT_MAX ) {
+			data = mapped;
+			length = (int)mappedLength;
+		}
+	}
+	if ( data == NULL ) {
+		length = fileSystem->ReadFile( binaryName, &buffer );
+		data = (const byte *)buffer;
+	}
+	const bool loaded = ( data != NULL && length >= (int)sizeof( aasBinaryHeader_t ) && ParseBinary( data, length, mapFileCRC, sourceTimeStamp ) );
+
+	Sys_UnmapFile( mapped );
+	if ( buffer != NULL ) {
+		fileSystem->FreeFile( buffer );
+	}
+
+	if ( loaded ) {
+		common->Printf( "loaded %s\n", binaryName.c_str() );
+	}
+	return loaded;
+}
+
+/*
+================
+idAASFileLocal::ParseBinary
+================
+*/
+bool idAASFileLocal::ParseBinary( const byte *data, int length, unsigned int mapFileCRC, ID_TIME_T sourceTimeStamp ) {
+	aasBinaryHeader_t header;
+	memcpy( &header, data, sizeof( header ) );
+
+	if ( header.magic != BAAS_MAGIC || header.fileSize != length ) {
+		return false;
+	}
+	if ( mapFileCRC && header.mapFileCRC != mapFileCRC ) {
+		return false;
+	}
+	if ( !fileSystem->InProductionMode() && header.timeStamp != (int64)sourceTimeStamp ) {
+		return false;
+	}
+
+	const int elementSizes[BAAS_NUM_TABLES] = {
+		sizeof( idPlane ), sizeof( aasVertex_t ), sizeof( aasEdge_t ), sizeof( aasIndex_t ), sizeof( aasFace_t ), sizeof( aasIndex_t ),
+		sizeof( aasArea_t ), sizeof( aasNode_t ), sizeof( aasPortal_t ), sizeof( aasIndex_t ), sizeof( aasCluster_t ),
+		sizeof( aasBinaryReachability_t ), 1, 1
+	};
+	for ( int i = 0; i < BAAS_NUM_TABLES; i++ ) {
+		const aasBinaryTable_t & table = header.tables[i];
+		if ( table.elementSize != elementSizes[i] || table.num < 0 || table.offset < (int)sizeof( header ) ||
+				(int64)table.offset + (int64)table.num * table.elementSize > length ) {
+			return false;
+		}
+	}
+
+	const aasBinaryTable_t & reachTable = header.tables[BAAS_REACHABILITIES];
+	const aasBinaryTable_t & stringTable = header.tables[BAAS_STRINGS];
+	const aasBinaryTable_t & areaTable = header.tables[BAAS_AREAS];
+	const aasBinaryReachability_t * binaryReach = (const aasBinaryReachability_t *)( data + reachTable.offset );
+	const char * strings = (const char *)( data + stringTable.offset );
+	const char * stringsEnd = strings + stringTable.num;
+	if ( stringTable.num > 0 && strings[stringTable.num - 1] != '\0' ) {
+		return false;
+	}
+	for ( int i = 0; i < reachTable.num; i++ ) {
+		if ( binaryReach[i].next < -1 || binaryReach[i].next >= reachTable.num || binaryReach[i].toAreaNum < 0 || binaryReach[i].toAreaNum >= areaTable.num ) {
+			return false;
+		}
+		if ( binaryReach[i].firstKeyVal > stringTable.num ) {
+			return false;
+		}
+	}
+
+	// every reachability has to be in exactly one area list, anything else would loop or double free
+	const aasArea_t * binaryAreas = (const aasArea_t *)( data + areaTable.offset );
+	idList< bool > linked;
+	linked.AssureSize( reachTable.num, false );
+	int numLinked = 0;
+	for ( int i = 0; i < areaTable.num; i++ ) {
+		const intptr_t first = (intptr_t)binaryAreas[i].reach - 1;
+		if ( first < -1 || first >= reachTable.num ) {
+			return false;
+		}
+		for ( int j = (int)first; j >= 0; j = binaryReach[j].next ) {
+			if ( linked[j] ) {
+				return false;
+			}
+			linked[j] = true;
+			numLinked++;
+		}
+	}
+	if ( numLinked != reachTable.num ) {
+		return false;
+	}
+
+	// settings are stored as text, they are tiny
+	idLexer src( LEXFL_NOFATALERRORS | LEXFL_NOSTRINGESCAPECHARS | LEXFL_NOSTRINGCONCAT | LEXFL_ALLOWPATHNAMES );
+	const aasBinaryTable_t & settingsTable = header.tables[BAAS_SETTINGS];
+	src.LoadMemory( (const char *)( data + settingsTable.offset ), settingsTable.num, name );
+	if ( !settings.FromParser( src ) ) {
+		return false;
+	}
+
+	// clear the file in memory
+	DeleteReachabilities();
+	Clear();
+
+	AAS_CopyBinaryTable( data, header.tables[BAAS_PLANES], planeList );
+	AAS_CopyBinaryTable( data, header.tables[BAAS_VERTICES], vertices );
+	AAS_CopyBinaryTable( data, header.tables[BAAS_EDGES], edges );
+	AAS_CopyBinaryTable( data, header.tables[BAAS_EDGEINDEX], edgeIndex );
+	AAS_CopyBinaryTable( data, header.tables[BAAS_FACES], faces );
+	AAS_CopyBinaryTable( data, header.tables[BAAS_FACEINDEX], faceIndex );
+	AAS_CopyBinaryTable( data, header.tables[BAAS_AREAS], areas );
+	AAS_CopyBinaryTable( data, header.tables[BAAS_NODES], nodes );
+	AAS_CopyBinaryTable( data, header.tables[BAAS_PORTALS], portals );
+	AAS_CopyBinaryTable( data, header.tables[BAAS_PORTALINDEX], portalIndex );
+	AAS_CopyBinaryTable( data, header.tables[BAAS_CLUSTERS], clusters );
+
+	// all plain reachabilities go into a single block, only special reachabilities are allocated on their own
+	idList< idReachability * > reachPointers;
+	reachPointers.SetNum( reachTable.num );
+	numBlockReachabilities = reachTable.num;
+	reachabilityBlock = ( reachTable.num > 0 ) ? new (TAG_AAS) idReachability[ reachTable.num ] : NULL;
+	for ( int i = 0; i < reachTable.num; i++ ) {
+		const aasBinaryReachability_t & in = binaryReach[i];
+		idReachability * reach;
+		if ( in.firstKeyVal >= 0 ) {
+			idReachability_Special * special = new (TAG_AAS) idReachability_Special();
+			const char * keyVal = strings + in.firstKeyVal;
+			for ( int j = 0; j < in.numKeyVals && keyVal < stringsEnd; j++ ) {
+				const char * key = keyVal;
+				const char * value = key + idStr::Length( key ) + 1;
+				if ( value >= stringsEnd ) {
+					break;
+				}
+				special->dict.Set( key, value );
+				keyVal = value + idStr::Length( value ) + 1;
+			}
+			reach = special;
+		} else {
+			reach = &reachabilityBlock[i];
+		}
+		reach->travelType = in.travelType;
+		reach->toAreaNum = in.toAreaNum;
+		reach->fromAreaNum = in.fromAreaNum;
+		reach->start = in.start;
+		reach->end = in.end;
+		reach->edgeNum = in.edgeNum;
+		reach->travelTime = in.travelTime;
+		reach->number = in.number;
+		reach->disableCount = in.disableCount;
+		reach->rev_next = NULL;
+		reach->areaTravelTimes = NULL;
+		reachPointers[i] = reach;
+	}
+	for ( int i = 0; i < reachTable.num; i++ ) {
+		reachPointers[i]->next = ( binaryReach[i].next >= 0 ) ? reachPointers[binaryReach[i].next] : NULL;
+	}
+	for ( int i = 0; i < areas.Num(); i++ ) {
+		const int first = (int)( (intptr_t)areas[i].reach - 1 );
+		areas[i].reach = ( first >= 0 ) ? reachPointers[first] : NULL;
+		areas[i].rev_reach = NULL;
+	}
+
+	LinkReversedReachability();
+
+	return true;
+}
+
+/*
+================
+idAASFileLocal::WriteBinary
+================
+*/
+bool idAASFileLocal::WriteBinary( const idStr &binaryName, unsigned int mapFileCRC, ID_TIME_T sourceTimeStamp ) {
+	// flatten the reachabilities in list order, the reachabilities of an area are consecutive
+	idList< aasBinaryReachability_t > binaryReach;
+	idList< char > strings;
+	idList< aasArea_t > binaryAreas;
+	binaryReach.SetGranularity( AAS_LIST_GRANULARITY );
+	binaryAreas.SetNum( areas.Num() );
+	for ( int i = 0; i < areas.Num(); i++ ) {
+		binaryAreas[i] = areas[i];
+		binaryAreas[i].reach = ( areas[i].reach != NULL ) ? (idReachability *)(intptr_t)( binaryReach.Num() + 1 ) : NULL;
+		binaryAreas[i].rev_reach = NULL;
+		for ( const idReachability * reach = areas[i].reach; reach != NULL; reach = reach->next ) {
+			aasBinaryReachability_t & out = binaryReach.Alloc();
+			memset( &out, 0, sizeof( out ) );
+			out.travelType = reach->travelType;
+			out.toAreaNum = reach->toAreaNum;
+			out.fromAreaNum = reach->fromAreaNum;
+			out.start = reach->start;
+			out.end = reach->end;
+			out.edgeNum = reach->edgeNum;
+			out.travelTime = reach->travelTime;
+			out.number = reach->number;
+			out.disableCount = reach->disableCount;
+			out.next = ( reach->next != NULL ) ? binaryReach.Num() : -1;
+			out.firstKeyVal = -1;
+			out.numKeyVals = 0;
+			if ( reach->travelType == TFL_SPECIAL ) {
+				const idDict & dict = static_cast< const idReachability_Special * >( reach )->dict;
+				out.firstKeyVal = strings.Num();
+				out.numKeyVals = dict.GetNumKeyVals();
+				for ( int j = 0; j < dict.GetNumKeyVals(); j++ ) {
+					const idKeyValue * keyValue = dict.GetKeyVal( j );
+					const char * keyVal[2] = { keyValue->GetKey().c_str(), keyValue->GetValue().c_str() };
+					for ( int k = 0; k < 2; k++ ) {
+						const int offset = strings.Num();
+						const int length = idStr::Length( keyVal[k] ) + 1;
+						strings.SetNum( offset + length );
+						memcpy( strings.Ptr() + offset, keyVal[k], length );
+					}
+				}
+			}
+		}
+	}
+
+	idFile_Memory settingsText( "settings" );
+	settings.WriteToFile( &settingsText );
+
+	struct tableData_t {
+		const void *			data;
+		int						num;
+		int						elementSize;
+	};
+	const tableData_t tableData[BAAS_NUM_TABLES] = {
+		{ planeList.Ptr(), planeList.Num(), sizeof( idPlane ) },
+		{ vertices.Ptr(), vertices.Num(), sizeof( aasVertex_t ) },
+		{ edges.Ptr(), edges.Num(), sizeof( aasEdge_t ) },
+		{ edgeIndex.Ptr(), edgeIndex.Num(), sizeof( aasIndex_t ) },
+		{ faces.Ptr(), faces.Num(), sizeof( aasFace_t ) },
+		{ faceIndex.Ptr(), faceIndex.Num(), sizeof( aasIndex_t ) },
+		{ binaryAreas.Ptr(), binaryAreas.Num(), sizeof( aasArea_t ) },
+		{ nodes.Ptr(), nodes.Num(), sizeof( aasNode_t ) },
+		{ portals.Ptr(), portals.Num(), sizeof( aasPortal_t ) },
+		{ portalIndex.Ptr(), portalIndex.Num(), sizeof( aasIndex_t ) },
+		{ clusters.Ptr(), clusters.Num(), sizeof( aasCluster_t ) },
+		{ binaryReach.Ptr(), binaryReach.Num(), sizeof( aasBinaryReachability_t ) },
+		{ strings.Ptr(), strings.Num(), 1 },
+		{ settingsText.GetDataPtr(), settingsText.Length(), 1 }
+	};
+
+	aasBinaryHeader_t header;
+	memset( &header, 0, sizeof( header ) );
+	header.magic = BAAS_MAGIC;
+	header.mapFileCRC = mapFileCRC;
+	header.timeStamp = (int64)sourceTimeStamp;
+	int offset = ( sizeof( header ) + 15 ) & ~15;
+	for ( int i = 0; i < BAAS_NUM_TABLES; i++ ) {
+		header.tables[i].offset = offset;
+		header.tables[i].num = tableData[i].num;
+		header.tables[i].elementSize = tableData[i].elementSize;
+		offset += ( tableData[i].num * tableData[i].elementSize + 15 ) & ~15;
+	}
+	header.fileSize = offset;
+
+	idFileLocal file( fileSystem->OpenFileWrite( binaryName, "fs_basepath" ) );
+	if ( file == NULL ) {
+		common->Warning( "Couldn't write %s", binaryName.c_str() );
+		return false;
+	}
+	static const byte zeros[16] = { 0 };
+	file->Write( &header, sizeof( header ) );
+	file->Write( zeros, header.tables[0].offset - sizeof( header ) );
+	for ( int i = 0; i < BAAS_NUM_TABLES; i++ ) {
+		const int size = tableData[i].num * tableData[i].elementSize;
+		if ( size > 0 ) {
+			file->Write( tableData[i].data, size );
+		}
+		file->Write( zeros, ( ( size + 15 ) & ~15 ) - size );
+	}
+	return true;
+}
+
 /*
 ================
 idAASFileLocal::Load
@@ -1109,6 +1511,19 @@ bool idAASFileLocal::Load( const idStr &fileName, unsigned int mapFileCRC ) {
 	common->Printf( "[Load AAS]\n" );
 	common->Printf( "loading %s\n", name.c_str() );
 
+	idStr binaryName;
+	AAS_BinaryFileName( name, binaryName );
+	const ID_TIME_T sourceTimeStamp = fileSystem->GetTimestamp( name );
+	if ( aas_binaryLoad.GetBool() && LoadBinary( binaryName, mapFileCRC, sourceTimeStamp ) ) {
+		depth = MaxTreeDepth();
+		if ( depth > MAX_AAS_TREE_DEPTH ) {
+			common->Error( "idAASFileLocal::Load: tree depth = %d", depth );
+		}
+		common->UpdateLevelLoadPacifier();
+		common->Printf( "done.\n" );
+		return true;
+	}
+
 	if ( !src.LoadFile( name ) ) {
 		return false;
 	}
@@ -1192,6 +1607,10 @@ bool idAASFileLocal::Load( const idStr &fileName, unsigned int mapFileCRC ) {
 		src.Error( "idAASFileLocal::Load: tree depth = %d", depth );
 	}
 
+	if ( aas_binaryLoad.GetBool() ) {
+		WriteBinary( binaryName, mapFileCRC, sourceTimeStamp );
+	}
+
 	common->UpdateLevelLoadPacifier();
 
 	common->Printf( "done.\n" );
@@ -1287,11 +1706,16 @@ void idAASFileLocal::DeleteReachabilities() {
 	for ( i = 0; i < areas.Num(); i++ ) {
 		for ( reach = areas[i].reach; reach; reach = nextReach ) {
 			nextReach = reach->next;
-			delete reach;
+			if ( !IsBlockReachability( reach ) ) {
+				delete reach;
+			}
 		}
 		areas[i].reach = NULL;
 		areas[i].rev_reach = NULL;
 	}
+	delete[] reachabilityBlock;
+	reachabilityBlock = NULL;
+	numBlockReachabilities = 0;
 }
 
 /*
@@ -87,6 +87,11 @@ private:
 	bool						ParsePortals( idLexer &src );
 	bool						ParseClusters( idLexer &src );
 
+	bool						LoadBinary( const idStr &binaryName, unsigned int mapFileCRC, ID_TIME_T sourceTimeStamp );
+	bool						ParseBinary( const byte *data, int length, unsigned int mapFileCRC, ID_TIME_T sourceTimeStamp );
+	bool						WriteBinary( const idStr &binaryName, unsigned int mapFileCRC, ID_TIME_T sourceTimeStamp );
+	bool						IsBlockReachability( const idReachability *reach ) const;
+
 private:
 	int							BoundsReachableAreaNum_r( int nodeNum, const idBounds &bounds, const int areaFlags, const int excludeTravelFlags ) const;
 	void						MaxTreeDepth_r( int nodeNum, int &depth, int &maxDepth ) const;
@@ -94,6 +99,10 @@ private:
 	int							AreaContentsTravelFlags( int areaNum ) const;
 	idVec3						AreaReachableGoal( int areaNum ) const;
 	int							NumReachabilities() const;
+
+private:
+	idReachability *			reachabilityBlock;		// plain reachabilities of a binary file, allocated at once
+	int							numBlockReachabilities;
 };
 
 #endif /* !__AASFILELOCAL_H__ */
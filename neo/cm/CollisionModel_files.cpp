@@ -585,12 +585,23 @@ bool idCollisionModelManagerLocal::LoadCollisionModelFile( const char *name, uns
 		file->ReadString( fileID );
 		file->ReadString( fileVersion );
 		if ( fileID == CM_FILEID && fileVersion == CM_FILEVERSION && crc == mapFileCRC && numEntries > 0 ) {
+			const int firstModel = numModels;
+			loaded = true;
 			for ( int i = 0; i < numEntries; i++ ) {
 				cm_model_t *model = LoadBinaryModelFromFile( file, currentTimeStamp );
+				if ( model == NULL ) {
+					// out of date or written by a different build, parse the text file instead
+					while ( numModels > firstModel ) {
+						numModels--;
+						FreeModel( models[ numModels ] );
+						models[ numModels ] = NULL;
+					}
+					loaded = false;
+					break;
+				}
 				models[ numModels ] = model;
 				numModels++;
 			}
-			loaded = true;
 		}
 	}
 
@@ -2972,16 +2972,13 @@ static const unsigned int BCM_MAGIC = ( 'B' << 24 ) | ( 'C' << 16 ) | ( 'M' << 1
 
 /*
 ================
-idCollisionModelManagerLocal::LoadBinaryModel
+idCollisionModelManagerLocal::LoadBigEndianBinaryModelFromFile
+
+  the magic has already been read
 ================
 */
-cm_model_t * idCollisionModelManagerLocal::LoadBinaryModelFromFile( idFile *file, ID_TIME_T sourceTimeStamp ) {
+cm_model_t * idCollisionModelManagerLocal::LoadBigEndianBinaryModelFromFile( idFile *file, ID_TIME_T sourceTimeStamp ) {
 
-	unsigned int magic = 0;
-	file->ReadBig( magic );
-	if ( magic != BCM_MAGIC ) {
-		return NULL;
-	}
 	ID_TIME_T storedTimeStamp = FILE_NOT_FOUND_TIMESTAMP;
 	file->ReadBig( storedTimeStamp );
 	if ( !fileSystem->InProductionMode() && storedTimeStamp != sourceTimeStamp ) {
@@ -3144,10 +3141,10 @@ cm_model_t * idCollisionModelManagerLocal::LoadBinaryModel( const char *fileName
 
 /*
 ================
-idCollisionModelManagerLocal::WriteBinaryModel
+idCollisionModelManagerLocal::WriteBigEndianBinaryModelToFile
 ================
 */
-void idCollisionModelManagerLocal::WriteBinaryModelToFile( cm_model_t *model, idFile *file, ID_TIME_T sourceTimeStamp ) {
+void idCollisionModelManagerLocal::WriteBigEndianBinaryModelToFile( cm_model_t *model, idFile *file, ID_TIME_T sourceTimeStamp ) {
 
 	file->WriteBig( BCM_MAGIC );
 	file->WriteBig( sourceTimeStamp );
@@ -3256,6 +3253,624 @@ void idCollisionModelManagerLocal::WriteBinaryModelToFile( cm_model_t *model, id
 	local::WriteNodeTree( file, model->node, polys, brushes );
 }
 
+/*
+===============================================================================
+
+Flat binary collision models
+
+	The flat layout stores a model in native byte order using the in-memory
+	structure layouts, so every array is loaded with a single read followed
+	by one pointer fixup pass. Pointers are stored as one based indices with
+	zero meaning NULL: node parents and children index the node array, the
+	node polygon and brush chains index the reference arrays, references hold
+	byte offsets into the polygon and brush blocks, and polygon and brush
+	materials index the material name table. Every section starts 16 byte
+	aligned relative to the start of the model, so a model can just as well
+	be used from a mapped image.
+
+	The header records the structure sizes of the build that wrote it, a file
+	written by a different platform or build is rejected and regenerated.
+
+===============================================================================
+*/
+
+static const byte BCM_FLAT_VERSION = 1;
+static const unsigned int BCM_FLAT_MAGIC = ( 'B' << 24 ) | ( 'C' << 16 ) | ( 'F' << 8 ) | BCM_FLAT_VERSION;
+
+idCVar cm_writeFlatBinary( "cm_writeFlatBinary", "1", CVAR_SYSTEM | CVAR_BOOL, "write generated collision models in the native endian flat layout instead of the portable big endian layout" );
+
+typedef struct cm_flatHeader_s {
+	unsigned int			magic;
+	unsigned short			pointerSize;		// structure sizes of the build that wrote the model
+	unsigned short			vertexSize;
+	unsigned short			edgeSize;
+	unsigned short			polygonSize;
+	unsigned short			brushSize;
+	unsigned short			nodeSize;
+	int64					timeStamp;
+	int						modelSize;			// size of the model including this header
+	idBounds				bounds;
+	int						contents;
+	int						isConvex;
+	int						numVertices;
+	int						numEdges;
+	int						polygonBytes;		// size of the polygon block
+	int						brushBytes;			// size of the brush block
+	int						nodeCount;			// size of the node array, the first node is the root
+	int						polygonRefCount;	// size of the polygon reference array
+	int						brushRefCount;		// size of the brush reference array
+	int						nameLength;
+	int						numMaterials;
+	int						materialNamesLength;	// NUL terminated names, an empty name is a NULL material
+	int						numPolygons;		// model statistics
+	int						polygonMemory;
+	int						numBrushes;
+	int						brushMemory;
+	int						numNodes;
+	int						numBrushRefs;
+	int						numPolygonRefs;
+	int						numInternalEdges;
+	int						numSharpEdges;
+	int						numRemovedPolys;
+	int						numMergedPolys;
+} cm_flatHeader_t;
+
+static ID_INLINE int CM_FlatAlign( int size ) {
+	return ( size + 15 ) & ~15;
+}
+
+static ID_INLINE void * CM_FlatEncode( int index ) {
+	return (void *)(intptr_t)( index + 1 );
+}
+
+template< class type >
+static ID_INLINE type * CM_FlatDecode( type *base, const void *encoded ) {
+	const intptr_t index = (intptr_t)encoded;
+	return ( index == 0 ) ? NULL : base + ( index - 1 );
+}
+
+/*
+================
+CM_FlatReadSection
+================
+*/
+static bool CM_FlatReadSection( idFile *file, void *buffer, int size ) {
+	if ( size > 0 && file->Read( buffer, size ) != size ) {
+		return false;
+	}
+	const int pad = CM_FlatAlign( size ) - size;
+	return ( pad == 0 || file->Seek( pad, FS_SEEK_CUR ) == 0 );
+}
+
+/*
+================
+CM_FlatWriteSection
+================
+*/
+static void CM_FlatWriteSection( idFile *file, const void *buffer, int size ) {
+	static const byte zeros[16] = { 0 };
+	if ( size > 0 ) {
+		file->Write( buffer, size );
+	}
+	const int pad = CM_FlatAlign( size ) - size;
+	if ( pad > 0 ) {
+		file->Write( zeros, pad );
+	}
+}
+
+/*
+===============================================================================
+
+idFlatCollisionModel
+
+	Copy of a model's node tree, references, polygons and brushes with all
+	pointers replaced by indices, in the order they are written.
+
+===============================================================================
+*/
+
+class idFlatCollisionModel {
+public:
+							idFlatCollisionModel();
+
+	void					Build( const cm_model_t *model );
+
+	idList< cm_node_t >		nodes;
+	idList< cm_polygonRef_t > polygonRefs;
+	idList< cm_brushRef_t >	brushRefs;
+	idList< byte >			polygonData;
+	idList< byte >			brushData;
+	idList< const idMaterial * > materials;
+
+private:
+	idList< const cm_polygon_t * > polygons;
+	idList< int >			polygonOffsets;
+	idHashIndex				polygonHash;
+	idList< const cm_brush_t * > brushes;
+	idList< int >			brushOffsets;
+	idHashIndex				brushHash;
+
+	int						AddNode_r( const cm_node_t *node, int parent );
+	int						PolygonOffset( const cm_polygon_t *poly );
+	int						BrushOffset( const cm_brush_t *brush );
+};
+
+/*
+================
+idFlatCollisionModel::idFlatCollisionModel
+================
+*/
+idFlatCollisionModel::idFlatCollisionModel() {
+	nodes.SetGranularity( 1024 );
+	polygonRefs.SetGranularity( 1024 );
+	brushRefs.SetGranularity( 1024 );
+	polygonData.SetGranularity( 65536 );
+	brushData.SetGranularity( 65536 );
+	polygons.SetGranularity( 1024 );
+	polygonOffsets.SetGranularity( 1024 );
+	brushes.SetGranularity( 1024 );
+	brushOffsets.SetGranularity( 1024 );
+}
+
+/*
+================
+idFlatCollisionModel::Build
+================
+*/
+void idFlatCollisionModel::Build( const cm_model_t *model ) {
+	if ( model->node != NULL ) {
+		AddNode_r( model->node, -1 );
+	}
+}
+
+/*
+================
+idFlatCollisionModel::AddNode_r
+
+  nodes are stored depth first with the references of a node stored consecutively
+================
+*/
+int idFlatCollisionModel::AddNode_r( const cm_node_t *node, int parent ) {
+	const int index = nodes.Append( *node );
+	nodes[index].parent = (cm_node_t *) CM_FlatEncode( parent );
+	nodes[index].polygons = NULL;
+	nodes[index].brushes = NULL;
+	nodes[index].children[0] = NULL;
+	nodes[index].children[1] = NULL;
+
+	const int firstPolygonRef = polygonRefs.Num();
+	for ( const cm_polygonRef_t *pref = node->polygons; pref != NULL; pref = pref->next ) {
+		cm_polygonRef_t ref;
+		ref.p = (cm_polygon_t *) CM_FlatEncode( PolygonOffset( pref->p ) );
+		ref.next = ( pref->next != NULL ) ? (cm_polygonRef_t *) CM_FlatEncode( polygonRefs.Num() + 1 ) : NULL;
+		polygonRefs.Append( ref );
+	}
+	if ( polygonRefs.Num() > firstPolygonRef ) {
+		nodes[index].polygons = (cm_polygonRef_t *) CM_FlatEncode( firstPolygonRef );
+	}
+
+	const int firstBrushRef = brushRefs.Num();
+	for ( const cm_brushRef_t *bref = node->brushes; bref != NULL; bref = bref->next ) {
+		cm_brushRef_t ref;
+		ref.b = (cm_brush_t *) CM_FlatEncode( BrushOffset( bref->b ) );
+		ref.next = ( bref->next != NULL ) ? (cm_brushRef_t *) CM_FlatEncode( brushRefs.Num() + 1 ) : NULL;
+		brushRefs.Append( ref );
+	}
+	if ( brushRefs.Num() > firstBrushRef ) {
+		nodes[index].brushes = (cm_brushRef_t *) CM_FlatEncode( firstBrushRef );
+	}
+
+	if ( node->planeType != -1 ) {
+		const int child0 = AddNode_r( node->children[0], index );
+		const int child1 = AddNode_r( node->children[1], index );
+		nodes[index].children[0] = (cm_node_t *) CM_FlatEncode( child0 );
+		nodes[index].children[1] = (cm_node_t *) CM_FlatEncode( child1 );
+	}
+	return index;
+}
+
+/*
+================
+idFlatCollisionModel::PolygonOffset
+
+  returns the offset of the polygon in the polygon block, adding it if not yet present
+================
+*/
+int idFlatCollisionModel::PolygonOffset( const cm_polygon_t *poly ) {
+	if ( poly == NULL ) {
+		return -1;
+	}
+	const int key = polygonHash.GenerateKey( (int)( (uintptr_t)poly >> 2 ) );
+	for ( int i = polygonHash.First( key ); i != -1; i = polygonHash.Next( i ) ) {
+		if ( polygons[i] == poly ) {
+			return polygonOffsets[i];
+		}
+	}
+	const int size = sizeof( cm_polygon_t ) + ( poly->numEdges - 1 ) * sizeof( poly->edges[0] );
+	const int offset = polygonData.Num();
+	polygonData.AssureSize( offset + size );
+	cm_polygon_t *copy = (cm_polygon_t *) &polygonData[offset];
+	memcpy( copy, poly, size );
+	copy->material = (const idMaterial *)(intptr_t) materials.AddUnique( poly->material );
+
+	polygonHash.Add( key, polygons.Append( poly ) );
+	polygonOffsets.Append( offset );
+	return offset;
+}
+
+/*
+================
+idFlatCollisionModel::BrushOffset
+
+  returns the offset of the brush in the brush block, adding it if not yet present
+================
+*/
+int idFlatCollisionModel::BrushOffset( const cm_brush_t *brush ) {
+	if ( brush == NULL ) {
+		return -1;
+	}
+	const int key = brushHash.GenerateKey( (int)( (uintptr_t)brush >> 2 ) );
+	for ( int i = brushHash.First( key ); i != -1; i = brushHash.Next( i ) ) {
+		if ( brushes[i] == brush ) {
+			return brushOffsets[i];
+		}
+	}
+	const int size = sizeof( cm_brush_t ) + ( brush->numPlanes - 1 ) * sizeof( brush->planes[0] );
+	const int offset = brushData.Num();
+	brushData.AssureSize( offset + size );
+	cm_brush_t *copy = (cm_brush_t *) &brushData[offset];
+	memcpy( copy, brush, size );
+	copy->material = (const idMaterial *)(intptr_t) materials.AddUnique( brush->material );
+
+	brushHash.Add( key, brushes.Append( brush ) );
+	brushOffsets.Append( offset );
+	return offset;
+}
+
+/*
+================
+idCollisionModelManagerLocal::LoadFlatBinaryModelFromFile
+
+  the magic has already been read
+================
+*/
+cm_model_t * idCollisionModelManagerLocal::LoadFlatBinaryModelFromFile( idFile *file, ID_TIME_T sourceTimeStamp ) {
+	cm_flatHeader_t header;
+	header.magic = BCM_FLAT_MAGIC;
+	const int headerBytes = sizeof( header ) - sizeof( header.magic );
+	if ( file->Read( (byte *)&header + sizeof( header.magic ), headerBytes ) != headerBytes ) {
+		return NULL;
+	}
+	if ( header.pointerSize != sizeof( void * ) ||
+			header.vertexSize != sizeof( cm_vertex_t ) ||
+			header.edgeSize != sizeof( cm_edge_t ) ||
+			header.polygonSize != sizeof( cm_polygon_t ) ||
+			header.brushSize != sizeof( cm_brush_t ) ||
+			header.nodeSize != sizeof( cm_node_t ) ||
+			( !fileSystem->InProductionMode() && header.timeStamp != (int64)sourceTimeStamp ) ) {
+		// skip the model so a following model in the same file can still be read
+		file->Seek( header.modelSize - (int)sizeof( header ), FS_SEEK_CUR );
+		return NULL;
+	}
+	file->Seek( CM_FlatAlign( sizeof( header ) ) - (int)sizeof( header ), FS_SEEK_CUR );
+
+	cm_model_t * model = AllocModel();
+	model->bounds = header.bounds;
+	model->contents = header.contents;
+	model->isConvex = ( header.isConvex != 0 );
+	model->maxVertices = model->numVertices = header.numVertices;
+	model->maxEdges = model->numEdges = header.numEdges;
+	model->numPolygons = header.numPolygons;
+	model->polygonMemory = header.polygonMemory;
+	model->numBrushes = header.numBrushes;
+	model->brushMemory = header.brushMemory;
+	model->numNodes = header.numNodes;
+	model->numBrushRefs = header.numBrushRefs;
+	model->numPolygonRefs = header.numPolygonRefs;
+	model->numInternalEdges = header.numInternalEdges;
+	model->numSharpEdges = header.numSharpEdges;
+	model->numRemovedPolys = header.numRemovedPolys;
+	model->numMergedPolys = header.numMergedPolys;
+
+	// allocate everything exactly the way FreeModel expects it, a single block per type
+	model->vertices = (cm_vertex_t *) Mem_Alloc( header.numVertices * sizeof( cm_vertex_t ), TAG_COLLISION );
+	model->edges = (cm_edge_t *) Mem_Alloc( header.numEdges * sizeof( cm_edge_t ), TAG_COLLISION );
+
+	model->polygonBlock = (cm_polygonBlock_t *) Mem_Alloc( sizeof( cm_polygonBlock_t ) + header.polygonBytes, TAG_COLLISION );
+	byte * polygonBase = ( (byte *) model->polygonBlock ) + sizeof( cm_polygonBlock_t );
+	model->polygonBlock->bytesRemaining = 0;
+	model->polygonBlock->next = polygonBase + header.polygonBytes;
+
+	model->brushBlock = (cm_brushBlock_t *) Mem_Alloc( sizeof( cm_brushBlock_t ) + header.brushBytes, TAG_COLLISION );
+	byte * brushBase = ( (byte *) model->brushBlock ) + sizeof( cm_brushBlock_t );
+	model->brushBlock->bytesRemaining = 0;
+	model->brushBlock->next = brushBase + header.brushBytes;
+
+	cm_node_t * nodes = NULL;
+	if ( header.nodeCount > 0 ) {
+		model->nodeBlocks = (cm_nodeBlock_t *) Mem_Alloc( sizeof( cm_nodeBlock_t ) + header.nodeCount * sizeof( cm_node_t ), TAG_COLLISION );
+		model->nodeBlocks->nextNode = NULL;
+		model->nodeBlocks->next = NULL;
+		nodes = (cm_node_t *) ( ( (byte *) model->nodeBlocks ) + sizeof( cm_nodeBlock_t ) );
+	}
+	cm_polygonRef_t * polygonRefs = NULL;
+	if ( header.polygonRefCount > 0 ) {
+		model->polygonRefBlocks = (cm_polygonRefBlock_t *) Mem_Alloc( sizeof( cm_polygonRefBlock_t ) + header.polygonRefCount * sizeof( cm_polygonRef_t ), TAG_COLLISION );
+		model->polygonRefBlocks->nextRef = NULL;
+		model->polygonRefBlocks->next = NULL;
+		polygonRefs = (cm_polygonRef_t *) ( ( (byte *) model->polygonRefBlocks ) + sizeof( cm_polygonRefBlock_t ) );
+	}
+	cm_brushRef_t * brushRefs = NULL;
+	if ( header.brushRefCount > 0 ) {
+		model->brushRefBlocks = (cm_brushRefBlock_t *) Mem_Alloc( sizeof( cm_brushRefBlock_t ) + header.brushRefCount * sizeof( cm_brushRef_t ), TAG_COLLISION );
+		model->brushRefBlocks->nextRef = NULL;
+		model->brushRefBlocks->next = NULL;
+		brushRefs = (cm_brushRef_t *) ( ( (byte *) model->brushRefBlocks ) + sizeof( cm_brushRefBlock_t ) );
+	}
+
+	idList< char > names;
+	names.SetNum( header.nameLength + 1 + header.materialNamesLength );
+	char * materialNames = names.Ptr() + header.nameLength + 1;
+
+	// one read per array
+	if ( !CM_FlatReadSection( file, model->vertices, header.numVertices * sizeof( cm_vertex_t ) ) ||
+			!CM_FlatReadSection( file, model->edges, header.numEdges * sizeof( cm_edge_t ) ) ||
+			!CM_FlatReadSection( file, polygonBase, header.polygonBytes ) ||
+			!CM_FlatReadSection( file, brushBase, header.brushBytes ) ||
+			!CM_FlatReadSection( file, nodes, header.nodeCount * sizeof( cm_node_t ) ) ||
+			!CM_FlatReadSection( file, polygonRefs, header.polygonRefCount * sizeof( cm_polygonRef_t ) ) ||
+			!CM_FlatReadSection( file, brushRefs, header.brushRefCount * sizeof( cm_brushRef_t ) ) ||
+			!CM_FlatReadSection( file, names.Ptr(), header.nameLength ) ||
+			!CM_FlatReadSection( file, materialNames, header.materialNamesLength ) ) {
+		FreeModel( model );
+		return NULL;
+	}
+	names[header.nameLength] = '\0';
+	model->name = names.Ptr();
+
+	idList< const idMaterial * > materials;
+	materials.SetNum( header.numMaterials );
+	const char * materialName = materialNames;
+	for ( int i = 0; i < materials.Num(); i++ ) {
+		materials[i] = ( materialName[0] != '\0' ) ? declManager->FindMaterial( materialName ) : NULL;
+		materialName += idStr::Length( materialName ) + 1;
+	}
+
+	// pointer fixup
+	for ( byte * p = polygonBase; p < polygonBase + header.polygonBytes; ) {
+		cm_polygon_t * poly = (cm_polygon_t *) p;
+		poly->material = materials[ (int)(intptr_t) poly->material ];
+		p += sizeof( cm_polygon_t ) + ( poly->numEdges - 1 ) * sizeof( poly->edges[0] );
+	}
+	for ( byte * p = brushBase; p < brushBase + header.brushBytes; ) {
+		cm_brush_t * brush = (cm_brush_t *) p;
+		brush->material = materials[ (int)(intptr_t) brush->material ];
+		p += sizeof( cm_brush_t ) + ( brush->numPlanes - 1 ) * sizeof( brush->planes[0] );
+	}
+	for ( int i = 0; i < header.polygonRefCount; i++ ) {
+		polygonRefs[i].p = (cm_polygon_t *) CM_FlatDecode( polygonBase, polygonRefs[i].p );
+		polygonRefs[i].next = CM_FlatDecode( polygonRefs, polygonRefs[i].next );
+	}
+	for ( int i = 0; i < header.brushRefCount; i++ ) {
+		brushRefs[i].b = (cm_brush_t *) CM_FlatDecode( brushBase, brushRefs[i].b );
+		brushRefs[i].next = CM_FlatDecode( brushRefs, brushRefs[i].next );
+	}
+	for ( int i = 0; i < header.nodeCount; i++ ) {
+		nodes[i].polygons = CM_FlatDecode( polygonRefs, nodes[i].polygons );
+		nodes[i].brushes = CM_FlatDecode( brushRefs, nodes[i].brushes );
+		nodes[i].parent = CM_FlatDecode( nodes, nodes[i].parent );
+		nodes[i].children[0] = CM_FlatDecode( nodes, nodes[i].children[0] );
+		nodes[i].children[1] = CM_FlatDecode( nodes, nodes[i].children[1] );
+	}
+	model->node = nodes;
+
+	model->usedMemory = model->numVertices * sizeof(cm_vertex_t) +
+		model->numEdges * sizeof(cm_edge_t) +
+		model->polygonMemory +
+		model->brushMemory +
+		model->numNodes * sizeof(cm_node_t) +
+		model->numPolygonRefs * sizeof(cm_polygonRef_t) +
+		model->numBrushRefs * sizeof(cm_brushRef_t);
+	return model;
+}
+
+/*
+================
+idCollisionModelManagerLocal::WriteFlatBinaryModelToFile
+================
+*/
+void idCollisionModelManagerLocal::WriteFlatBinaryModelToFile( cm_model_t *model, idFile *file, ID_TIME_T sourceTimeStamp ) {
+	idFlatCollisionModel flat;
+	flat.Build( model );
+
+	idList< char > materialNames;
+	for ( int i = 0; i < flat.materials.Num(); i++ ) {
+		const char * name = ( flat.materials[i] != NULL ) ? flat.materials[i]->GetName() : "";
+		const int length = idStr::Length( name ) + 1;
+		const int offset = materialNames.Num();
+		materialNames.SetNum( offset + length );
+		memcpy( materialNames.Ptr() + offset, name, length );
+	}
+
+	cm_flatHeader_t header;
+	memset( &header, 0, sizeof( header ) );
+	header.magic = BCM_FLAT_MAGIC;
+	header.pointerSize = sizeof( void * );
+	header.vertexSize = sizeof( cm_vertex_t );
+	header.edgeSize = sizeof( cm_edge_t );
+	header.polygonSize = sizeof( cm_polygon_t );
+	header.brushSize = sizeof( cm_brush_t );
+	header.nodeSize = sizeof( cm_node_t );
+	header.timeStamp = (int64)sourceTimeStamp;
+	header.bounds = model->bounds;
+	header.contents = model->contents;
+	header.isConvex = model->isConvex;
+	header.numVertices = model->numVertices;
+	header.numEdges = model->numEdges;
+	header.polygonBytes = flat.polygonData.Num();
+	header.brushBytes = flat.brushData.Num();
+	header.nodeCount = flat.nodes.Num();
+	header.polygonRefCount = flat.polygonRefs.Num();
+	header.brushRefCount = flat.brushRefs.Num();
+	header.nameLength = model->name.Length();
+	header.numMaterials = flat.materials.Num();
+	header.materialNamesLength = materialNames.Num();
+	header.numPolygons = model->numPolygons;
+	header.polygonMemory = model->polygonMemory;
+	header.numBrushes = model->numBrushes;
+	header.brushMemory = model->brushMemory;
+	header.numNodes = model->numNodes;
+	header.numBrushRefs = model->numBrushRefs;
+	header.numPolygonRefs = model->numPolygonRefs;
+	header.numInternalEdges = model->numInternalEdges;
+	header.numSharpEdges = model->numSharpEdges;
+	header.numRemovedPolys = model->numRemovedPolys;
+	header.numMergedPolys = model->numMergedPolys;
+
+	const int vertexBytes = model->numVertices * sizeof( cm_vertex_t );
+	const int edgeBytes = model->numEdges * sizeof( cm_edge_t );
+	const int nodeBytes = flat.nodes.Num() * sizeof( cm_node_t );
+	const int polygonRefBytes = flat.polygonRefs.Num() * sizeof( cm_polygonRef_t );
+	const int brushRefBytes = flat.brushRefs.Num() * sizeof( cm_brushRef_t );
+	header.modelSize = CM_FlatAlign( sizeof( header ) ) + CM_FlatAlign( vertexBytes ) + CM_FlatAlign( edgeBytes ) +
+						CM_FlatAlign( header.polygonBytes ) + CM_FlatAlign( header.brushBytes ) + CM_FlatAlign( nodeBytes ) +
+						CM_FlatAlign( polygonRefBytes ) + CM_FlatAlign( brushRefBytes ) +
+						CM_FlatAlign( header.nameLength ) + CM_FlatAlign( header.materialNamesLength );
+
+	CM_FlatWriteSection( file, &header, sizeof( header ) );
+	CM_FlatWriteSection( file, model->vertices, vertexBytes );
+	CM_FlatWriteSection( file, model->edges, edgeBytes );
+	CM_FlatWriteSection( file, flat.polygonData.Ptr(), header.polygonBytes );
+	CM_FlatWriteSection( file, flat.brushData.Ptr(), header.brushBytes );
+	CM_FlatWriteSection( file, flat.nodes.Ptr(), nodeBytes );
+	CM_FlatWriteSection( file, flat.polygonRefs.Ptr(), polygonRefBytes );
+	CM_FlatWriteSection( file, flat.brushRefs.Ptr(), brushRefBytes );
+	CM_FlatWriteSection( file, model->name.c_str(), header.nameLength );
+	CM_FlatWriteSection( file, materialNames.Ptr(), header.materialNamesLength );
+}
+
+/*
+================
+idCollisionModelManagerLocal::LoadBinaryModelFromFile
+================
+*/
+cm_model_t * idCollisionModelManagerLocal::LoadBinaryModelFromFile( idFile *file, ID_TIME_T sourceTimeStamp ) {
+	unsigned int magic = 0;
+	if ( file->Read( &magic, sizeof( magic ) ) != sizeof( magic ) ) {
+		return NULL;
+	}
+	if ( magic == BCM_FLAT_MAGIC ) {
+		return LoadFlatBinaryModelFromFile( file, sourceTimeStamp );
+	}
+	idSwap::Big( magic );
+	if ( magic == BCM_MAGIC ) {
+		return LoadBigEndianBinaryModelFromFile( file, sourceTimeStamp );
+	}
+	return NULL;
+}
+
+/*
+================
+idCollisionModelManagerLocal::WriteBinaryModelToFile
+================
+*/
+void idCollisionModelManagerLocal::WriteBinaryModelToFile( cm_model_t *model, idFile *file, ID_TIME_T sourceTimeStamp ) {
+	if ( cm_writeFlatBinary.GetBool() ) {
+		WriteFlatBinaryModelToFile( model, file, sourceTimeStamp );
+	} else {
+		WriteBigEndianBinaryModelToFile( model, file, sourceTimeStamp );
+	}
+}
+
+/*
+================
+idCollisionModelManagerLocal::TestBinaryModelLoad
+
+  times loading every loaded model from memory in both binary layouts and
+  checks that the flat layout survives a load and write round trip unchanged
+================
+*/
+void idCollisionModelManagerLocal::TestBinaryModelLoad( int passes ) {
+	if ( numModels == 0 ) {
+		common->Printf( "testCollisionModelLoad: no collision models loaded\n" );
+		return;
+	}
+	passes = Max( passes, 1 );
+
+	uint64 bigEndianTime = 0;
+	uint64 flatTime = 0;
+	int bigEndianBytes = 0;
+	int flatBytes = 0;
+	int numTested = 0;
+	int numMismatched = 0;
+
+	for ( int i = 0; i < numModels; i++ ) {
+		cm_model_t * model = models[i];
+		if ( model == NULL || model->node == NULL ) {
+			continue;
+		}
+
+		idFile_Memory bigEndianFile( "bigEndian" );
+		idFile_Memory flatFile( "flat" );
+		WriteBigEndianBinaryModelToFile( model, &bigEndianFile, 0 );
+		WriteFlatBinaryModelToFile( model, &flatFile, 0 );
+		bigEndianBytes += bigEndianFile.Length();
+		flatBytes += flatFile.Length();
+		numTested++;
+
+		{
+			idFile_Memory file( "flat", (const char *) flatFile.GetDataPtr(), flatFile.Length() );
+			cm_model_t * loaded = LoadBinaryModelFromFile( &file, 0 );
+			idFile_Memory roundTrip( "roundTrip" );
+			if ( loaded != NULL ) {
+				WriteFlatBinaryModelToFile( loaded, &roundTrip, 0 );
+				FreeModel( loaded );
+			}
+			if ( loaded == NULL || roundTrip.Length() != flatFile.Length() || memcmp( roundTrip.GetDataPtr(), flatFile.GetDataPtr(), flatFile.Length() ) != 0 ) {
+				common->Printf( "%s: flat layout did not round trip\n", model->name.c_str() );
+				numMismatched++;
+			}
+		}
+
+		for ( int pass = 0; pass < passes; pass++ ) {
+			idFile_Memory file( "bigEndian", (const char *) bigEndianFile.GetDataPtr(), bigEndianFile.Length() );
+			const uint64 start = Sys_Microseconds();
+			cm_model_t * loaded = LoadBinaryModelFromFile( &file, 0 );
+			bigEndianTime += Sys_Microseconds() - start;
+			if ( loaded != NULL ) {
+				FreeModel( loaded );
+			}
+		}
+		for ( int pass = 0; pass < passes; pass++ ) {
+			idFile_Memory file( "flat", (const char *) flatFile.GetDataPtr(), flatFile.Length() );
+			const uint64 start = Sys_Microseconds();
+			cm_model_t * loaded = LoadBinaryModelFromFile( &file, 0 );
+			flatTime += Sys_Microseconds() - start;
+			if ( loaded != NULL ) {
+				FreeModel( loaded );
+			}
+		}
+	}
+
+	common->Printf( "%d models, %d passes\n", numTested, passes );
+	common->Printf( "big endian: %6d KB, %8.3f ms per pass\n", bigEndianBytes >> 10, bigEndianTime * 0.001 / passes );
+	common->Printf( "flat:       %6d KB, %8.3f ms per pass\n", flatBytes >> 10, flatTime * 0.001 / passes );
+	if ( flatTime > 0 ) {
+		common->Printf( "flat layout loads %.1f times faster\n", (double)bigEndianTime / flatTime );
+	}
+	common->Printf( numMismatched == 0 ? "testCollisionModelLoad passed\n" : "testCollisionModelLoad FAILED on %d models\n", numMismatched );
+}
+
+/*
+================
+testCollisionModelLoad
+================
+*/
+CONSOLE_COMMAND( testCollisionModelLoad, "benchmarks loading the loaded collision models in both binary layouts", NULL ) {
+	const int passes = ( args.Argc() > 1 ) ? Max( atoi( args.Argv( 1 ) ), 1 ) : 10;
+	collisionModelManagerLocal.TestBinaryModelLoad( passes );
+}
+
 /*
 ================
 idCollisionModelManagerLocal::WriteBinaryModel
@@ -350,6 +350,8 @@ public:
 	void			ModelInfo( cmHandle_t model );
 	// list all loaded models
 	void			ListModels();
+	// time loading the loaded models in both binary layouts
+	void			TestBinaryModelLoad( int passes );
 	// write a collision model file for the map entity
 	bool			WriteCollisionModelForMapEntity( const idMapEntity *mapEnt, const char *filename, const bool testTraceModel = true );
 
@@ -479,8 +481,12 @@ private:			// CollisionMap_load.cpp
 	cm_model_t *	LoadRenderModel( const char *fileName );					// ASE/LWO models
 	cm_model_t *	LoadBinaryModel( const char *fileName, ID_TIME_T sourceTimeStamp );
 	cm_model_t *	LoadBinaryModelFromFile( idFile *fileIn, ID_TIME_T sourceTimeStamp );
+	cm_model_t *	LoadBigEndianBinaryModelFromFile( idFile *fileIn, ID_TIME_T sourceTimeStamp );
+	cm_model_t *	LoadFlatBinaryModelFromFile( idFile *fileIn, ID_TIME_T sourceTimeStamp );
 	void			WriteBinaryModel( cm_model_t *model, const char *fileName, ID_TIME_T sourceTimeStamp );
 	void			WriteBinaryModelToFile( cm_model_t *model, idFile *fileOut, ID_TIME_T sourceTimeStamp ); 
+	void			WriteBigEndianBinaryModelToFile( cm_model_t *model, idFile *fileOut, ID_TIME_T sourceTimeStamp );
+	void			WriteFlatBinaryModelToFile( cm_model_t *model, idFile *fileOut, ID_TIME_T sourceTimeStamp );
 	bool			TrmFromModel_r( idTraceModel &trm, cm_node_t *node );
 	bool			TrmFromModel( const cm_model_t *model, idTraceModel &trm );
 
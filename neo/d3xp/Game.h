@@ -112,6 +112,9 @@ public:
 
 	virtual void				Preload( const idPreloadManifest &manifest ) = 0;
 
+	// Writes the generated binary file of an anim if it is out of date, the anim is not kept.
+	virtual bool				BakeAnim( const char *animName ) = 0;
+
 	// Runs a game frame, may return a session command for level changing, etc
 	virtual void				RunFrame( idUserCmdMgr & cmdMgr, gameReturn_t & gameReturn ) = 0;
 
@@ -308,7 +311,7 @@ extern idGameEdit *				gameEdit;
 ===============================================================================
 */
 
-const int GAME_API_VERSION		= 8;
+const int GAME_API_VERSION		= 9;
 
 typedef struct {
 
@@ -1641,6 +1641,16 @@ void idGameLocal::Preload( const idPreloadManifest &manifest ) {
 	animationLib.Preload( manifest );
 }
 
+/*
+===================
+idGameLocal::BakeAnim
+===================
+*/
+bool idGameLocal::BakeAnim( const char *animName ) {
+	idMD5Anim anim;
+	return anim.LoadAnim( animName );
+}
+
 /*
 ===================
 idGameLocal::CacheDictionaryMedia
@@ -351,6 +351,7 @@ public:
 	virtual void			MapShutdown();
 	virtual void			CacheDictionaryMedia( const idDict *dict );
 	virtual void			Preload( const idPreloadManifest &manifest );
+	virtual bool			BakeAnim( const char *animName );
 	virtual void			RunFrame( idUserCmdMgr & cmdMgr, gameReturn_t & gameReturn );
 	void					RunAllUserCmdsForPlayer( idUserCmdMgr & cmdMgr, const int playerNumber );
 	void					RunSingleUserCmd( usercmd_t & cmd, idPlayer & player );
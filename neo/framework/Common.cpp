@@ -987,6 +987,9 @@ void idCommonLocal::Init( int argc, const char * const * argv, const char *cmdli
 		// override cvars from command line
 		StartupVariable( NULL );
 
+		// pick the allocator now that mem_poolAllocator can be set
+		Mem_Init();
+
 		consoleUsed = com_allowConsole.GetBool();
 
 		if ( Sys_AlreadyRunning() ) {
@@ -1015,15 +1018,15 @@ void idCommonLocal::Init( int argc, const char * const * argv, const char *cmdli
 
 		fileSystem->BeginLevelLoad( "_startup", saveFile.GetDataPtr(), saveFile.GetAllocated() );
 
+		// init the parallel job manager, the declaration manager scans decl files on the job threads
+		parallelJobManager->Init();
+
 		// initialize the declaration manager
 		declManager->Init();
 
 		// init journalling, etc
 		eventLoop->Init();
 
-		// init the parallel job manager
-		parallelJobManager->Init();
-
 		// exec the startup scripts
 		cmdSystem->BufferCommandText( CMD_EXEC_APPEND, "exec default.cfg\n" );
 
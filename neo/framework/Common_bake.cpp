@@ -0,0 +1,362 @@
+/*
+===========================================================================
+
+Doom 3 BFG Edition GPL Source Code
+Copyright (C) 1993-2012 id Software LLC, a ZeniMax Media company. 
+
+This file is part of the Doom 3 BFG Edition GPL Source Code ("Doom 3 BFG Edition Source Code").  
+
+Doom 3 BFG Edition Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 BFG Edition Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 BFG Edition Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 BFG Edition Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 BFG Edition Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+#include "../idlib/precompiled.h"
+#pragma hdrstop
+
+#include "Common_local.h"
+#include "../renderer/Image.h"
+
+extern idCVar r_binaryLoadRenderModels;
+
+/*
+================================================================================================
+
+	Baking generated files
+
+	Writes the generated binary files of every asset in the map preload manifests, instead of
+	waiting for each asset to be loaded for the first time. Images are compressed in parallel
+	on the job threads. Models, anims and collision models are parsed on the main thread,
+	because their loaders use the decl manager and other systems that are not thread safe.
+
+================================================================================================
+*/
+
+/*
+================
+BakeIsCurrent
+
+The loaders still check the source time stamp stored in the generated file.
+================
+*/
+static bool BakeIsCurrent( const char *sourceName, const char *generatedName ) {
+	const ID_TIME_T generatedTime = fileSystem->GetTimestamp( generatedName );
+	return ( generatedTime != FILE_NOT_FOUND_TIMESTAMP && generatedTime >= fileSystem->GetTimestamp( sourceName ) );
+}
+
+/*
+================
+BakeFindMapFile
+
+The preload manifests are named after the map without its path, maps/game/mp/d3dm1.map writes
+maps/d3dm1.preload, so find the map file with the same stripped name.
+================
+*/
+static bool BakeFindMapFile( const idStrList & mapFiles, const char *manifestName, idStr & mapName ) {
+	idStr baseName = manifestName;
+	baseName.StripPath();
+	baseName.StripFileExtension();
+	for ( int i = 0; i < mapFiles.Num(); i++ ) {
+		idStr mapBaseName = mapFiles[i];
+		mapBaseName.StripPath();
+		mapBaseName.StripFileExtension();
+		if ( mapBaseName.Icmp( baseName ) == 0 ) {
+			mapName = mapFiles[i];
+			return true;
+		}
+	}
+	mapName.Clear();
+	return false;
+}
+
+/*
+================
+BakeModelSupportsBinary
+================
+*/
+static bool BakeModelSupportsBinary( const char *modelName ) {
+	idStr extension;
+	idStr( modelName ).ExtractFileExtension( extension );
+	return ( extension.Icmp( "ase" ) == 0 || extension.Icmp( "lwo" ) == 0 || extension.Icmp( "flt" ) == 0 || extension.Icmp( "ma" ) == 0 || extension.Icmp( MD5_MESH_EXT ) == 0 );
+}
+
+/*
+================
+BakePrintTime
+================
+*/
+static void BakePrintTime( uint64 startMicroseconds, const char *name ) {
+	common->Printf( "%8.1f ms %s\n", ( Sys_Microseconds() - startMicroseconds ) * 0.001f, name );
+}
+
+/*
+================
+BakePrintSummary
+================
+*/
+static void BakePrintSummary( const char *type, int numBaked, int numCurrent, int startMilliseconds ) {
+	common->Printf( "%05d %s baked, %05d were current in %5.1f seconds\n", numBaked, type, numCurrent, ( Sys_Milliseconds() - startMilliseconds ) * 0.001 );
+	common->Printf( "----------------------------------------\n" );
+}
+
+/*
+================
+idCommonLocal::BakeGeneratedFiles
+================
+*/
+void idCommonLocal::BakeGeneratedFiles( const idCmdArgs &args ) {
+	if ( mapSpawned ) {
+		common->Printf( "bakeGeneratedFiles: can't be used while a map is loaded\n" );
+		return;
+	}
+	if ( fileSystem->InProductionMode() ) {
+		common->Printf( "bakeGeneratedFiles: generated files are not written in production mode\n" );
+		return;
+	}
+
+	const int start = Sys_Milliseconds();
+
+	idStrList mapFiles;
+	idFileList * files = fileSystem->ListFilesTree( "maps", ".map", true );
+	for ( int i = 0; i < files->GetNumFiles(); i++ ) {
+		mapFiles.Append( files->GetFile( i ) );
+	}
+	fileSystem->FreeFileList( files );
+
+	// the given maps, or every preload manifest
+	idStrList manifestNames;
+	if ( args.Argc() > 1 ) {
+		for ( int i = 1; i < args.Argc(); i++ ) {
+			idStr name = args.Argv( i );
+			name.BackSlashesToSlashes();
+			name.StripPath();
+			name.StripFileExtension();
+			manifestNames.Append( va( "maps/%s.preload", name.c_str() ) );
+		}
+	} else {
+		files = fileSystem->ListFilesTree( "maps", ".preload", true );
+		for ( int i = 0; i < files->GetNumFiles(); i++ ) {
+			manifestNames.Append( files->GetFile( i ) );
+		}
+		fileSystem->FreeFileList( files );
+	}
+
+	// merge the manifests, the collision models are baked per map
+	idPreloadManifest assets;
+	idHashIndex assetHash;
+	idStrList assetKeys;
+	idStrList mapNames;
+	idList< idStrList > mapCollisionModels;
+	for ( int i = 0; i < manifestNames.Num(); i++ ) {
+		idPreloadManifest manifest;
+		if ( !manifest.LoadManifest( manifestNames[i] ) ) {
+			common->Warning( "bakeGeneratedFiles: couldn't load %s", manifestNames[i].c_str() );
+			continue;
+		}
+		idStrList & collisionModels = mapCollisionModels.Alloc();
+		idStr & mapName = mapNames.Alloc();
+		if ( !BakeFindMapFile( mapFiles, manifestNames[i], mapName ) ) {
+			common->Warning( "bakeGeneratedFiles: couldn't find the map of %s, its collision models won't be baked", manifestNames[i].c_str() );
+		}
+
+		for ( int j = 0; j < manifest.NumResources(); j++ ) {
+			const preloadEntry_s & p = manifest.GetPreloadByIndex( j );
+			if ( p.resType == PRELOAD_COLLISION ) {
+				collisionModels.AddUnique( p.resourceName );
+				continue;
+			}
+			if ( p.resType != PRELOAD_IMAGE && p.resType != PRELOAD_MODEL && p.resType != PRELOAD_ANIM ) {
+				continue;
+			}
+			idStr key = va( "%d %d %d %d %d %s", p.resType, p.imgData.filter, p.imgData.repeat, p.imgData.usage, p.imgData.cubeMap, p.resourceName.c_str() );
+			key.ToLower();
+			const int hashKey = assetHash.GenerateKey( key, true );
+			bool found = false;
+			for ( int k = assetHash.First( hashKey ); k != -1; k = assetHash.Next( k ) ) {
+				if ( assetKeys[k] == key ) {
+					found = true;
+					break;
+				}
+			}
+			if ( found ) {
+				continue;
+			}
+			assetHash.Add( hashKey, assetKeys.Append( key ) );
+			if ( p.resType == PRELOAD_IMAGE ) {
+				assets.AddImage( p.resourceName, p.imgData.filter, p.imgData.repeat, p.imgData.usage, p.imgData.cubeMap );
+			} else if ( p.resType == PRELOAD_MODEL ) {
+				assets.AddModel( p.resourceName );
+			} else {
+				assets.AddAnim( p.resourceName );
+			}
+		}
+	}
+	common->Printf( "Baking %d assets from %d preload manifests\n", assets.NumResources(), mapNames.Num() );
+
+	// images go first, so the materials of the models find them current
+	globalImages->BakeImages( assets );
+
+	// the materials only need to be registered, don't create the textures of every map at once
+	const bool insideLevelLoad = globalImages->insideLevelLoad;
+	globalImages->insideLevelLoad = true;
+
+	common->Printf( "Baking models...\n" );
+	int stageStart = Sys_Milliseconds();
+	int numBaked = 0;
+	int numCurrent = 0;
+	// the model manager only writes generated models when it loads them in binary
+	const bool bakeModels = r_binaryLoadRenderModels.GetBool();
+	if ( !bakeModels ) {
+		common->Printf( "r_binaryLoadRenderModels is 0, no models are baked\n" );
+	}
+	for ( int i = 0; bakeModels && i < assets.NumResources(); i++ ) {
+		const preloadEntry_s & p = assets.GetPreloadByIndex( i );
+		if ( p.resType != PRELOAD_MODEL || !BakeModelSupportsBinary( p.resourceName ) ) {
+			continue;
+		}
+		idStrStatic< MAX_OSPATH > generatedFileName = "generated/rendermodels/";
+		generatedFileName.AppendPath( p.resourceName );
+		idStrStatic< 16 > extension;
+		generatedFileName.ExtractFileExtension( extension );
+		generatedFileName.SetFileExtension( va( "b%s", extension.c_str() ) );
+		if ( BakeIsCurrent( p.resourceName, generatedFileName ) ) {
+			numCurrent++;
+			continue;
+		}
+		const uint64 assetStart = Sys_Microseconds();
+		idRenderModel * model = renderModelManager->CheckModel( p.resourceName );
+		if ( model != NULL && !BakeIsCurrent( p.resourceName, generatedFileName ) && model->IsLoaded() && !model->IsDefaultModel() && model->SupportsBinaryModel() ) {
+			// the model was already in memory, so loading it didn't write the generated file
+			idFileLocal outputFile( fileSystem->OpenFileWrite( generatedFileName, "fs_basepath" ) );
+			model->WriteBinaryModel( outputFile );
+		}
+		if ( !BakeIsCurrent( p.resourceName, generatedFileName ) ) {
+			common->Warning( "bakeGeneratedFiles: couldn't write %s", generatedFileName.c_str() );
+			continue;
+		}
+		BakePrintTime( assetStart, p.resourceName );
+		numBaked++;
+	}
+	BakePrintSummary( "models", numBaked, numCurrent, stageStart );
+
+	common->Printf( "Baking anims...\n" );
+	stageStart = Sys_Milliseconds();
+	numBaked = 0;
+	numCurrent = 0;
+	for ( int i = 0; i < assets.NumResources(); i++ ) {
+		const preloadEntry_s & p = assets.GetPreloadByIndex( i );
+		if ( p.resType != PRELOAD_ANIM ) {
+			continue;
+		}
+		idStrStatic< MAX_OSPATH > generatedFileName = "generated/anim/";
+		generatedFileName.AppendPath( p.resourceName );
+		generatedFileName.SetFileExtension( ".bMD5anim" );
+		if ( BakeIsCurrent( p.resourceName, generatedFileName ) ) {
+			numCurrent++;
+			continue;
+		}
+		const uint64 assetStart = Sys_Microseconds();
+		if ( !game->BakeAnim( p.resourceName ) ) {
+			common->Warning( "bakeGeneratedFiles: couldn't load anim %s", p.resourceName.c_str() );
+		}
+		BakePrintTime( assetStart, p.resourceName );
+		numBaked++;
+	}
+	BakePrintSummary( "anims", numBaked, numCurrent, stageStart );
+
+	// collision models can only be loaded with their map
+	common->Printf( "Baking collision models...\n" );
+	stageStart = Sys_Milliseconds();
+	numBaked = 0;
+	numCurrent = 0;
+	for ( int i = 0; i < mapNames.Num(); i++ ) {
+		if ( mapNames[i].IsEmpty() ) {
+			continue;
+		}
+		// the .bcm is generated from the .cm that dmap writes, not from the .map
+		idStrStatic< MAX_OSPATH > collisionMapName = mapNames[i];
+		collisionMapName.SetFileExtension( "cm" );
+		idStrStatic< MAX_OSPATH > generatedMapName = collisionMapName;
+		generatedMapName.Insert( "generated/", 0 );
+		generatedMapName.SetFileExtension( "bcm" );
+		const bool mapCurrent = BakeIsCurrent( collisionMapName, generatedMapName );
+
+		idStrList staleModels;
+		for ( int j = 0; j < mapCollisionModels[i].Num(); j++ ) {
+			const idStr & modelName = mapCollisionModels[i][j];
+			idStrStatic< MAX_OSPATH > generatedFileName = "generated/collision/";
+			generatedFileName.AppendPath( modelName );
+			generatedFileName.SetFileExtension( "bcmodel" );
+			if ( BakeIsCurrent( modelName, generatedFileName ) ) {
+				numCurrent++;
+			} else {
+				staleModels.Append( modelName );
+			}
+		}
+		if ( mapCurrent ) {
+			numCurrent++;
+			if ( staleModels.Num() == 0 ) {
+				continue;
+			}
+		}
+
+		uint64 assetStart = Sys_Microseconds();
+		idMapFile mapFile;
+		if ( !mapFile.Parse( mapNames[i] ) ) {
+			common->Warning( "bakeGeneratedFiles: couldn't load %s", mapNames[i].c_str() );
+			continue;
+		}
+		collisionModelManager->LoadMap( &mapFile );
+		if ( !mapCurrent ) {
+			if ( BakeIsCurrent( collisionMapName, generatedMapName ) ) {
+				BakePrintTime( assetStart, mapNames[i] );
+				numBaked++;
+			} else {
+				common->Warning( "bakeGeneratedFiles: couldn't write %s", generatedMapName.c_str() );
+			}
+		}
+		for ( int j = 0; j < staleModels.Num(); j++ ) {
+			assetStart = Sys_Microseconds();
+			collisionModelManager->LoadModel( staleModels[j] );
+			idStrStatic< MAX_OSPATH > generatedFileName = "generated/collision/";
+			generatedFileName.AppendPath( staleModels[j] );
+			generatedFileName.SetFileExtension( "bcmodel" );
+			if ( !BakeIsCurrent( staleModels[j], generatedFileName ) ) {
+				common->Warning( "bakeGeneratedFiles: couldn't write %s", generatedFileName.c_str() );
+				continue;
+			}
+			BakePrintTime( assetStart, staleModels[j] );
+			numBaked++;
+		}
+		collisionModelManager->FreeMap();
+	}
+	BakePrintSummary( "collision models", numBaked, numCurrent, stageStart );
+
+	globalImages->insideLevelLoad = insideLevelLoad;
+
+	common->Printf( "bakeGeneratedFiles: done in %5.1f seconds\n", ( Sys_Milliseconds() - start ) * 0.001 );
+}
+
+/*
+================
+BakeGeneratedFiles_f
+================
+*/
+CONSOLE_COMMAND( bakeGeneratedFiles, "writes the generated binary files of every preload manifest, or of the given maps", idCmdSystem::ArgCompletion_MapName ) {
+	commonLocal.BakeGeneratedFiles( args );
+}
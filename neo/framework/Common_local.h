@@ -236,6 +236,9 @@ public:	// These are public because they are called directly by static functions
 	void	AVIRenderDemo( const char *name );
 	void	AVIGame( const char *name );
 
+	// writes the generated binary files of the preload manifests
+	void	BakeGeneratedFiles( const idCmdArgs &args );
+
 	// localization
 	void	InitLanguageDict();
 	void	LocalizeGui( const char *fileName, idLangDict &langDict );
@@ -135,6 +135,10 @@ void idCommonLocal::SendSnapshots() {
 	idSnapShot ss;
 	game->ServerWriteSnapshot( ss );
 
+	// Objects that didn't change since the last snap keep their generation, so the peers' deltas can skip them
+	ss.InheritGenerations( oldss );
+	oldss = ss;
+
 	session->SendSnapshot( ss );
 	nextSnapshotSendTime = MSEC_ALIGN_TO_FRAME( currentTime + net_snapRate.GetInteger() );
 }
@@ -46,6 +46,8 @@ idDeclEntityDef::FreeData
 */
 void idDeclEntityDef::FreeData() {
 	dict.Clear();
+	inherit.Clear();
+	numLocalKeys = 0;
 }
 
 /*
@@ -93,9 +95,7 @@ bool idDeclEntityDef::Parse( const char *text, const int textLength, bool allowB
 	// "inherit" keys will cause all values from another entityDef to be copied into this one
 	// if they don't conflict.  We can't have circular recursions, because each entityDef will
 	// never be parsed mroe than once
-
-	// find all of the dicts first, because copying inherited values will modify the dict
-	idList<const idDeclEntityDef *> defList;
+	inherit.Clear();
 
 	while ( 1 ) {
 		const idKeyValue *kv;
@@ -104,15 +104,36 @@ bool idDeclEntityDef::Parse( const char *text, const int textLength, bool allowB
 			break;
 		}
 
-		const idDeclEntityDef *copy = static_cast<const idDeclEntityDef *>( declManager->FindType( DECL_ENTITYDEF, kv->GetValue(), false ) );
+		inherit.Append( kv->GetValue() );
+
+		// delete this key/value pair
+		dict.Delete( kv->GetKey() );
+	}
+
+	// the inherited pairs are added after these
+	numLocalKeys = dict.GetNumKeyVals();
+
+	Inherit();
+
+	return true;
+}
+
+/*
+================
+idDeclEntityDef::Inherit
+================
+*/
+void idDeclEntityDef::Inherit() {
+	// find all of the dicts first, because copying inherited values will modify the dict
+	idList<const idDeclEntityDef *> defList;
+
+	for ( int i = 0; i < inherit.Num(); i++ ) {
+		const idDeclEntityDef *copy = static_cast<const idDeclEntityDef *>( declManager->FindType( DECL_ENTITYDEF, inherit[i], false ) );
 		if ( !copy ) {
-			src.Warning( "Unknown entityDef '%s' inherited by '%s'", kv->GetValue().c_str(), GetName() );
+			common->Warning( "file %s, line %d: Unknown entityDef '%s' inherited by '%s'", GetFileName(), GetLineNum(), inherit[i].c_str(), GetName() );
 		} else {
 			defList.Append( copy );
 		}
-
-		// delete this key/value pair
-		dict.Delete( kv->GetKey() );
 	}
 
 	// now copy over the inherited key / value pairs
@@ -121,6 +142,61 @@ bool idDeclEntityDef::Parse( const char *text, const int textLength, bool allowB
 	}
 
 	game->CacheDictionaryMedia( &dict );
+}
+
+/*
+================
+idDeclEntityDef::WriteBinaryCache
+
+Only the pairs of this entityDef are written, the inherited ones are copied again when
+it is read, so changes to the entityDefs it inherits from are picked up.
+================
+*/
+bool idDeclEntityDef::WriteBinaryCache( idFile *file ) const {
+	file->WriteBig( numLocalKeys );
+	for ( int i = 0; i < numLocalKeys; i++ ) {
+		const idKeyValue *kv = dict.GetKeyVal( i );
+		file->WriteString( kv->GetKey() );
+		file->WriteString( kv->GetValue() );
+	}
+	file->WriteBig( inherit.Num() );
+	for ( int i = 0; i < inherit.Num(); i++ ) {
+		file->WriteString( inherit[i] );
+	}
+	return true;
+}
+
+/*
+================
+idDeclEntityDef::ReadBinaryCache
+================
+*/
+bool idDeclEntityDef::ReadBinaryCache( idFile *file ) {
+	int num = 0;
+	idStr key, value;
+
+	if ( !ReadBinaryCount( file, num, 2 * sizeof( int ) ) ) {
+		return false;
+	}
+	for ( int i = 0; i < num; i++ ) {
+		if ( !ReadBinaryString( file, key ) || !ReadBinaryString( file, value ) ) {
+			return false;
+		}
+		dict.Set( key, value );
+	}
+	numLocalKeys = dict.GetNumKeyVals();
+
+	if ( !ReadBinaryCount( file, num, sizeof( int ) ) ) {
+		return false;
+	}
+	for ( int i = 0; i < num; i++ ) {
+		if ( !ReadBinaryString( file, value ) ) {
+			return false;
+		}
+		inherit.Append( value );
+	}
+
+	Inherit();
 
 	return true;
 }
@@ -46,6 +46,14 @@ public:
 	virtual bool			Parse( const char *text, const int textLength, bool allowBinaryVersion );
 	virtual void			FreeData();
 	virtual void			Print();
+	virtual bool			WriteBinaryCache( idFile *file ) const;
+	virtual bool			ReadBinaryCache( idFile *file );
+
+private:
+	void					Inherit();
+
+	idStrList				inherit;		// names of the entityDefs inherited from
+	int						numLocalKeys;	// the first key/value pairs of dict are not inherited
 };
 
 #endif /* !__DECLENTITYDEF_H__ */
@@ -448,6 +448,128 @@ bool idDeclFX::Parse( const char *text, const int textLength, bool allowBinaryVe
 	return true;
 }
 
+/*
+================
+idDeclFX::WriteBinaryCache
+================
+*/
+bool idDeclFX::WriteBinaryCache( idFile *file ) const {
+	file->WriteString( joint );
+	file->WriteBig( events.Num() );
+	for ( int i = 0; i < events.Num(); i++ ) {
+		const idFXSingleAction & action = events[i];
+		file->WriteBig( action.type );
+		file->WriteBig( action.sibling );
+		file->WriteString( action.data );
+		file->WriteString( action.name );
+		file->WriteString( action.fire );
+		file->WriteFloat( action.delay );
+		file->WriteFloat( action.duration );
+		file->WriteFloat( action.restart );
+		file->WriteFloat( action.size );
+		file->WriteFloat( action.fadeInTime );
+		file->WriteFloat( action.fadeOutTime );
+		file->WriteFloat( action.shakeTime );
+		file->WriteFloat( action.shakeAmplitude );
+		file->WriteFloat( action.shakeDistance );
+		file->WriteFloat( action.shakeImpulse );
+		file->WriteFloat( action.lightRadius );
+		file->WriteFloat( action.rotate );
+		file->WriteFloat( action.random1 );
+		file->WriteFloat( action.random2 );
+		file->WriteVec3( action.lightColor );
+		file->WriteVec3( action.offset );
+		file->WriteMat3( action.axis );
+		file->WriteBool( action.soundStarted );
+		file->WriteBool( action.shakeStarted );
+		file->WriteBool( action.shakeFalloff );
+		file->WriteBool( action.shakeIgnoreMaster );
+		file->WriteBool( action.bindParticles );
+		file->WriteBool( action.explicitAxis );
+		file->WriteBool( action.noshadows );
+		file->WriteBool( action.particleTrackVelocity );
+		file->WriteBool( action.trackOrigin );
+	}
+	return true;
+}
+
+// bytes of an action WriteBinaryCache writes after the strings, and the least it writes in all
+static const int FX_ACTION_FIXED_SIZE	= 14 * sizeof( float ) + 2 * sizeof( idVec3 ) + sizeof( idMat3 ) + 9;
+static const int FX_ACTION_MIN_SIZE		= 2 * sizeof( int ) + 3 * sizeof( int ) + FX_ACTION_FIXED_SIZE;
+
+/*
+================
+idDeclFX::ReadBinaryCache
+================
+*/
+bool idDeclFX::ReadBinaryCache( idFile *file ) {
+	int numEvents = 0;
+
+	if ( !ReadBinaryString( file, joint ) || !ReadBinaryCount( file, numEvents, FX_ACTION_MIN_SIZE ) ) {
+		return false;
+	}
+	events.SetNum( numEvents );
+	for ( int i = 0; i < numEvents; i++ ) {
+		idFXSingleAction & action = events[i];
+		file->ReadBig( action.type );
+		file->ReadBig( action.sibling );
+		if ( !ReadBinaryString( file, action.data ) || !ReadBinaryString( file, action.name ) || !ReadBinaryString( file, action.fire ) ) {
+			return false;
+		}
+		if ( file->Length() - file->Tell() < FX_ACTION_FIXED_SIZE ) {
+			return false;
+		}
+		file->ReadFloat( action.delay );
+		file->ReadFloat( action.duration );
+		file->ReadFloat( action.restart );
+		file->ReadFloat( action.size );
+		file->ReadFloat( action.fadeInTime );
+		file->ReadFloat( action.fadeOutTime );
+		file->ReadFloat( action.shakeTime );
+		file->ReadFloat( action.shakeAmplitude );
+		file->ReadFloat( action.shakeDistance );
+		file->ReadFloat( action.shakeImpulse );
+		file->ReadFloat( action.lightRadius );
+		file->ReadFloat( action.rotate );
+		file->ReadFloat( action.random1 );
+		file->ReadFloat( action.random2 );
+		file->ReadVec3( action.lightColor );
+		file->ReadVec3( action.offset );
+		file->ReadMat3( action.axis );
+		file->ReadBool( action.soundStarted );
+		file->ReadBool( action.shakeStarted );
+		file->ReadBool( action.shakeFalloff );
+		file->ReadBool( action.shakeIgnoreMaster );
+		file->ReadBool( action.bindParticles );
+		file->ReadBool( action.explicitAxis );
+		file->ReadBool( action.noshadows );
+		file->ReadBool( action.particleTrackVelocity );
+		file->ReadBool( action.trackOrigin );
+
+		// precache the same media ParseSingleFXAction does
+		switch ( action.type ) {
+			case FX_LIGHT:
+			case FX_ATTACHLIGHT:
+			case FX_DECAL:
+				declManager->FindMaterial( action.data );
+				break;
+			case FX_MODEL:
+			case FX_PARTICLE:
+			case FX_ATTACHENTITY:
+				renderModelManager->FindModel( action.data );
+				break;
+			case FX_LAUNCH:
+			case FX_SHOCKWAVE:
+				declManager->FindType( DECL_ENTITYDEF, action.data );
+				break;
+			case FX_SOUND:
+				declManager->FindSound( action.data );
+				break;
+		}
+	}
+	return true;
+}
+
 /*
 ===================
 idDeclFX::DefaultDefinition
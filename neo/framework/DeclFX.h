@@ -102,6 +102,8 @@ public:
 	virtual void			FreeData();
 	virtual void			Print() const;
 	virtual void			List() const;
+	virtual bool			WriteBinaryCache( idFile *file ) const;
+	virtual bool			ReadBinaryCache( idFile *file );
 
 	idList<idFXSingleAction, TAG_FX>events;
 	idStr					joint;
@@ -64,6 +64,9 @@ missing reload over a previously explicit definition
 #define USE_COMPRESSED_DECLS
 //#define GET_HUFFMAN_FREQUENCIES
 
+static const byte BDECL_VERSION = 1;
+static const unsigned int BDECL_MAGIC = ( 'B' << 24 ) | ( 'D' << 16 ) | ( 'C' << 8 ) | BDECL_VERSION;
+
 class idDeclType {
 public:
 	idStr						typeName;
@@ -129,6 +132,9 @@ protected:
 								// Set textSource possible with compression.
 	void						SetTextLocal( const char *text, const int length );
 
+								// Restores the decl from the binary decl cache of its source file.
+	bool						ReadBinaryLocal();
+
 private:
 	idDecl *					self;
 
@@ -153,14 +159,79 @@ private:
 	idDeclLocal *				nextInFile;				// next decl in the decl file
 };
 
+/*
+================================================
+declScanEntry_t is a decl found by the parallel scan of a decl file, with its text already
+checksummed and compressed the way idDeclLocal::SetTextLocal would do it.
+================================================
+*/
+struct declScanEntry_t {
+	declType_t					type;
+	idStr						name;
+	int							sourceTextOffset;
+	int							sourceTextLength;
+	int							sourceLine;
+	int							endLine;				// lexer line after the closing brace, for warnings
+	int							checksum;
+	char *						textSource;				// handed over to the decl by the merge
+	int							compressedLength;
+};
+
+/*
+================================================
+binaryDeclEntry_t is a decl in the binary decl cache of a decl file.
+================================================
+*/
+struct binaryDeclEntry_t {
+	declType_t					type;
+	idStr						name;
+	int							checksum;				// checksum of the decl text the entry was written from
+	int							offset;
+	int							length;
+};
+
+/*
+================================================
+declFileScan_t holds the text of a decl file that was loaded on the main thread and the
+results of scanning it on a job thread.
+================================================
+*/
+struct declFileScan_t {
+	const idDeclFile *			file;
+	char *						buffer;
+	int							length;
+	ID_TIME_T					timestamp;
+	int							checksum;
+	int							numLines;
+	bool						serial;					// the file needs a serial LoadAndParse to report warnings
+	idList< declScanEntry_t >	decls;
+};
+
 class idDeclFile {
 public:
 								idDeclFile();
 								idDeclFile( const char *fileName, declType_t defaultType );
+								~idDeclFile();
 
 	void						Reload( bool force );
+	bool						NeedsReload( bool force ) const;
 	int							LoadAndParse();
 
+								// finds and compresses the decls of an already loaded file, safe to run on a job thread
+	void						Scan( declFileScan_t & scan ) const;
+								// adds the scanned decls in file order, must run on the main thread
+	int							MergeScan( declFileScan_t & scan );
+
+								// finds the binary version of a decl, if the cache matches the loaded text
+	bool						FindBinaryDecl( declType_t type, const char *name, int declChecksum, const char *&data, int &length );
+								// parses all decls in the file and writes the binary decl cache, returns the number of decls written
+	int							WriteBinaryCache();
+	void						FreeBinaryCache();
+
+private:
+	void						LoadBinaryCache();
+	void						GetBinaryCacheName( idStr &generatedFileName ) const;
+
 public:
 	idStr						fileName;
 	declType_t					defaultType;
@@ -171,6 +242,12 @@ public:
 	int							numLines;
 
 	idDeclLocal *				decls;
+
+private:
+	bool						binaryLoaded;			// LoadBinaryCache was called since the text was loaded
+	char *						binaryBuffer;
+	idList< binaryDeclEntry_t >	binaryDecls;
+	idHashIndex					binaryHash;
 };
 
 class idDeclManagerLocal : public idDeclManager {
@@ -226,6 +303,9 @@ public:
 
 	void						ConvertPDAsToStrings( const idCmdArgs &args );
 
+								// loads a set of decl files, scanning their text in parallel
+	void						LoadAndParseFiles( const idList< idDeclFile * > & files );
+
 private:
 	idSysMutex					mutex;
 
@@ -243,14 +323,19 @@ private:
 	bool						insideLevelLoad;
 
 	static idCVar				decl_show;
+	static idCVar				decl_parallelParse;
+	static idCVar				decl_binaryLoad;
 
 private:
 	static void					ListDecls_f( const idCmdArgs &args );
 	static void					ReloadDecls_f( const idCmdArgs &args );
 	static void					TouchDecl_f( const idCmdArgs &args );
+	static void					BuildDeclCache_f( const idCmdArgs &args );
 };
 
 idCVar idDeclManagerLocal::decl_show( "decl_show", "0", CVAR_SYSTEM, "set to 1 to print parses, 2 to also print references", 0, 2, idCmdSystem::ArgCompletion_Integer<0,2> );
+idCVar idDeclManagerLocal::decl_binaryLoad( "decl_binaryLoad", "1", CVAR_SYSTEM | CVAR_BOOL, "restore decls from the binary decl cache written by buildDeclCache" );
+idCVar idDeclManagerLocal::decl_parallelParse( "decl_parallelParse", "1", CVAR_SYSTEM | CVAR_BOOL, "scan and compress decl files on the job threads" );
 
 idDeclManagerLocal	declManagerLocal;
 idDeclManager *		declManager = &declManagerLocal;
@@ -465,15 +550,15 @@ void ShutdownHuffman() {
 
 /*
 ================
-HuffmanCompressText
+HuffmanEncodeText
+
+Does not touch the compression statistics, so it can be used from job threads.
 ================
 */
-int HuffmanCompressText( const char *text, int textLength, byte *compressed, int maxCompressedSize ) {
+int HuffmanEncodeText( const char *text, int textLength, byte *compressed, int maxCompressedSize ) {
 	int i, j;
 	idBitMsg msg;
 
-	totalUncompressedLength += textLength;
-
 	msg.InitWrite( compressed, maxCompressedSize );
 	msg.BeginWriting();
 	for ( i = 0; i < textLength; i++ ) {
@@ -486,11 +571,23 @@ int HuffmanCompressText( const char *text, int textLength, byte *compressed, int
 		}
 	}
 
-	totalCompressedLength += msg.GetSize();
-
 	return msg.GetSize();
 }
 
+/*
+================
+HuffmanCompressText
+================
+*/
+int HuffmanCompressText( const char *text, int textLength, byte *compressed, int maxCompressedSize ) {
+	int compressedLength = HuffmanEncodeText( text, textLength, compressed, maxCompressedSize );
+
+	totalUncompressedLength += textLength;
+	totalCompressedLength += compressedLength;
+
+	return compressedLength;
+}
+
 /*
 ================
 HuffmanDecompressText
@@ -562,6 +659,8 @@ idDeclFile::idDeclFile( const char *fileName, declType_t defaultType ) {
 	this->fileSize = 0;
 	this->numLines = 0;
 	this->decls = NULL;
+	this->binaryLoaded = false;
+	this->binaryBuffer = NULL;
 }
 
 /*
@@ -577,6 +676,17 @@ idDeclFile::idDeclFile() {
 	this->fileSize = 0;
 	this->numLines = 0;
 	this->decls = NULL;
+	this->binaryLoaded = false;
+	this->binaryBuffer = NULL;
+}
+
+/*
+================
+idDeclFile::~idDeclFile
+================
+*/
+idDeclFile::~idDeclFile() {
+	FreeBinaryCache();
 }
 
 /*
@@ -587,18 +697,30 @@ ForceReload will cause it to reload even if the timestamp hasn't changed
 ================
 */
 void idDeclFile::Reload( bool force ) {
+	if ( !NeedsReload( force ) ) {
+		return;
+	}
+
+	// parse the text
+	LoadAndParse();
+}
+
+/*
+================
+idDeclFile::NeedsReload
+================
+*/
+bool idDeclFile::NeedsReload( bool force ) const {
 	// check for an unchanged timestamp
 	if ( !force && timestamp != 0 ) {
 		ID_TIME_T	testTimeStamp;
 		fileSystem->ReadFile( fileName, NULL, &testTimeStamp );
 
 		if ( testTimeStamp == timestamp ) {
-			return;
+			return false;
 		}
 	}
-
-	// parse the text
-	LoadAndParse();
+	return true;
 }
 
 /*
@@ -641,6 +763,9 @@ int idDeclFile::LoadAndParse() {
 		decl->redefinedInReload = false;
 	}
 
+	// the binary decl cache is checked against the new text the next time it is needed
+	FreeBinaryCache();
+
 	src.SetFlags( DECL_LEXER_FLAGS );
 
 	checksum = MD5_BlockChecksum( buffer, length );
@@ -784,6 +909,411 @@ int idDeclFile::LoadAndParse() {
 	return checksum;
 }
 
+/*
+================
+idDeclFile::Scan
+
+Identifies the declarations in text that was loaded on the main thread, and checksums and
+compresses each of them. Only the scan and read-only manager state are touched, so this is
+run on the job threads. Anything LoadAndParse would have warned about makes the file fall
+back to a serial LoadAndParse, so the warnings still come out in file order.
+================
+*/
+void idDeclFile::Scan( declFileScan_t & scan ) const {
+	idLexer		src;
+	idToken		token;
+	idStr		name;
+	idList< byte, TAG_DECLTEXT > compressed;
+
+	scan.serial = true;
+
+	if ( !src.LoadMemory( scan.buffer, scan.length, fileName ) ) {
+		return;
+	}
+
+	src.SetFlags( DECL_LEXER_FLAGS | LEXFL_NOWARNINGS | LEXFL_NOERRORS );
+
+	scan.checksum = MD5_BlockChecksum( scan.buffer, scan.length );
+
+	// scan through, identifying each individual declaration
+	while( 1 ) {
+
+		int startMarker = src.GetFileOffset();
+		int sourceLine = src.GetLineNum();
+
+		// parse the decl type name
+		if ( !src.ReadToken( &token ) ) {
+			break;
+		}
+
+		declType_t identifiedType = declManagerLocal.GetDeclTypeFromName( token );
+		if ( identifiedType == DECL_MAX_TYPES ) {
+			if ( token.Icmp( "{" ) == 0 || defaultType == DECL_MAX_TYPES ) {
+				// missing decl name or no type
+				return;
+			}
+			src.UnreadToken( &token );
+			// use the default type
+			identifiedType = defaultType;
+		}
+
+		// now parse the name
+		if ( !src.ReadToken( &token ) || token.Icmp( "{" ) == 0 ) {
+			return;
+		}
+
+		// export decls are skipped by LoadAndParse as well
+		if ( identifiedType == DECL_MODELEXPORT ) {
+			src.SkipBracedSection();
+			continue;
+		}
+
+		name = token;
+
+		// make sure there's a '{'
+		if ( !src.ReadToken( &token ) || token != "{" ) {
+			return;
+		}
+		src.UnreadToken( &token );
+
+		// now take everything until a matched closing brace
+		src.SkipBracedSection();
+		if ( src.HadError() || src.HadWarning() ) {
+			return;
+		}
+
+		declScanEntry_t & decl = scan.decls.Alloc();
+		decl.type = identifiedType;
+		decl.name = name;
+		decl.sourceTextOffset = startMarker;
+		decl.sourceTextLength = src.GetFileOffset() - startMarker;
+		decl.sourceLine = sourceLine;
+		decl.endLine = src.GetLineNum();
+
+		// same as idDeclLocal::SetTextLocal
+		const char * text = scan.buffer + decl.sourceTextOffset;
+		const int length = decl.sourceTextLength;
+
+		decl.checksum = MD5_BlockChecksum( text, length );
+
+#ifdef USE_COMPRESSED_DECLS
+		int maxBytesPerCode = ( maxHuffmanBits + 7 ) >> 3;
+		compressed.AssureSize( length * maxBytesPerCode );
+		decl.compressedLength = HuffmanEncodeText( text, length, compressed.Ptr(), length * maxBytesPerCode );
+		decl.textSource = (char *)Mem_Alloc( decl.compressedLength, TAG_DECLTEXT );
+		memcpy( decl.textSource, compressed.Ptr(), decl.compressedLength );
+#else
+		decl.compressedLength = length;
+		decl.textSource = (char *) Mem_Alloc( length + 1, TAG_DECLTEXT );
+		memcpy( decl.textSource, text, length );
+		decl.textSource[length] = '\0';
+#endif
+	}
+
+	if ( src.HadError() || src.HadWarning() ) {
+		return;
+	}
+
+	scan.numLines = src.GetLineNum();
+	scan.serial = false;
+}
+
+/*
+================
+idDeclFile::MergeScan
+
+Does what LoadAndParse does with the text of each declaration, using the results of Scan.
+================
+*/
+int idDeclFile::MergeScan( declFileScan_t & scan ) {
+	idDeclLocal *newDecl;
+	bool		reparse;
+
+	assert( scan.file == this && !scan.serial );
+
+	timestamp = scan.timestamp;
+
+	// mark all the defs that were from the last reload of this file
+	for ( idDeclLocal *decl = decls; decl; decl = decl->nextInFile ) {
+		decl->redefinedInReload = false;
+	}
+
+	// the binary decl cache is checked against the new text the next time it is needed
+	FreeBinaryCache();
+
+	checksum = scan.checksum;
+
+	fileSize = scan.length;
+
+	for ( int i = 0; i < scan.decls.Num(); i++ ) {
+		declScanEntry_t & decl = scan.decls[i];
+
+		// look it up, possibly getting a newly created default decl
+		reparse = false;
+		newDecl = declManagerLocal.FindTypeWithoutParsing( decl.type, decl.name, false );
+		if ( newDecl ) {
+			// update the existing copy
+			if ( newDecl->sourceFile != this || newDecl->redefinedInReload ) {
+				common->Warning( "file %s, line %d: %s '%s' previously defined at %s:%i", fileName.c_str(), decl.endLine,
+								declManagerLocal.GetDeclNameFromType( decl.type ), decl.name.c_str(), newDecl->sourceFile->fileName.c_str(), newDecl->sourceLine );
+				continue;
+			}
+			if ( newDecl->declState != DS_UNPARSED ) {
+				reparse = true;
+			}
+		} else {
+			// allow it to be created as a default, then add it to the per-file list
+			newDecl = declManagerLocal.FindTypeWithoutParsing( decl.type, decl.name, true );
+			newDecl->nextInFile = this->decls;
+			this->decls = newDecl;
+		}
+
+		newDecl->redefinedInReload = true;
+
+		if ( newDecl->textSource ) {
+			Mem_Free( newDecl->textSource );
+		}
+
+		newDecl->textSource = decl.textSource;
+		newDecl->textLength = decl.sourceTextLength;
+		newDecl->compressedLength = decl.compressedLength;
+		newDecl->checksum = decl.checksum;
+		decl.textSource = NULL;
+
+#ifdef USE_COMPRESSED_DECLS
+		totalUncompressedLength += decl.sourceTextLength;
+		totalCompressedLength += decl.compressedLength;
+#endif
+
+		newDecl->sourceFile = this;
+		newDecl->sourceTextOffset = decl.sourceTextOffset;
+		newDecl->sourceTextLength = decl.sourceTextLength;
+		newDecl->sourceLine = decl.sourceLine;
+		newDecl->declState = DS_UNPARSED;
+
+		// if it is currently in use, reparse it immedaitely
+		if ( reparse ) {
+			newDecl->ParseLocal();
+		}
+	}
+
+	numLines = scan.numLines;
+
+	// any defs that weren't redefinedInReload should now be defaulted
+	for ( idDeclLocal *decl = decls ; decl ; decl = decl->nextInFile ) {
+		if ( decl->redefinedInReload == false ) {
+			decl->MakeDefault();
+			decl->sourceTextOffset = decl->sourceFile->fileSize;
+			decl->sourceTextLength = 0;
+			decl->sourceLine = decl->sourceFile->numLines;
+		}
+	}
+
+	return checksum;
+}
+
+/*
+================
+ScanDeclFileJob
+================
+*/
+static void ScanDeclFileJob( declFileScan_t * scan ) {
+	scan->file->Scan( *scan );
+}
+
+REGISTER_PARALLEL_JOB( ScanDeclFileJob, "ScanDeclFileJob" );
+
+/*
+================
+idDeclFile::GetBinaryCacheName
+================
+*/
+void idDeclFile::GetBinaryCacheName( idStr &generatedFileName ) const {
+	generatedFileName = "generated/decls/";
+	generatedFileName.AppendPath( fileName );
+	generatedFileName += ".bdecl";
+}
+
+/*
+================
+idDeclFile::LoadBinaryCache
+
+The cache is only used if it was written from the same text, the decls are also checked
+one by one, because the text of a decl can be replaced with SetText.
+================
+*/
+void idDeclFile::LoadBinaryCache() {
+	FreeBinaryCache();
+	binaryLoaded = true;
+
+	if ( this == declManagerLocal.GetImplicitDeclFile() ) {
+		return;
+	}
+
+	idStr generatedFileName;
+	GetBinaryCacheName( generatedFileName );
+
+	int length = fileSystem->ReadFile( generatedFileName, (void **)&binaryBuffer, NULL );
+	if ( length <= 0 ) {
+		binaryBuffer = NULL;
+		return;
+	}
+
+	idFile_Memory file( generatedFileName, (const char *)binaryBuffer, length );
+
+	unsigned int magic = 0;
+	file.ReadBig( magic );
+	if ( magic != BDECL_MAGIC ) {
+		FreeBinaryCache();
+		return;
+	}
+
+	ID_TIME_T loadedTimestamp = 0;
+	int loadedChecksum = 0;
+	file.ReadBig( loadedTimestamp );
+	file.ReadBig( loadedChecksum );
+
+	// resource files don't keep the timestamps of the source files
+	if ( loadedChecksum != checksum || ( loadedTimestamp != timestamp && !fileSystem->InProductionMode() ) ) {
+		idLib::Printf( "%s is out of date\n", generatedFileName.c_str() );
+		FreeBinaryCache();
+		return;
+	}
+
+	// every entry has at least a type, a name length, a checksum and a length
+	int numDecls;
+	if ( !idDecl::ReadBinaryCount( &file, numDecls, 4 * sizeof( int ) ) ) {
+		idLib::Warning( "%s is corrupt", generatedFileName.c_str() );
+		FreeBinaryCache();
+		return;
+	}
+
+	binaryDecls.SetNum( numDecls );
+	binaryHash.Clear( 1024, numDecls );
+	for ( int i = 0; i < numDecls; i++ ) {
+		binaryDeclEntry_t & entry = binaryDecls[i];
+		int type = 0;
+		file.ReadBig( type );
+		bool validName = idDecl::ReadBinaryString( &file, entry.name );
+		file.ReadBig( entry.checksum );
+		if ( !validName || file.ReadBig( entry.length ) != sizeof( entry.length ) ) {
+			idLib::Warning( "%s is corrupt", generatedFileName.c_str() );
+			FreeBinaryCache();
+			return;
+		}
+		entry.type = (declType_t)type;
+		entry.offset = file.Tell();
+		if ( entry.length < 0 || entry.length > length - entry.offset ) {
+			idLib::Warning( "%s is corrupt", generatedFileName.c_str() );
+			FreeBinaryCache();
+			return;
+		}
+		file.Seek( entry.length, FS_SEEK_CUR );
+		binaryHash.Add( binaryHash.GenerateKey( entry.name, false ), i );
+	}
+}
+
+/*
+================
+idDeclFile::FreeBinaryCache
+================
+*/
+void idDeclFile::FreeBinaryCache() {
+	if ( binaryBuffer != NULL ) {
+		fileSystem->FreeFile( binaryBuffer );
+		binaryBuffer = NULL;
+	}
+	binaryDecls.Clear();
+	binaryHash.Free();
+	binaryLoaded = false;
+}
+
+/*
+================
+idDeclFile::FindBinaryDecl
+================
+*/
+bool idDeclFile::FindBinaryDecl( declType_t type, const char *name, int declChecksum, const char *&data, int &length ) {
+	if ( !binaryLoaded ) {
+		LoadBinaryCache();
+	}
+	if ( binaryBuffer == NULL ) {
+		return false;
+	}
+
+	int hash = binaryHash.GenerateKey( name, false );
+	for ( int i = binaryHash.First( hash ); i != -1; i = binaryHash.Next( i ) ) {
+		const binaryDeclEntry_t & entry = binaryDecls[i];
+		if ( entry.type == type && entry.name.Icmp( name ) == 0 ) {
+			if ( entry.checksum != declChecksum ) {
+				return false;
+			}
+			data = binaryBuffer + entry.offset;
+			length = entry.length;
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+================
+idDeclFile::WriteBinaryCache
+================
+*/
+int idDeclFile::WriteBinaryCache() {
+	idFile_Memory entries( "entries" );
+	int numDecls = 0;
+
+	for ( idDeclLocal *decl = decls; decl; decl = decl->nextInFile ) {
+		if ( decl->sourceFile != this || decl->textSource == NULL ) {
+			continue;
+		}
+
+		// make sure it is parsed
+		declManagerLocal.FindType( decl->type, decl->name, false );
+		if ( decl->declState != DS_PARSED ) {
+			continue;
+		}
+
+		idFile_Memory declFile( decl->name );
+		if ( !decl->self->WriteBinaryCache( &declFile ) ) {
+			continue;
+		}
+
+		entries.WriteBig( (int)decl->type );
+		entries.WriteString( decl->name );
+		entries.WriteBig( decl->checksum );
+		entries.WriteBig( (int)declFile.Length() );
+		entries.Write( declFile.GetDataPtr(), declFile.Length() );
+		numDecls++;
+	}
+
+	if ( numDecls == 0 ) {
+		return 0;
+	}
+
+	idStr generatedFileName;
+	GetBinaryCacheName( generatedFileName );
+
+	idFileLocal outputFile( fileSystem->OpenFileWrite( generatedFileName, "fs_basepath" ) );
+	if ( outputFile == NULL ) {
+		idLib::Warning( "couldn't write %s", generatedFileName.c_str() );
+		return 0;
+	}
+
+	outputFile->WriteBig( BDECL_MAGIC );
+	outputFile->WriteBig( timestamp );
+	outputFile->WriteBig( checksum );
+	outputFile->WriteBig( numDecls );
+	outputFile->Write( entries.GetDataPtr(), entries.Length() );
+
+	// pick up the new cache the next time a decl from this file is parsed
+	FreeBinaryCache();
+
+	return numDecls;
+}
+
 /*
 ====================================================================================
 
@@ -836,6 +1366,7 @@ void idDeclManagerLocal::Init() {
 
 	cmdSystem->AddCommand( "reloadDecls", ReloadDecls_f, CMD_FL_SYSTEM, "reloads decls" );
 	cmdSystem->AddCommand( "touch", TouchDecl_f, CMD_FL_SYSTEM, "touches a decl" );
+	cmdSystem->AddCommand( "buildDeclCache", BuildDeclCache_f, CMD_FL_SYSTEM, "parses all decls and writes the binary decl cache" );
 
 	cmdSystem->AddCommand( "listTables", idListDecls_f<DECL_TABLE>, CMD_FL_SYSTEM, "lists tables", idCmdSystem::ArgCompletion_String<listDeclStrings> );
 	cmdSystem->AddCommand( "listMaterials", idListDecls_f<DECL_MATERIAL>, CMD_FL_SYSTEM, "lists materials", idCmdSystem::ArgCompletion_String<listDeclStrings> );
@@ -924,9 +1455,13 @@ idDeclManagerLocal::Reload
 ===================
 */
 void idDeclManagerLocal::Reload( bool force ) {
+	idList< idDeclFile * > files;
 	for ( int i = 0; i < loadedFiles.Num(); i++ ) {
-		loadedFiles[i]->Reload( force );
+		if ( loadedFiles[i]->NeedsReload( force ) ) {
+			files.Append( loadedFiles[i] );
+		}
 	}
+	LoadAndParseFiles( files );
 }
 
 /*
@@ -995,6 +1530,7 @@ void idDeclManagerLocal::RegisterDeclFolder( const char *folder, const char *ext
 	idDeclFolder *declFolder;
 	idFileList *fileList;
 	idDeclFile *df;
+	idList< idDeclFile * > files;
 
 	// check whether this folder / extension combination already exists
 	for ( i = 0; i < declFolders.Num(); i++ ) {
@@ -1031,10 +1567,78 @@ void idDeclManagerLocal::RegisterDeclFolder( const char *folder, const char *ext
 			df = new (TAG_DECL) idDeclFile( fileName, defaultType );
 			loadedFiles.Append( df );
 		}
-		df->LoadAndParse();
+		files.AddUnique( df );
 	}
 
 	fileSystem->FreeFileList( fileList );
+
+	LoadAndParseFiles( files );
+}
+
+/*
+===================
+idDeclManagerLocal::LoadAndParseFiles
+
+The file system is not thread safe, so the files are read here and only the scanning of the
+text, which dominates the load time, is spread over the job threads. The results are merged
+back in file order, which gives the same decl indices and hash chains as loading the files one
+after the other. The decls themselves are still parsed on demand on the main thread, because
+parsing materials and skins touches the image manager and finds other decls.
+===================
+*/
+void idDeclManagerLocal::LoadAndParseFiles( const idList< idDeclFile * > & files ) {
+	int i, j;
+
+#ifndef GET_HUFFMAN_FREQUENCIES
+	if ( decl_parallelParse.GetBool() && files.Num() > 1 ) {
+		int start = Sys_Milliseconds();
+
+		idList< declFileScan_t > scans;
+		scans.SetNum( files.Num() );
+
+		for ( i = 0; i < files.Num(); i++ ) {
+			declFileScan_t & scan = scans[i];
+			common->DPrintf( "...loading '%s'\n", files[i]->fileName.c_str() );
+			scan.file = files[i];
+			scan.length = fileSystem->ReadFile( files[i]->fileName, (void **)&scan.buffer, &scan.timestamp );
+			if ( scan.length == -1 ) {
+				common->FatalError( "couldn't load %s", files[i]->fileName.c_str() );
+				return;
+			}
+		}
+
+		idParallelJobList * scanJobs = parallelJobManager->AllocJobList( JOBLIST_UTILITY, JOBLIST_PRIORITY_MEDIUM, files.Num(), 0, NULL );
+		for ( i = 0; i < scans.Num(); i++ ) {
+			scanJobs->AddJob( (jobRun_t)ScanDeclFileJob, &scans[i] );
+		}
+		scanJobs->Submit();
+		scanJobs->Wait();
+		parallelJobManager->FreeJobList( scanJobs );
+
+		int numSerial = 0;
+		for ( i = 0; i < scans.Num(); i++ ) {
+			declFileScan_t & scan = scans[i];
+			if ( scan.serial ) {
+				files[i]->LoadAndParse();
+				numSerial++;
+			} else {
+				files[i]->MergeScan( scan );
+			}
+			// free the text of redefined decls and of files that were parsed serially
+			for ( j = 0; j < scan.decls.Num(); j++ ) {
+				Mem_Free( scan.decls[j].textSource );
+			}
+			fileSystem->FreeFile( scan.buffer );
+		}
+
+		common->DPrintf( "loaded %d decl files in %d msec, %d parsed serially\n", files.Num(), Sys_Milliseconds() - start, numSerial );
+		return;
+	}
+#endif
+
+	for ( i = 0; i < files.Num(); i++ ) {
+		files[i]->LoadAndParse();
+	}
 }
 
 /*
@@ -1717,6 +2321,26 @@ void idDeclManagerLocal::TouchDecl_f( const idCmdArgs &args ) {
 	}
 }
 
+/*
+===================
+idDeclManagerLocal::BuildDeclCache_f
+===================
+*/
+void idDeclManagerLocal::BuildDeclCache_f( const idCmdArgs &args ) {
+	int numFiles = 0;
+	int numDecls = 0;
+
+	for ( int i = 0; i < declManagerLocal.loadedFiles.Num(); i++ ) {
+		int n = declManagerLocal.loadedFiles[i]->WriteBinaryCache();
+		if ( n > 0 ) {
+			numFiles++;
+			numDecls += n;
+		}
+	}
+
+	common->Printf( "wrote %d decls to %d binary decl cache files\n", numDecls, numFiles );
+}
+
 /*
 ===================
 idDeclManagerLocal::FindTypeWithoutParsing
@@ -2389,10 +3013,12 @@ void idDeclLocal::ParseLocal() {
 
 	declState = DS_PARSED;
 
-	// parse
-	char *declText = (char *) _alloca( ( GetTextLength() + 1 ) * sizeof( char ) );
-	GetText( declText );
-	self->Parse( declText, GetTextLength(), true );
+	// restore it from the binary decl cache, or parse the text
+	if ( generatedDefaultText || !ReadBinaryLocal() ) {
+		char *declText = (char *) _alloca( ( GetTextLength() + 1 ) * sizeof( char ) );
+		GetText( declText );
+		self->Parse( declText, GetTextLength(), true );
+	}
 
 	// free generated text
 	if ( generatedDefaultText ) {
@@ -2404,6 +3030,34 @@ void idDeclLocal::ParseLocal() {
 	declManagerLocal.indent--;
 }
 
+/*
+=================
+idDeclLocal::ReadBinaryLocal
+=================
+*/
+bool idDeclLocal::ReadBinaryLocal() {
+	if ( !declManagerLocal.decl_binaryLoad.GetBool() ) {
+		return false;
+	}
+
+	const char *data;
+	int length;
+	if ( !sourceFile->FindBinaryDecl( type, name, checksum, data, length ) ) {
+		return false;
+	}
+
+	// the decl has to read back exactly what was written for it
+	idFile_Memory file( name, data, length );
+	if ( self->ReadBinaryCache( &file ) && file.Tell() == file.Length() ) {
+		return true;
+	}
+
+	// the text parse starts from scratch
+	common->Warning( "binary %s '%s' in %s is corrupt, parsing the text", declManagerLocal.GetDeclNameFromType( type ), name.c_str(), sourceFile->fileName.c_str() );
+	self->FreeData();
+	return false;
+}
+
 /*
 =================
 idDeclLocal::Purge
@@ -232,10 +232,46 @@ public:
 							// explicit data.
 	virtual void			Print() const { base->Print(); }
 
+							// Writes the parsed decl to the binary decl cache, so a later load can
+							// restore it with ReadBinaryCache() instead of lexing the text. Other decls
+							// and media should be written by name. Returns false if the decl type has
+							// no binary version.
+	virtual bool			WriteBinaryCache( idFile *file ) const { return false; }
+
+							// Restores a decl written by WriteBinaryCache(), touching the same media
+							// Parse() would have. The manager will have called FreeData() first, and
+							// falls back to Parse() if this returns false.
+	virtual bool			ReadBinaryCache( idFile *file ) { return false; }
+
+							// Reads a count written with WriteBig() for ReadBinaryCache(), returns false
+							// if it is negative or more items of at least minItemSize bytes than are left.
+	static bool				ReadBinaryCount( idFile *file, int &count, int minItemSize );
+
+							// Reads a string written with WriteString() for ReadBinaryCache(), returns false
+							// if it runs past the end of the file.
+	static bool				ReadBinaryString( idFile *file, idStr &string );
+
 public:
 	idDeclBase *			base;
 };
 
+ID_INLINE bool idDecl::ReadBinaryCount( idFile *file, int &count, int minItemSize ) {
+	count = 0;
+	if ( file->ReadBig( count ) != sizeof( count ) || count < 0 ) {
+		return false;
+	}
+	return count <= ( file->Length() - file->Tell() ) / minItemSize;
+}
+
+ID_INLINE bool idDecl::ReadBinaryString( idFile *file, idStr &string ) {
+	int len = 0;
+	if ( file->ReadInt( len ) != sizeof( len ) || len < 0 || len > file->Length() - file->Tell() ) {
+		return false;
+	}
+	string.Fill( ' ', len );
+	return file->Read( &string[0], len ) == len;
+}
+
 
 template< class type >
 ID_INLINE idDecl *idDeclAllocator() {
@@ -99,6 +99,66 @@ bool idDeclSkin::Parse( const char *text, const int textLength, bool allowBinary
 	return false;
 }
 
+/*
+================
+idDeclSkin::WriteBinaryCache
+================
+*/
+bool idDeclSkin::WriteBinaryCache( idFile *file ) const {
+	file->WriteBig( associatedModels.Num() );
+	for ( int i = 0; i < associatedModels.Num(); i++ ) {
+		file->WriteString( associatedModels[i] );
+	}
+	file->WriteBig( mappings.Num() );
+	for ( int i = 0; i < mappings.Num(); i++ ) {
+		// an empty name is the wildcard
+		file->WriteString( mappings[i].from != NULL ? mappings[i].from->GetName() : "" );
+		file->WriteString( mappings[i].to->GetName() );
+	}
+	return true;
+}
+
+/*
+================
+idDeclSkin::ReadBinaryCache
+================
+*/
+bool idDeclSkin::ReadBinaryCache( idFile *file ) {
+	int num = 0;
+	idStr name;
+
+	associatedModels.Clear();
+
+	if ( !ReadBinaryCount( file, num, sizeof( int ) ) ) {
+		return false;
+	}
+	for ( int i = 0; i < num; i++ ) {
+		if ( !ReadBinaryString( file, name ) ) {
+			return false;
+		}
+		associatedModels.Append( name );
+	}
+
+	if ( !ReadBinaryCount( file, num, 2 * sizeof( int ) ) ) {
+		return false;
+	}
+	for ( int i = 0; i < num; i++ ) {
+		skinMapping_t	map;
+
+		if ( !ReadBinaryString( file, name ) ) {
+			return false;
+		}
+		map.from = name.IsEmpty() ? NULL : declManager->FindMaterial( name );
+		if ( !ReadBinaryString( file, name ) ) {
+			return false;
+		}
+		map.to = declManager->FindMaterial( name );
+
+		mappings.Append( map );
+	}
+	return true;
+}
+
 /*
 ================
 idDeclSkin::SetDefaultText
@@ -49,6 +49,8 @@ public:
 	virtual const char *	DefaultDefinition() const;
 	virtual bool			Parse( const char *text, const int textLength, bool allowBinaryVersion );
 	virtual void			FreeData();
+	virtual bool			WriteBinaryCache( idFile *file ) const;
+	virtual bool			ReadBinaryCache( idFile *file );
 
 	const idMaterial *		RemapShaderBySkin( const idMaterial *shader ) const;
 
@@ -175,3 +175,33 @@ bool idDeclTable::Parse( const char *text, const int textLength, bool allowBinar
 
 	return true;
 }
+
+/*
+=================
+idDeclTable::WriteBinaryCache
+=================
+*/
+bool idDeclTable::WriteBinaryCache( idFile *file ) const {
+	file->WriteBool( clamp );
+	file->WriteBool( snap );
+	file->WriteBig( values.Num() );
+	file->WriteBigArray( values.Ptr(), values.Num() );
+	return true;
+}
+
+/*
+=================
+idDeclTable::ReadBinaryCache
+=================
+*/
+bool idDeclTable::ReadBinaryCache( idFile *file ) {
+	int numValues = 0;
+	file->ReadBool( clamp );
+	file->ReadBool( snap );
+	if ( !ReadBinaryCount( file, numValues, sizeof( float ) ) || numValues < 2 ) {
+		return false;
+	}
+	values.SetNum( numValues );
+	file->ReadBigArray( values.Ptr(), numValues );
+	return true;
+}
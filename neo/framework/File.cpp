@@ -241,6 +241,18 @@ int idFile::Seek( long offset, fsOrigin_t origin ) {
 	return -1;
 }
 
+/*
+=================
+idFile::ReadAt
+=================
+*/
+int idFile::ReadAt( void *buffer, int len, int64 offset ) {
+	if ( Seek( (long)offset, FS_SEEK_SET ) != 0 ) {
+		return 0;
+	}
+	return Read( buffer, len );
+}
+
 /*
 =================
 idFile::Rewind
@@ -725,6 +737,28 @@ int idFile_Memory::Read( void *buffer, int len ) {
 	return len;
 }
 
+/*
+=================
+idFile_Memory::ReadAt
+=================
+*/
+int idFile_Memory::ReadAt( void *buffer, int len, int64 offset ) {
+
+	if ( !( mode & ( 1 << FS_READ ) ) ) {
+		common->FatalError( "idFile_Memory::ReadAt: %s not opened in read mode", name.c_str() );
+		return 0;
+	}
+
+	if ( offset < 0 || offset >= (int64)fileSize ) {
+		return 0;
+	}
+	if ( offset + len > (int64)fileSize ) {
+		len = (int)( fileSize - offset );
+	}
+	memcpy( buffer, filePtr + offset, len );
+	return len;
+}
+
 idCVar memcpyImpl( "memcpyImpl", "0", 0, "Which implementation of memcpy to use for idFile_Memory::Write() [0/1 - standard (1 eliminates branch misprediction), 2 - auto-vectorized]" );
 void * memcpy2( void * __restrict b, const void * __restrict a, size_t n ) {
 	char * s1 = (char *)b;
@@ -1222,6 +1256,48 @@ int idFile_Permanent::Read( void *buffer, int len ) {
 	return len;
 }
 
+/*
+=================
+idFile_Permanent::ReadAt
+
+Reads at an explicit offset, so several threads can read the same handle at once
+=================
+*/
+int idFile_Permanent::ReadAt( void *buffer, int len, int64 offset ) {
+	if ( !(mode & ( 1 << FS_READ ) ) ) {
+		common->FatalError( "idFile_Permanent::ReadAt: %s not opened in read mode", name.c_str() );
+		return 0;
+	}
+
+	if ( !o ) {
+		return 0;
+	}
+
+	byte * buf = (byte *)buffer;
+	int remaining = len;
+	while ( remaining > 0 ) {
+		OVERLAPPED overlapped;
+		memset( &overlapped, 0, sizeof( overlapped ) );
+		overlapped.Offset = (DWORD)( offset & 0xFFFFFFFF );
+		overlapped.OffsetHigh = (DWORD)( offset >> 32 );
+
+		DWORD bytesRead = 0;
+		if ( !ReadFile( o, buf, remaining, &bytesRead, &overlapped ) ) {
+			if ( GetLastError() != ERROR_HANDLE_EOF ) {
+				idLib::Warning( "idFile_Permanent::ReadAt failed with %d from %s", GetLastError(), name.c_str() );
+			}
+			break;
+		}
+		if ( bytesRead == 0 ) {
+			break;
+		}
+		remaining -= bytesRead;
+		buf += bytesRead;
+		offset += bytesRead;
+	}
+	return len - remaining;
+}
+
 /*
 =================
 idFile_Permanent::Write
@@ -1599,7 +1675,7 @@ idFile_InnerResource
 idFile_InnerResource::idFile_InnerResource
 =================
 */
-idFile_InnerResource::idFile_InnerResource( const char *_name, idFile *rezFile, int _offset, int _len ) {
+idFile_InnerResource::idFile_InnerResource( const char *_name, idFile *rezFile, int64 _offset, int _len ) {
 	name = _name;
 	offset = _offset;
 	length = _len;
@@ -1635,15 +1711,13 @@ int idFile_InnerResource::Read( void *buffer, int len ) {
 		len = length - internalFilePos;
 	}
 
-	int read = 0; //fileSystem->ReadFromBGL( resourceFile, (byte*)buffer, offset + internalFilePos, len );
-
-	if ( read != len ) {
-		if ( resourceBuffer != NULL ) {
-			memcpy( buffer, &resourceBuffer[ internalFilePos ], len );
-			read = len;
-		} else {
-			read = fileSystem->ReadFromBGL( resourceFile, buffer, offset + internalFilePos, len );
-		}
+	int read = 0;
+	if ( resourceBuffer != NULL ) {
+		memcpy( buffer, &resourceBuffer[ internalFilePos ], len );
+		read = len;
+	} else {
+		// positional, so other inner files of the same container can be read at the same time
+		read = resourceFile->ReadAt( buffer, len, offset + internalFilePos );
 	}
 
 	internalFilePos += read;
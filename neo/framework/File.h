@@ -70,6 +70,9 @@ public:
 	virtual void			Flush();
 							// Seek on a file.
 	virtual int				Seek( long offset, fsOrigin_t origin );
+							// Read data from the given offset, independent of the file offset. Thread safe for
+							// permanent and memory files, other files fall back to a seek and a read.
+	virtual int				ReadAt( void *buffer, int len, int64 offset );
 							// Go back to the beginning of the file.
 	virtual void			Rewind();
 							// Like fprintf.
@@ -164,6 +167,7 @@ public:
 	virtual void			ForceFlush();
 	virtual void			Flush();
 	virtual int				Seek( long offset, fsOrigin_t origin );
+	virtual int				ReadAt( void *buffer, int len, int64 offset );
 
 	// Set the given length and don't allow the file to grow.
 	void					SetMaxLength( size_t len );
@@ -248,6 +252,8 @@ public:
 	virtual void			ForceFlush();
 	virtual void			Flush();
 	virtual int				Seek( long offset, fsOrigin_t origin );
+	// the read moves the file offset, so don't mix it with Seek and Read from other threads
+	virtual int				ReadAt( void *buffer, int len, int64 offset );
 
 	// returns file pointer
 	idFileHandle			GetFilePtr() { return o; }
@@ -313,7 +319,7 @@ class idFile_InnerResource : public idFile {
 	friend class			idFileSystemLocal;
 
 public:
-							idFile_InnerResource( const char *_name, idFile *rezFile, int _offset, int _len );
+							idFile_InnerResource( const char *_name, idFile *rezFile, int64 _offset, int _len );
 	virtual					~idFile_InnerResource();
 
 	virtual const char *	GetName() const { return name.c_str(); }
@@ -331,7 +337,7 @@ public:
 
 private:
 	idStr				name;				// name of the file in the pak
-	int					offset;				// offset in the resource file
+	int64				offset;				// offset in the resource file
 	int					length;				// size
 	idFile *			resourceFile;		// actual file
 	int					internalFilePos;	// seek offset
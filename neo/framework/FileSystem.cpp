@@ -31,6 +31,7 @@ If you have questions concerning this license or the applicable additional terms
 
 #include "Unzip.h"
 #include "Zip.h"
+#include "File_Preload.h"
 
 #ifdef WIN32
 	#include <io.h>	// for _read
@@ -184,7 +185,8 @@ public:
 	virtual int				ReadFromBGL( idFile *_resourceFile, void * _buffer, int _offset, int _len );
 	virtual bool			IsBinaryModel( const idStr & resName ) const;
 	virtual bool			IsSoundSample( const idStr & resName ) const;
-	virtual void			FreeResourceBuffer() { resourceBufferAvailable = resourceBufferSize; }
+	virtual void			FreeResourceBuffer() { idScopedCriticalSection lock( resourceBufferLock ); resourceBufferAvailable = resourceBufferSize; }
+	virtual const byte *	ReadFileMapped( const char *relativePath, int &length );
 	virtual void			AddImagePreload( const char *resName, int _filter, int _repeat, int _usage, int _cube ) {
 		preloadList.AddImage( resName, _filter, _repeat, _usage, _cube );
 	}
@@ -216,6 +218,7 @@ public:
 	static void				UpdateResourceFile_f( const idCmdArgs &args );
 	static void				GenerateResourceCRCs_f( const idCmdArgs &args );
 	static void				CreateCRCsForResourceFileList( const idFileList & list );
+	static void				TestResourceReads_f( const idCmdArgs &args );
 
 	void					BuildOrderedStartupContainer();
 private:
@@ -238,9 +241,11 @@ private:
 	idPreloadManifest		preloadList;
 
 	idList< idResourceContainer * > resourceFiles;
+	idResourcePreloader		preloader;
 	byte *	resourceBufferPtr;
 	int		resourceBufferSize;
 	int		resourceBufferAvailable;
+	idSysMutex	resourceBufferLock;		// loaders on several threads compete for the resource buffer
 	int		numFilesOpenedAsCached;
 
 private:
@@ -290,6 +295,7 @@ idCVar  fs_devpath("fs_devpath", "", CVAR_SYSTEM | CVAR_INIT, "");
 idCVar	fs_savepath( "fs_savepath", "", CVAR_SYSTEM | CVAR_INIT, "" );
 idCVar	fs_resourceLoadPriority( "fs_resourceLoadPriority", "0", CVAR_SYSTEM , "if 1, open requests will be honored from resource files first; if 0, the resource files are checked after normal search paths" );
 idCVar	fs_enableBackgroundCaching( "fs_enableBackgroundCaching", "1", CVAR_SYSTEM , "if 1 allow the 360 to precache game files in the background" );
+idCVar	fs_preloadCacheSize( "fs_preloadCacheSize", "64", CVAR_SYSTEM | CVAR_INTEGER, "megabytes the level load preload may read ahead of the loaders, 0 disables the preload" );
 
 idFileSystemLocal	fileSystemLocal;
 idFileSystem *		fileSystem = &fileSystemLocal;
@@ -300,10 +306,7 @@ idFileSystemLocal::ReadFromBGL
 ================
 */
 int idFileSystemLocal::ReadFromBGL( idFile *_resourceFile, void * _buffer, int _offset, int _len ) {
-	if ( _resourceFile->Tell() != _offset ) {
-		_resourceFile->Seek( _offset, FS_SEEK_SET );
-	}
-	return _resourceFile->Read( _buffer, _len );
+	return _resourceFile->ReadAt( _buffer, _len, _offset );
 }
 
 /*
@@ -312,6 +315,22 @@ idFileSystemLocal::StartPreload
 ================
 */
 void idFileSystemLocal::StartPreload( const idStrList & _preload ) {
+	StopPreload();
+
+	const int cacheSize = fs_preloadCacheSize.GetInteger() * 1024 * 1024;
+	if ( cacheSize <= 0 || resourceFiles.Num() == 0 ) {
+		return;
+	}
+
+	idList< idResourceCacheEntry > entries;
+	entries.Resize( _preload.Num() );
+	for ( int i = 0; i < _preload.Num(); i++ ) {
+		idResourceCacheEntry rc;
+		if ( GetResourceCacheEntry( _preload[ i ], rc ) ) {
+			entries.Append( rc );
+		}
+	}
+	preloader.Start( resourceFiles, entries, cacheSize );
 }
 
 /*
@@ -320,6 +339,7 @@ idFileSystemLocal::StopPreload
 ================
 */
 void idFileSystemLocal::StopPreload() {
+	preloader.Stop();
 }
 
 /*
@@ -533,7 +553,17 @@ void idFileSystemLocal::BeginLevelLoad( const char *name, char *_blockBuffer, in
 	manifestName.StripPath();
 	
 	if ( resourceFiles.Num() > 0 ) {
-		AddResourceFile( va( "%s.resources", manifestName.c_str() ) );
+		const int idx = AddResourceFile( va( "%s.resources", manifestName.c_str() ) );
+		if ( idx >= 0 ) {
+			// the map container was written in the order the level load opens its files
+			const idList< idResourceCacheEntry, TAG_RESOURCE > & cacheTable = resourceFiles[ idx ]->cacheTable;
+			idStrList preloadFiles;
+			preloadFiles.SetNum( cacheTable.Num() );
+			for ( int i = 0; i < cacheTable.Num(); i++ ) {
+				preloadFiles[ i ] = cacheTable[ i ].filename;
+			}
+			StartPreload( preloadFiles );
+		}
 	}
 
 }
@@ -573,6 +603,8 @@ idFileSystemLocal::EndLevelLoad
 =================	
 */
 void idFileSystemLocal::EndLevelLoad() {
+	StopPreload();
+
 	if ( fs_buildResources.GetBool() ) {
 		int saveCopyFiles = fs_copyfiles.GetInteger();
 		fs_copyfiles.SetInteger( 0 );
@@ -2267,6 +2299,9 @@ void idFileSystemLocal::GenerateResourceCRCs_f( const idCmdArgs &args ) {
 	idLib::Printf( "Done generating CRCs for resource files.\n" );
 }
 
+static const uint32 CRC_FILE_MAGIC = 0xCC00CC00; // I just made this up, it has no meaning.
+static const uint32 CRC_FILE_VERSION = 1;
+
 /*
 ================
 idFileSystemLocal::CreateCRCsForResourceFileList
@@ -2276,46 +2311,26 @@ void idFileSystemLocal::CreateCRCsForResourceFileList( const idFileList & list )
 	for ( int fileIndex = 0; fileIndex < list.GetNumFiles(); ++fileIndex ) {
 		idLib::Printf( " Processing %s.\n", list.GetFile( fileIndex ) );
 
-		std::auto_ptr<idFile_Memory> currentFile( static_cast<idFile_Memory *>( fileSystem->OpenFileReadMemory( list.GetFile( fileIndex ) ) ) );
-
-		if ( currentFile.get() == NULL ) {
+		// the container reads both the plain and the compressed format
+		idResourceContainer container;
+		if ( !container.Open( list.GetFile( fileIndex ) ) ) {
 			idLib::Printf( " Error reading %s.\n", list.GetFile( fileIndex ) );
 			continue;
 		}
 
-		uint32 resourceMagic;
-		currentFile->ReadBig( resourceMagic );
-
-		if ( resourceMagic != RESOURCE_FILE_MAGIC ) {
-			idLib::Printf( "Resource file magic number doesn't match, skipping %s.\n", list.GetFile( fileIndex ) );
-			continue;
-		}
-
-		int tableOffset;
-		currentFile->ReadBig( tableOffset );
-
-		int tableLength;
-		currentFile->ReadBig( tableLength );
-
-		// Read in the table
-		currentFile->Seek( tableOffset, FS_SEEK_SET );
+		const idList< idResourceCacheEntry, TAG_RESOURCE > & cacheEntries = container.cacheTable;
+		const int numFileResources = cacheEntries.Num();
 
-		int numFileResources;
-		currentFile->ReadBig( numFileResources );
-
-		idList< idResourceCacheEntry > cacheEntries;
-		cacheEntries.SetNum( numFileResources );
-
-		for ( int innerFileIndex = 0; innerFileIndex < numFileResources; ++innerFileIndex ) {
-			cacheEntries[innerFileIndex].Read( currentFile.get() );
-		}
-
-		// All tables read, now seek to each one and calculate the CRC.
+		// All tables read, now read each one and calculate the CRC.
 		idTempArray< unsigned long > innerFileCRCs( numFileResources );
+		idList< byte > innerFileData;
 		for ( int innerFileIndex = 0; innerFileIndex < numFileResources; ++innerFileIndex ) {
-			const char * innerFileDataBegin = currentFile->GetDataPtr() + cacheEntries[innerFileIndex].offset;
+			innerFileData.SetNum( Max( cacheEntries[innerFileIndex].length, 1 ) );
+			if ( !container.ReadResource( cacheEntries[innerFileIndex], innerFileData.Ptr() ) ) {
+				idLib::Printf( " Error reading %s from %s.\n", cacheEntries[innerFileIndex].filename.c_str(), list.GetFile( fileIndex ) );
+			}
 
-			innerFileCRCs[innerFileIndex] = CRC32_BlockChecksum( innerFileDataBegin, cacheEntries[innerFileIndex].length );
+			innerFileCRCs[innerFileIndex] = CRC32_BlockChecksum( innerFileData.Ptr(), cacheEntries[innerFileIndex].length );
 		}
 
 		// Get the CRC for all the CRCs.
@@ -2330,8 +2345,6 @@ void idFileSystemLocal::CreateCRCsForResourceFileList( const idFileList & list )
 			continue;
 		}
 		
-		const uint32 CRC_FILE_MAGIC = 0xCC00CC00; // I just made this up, it has no meaning.
-		const uint32 CRC_FILE_VERSION = 1;
 		crcOutputFile->WriteBig( CRC_FILE_MAGIC );
 		crcOutputFile->WriteBig( CRC_FILE_VERSION );
 		crcOutputFile->WriteBig( totalCRC );
@@ -2340,6 +2353,150 @@ void idFileSystemLocal::CreateCRCsForResourceFileList( const idFileList & list )
 	}
 }
 
+/*
+================================================
+idResourceReadThread reads all the files of a resource container in a random order and checks
+their CRCs. Plain containers are read through idFile_InnerResource in random sized chunks,
+compressed ones are decompressed whole.
+================================================
+*/
+class idResourceReadThread : public idSysThread {
+public:
+	const idResourceContainer *	container;
+	idFile *				resourceFile;
+	const idList< idResourceCacheEntry, TAG_RESOURCE > * entries;
+	const unsigned long *	expectedCRCs;
+	int						passes;
+	int						seed;
+
+	int						numMismatches;
+	int						firstMismatch;
+	int64					bytesRead;
+
+	virtual int Run() {
+		idRandom random( seed );
+		idList< int > order;
+		order.SetNum( entries->Num() );
+		for ( int i = 0; i < order.Num(); i++ ) {
+			order[ i ] = i;
+		}
+		idList< byte > buffer;
+
+		numMismatches = 0;
+		firstMismatch = -1;
+		bytesRead = 0;
+		for ( int pass = 0; pass < passes; pass++ ) {
+			for ( int i = order.Num() - 1; i > 0; i-- ) {
+				SwapValues( order[ i ], order[ random.RandomInt( i + 1 ) ] );
+			}
+			for ( int i = 0; i < order.Num(); i++ ) {
+				const idResourceCacheEntry & rc = (*entries)[ order[ i ] ];
+				buffer.SetNum( Max( rc.length, 1 ) );
+
+				int pos = 0;
+				if ( container->IsCompressed() ) {
+					// compressed resources are always decompressed whole
+					pos = container->ReadResource( rc, buffer.Ptr() ) ? rc.length : 0;
+				} else {
+					idFile_InnerResource file( rc.filename, resourceFile, rc.offset, rc.length );
+					while ( pos < rc.length ) {
+						const int read = file.Read( buffer.Ptr() + pos, Min( rc.length - pos, 1 + random.RandomInt( 64 * 1024 ) ) );
+						if ( read <= 0 ) {
+							break;
+						}
+						pos += read;
+					}
+				}
+				bytesRead += pos;
+
+				if ( pos != rc.length || CRC32_BlockChecksum( buffer.Ptr(), rc.length ) != expectedCRCs[ order[ i ] ] ) {
+					if ( numMismatches++ == 0 ) {
+						firstMismatch = order[ i ];
+					}
+				}
+			}
+		}
+		return 0;
+	}
+};
+
+/*
+================
+idFileSystemLocal::TestResourceReads_f
+
+Reads the loaded resource containers from many threads at once and checks every file
+against the CRCs written by generateResourceCRCs.
+================
+*/
+void idFileSystemLocal::TestResourceReads_f( const idCmdArgs &args ) {
+	const int numThreads = ( args.Argc() > 1 ) ? idMath::ClampInt( 1, 64, atoi( args.Argv( 1 ) ) ) : 16;
+	const int passes = ( args.Argc() > 2 ) ? Max( 1, atoi( args.Argv( 2 ) ) ) : 2;
+
+	int numFailed = 0;
+	for ( int c = 0; c < fileSystemLocal.resourceFiles.Num(); c++ ) {
+		idResourceContainer * container = fileSystemLocal.resourceFiles[ c ];
+		const idList< idResourceCacheEntry, TAG_RESOURCE > & entries = container->cacheTable;
+
+		idStr crcFilename = container->GetFileName();
+		crcFilename.SetFileExtension( ".crc" );
+		idFileLocal crcFile( fileSystem->OpenFileRead( crcFilename ) );
+		if ( crcFile == NULL ) {
+			idLib::Printf( "%s: no %s, run generateResourceCRCs first\n", container->GetFileName(), crcFilename.c_str() );
+			continue;
+		}
+		uint32 magic = 0;
+		uint32 version = 0;
+		unsigned long totalCRC = 0;
+		int numFileResources = 0;
+		crcFile->ReadBig( magic );
+		crcFile->ReadBig( version );
+		crcFile->ReadBig( totalCRC );
+		crcFile->ReadBig( numFileResources );
+		if ( magic != CRC_FILE_MAGIC || version != CRC_FILE_VERSION || numFileResources != entries.Num() ) {
+			idLib::Printf( "%s: %s doesn't match the container\n", container->GetFileName(), crcFilename.c_str() );
+			numFailed++;
+			continue;
+		}
+		idTempArray< unsigned long > expectedCRCs( numFileResources );
+		crcFile->ReadBigArray( expectedCRCs.Ptr(), numFileResources );
+
+		idList< idResourceReadThread * > threads;
+		threads.SetNum( numThreads );
+		const int startTime = Sys_Milliseconds();
+		for ( int i = 0; i < numThreads; i++ ) {
+			threads[ i ] = new (TAG_RESOURCE) idResourceReadThread;
+			threads[ i ]->container = container;
+			threads[ i ]->resourceFile = container->resourceFile;
+			threads[ i ]->entries = &entries;
+			threads[ i ]->expectedCRCs = expectedCRCs.Ptr();
+			threads[ i ]->passes = passes;
+			threads[ i ]->seed = i + 1;
+			threads[ i ]->StartThread( va( "ResourceRead%d", i ), CORE_ANY );
+		}
+
+		int numMismatches = 0;
+		int64 bytesRead = 0;
+		for ( int i = 0; i < numThreads; i++ ) {
+			threads[ i ]->WaitForThread();
+			if ( threads[ i ]->numMismatches > 0 ) {
+				idLib::Printf( "%s: thread %d read %d files wrong, first was %s\n", container->GetFileName(), i,
+					threads[ i ]->numMismatches, entries[ threads[ i ]->firstMismatch ].filename.c_str() );
+			}
+			numMismatches += threads[ i ]->numMismatches;
+			bytesRead += threads[ i ]->bytesRead;
+		}
+		threads.DeleteContents();
+		const int msec = Max( Sys_Milliseconds() - startTime, 1 );
+
+		idLib::Printf( "%s: %d files x %d threads x %d passes, %d mismatches, %.1f MB/s\n", container->GetFileName(),
+			entries.Num(), numThreads, passes, numMismatches, ( bytesRead / ( 1024.0 * 1024.0 ) ) * 1000.0 / msec );
+		if ( numMismatches > 0 ) {
+			numFailed++;
+		}
+	}
+	idLib::Printf( numFailed == 0 ? "testResourceReads passed\n" : "testResourceReads FAILED on %d containers\n", numFailed );
+}
+
 /*
 ================
 idFileSystemLocal::AddResourceFile
@@ -2376,6 +2533,8 @@ idFileSystemLocal::RemoveResourceFileByIndex
 */
 void idFileSystemLocal::RemoveResourceFileByIndex( const int &idx ) {
 	if ( idx >= 0 && idx < resourceFiles.Num() ) {
+		// the preloader keeps the container indexes
+		StopPreload();
 		if ( idx >= 0 && idx < resourceFiles.Num() ) {
 			delete resourceFiles[ idx ];
 			resourceFiles.RemoveIndex( idx );
@@ -2569,6 +2728,7 @@ void idFileSystemLocal::Startup() {
 	cmdSystem->AddCommand( "updateResourceFile", UpdateResourceFile_f, CMD_FL_SYSTEM, "updates or appends the supplied files in the supplied resource file" );
 
 	cmdSystem->AddCommand( "generateResourceCRCs", GenerateResourceCRCs_f, CMD_FL_SYSTEM, "Generates CRC checksums for all the resource files." );
+	cmdSystem->AddCommand( "testResourceReads", TestResourceReads_f, CMD_FL_SYSTEM, "reads the loaded resource files from many threads and checks them against their CRCs, usage: testResourceReads [threads] [passes]" );
 
 	// print the current search paths
 	Path_f( idCmdArgs() );
@@ -2655,7 +2815,9 @@ void idFileSystemLocal::Shutdown( bool reloading ) {
 	gameFolder.Clear();
 	searchPaths.Clear();
 
+	StopPreload();
 	resourceFiles.DeleteContents();
+	idResourceContainer::FreeDecompressionJobs();
 
 
 	cmdSystem->RemoveCommand( "path" );
@@ -2719,6 +2881,26 @@ bool idFileSystemLocal::GetResourceCacheEntry( const char *fileName, idResourceC
 	return false;
 }
 
+/*
+========================
+idFileSystemLocal::ReadFileMapped
+========================
+*/
+const byte * idFileSystemLocal::ReadFileMapped( const char *relativePath, int &length ) {
+	length = 0;
+
+	idResourceCacheEntry rc;
+	if ( !GetResourceCacheEntry( relativePath, rc ) ) {
+		return NULL;
+	}
+
+	const byte * data = resourceFiles[ rc.containerIndex ]->GetMappedData( rc );
+	if ( data != NULL ) {
+		length = rc.length;
+	}
+	return data;
+}
+
 /*
 ========================
 idFileSystemLocal::GetResourceFile
@@ -2733,18 +2915,30 @@ idFile * idFileSystemLocal::GetResourceFile( const char *fileName, bool memFile
 		return NULL;
 	}
 
-	static idResourceCacheEntry rc;
+	idResourceCacheEntry rc;
 	if ( GetResourceCacheEntry( fileName, rc ) ) {
 		if ( fs_debugResources.GetBool() ) {
 			idLib::Printf( "RES: loading file %s\n", rc.filename.c_str() );
 		}
+		idFile * preloaded = preloader.OpenFile( rc );
+		if ( preloaded != NULL ) {
+			return preloaded;
+		}
+		idResourceContainer * container = resourceFiles[ rc.containerIndex ];
+		if ( container->IsMapped() || container->IsCompressed() ) {
+			// reads come straight out of the mapping or are decompressed, so there is nothing to buffer
+			return container->OpenFile( rc );
+		}
 		idFile_InnerResource *file = new idFile_InnerResource( rc.filename, resourceFiles[ rc.containerIndex ]->resourceFile, rc.offset, rc.length );
 		if ( file != NULL && ( memFile || rc.length <= resourceBufferAvailable ) || rc.length < 8 * 1024 * 1024 ) {
 			byte *buf = NULL;
+			resourceBufferLock.Lock();
 			if ( rc.length < resourceBufferAvailable ) {
 				buf = resourceBufferPtr;
 				resourceBufferAvailable = 0;
-			} else {
+			}
+			resourceBufferLock.Unlock();
+			if ( buf == NULL ) {
 		if ( fs_debugResources.GetBool() ) {
 				idLib::Printf( "MEM: Allocating %05d bytes for a resource load\n", rc.length );
 }
@@ -192,6 +192,10 @@ public:
 	virtual bool			IsSoundSample( const idStr & resName ) const = 0;
 	virtual bool			GetResourceCacheEntry( const char *fileName, idResourceCacheEntry &rc ) = 0;
 	virtual void			FreeResourceBuffer() = 0;
+							// Returns a read only pointer to a file inside a memory mapped resource container, or NULL if
+							// it isn't in one. Nothing is copied or allocated, and the pointer stays valid until the
+							// container is unloaded. Unlike ReadFile, loose files are not searched and there is no trailing 0.
+	virtual const byte *	ReadFileMapped( const char *relativePath, int &length ) = 0;
 	virtual void			AddImagePreload( const char *resName, int filter, int repeat, int usage, int cube ) = 0;
 	virtual void			AddSamplePreload( const char *resName ) = 0;
 	virtual void			AddModelPreload( const char *resName ) = 0;
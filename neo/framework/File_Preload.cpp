@@ -0,0 +1,303 @@
+/*
+===========================================================================
+
+Doom 3 BFG Edition GPL Source Code
+Copyright (C) 1993-2012 id Software LLC, a ZeniMax Media company. 
+
+This file is part of the Doom 3 BFG Edition GPL Source Code ("Doom 3 BFG Edition Source Code").  
+
+Doom 3 BFG Edition Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 BFG Edition Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 BFG Edition Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 BFG Edition Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 BFG Edition Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+#include "../idlib/precompiled.h"
+#pragma hdrstop
+
+#include "File_Preload.h"
+
+// touching one byte per page is enough to fault a mapped resource in
+static const int PRELOAD_PAGE_SIZE = 4096;
+
+/*
+================================================
+idSort_PreloadEntry sorts the resources by container and then by offset, so each container
+is streamed front to back.
+================================================
+*/
+class idSort_PreloadEntry : public idSort_Quick< idResourceCacheEntry, idSort_PreloadEntry > {
+public:
+	int Compare( const idResourceCacheEntry & a, const idResourceCacheEntry & b ) const {
+		if ( a.containerIndex != b.containerIndex ) {
+			return a.containerIndex - b.containerIndex;
+		}
+		return ( a.offset < b.offset ) ? -1 : ( a.offset > b.offset ) ? 1 : 0;
+	}
+};
+
+/*
+========================
+idResourcePreloader::idResourcePreloader
+========================
+*/
+idResourcePreloader::idResourcePreloader() :
+	roomAvailable( false ) {
+	cacheSize = 0;
+	cachedBytes = 0;
+	active = false;
+	numHits = 0;
+	numMisses = 0;
+	pageSum = 0;
+}
+
+/*
+========================
+idResourcePreloader::~idResourcePreloader
+========================
+*/
+idResourcePreloader::~idResourcePreloader() {
+	Stop();
+}
+
+/*
+========================
+idResourcePreloader::Start
+========================
+*/
+void idResourcePreloader::Start( const idList< idResourceContainer * > & _containers, const idList< idResourceCacheEntry > & entries, int _cacheSize ) {
+	Stop();
+
+	if ( entries.Num() == 0 || _cacheSize <= 0 ) {
+		return;
+	}
+
+	containers.SetNum( _containers.Num() );
+	containerFiles.SetNum( _containers.Num() );
+	for ( int i = 0; i < containers.Num(); i++ ) {
+		containers[ i ] = _containers[ i ];
+		containerFiles[ i ] = NULL;
+		if ( !containers[ i ]->IsMapped() && !containers[ i ]->IsCompressed() && containers[ i ]->resourceFile != NULL ) {
+			// fails for containers that only live in memory, those aren't worth preloading anyway
+			containerFiles[ i ] = fileSystem->OpenExplicitFileRead( containers[ i ]->resourceFile->GetFullPath() );
+		}
+	}
+
+	idList< idResourceCacheEntry > sorted = entries;
+	sorted.SortWithTemplate( idSort_PreloadEntry() );
+
+	reads.SetNum( 0 );
+	reads.Resize( sorted.Num() );
+	readHash.Clear( 4096, sorted.Num() );
+	for ( int i = 0; i < sorted.Num(); i++ ) {
+		const idResourceCacheEntry & rc = sorted[ i ];
+		if ( rc.length <= 0 || rc.length > _cacheSize || rc.containerIndex < 0 || rc.containerIndex >= containers.Num() ) {
+			continue;
+		}
+		const idResourceContainer * container = containers[ rc.containerIndex ];
+		if ( !container->IsMapped() && !container->IsCompressed() && containerFiles[ rc.containerIndex ] == NULL ) {
+			continue;
+		}
+		if ( i > 0 && rc.containerIndex == sorted[ i - 1 ].containerIndex && rc.offset == sorted[ i - 1 ].offset ) {
+			continue;
+		}
+		preloadRead_t & read = reads.Alloc();
+		read.filename = rc.filename;
+		read.containerIndex = rc.containerIndex;
+		read.offset = rc.offset;
+		read.length = rc.length;
+		read.data = NULL;
+		read.state = READ_PENDING;
+		readHash.Add( readHash.GenerateKey( read.filename, false ), reads.Num() - 1 );
+	}
+
+	cacheSize = _cacheSize;
+	cachedBytes = 0;
+	numHits = 0;
+	numMisses = 0;
+	roomAvailable.Clear();
+	active = true;
+
+	StartThread( "ResourcePreload", CORE_ANY, THREAD_BELOW_NORMAL );
+}
+
+/*
+========================
+idResourcePreloader::Stop
+========================
+*/
+void idResourcePreloader::Stop() {
+	if ( !active ) {
+		return;
+	}
+
+	// wake the thread up if it is waiting for room before waiting for it
+	StopThread( false );
+	roomAvailable.Raise();
+	WaitForThread();
+
+	common->DPrintf( "preloaded %d of %d resources, %d were opened before they were read\n", numHits, reads.Num(), numMisses );
+
+	for ( int i = 0; i < reads.Num(); i++ ) {
+		Mem_Free( reads[ i ].data );
+	}
+	for ( int i = 0; i < containerFiles.Num(); i++ ) {
+		delete containerFiles[ i ];
+	}
+	containers.Clear();
+	containerFiles.Clear();
+	reads.Clear();
+	readHash.Free();
+	cachedBytes = 0;
+	active = false;
+}
+
+/*
+========================
+idResourcePreloader::OpenFile
+========================
+*/
+idFile * idResourcePreloader::OpenFile( const idResourceCacheEntry & rc ) {
+	if ( !active ) {
+		return NULL;
+	}
+
+	idScopedCriticalSection lock( mutex );
+
+	const int key = readHash.GenerateKey( rc.filename, false );
+	for ( int i = readHash.First( key ); i != -1; i = readHash.Next( i ) ) {
+		preloadRead_t & read = reads[ i ];
+		if ( read.containerIndex != rc.containerIndex || read.offset != rc.offset ) {
+			continue;
+		}
+		if ( read.state == READ_PENDING ) {
+			// the loader got here first, reading it now would only be wasted
+			read.state = READ_SKIPPED;
+			numMisses++;
+			return NULL;
+		}
+		if ( read.state != READ_CACHED ) {
+			return NULL;
+		}
+
+		read.state = READ_TAKEN;
+		cachedBytes -= read.length;
+		numHits++;
+		roomAvailable.Raise();
+
+		if ( read.data == NULL ) {
+			// the pages of the mapping are resident, the container opens a view of them
+			return NULL;
+		}
+		idFile_Memory * file = new (TAG_IDFILE) idFile_Memory( rc.filename, ( const char * )read.data, read.length );
+		file->TakeDataOwnership();
+		read.data = NULL;
+		return file;
+	}
+	return NULL;
+}
+
+/*
+========================
+idResourcePreloader::Run
+========================
+*/
+int idResourcePreloader::Run() {
+	for ( int i = 0; i < reads.Num() && !IsTerminating(); i++ ) {
+		preloadRead_t & read = reads[ i ];
+		if ( !ReserveRoom( read ) ) {
+			continue;
+		}
+
+		byte * data = NULL;
+		const bool ok = ReadResource( read, data );
+
+		idScopedCriticalSection lock( mutex );
+		if ( ok && read.state == READ_PENDING ) {
+			read.data = data;
+			read.state = READ_CACHED;
+		} else {
+			// the read failed or the file was opened while it was being read
+			Mem_Free( data );
+			cachedBytes -= read.length;
+			if ( read.state == READ_PENDING ) {
+				read.state = READ_SKIPPED;
+			}
+		}
+	}
+	return 0;
+}
+
+/*
+========================
+idResourcePreloader::ReserveRoom
+
+Waits until the read fits in the cache. Returns false if the file was opened in the meantime
+or the preload is stopping.
+========================
+*/
+bool idResourcePreloader::ReserveRoom( preloadRead_t & read ) {
+	while ( !IsTerminating() ) {
+		{
+			idScopedCriticalSection lock( mutex );
+			if ( read.state != READ_PENDING ) {
+				return false;
+			}
+			if ( cachedBytes + read.length <= cacheSize ) {
+				cachedBytes += read.length;
+				return true;
+			}
+		}
+		roomAvailable.Wait( idSysSignal::WAIT_INFINITE );
+	}
+	return false;
+}
+
+/*
+========================
+idResourcePreloader::ReadResource
+========================
+*/
+bool idResourcePreloader::ReadResource( preloadRead_t & read, byte * & data ) {
+	idResourceCacheEntry rc;
+	rc.offset = read.offset;
+	rc.length = read.length;
+
+	const idResourceContainer * container = containers[ read.containerIndex ];
+	if ( container->IsCompressed() ) {
+		// decompressing is the expensive part, so the cache keeps the uncompressed data
+		data = ( byte * )Mem_Alloc( read.length, TAG_RESOURCE );
+		return container->ReadResource( rc, data );
+	}
+
+	const byte * mapped = container->GetMappedData( rc );
+	if ( mapped != NULL ) {
+		int sum = 0;
+		for ( int i = 0; i < read.length; i += PRELOAD_PAGE_SIZE ) {
+			sum += mapped[ i ];
+		}
+		pageSum += sum;
+		return true;
+	}
+
+	idFile * file = containerFiles[ read.containerIndex ];
+	if ( file == NULL ) {
+		return false;
+	}
+	data = ( byte * )Mem_Alloc( read.length, TAG_RESOURCE );
+	return file->ReadAt( data, read.length, read.offset ) == read.length;
+}
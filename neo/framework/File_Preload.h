@@ -0,0 +1,105 @@
+/*
+===========================================================================
+
+Doom 3 BFG Edition GPL Source Code
+Copyright (C) 1993-2012 id Software LLC, a ZeniMax Media company. 
+
+This file is part of the Doom 3 BFG Edition GPL Source Code ("Doom 3 BFG Edition Source Code").  
+
+Doom 3 BFG Edition Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 BFG Edition Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 BFG Edition Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 BFG Edition Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 BFG Edition Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+#ifndef __FILE_PRELOAD_H__
+#define __FILE_PRELOAD_H__
+
+/*
+==============================================================
+
+  Resource preloading
+
+==============================================================
+*/
+
+/*
+================================================
+idResourcePreloader reads the resources a level load is about to open on a background
+thread, in container order, and keeps them until they are opened. The reads stay at most
+cacheSize bytes ahead of the loaders.
+
+Resources in memory mapped containers aren't copied, the thread only faults their pages in.
+Resources in compressed containers are kept decompressed.
+Other containers are read through a file handle that belongs to the thread, so the preloader
+never moves the file position of the handles the loaders use.
+================================================
+*/
+class idResourcePreloader : public idSysThread {
+public:
+						idResourcePreloader();
+	virtual				~idResourcePreloader();
+
+	// the entries must come from the given containers, which have to stay loaded until Stop
+	void				Start( const idList< idResourceContainer * > & containers, const idList< idResourceCacheEntry > & entries, int cacheSize );
+	void				Stop();
+	bool				IsActive() const { return active; }
+
+	// Returns the preloaded file and frees its room in the cache. Returns NULL if the file wasn't
+	// preloaded, or if it is in a mapped container, which is then opened as usual.
+	idFile *			OpenFile( const idResourceCacheEntry & rc );
+
+protected:
+	virtual int			Run();
+
+private:
+	enum readState_t {
+		READ_PENDING,					// not read yet
+		READ_CACHED,					// waiting to be opened
+		READ_TAKEN,						// opened from the cache
+		READ_SKIPPED					// opened before it was read, or the read failed
+	};
+
+	struct preloadRead_t {
+		idStr			filename;
+		int				containerIndex;
+		int64			offset;
+		int				length;
+		byte *			data;			// NULL for mapped containers
+		readState_t		state;
+	};
+
+	idList< idResourceContainer *, TAG_RESOURCE >	containers;
+	idList< idFile *, TAG_RESOURCE >				containerFiles;		// read handles of the unmapped containers
+	idList< preloadRead_t, TAG_RESOURCE >			reads;
+	idHashIndex			readHash;
+
+	idSysMutex			mutex;			// guards the read states and cachedBytes
+	idSysSignal			roomAvailable;
+	int					cacheSize;
+	int					cachedBytes;	// read or being read, but not opened yet
+	bool				active;
+
+	int					numHits;
+	int					numMisses;
+	volatile int		pageSum;		// keeps the page touches from being optimized away
+
+	bool				ReserveRoom( preloadRead_t & read );
+	bool				ReadResource( preloadRead_t & read, byte * & data );
+};
+
+#endif /* !__FILE_PRELOAD_H__ */
@@ -29,6 +29,255 @@ If you have questions concerning this license or the applicable additional terms
 #include "../idlib/precompiled.h"
 #pragma hdrstop
 
+#include "zlib/zlib.h"
+
+idCVar fs_mapResourceFiles( "fs_mapResourceFiles", "1", CVAR_SYSTEM | CVAR_BOOL, "memory map resource containers and read resources straight out of the mapping" );
+idCVar fs_compressResourceFiles( "fs_compressResourceFiles", "0", CVAR_SYSTEM | CVAR_BOOL, "write new resource containers in the compressed, chunked version 2 format" );
+
+/*
+================================================================================================
+
+idResourceWriter
+
+================================================================================================
+*/
+
+/*
+================================================
+idResourceWriter writes the resources and the table of a container. Version 2 containers
+put the resources into one stream that is compressed in chunks of RESOURCE_CHUNK_SIZE bytes.
+A chunk that doesn't get smaller is stored as is.
+================================================
+*/
+class idResourceWriter {
+public:
+					idResourceWriter( idFile * file, bool compressed );
+					~idResourceWriter();
+
+	// returns the offset of the resource, which is what its table entry has to hold
+	int64			Write( const void * data, int length );
+	// returns false if the resources don't fit the container version
+	bool			Finish( const idList< idResourceCacheEntry > & entries );
+
+private:
+	int				WriteHeader( int64 tableOffset, int tableLength );
+	void			FlushChunk();
+
+	idFile *		file;
+	bool			compressed;
+	int64			fileLength;			// bytes written to the file so far, idFile::Tell wraps at 2 gigs
+	int64			dataLength;			// uncompressed bytes written so far
+	byte *			chunkData;
+	int				chunkFill;
+	byte *			compressedData;
+	int				compressedSize;
+	idList< resourceChunk_t >	chunks;
+};
+
+/*
+========================
+idResourceWriter::idResourceWriter
+========================
+*/
+idResourceWriter::idResourceWriter( idFile * _file, bool _compressed ) {
+	file = _file;
+	compressed = _compressed;
+	fileLength = 0;
+	dataLength = 0;
+	chunkData = NULL;
+	chunkFill = 0;
+	compressedData = NULL;
+	compressedSize = 0;
+	if ( compressed ) {
+		chunkData = (byte *)Mem_Alloc( RESOURCE_CHUNK_SIZE, TAG_TEMP );
+		compressedSize = compressBound( RESOURCE_CHUNK_SIZE );
+		compressedData = (byte *)Mem_Alloc( compressedSize, TAG_TEMP );
+	}
+	// written again by Finish, once the table is known
+	fileLength = WriteHeader( 0, 0 );
+}
+
+/*
+========================
+idResourceWriter::~idResourceWriter
+========================
+*/
+idResourceWriter::~idResourceWriter() {
+	Mem_Free( chunkData );
+	Mem_Free( compressedData );
+}
+
+/*
+========================
+idResourceWriter::WriteHeader
+
+Returns the size of the header.
+========================
+*/
+int idResourceWriter::WriteHeader( int64 tableOffset, int tableLength ) {
+	size_t size = 0;
+	if ( compressed ) {
+		size += file->WriteBig( RESOURCE_FILE_MAGIC_V2 );
+		size += file->WriteBig( tableOffset );
+	} else {
+		assert( tableOffset <= INT_MAX );
+		size += file->WriteBig( RESOURCE_FILE_MAGIC );
+		size += file->WriteBig( (int)tableOffset );
+	}
+	size += file->WriteBig( tableLength );
+	return (int)size;
+}
+
+/*
+========================
+idResourceWriter::Write
+========================
+*/
+int64 idResourceWriter::Write( const void * data, int length ) {
+	if ( !compressed ) {
+		const int64 offset = fileLength;
+		fileLength += file->Write( data, length );
+		return offset;
+	}
+
+	const int64 offset = dataLength;
+	const byte * src = (const byte *)data;
+	while ( length > 0 ) {
+		const int count = Min( length, RESOURCE_CHUNK_SIZE - chunkFill );
+		memcpy( chunkData + chunkFill, src, count );
+		chunkFill += count;
+		src += count;
+		length -= count;
+		dataLength += count;
+		if ( chunkFill == RESOURCE_CHUNK_SIZE ) {
+			FlushChunk();
+		}
+	}
+	return offset;
+}
+
+/*
+========================
+idResourceWriter::FlushChunk
+========================
+*/
+void idResourceWriter::FlushChunk() {
+	if ( chunkFill == 0 ) {
+		return;
+	}
+	resourceChunk_t & chunk = chunks.Alloc();
+	chunk.offset = fileLength;
+
+	uLongf length = compressedSize;
+	if ( compress2( compressedData, &length, chunkData, chunkFill, Z_BEST_SPEED ) == Z_OK && (int)length < chunkFill ) {
+		chunk.compressedLength = (int)length;
+		fileLength += file->Write( compressedData, chunk.compressedLength );
+	} else {
+		chunk.compressedLength = chunkFill;
+		fileLength += file->Write( chunkData, chunkFill );
+	}
+	chunkFill = 0;
+}
+
+/*
+========================
+idResourceWriter::Finish
+========================
+*/
+bool idResourceWriter::Finish( const idList< idResourceCacheEntry > & entries ) {
+	FlushChunk();
+
+	const int64 tableOffset = fileLength;
+	if ( !compressed && tableOffset > INT_MAX ) {
+		// version 1 offsets are 32 bits
+		idLib::Warning( "%s is over 2 gigs, write it with fs_compressResourceFiles 1", file->GetName() );
+		return false;
+	}
+	size_t tableSize = 0;
+	tableSize += file->WriteBig( entries.Num() );
+	for ( int i = 0; i < entries.Num(); i++ ) {
+		tableSize += entries[ i ].Write( file, compressed );
+	}
+	if ( compressed ) {
+		tableSize += file->WriteBig( RESOURCE_CHUNK_SIZE );
+		tableSize += file->WriteBig( dataLength );
+		tableSize += file->WriteBig( chunks.Num() );
+		for ( int i = 0; i < chunks.Num(); i++ ) {
+			tableSize += file->WriteBig( chunks[ i ].offset );
+			tableSize += file->WriteBig( chunks[ i ].compressedLength );
+		}
+	}
+	const int tableLength = (int)tableSize;
+	fileLength += tableLength;
+
+	// go back and write the header offsets again, now that we have file offsets and lengths
+	file->Seek( 0, FS_SEEK_SET );
+	WriteHeader( tableOffset, tableLength );
+	return true;
+}
+
+/*
+================================================================================================
+
+Resource decompression
+
+================================================================================================
+*/
+
+struct resourceDecompressParms_t {
+	const idResourceContainer *	container;
+	int64						offset;		// into the uncompressed stream
+	int							length;
+	byte *						dest;
+	bool						ok;
+};
+
+/*
+========================
+DecompressResourceJob
+========================
+*/
+static void DecompressResourceJob( resourceDecompressParms_t * parms ) {
+	parms->ok = parms->container->DecompressRange( parms->offset, parms->length, parms->dest );
+}
+
+REGISTER_PARALLEL_JOB( DecompressResourceJob, "DecompressResourceJob" );
+
+// the job system is initialized after the file system, so the list is allocated on first use
+static idParallelJobList *	resourceDecompressJobs = NULL;
+static bool					resourceDecompressJobsBusy = false;
+static idSysMutex			resourceDecompressLock;
+
+/*
+========================
+ClaimResourceDecompressJobs
+
+Returns NULL when another read is already using the job list, the lock is only held while
+claiming it so reads on other threads never wait on each other.
+========================
+*/
+static idParallelJobList * ClaimResourceDecompressJobs() {
+	idScopedCriticalSection lock( resourceDecompressLock );
+	if ( resourceDecompressJobsBusy ) {
+		return NULL;
+	}
+	if ( resourceDecompressJobs == NULL ) {
+		resourceDecompressJobs = parallelJobManager->AllocJobList( JOBLIST_UTILITY, JOBLIST_PRIORITY_MEDIUM, RESOURCE_MAX_PARALLEL_JOBS, 0, NULL );
+	}
+	resourceDecompressJobsBusy = true;
+	return resourceDecompressJobs;
+}
+
+/*
+========================
+ReleaseResourceDecompressJobs
+========================
+*/
+static void ReleaseResourceDecompressJobs() {
+	idScopedCriticalSection lock( resourceDecompressLock );
+	resourceDecompressJobsBusy = false;
+}
+
 /*
 ================================================================================================
 
@@ -66,18 +315,70 @@ bool idResourceContainer::Init( const char *_fileName, uint8 containerIndex ) {
 	}
 
 	resourceFile->ReadBig( resourceMagic );
-	if ( resourceMagic != RESOURCE_FILE_MAGIC ) {
+	if ( resourceMagic != RESOURCE_FILE_MAGIC && resourceMagic != RESOURCE_FILE_MAGIC_V2 ) {
 		idLib::FatalError( "resourceFileMagic != RESOURCE_FILE_MAGIC" );
 	}
 
 	fileName = _fileName;
 
-	resourceFile->ReadBig( tableOffset );
+	// containers that are already in memory don't need a mapping, and if the mapping
+	// fails (out of address space) the resources are read through the file instead
+	if ( fs_mapResourceFiles.GetBool() && idStr::Icmp( _fileName, "_ordered.resources" ) != 0 ) {
+		mappedData = Sys_MapFileRead( resourceFile->GetFullPath(), mappedLength );
+		if ( mappedData == NULL ) {
+			idLib::Warning( "Unable to memory map resource file %s", _fileName );
+		}
+	}
+
+	return ReadTable( containerIndex );
+}
+
+/*
+========================
+idResourceContainer::Open
+========================
+*/
+bool idResourceContainer::Open( const char *_fileName ) {
+	resourceFile = fileSystem->OpenFileRead( _fileName );
+	if ( resourceFile == NULL ) {
+		idLib::Warning( "Unable to open resource file %s", _fileName );
+		return false;
+	}
+
+	resourceFile->ReadBig( resourceMagic );
+	if ( resourceMagic != RESOURCE_FILE_MAGIC && resourceMagic != RESOURCE_FILE_MAGIC_V2 ) {
+		idLib::Warning( "%s has bad magic.", _fileName );
+		return false;
+	}
+
+	fileName = _fileName;
+	return ReadTable( 0 );
+}
+
+/*
+========================
+idResourceContainer::ReadTable
+
+Reads the rest of the header and the table, the magic has been read already.
+========================
+*/
+bool idResourceContainer::ReadTable( uint8 containerIndex ) {
+	compressed = ( resourceMagic == RESOURCE_FILE_MAGIC_V2 );
+	if ( compressed ) {
+		resourceFile->ReadBig( tableOffset );
+	} else {
+		int tableOffset32 = 0;
+		resourceFile->ReadBig( tableOffset32 );
+		tableOffset = tableOffset32;
+	}
 	resourceFile->ReadBig( tableLength );
 	// read this into a memory buffer with a single read
 	char * const buf = (char *)Mem_Alloc( tableLength, TAG_RESOURCE );
-	resourceFile->Seek( tableOffset, FS_SEEK_SET );
-	resourceFile->Read( buf, tableLength );
+	if ( resourceFile->ReadAt( buf, tableLength, tableOffset ) != tableLength ) {
+		idLib::Warning( "Unable to read the table of resource file %s", fileName.c_str() );
+		Mem_Free( buf );
+		return false;
+	}
 	idFile_Memory memFile( "resourceHeader", (const char *)buf, tableLength );
 
 	// Parse the resourceFile header, which includes every resource used
@@ -88,7 +389,7 @@ bool idResourceContainer::Init( const char *_fileName, uint8 containerIndex ) {
 
 	for ( int i = 0; i < numFileResources; i++ ) {
 		idResourceCacheEntry &rt = cacheTable[ i ];
-		rt.Read( &memFile );
+		rt.Read( &memFile, compressed );
 		rt.filename.BackSlashesToSlashes();
 		rt.filename.ToLower();
 		rt.containerIndex = containerIndex;
@@ -107,11 +408,230 @@ bool idResourceContainer::Init( const char *_fileName, uint8 containerIndex ) {
 			cacheHash.Add( key, i );
 		}
 	}
+
+	if ( compressed ) {
+		int numChunks = 0;
+		memFile.ReadBig( chunkSize );
+		memFile.ReadBig( dataLength );
+		memFile.ReadBig( numChunks );
+		if ( chunkSize <= 0 || numChunks != ( dataLength + chunkSize - 1 ) / chunkSize ) {
+			idLib::Warning( "Resource file %s has a bad chunk index", fileName.c_str() );
+			Mem_Free( buf );
+			return false;
+		}
+		chunks.SetNum( numChunks );
+		for ( int i = 0; i < numChunks; i++ ) {
+			memFile.ReadBig( chunks[ i ].offset );
+			memFile.ReadBig( chunks[ i ].compressedLength );
+		}
+	}
 	Mem_Free( buf );
 
 	return true;
 }
 
+/*
+========================
+idResourceContainer::GetMappedData
+
+The resources are never written through the mapping, so any number of threads can read them
+at the same time.
+========================
+*/
+const byte * idResourceContainer::GetMappedData( const idResourceCacheEntry & rc ) const {
+	if ( mappedData == NULL || compressed || rc.offset < 0 || rc.length < 0 || (int64)rc.offset + rc.length > mappedLength ) {
+		return NULL;
+	}
+	return mappedData + rc.offset;
+}
+
+/*
+========================
+idResourceContainer::OpenFile
+
+Files in a mapped container are views into the mapping, which stay valid until the
+container is unloaded.
+========================
+*/
+idFile * idResourceContainer::OpenFile( const idResourceCacheEntry & rc ) {
+	const byte * data = GetMappedData( rc );
+	if ( data != NULL ) {
+		return new idFile_Memory( rc.filename, (const char *)data, rc.length );
+	}
+	if ( compressed ) {
+		byte * buf = (byte *)Mem_Alloc( rc.length, TAG_RESOURCE );
+		if ( !ReadResource( rc, buf ) ) {
+			idLib::Warning( "Unable to decompress %s from %s", rc.filename.c_str(), fileName.c_str() );
+			Mem_Free( buf );
+			return NULL;
+		}
+		idFile_Memory * file = new idFile_Memory( rc.filename, (const char *)buf, rc.length );
+		file->TakeDataOwnership();
+		return file;
+	}
+	return new idFile_InnerResource( rc.filename, resourceFile, rc.offset, rc.length );
+}
+
+/*
+========================
+idResourceContainer::ReadResource
+
+Resources that span many chunks are decompressed in parallel, one job per run of chunks,
+unless the read comes from a job thread or another read is already using the jobs.
+Reads only use the mapping or positional reads, so loaders on several threads can read
+from the same container.
+========================
+*/
+bool idResourceContainer::ReadResource( const idResourceCacheEntry & rc, void * dest ) const {
+	if ( rc.length <= 0 ) {
+		return ( rc.length == 0 );
+	}
+
+	if ( !compressed ) {
+		const byte * data = GetMappedData( rc );
+		if ( data != NULL ) {
+			memcpy( dest, data, rc.length );
+			return true;
+		}
+		return ( resourceFile->ReadAt( dest, rc.length, rc.offset ) == rc.length );
+	}
+
+	if ( rc.offset < 0 || rc.offset + rc.length > dataLength ) {
+		return false;
+	}
+
+	const int firstChunk = (int)( rc.offset / chunkSize );
+	const int lastChunk = (int)( ( rc.offset + rc.length - 1 ) / chunkSize );
+	const int numChunks = lastChunk - firstChunk + 1;
+	if ( numChunks < RESOURCE_MIN_PARALLEL_CHUNKS ) {
+		return DecompressRange( rc.offset, rc.length, (byte *)dest );
+	}
+
+	// a job waiting on other jobs can starve the job threads, and only one read at a time
+	// uses the job list, so anything else decompresses on the calling thread
+	idParallelJobList * jobList = parallelJobManager->IsJobThread() ? NULL : ClaimResourceDecompressJobs();
+	if ( jobList == NULL ) {
+		return DecompressRange( rc.offset, rc.length, (byte *)dest );
+	}
+
+	// split the chunks evenly over the jobs, cutting the range on chunk boundaries
+	const int numJobs = Min( RESOURCE_MAX_PARALLEL_JOBS, numChunks );
+	resourceDecompressParms_t parms[ RESOURCE_MAX_PARALLEL_JOBS ];
+
+	const int64 end = rc.offset + rc.length;
+	for ( int i = 0; i < numJobs; i++ ) {
+		const int64 start = ( i == 0 ) ? rc.offset : (int64)( firstChunk + numChunks * i / numJobs ) * chunkSize;
+		const int64 stop = ( i == numJobs - 1 ) ? end : (int64)( firstChunk + numChunks * ( i + 1 ) / numJobs ) * chunkSize;
+		parms[ i ].container = this;
+		parms[ i ].offset = start;
+		parms[ i ].length = (int)( stop - start );
+		parms[ i ].dest = (byte *)dest + ( start - rc.offset );
+		parms[ i ].ok = false;
+		jobList->AddJob( (jobRun_t)DecompressResourceJob, &parms[ i ] );
+	}
+	jobList->Submit();
+	jobList->Wait();
+	ReleaseResourceDecompressJobs();
+
+	bool ok = true;
+	for ( int i = 0; i < numJobs; i++ ) {
+		ok &= parms[ i ].ok;
+	}
+	return ok;
+}
+
+/*
+========================
+idResourceContainer::DecompressRange
+
+Decompresses a range of the uncompressed stream of a version 2 container.
+========================
+*/
+bool idResourceContainer::DecompressRange( int64 offset, int length, byte * dest ) const {
+	byte * compressedBuffer = NULL;
+	byte * chunkBuffer = NULL;
+	bool ok = true;
+
+	const int64 end = offset + length;
+	while ( offset < end && ok ) {
+		const int chunkIndex = (int)( offset / chunkSize );
+		const int64 chunkStart = (int64)chunkIndex * chunkSize;
+		const int chunkLength = (int)Min( (int64)chunkSize, dataLength - chunkStart );
+		const resourceChunk_t & chunk = chunks[ chunkIndex ];
+		const int skip = (int)( offset - chunkStart );
+		const int count = (int)Min( end - offset, (int64)( chunkLength - skip ) );
+
+		const byte * src = NULL;
+		if ( mappedData != NULL && chunk.offset >= 0 && chunk.offset + chunk.compressedLength <= mappedLength ) {
+			src = mappedData + chunk.offset;
+		} else {
+			if ( compressedBuffer == NULL ) {
+				compressedBuffer = (byte *)Mem_Alloc( chunkSize, TAG_TEMP );
+			}
+			if ( chunk.compressedLength > chunkSize || resourceFile->ReadAt( compressedBuffer, chunk.compressedLength, chunk.offset ) != chunk.compressedLength ) {
+				ok = false;
+				break;
+			}
+			src = compressedBuffer;
+		}
+
+		if ( chunk.compressedLength == chunkLength ) {
+			// stored
+			memcpy( dest, src + skip, count );
+		} else if ( count == chunkLength ) {
+			uLongf destLength = chunkLength;
+			ok = ( uncompress( dest, &destLength, src, chunk.compressedLength ) == Z_OK && (int)destLength == chunkLength );
+		} else {
+			if ( chunkBuffer == NULL ) {
+				chunkBuffer = (byte *)Mem_Alloc( chunkSize, TAG_TEMP );
+			}
+			uLongf destLength = chunkLength;
+			ok = ( uncompress( chunkBuffer, &destLength, src, chunk.compressedLength ) == Z_OK && (int)destLength == chunkLength );
+			memcpy( dest, chunkBuffer + skip, count );
+		}
+
+		dest += count;
+		offset += count;
+	}
+
+	Mem_Free( compressedBuffer );
+	Mem_Free( chunkBuffer );
+	return ok;
+}
+
+/*
+========================
+idResourceContainer::FreeDecompressionJobs
+========================
+*/
+void idResourceContainer::FreeDecompressionJobs() {
+	idScopedCriticalSection lock( resourceDecompressLock );
+	assert( !resourceDecompressJobsBusy );
+	if ( resourceDecompressJobs != NULL ) {
+		parallelJobManager->FreeJobList( resourceDecompressJobs );
+		resourceDecompressJobs = NULL;
+	}
+}
+
+/*
+========================
+idResourceContainer::OpenFile
+========================
+*/
+idFile * idResourceContainer::OpenFile( const char *_fileName ) {
+	idStrStatic< MAX_OSPATH > canonical = _fileName;
+	canonical.BackSlashesToSlashes();
+	canonical.ToLower();
+
+	const int key = cacheHash.GenerateKey( canonical, false );
+	for ( int index = cacheHash.GetFirst( key ); index != idHashIndex::NULL_INDEX; index = cacheHash.GetNext( index ) ) {
+		if ( idStr::Icmp( cacheTable[ index ].filename, canonical ) == 0 ) {
+			return OpenFile( cacheTable[ index ] );
+		}
+	}
+	return NULL;
+}
+
 
 /*
 ========================
@@ -168,47 +688,26 @@ void idResourceContainer::UpdateResourceFile( const char *_filename, const idStr
 		return;
 	}
 
-	uint32 magic = 0;
-	int _tableOffset = 0;
-	int _tableLength = 0;
 	idList< idResourceCacheEntry > entries;
 	idStrList filesToUpdate = _filesToUpdate;
 
-	idFile *inFile = fileSystem->OpenFileRead( _filename );
-	if ( inFile == NULL ) {
-		magic = RESOURCE_FILE_MAGIC;
-
-		outFile->WriteBig( magic );
-		outFile->WriteBig( _tableOffset );
-		outFile->WriteBig( _tableLength );
-
-	} else {
-		inFile->ReadBig( magic );
-		if ( magic != RESOURCE_FILE_MAGIC ) {
-			delete inFile;
+	// keep the format of the container that is updated
+	idResourceContainer inContainer;
+	bool haveInput = false;
+	if ( fileSystem->FindFile( _filename ) != FIND_NO ) {
+		if ( !inContainer.Open( _filename ) ) {
+			delete outFile;
 			return;
 		}
+		haveInput = true;
+	}
+	idResourceWriter writer( outFile, haveInput ? inContainer.IsCompressed() : fs_compressResourceFiles.GetBool() );
 
-		inFile->ReadBig( _tableOffset );
-		inFile->ReadBig( _tableLength );
-		// read this into a memory buffer with a single read
-		char * const buf = (char *)Mem_Alloc( _tableLength, TAG_RESOURCE );
-		inFile->Seek( _tableOffset, FS_SEEK_SET );
-		inFile->Read( buf, _tableLength );
-		idFile_Memory memFile( "resourceHeader", (const char *)buf, _tableLength );
-
-		int _numFileResources = 0;
-		memFile.ReadBig( _numFileResources );
-
-		outFile->WriteBig( magic );
-		outFile->WriteBig( _tableOffset );
-		outFile->WriteBig( _tableLength );
-
-		entries.SetNum( _numFileResources );
-
-		for ( int i = 0; i < _numFileResources; i++ ) {
-			entries[ i ].Read( &memFile );
+	if ( haveInput ) {
+		entries.SetNum( inContainer.cacheTable.Num() );
 
+		for ( int i = 0; i < entries.Num(); i++ ) {
+			entries[ i ] = inContainer.cacheTable[ i ];
 
 			idLib::Printf( "examining %s\n", entries[ i ].filename.c_str() );
 			byte * fileData = NULL;
@@ -228,18 +727,16 @@ void idResourceContainer::UpdateResourceFile( const char *_filename, const idStr
 			}
 
 			if ( fileData == NULL ) {
-				inFile->Seek( entries[ i ].offset, FS_SEEK_SET );
 				fileData = (byte *)Mem_Alloc( entries[ i ].length, TAG_TEMP );
-				inFile->Read( fileData, entries[ i ].length );
+				if ( !inContainer.ReadResource( entries[ i ], fileData ) ) {
+					idLib::Warning( "Unable to read %s from %s", entries[ i ].filename.c_str(), _filename );
+				}
 			}
 
-			entries[ i ].offset = outFile->Tell();
-			outFile->Write( ( void* )fileData, entries[ i ].length );
+			entries[ i ].offset = writer.Write( fileData, entries[ i ].length );
 
 			Mem_Free( fileData );
 		}
-
-		Mem_Free( buf );
 	}
 
 	while ( filesToUpdate.Num() > 0 ) {
@@ -253,8 +750,7 @@ void idResourceContainer::UpdateResourceFile( const char *_filename, const idStr
 			newFile->Read( fileData, rt.length );
 			int idx = entries.Append( rt );
 			if ( idx >= 0 ) {
-				entries[ idx ].offset = outFile->Tell();
-				outFile->Write( ( void* )fileData, entries[ idx ].length );
+				entries[ idx ].offset = writer.Write( fileData, entries[ idx ].length );
 			}
 			delete newFile;
 			Mem_Free( fileData );
@@ -262,23 +758,13 @@ void idResourceContainer::UpdateResourceFile( const char *_filename, const idStr
 		filesToUpdate.RemoveIndex( 0 );
 	}
 
-	_tableOffset = outFile->Tell();
-	outFile->WriteBig( entries.Num() );
-
-	// write the individual resource entries
-	for ( int i = 0; i < entries.Num(); i++ ) {
-		entries[ i ].Write( outFile );
-	}
-
-	// go back and write the header offsets again, now that we have file offsets and lengths
-	_tableLength = outFile->Tell() - _tableOffset;
-	outFile->Seek( 0, FS_SEEK_SET );
-	outFile->WriteBig( magic );
-	outFile->WriteBig( _tableOffset );
-	outFile->WriteBig( _tableLength );
+	const bool written = writer.Finish( entries );
 
 	delete outFile;
-	delete inFile;
+
+	if ( !written ) {
+		fileSystem->RemoveFile( va( "%s.new", _filename ) );
+	}
 }
 
 
@@ -299,39 +785,13 @@ idResourceContainer::ExtractResourceFile
 ========================
 */ 
 void idResourceContainer::ExtractResourceFile ( const char * _fileName, const char * _outPath, bool _copyWavs ) {
-	idFile *inFile = fileSystem->OpenFileRead( _fileName );
-
-	if ( inFile == NULL ) {
-		idLib::Warning( "Unable to open resource file %s", _fileName );
+	idResourceContainer container;
+	if ( !container.Open( _fileName ) ) {
 		return;
 	}
 
-	uint32 magic;
-	inFile->ReadBig( magic );
-	if ( magic != RESOURCE_FILE_MAGIC ) {
-		idLib::Warning( "%s has bad magic.", _fileName );
-		delete inFile;
-		return;
-	}
-
-	int _tableOffset;
-	int _tableLength;
-	inFile->ReadBig( _tableOffset );
-	inFile->ReadBig( _tableLength );
-	// read this into a memory buffer with a single read
-	char * const buf = (char *)Mem_Alloc( _tableLength, TAG_RESOURCE );
-	inFile->Seek( _tableOffset, FS_SEEK_SET );
-	inFile->Read( buf, _tableLength );
-	idFile_Memory memFile( "resourceHeader", (const char *)buf, _tableLength );
-
-	int _numFileResources;
-	memFile.ReadBig( _numFileResources );
-
-	for ( int i = 0; i < _numFileResources; i++ ) {
-		idResourceCacheEntry rt;
-		rt.Read( &memFile );
-		rt.filename.BackSlashesToSlashes();
-		rt.filename.ToLower();
+	for ( int i = 0; i < container.cacheTable.Num(); i++ ) {
+		idResourceCacheEntry rt = container.cacheTable[ i ];
 		byte *fbuf = NULL;
 		if ( _copyWavs && ( rt.filename.Find( ".idwav" ) >= 0 ||  rt.filename.Find( ".idxma" ) >= 0 ||  rt.filename.Find( ".idmsf" ) >= 0 ) ) {
 			rt.filename.SetFileExtension( "wav" );
@@ -340,9 +800,10 @@ void idResourceContainer::ExtractResourceFile ( const char * _fileName, const ch
 			fbuf =  (byte *)Mem_Alloc( len, TAG_RESOURCE );
 			fileSystem->ReadFile( rt.filename, (void**)&fbuf, NULL );
 		} else {
-			inFile->Seek( rt.offset, FS_SEEK_SET );
 			fbuf =  (byte *)Mem_Alloc( rt.length, TAG_RESOURCE );
-			inFile->Read( fbuf, rt.length );
+			if ( !container.ReadResource( rt, fbuf ) ) {
+				idLib::Warning( "Unable to read %s from %s", rt.filename.c_str(), _fileName );
+			}
 		}
 		idStr outName = _outPath;
 		outName.AppendPath( rt.filename );
@@ -353,8 +814,6 @@ void idResourceContainer::ExtractResourceFile ( const char * _fileName, const ch
 		}
 		Mem_Free( fbuf );
 	}
-	delete inFile;
-	Mem_Free( buf );
 }
 
 
@@ -422,14 +881,7 @@ void idResourceContainer::WriteResourceFile( const char *manifestName, const idS
 
 		idLib::Printf( "Writing resource file %s\n", fileName.c_str() );
 
-		int	tableOffset = 0;
-		int	tableLength = 0;
-		int	tableNewLength = 0;
-		uint32	resourceFileMagic = RESOURCE_FILE_MAGIC;
-
-		resFile->WriteBig( resourceFileMagic );
-		resFile->WriteBig( tableOffset );
-		resFile->WriteBig( tableLength );
+		idResourceWriter writer( resFile, fs_compressResourceFiles.GetBool() );
 
 		idList< idResourceCacheEntry > entries;
 
@@ -452,18 +904,10 @@ void idResourceContainer::WriteResourceFile( const char *manifestName, const idS
 			ent.length = fm->Length();
 
 			// always get the offset, even if the file will have zero length
-			ent.offset = resFile->Tell();
+			ent.offset = writer.Write( fm->GetDataPtr(), ent.length );
 
 			entries.Append( ent );
 
-			if ( ent.length == 0 ) {
-				ent.filename = "";
-				delete fm;
-				continue;
-			}
-
-			resFile->Write( fm->GetDataPtr(), ent.length );
-
 			delete fm;
 
 			// pacifier every ten megs
@@ -475,28 +919,11 @@ void idResourceContainer::WriteResourceFile( const char *manifestName, const idS
 		idLib::Printf( "\n" );
 
 		// write the table out now that we have all the files
-		tableOffset = resFile->Tell();
-
-		// count how many we are going to write for this platform
-		int	numFileResources = entries.Num();
-
-		resFile->WriteBig( numFileResources );
+		const bool written = writer.Finish( entries );
+		delete resFile;
 
-		// write the individual resource entries
-		for ( int i = 0; i < entries.Num(); i++ ) {
-			entries[ i ].Write( resFile );
-			if ( i + 1 == numFileResources ) {
-				// we just wrote out the last new entry
-				tableNewLength = resFile->Tell() - tableOffset;
-			}
+		if ( !written ) {
+			fileSystem->RemoveFile( fileName );
 		}
-
-		// go back and write the header offsets again, now that we have file offsets and lengths
-		tableLength = resFile->Tell() - tableOffset;
-		resFile->Seek( 0, FS_SEEK_SET );
-		resFile->WriteBig( resourceFileMagic );
-		resFile->WriteBig( tableOffset );
-		resFile->WriteBig( tableLength );
-		delete resFile;
 	}
 }
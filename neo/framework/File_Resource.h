@@ -37,6 +37,19 @@ If you have questions concerning this license or the applicable additional terms
 ==============================================================
 */
 
+static const uint32 RESOURCE_FILE_MAGIC = 0xD000000D;
+// version 2 containers have 64 bit offsets and keep the resources in one stream that is cut
+// into chunks, each compressed on its own so a resource can be read without the ones before it
+static const uint32 RESOURCE_FILE_MAGIC_V2 = 0xD000200D;
+static const int RESOURCE_CHUNK_SIZE = 64 * 1024;
+static const int RESOURCE_MIN_PARALLEL_CHUNKS = 8;		// fewer chunks are decompressed on the calling thread
+static const int RESOURCE_MAX_PARALLEL_JOBS = 32;
+
+struct resourceChunk_t {
+	int64				offset;				// of the compressed chunk in the container
+	int					compressedLength;	// equal to the chunk size if the chunk is stored uncompressed
+};
+
 class idResourceCacheEntry {
 public:
 	idResourceCacheEntry() {
@@ -49,27 +62,37 @@ public:
 		length = 0;
 		containerIndex = 0;
 	}
-	size_t Read( idFile *f ) {
+	size_t Read( idFile *f, bool wideOffsets = false ) {
 		size_t sz = f->ReadString( filename );
-		sz += f->ReadBig( offset );
+		if ( wideOffsets ) {
+			sz += f->ReadBig( offset );
+		} else {
+			int offset32 = 0;
+			sz += f->ReadBig( offset32 );
+			offset = offset32;
+		}
 		sz += f->ReadBig( length );
 		return sz;
 	}
-	size_t Write( idFile *f ) {
+	size_t Write( idFile *f, bool wideOffsets = false ) const {
 		size_t sz = f->WriteString( filename );
-		sz += f->WriteBig( offset );
+		if ( wideOffsets ) {
+			sz += f->WriteBig( offset );
+		} else {
+			sz += f->WriteBig( (int)offset );
+		}
 		sz += f->WriteBig( length );
 		return sz;
 	}
 	idStrStatic< 256 >	filename;
-	int					offset;							// into the resource file
+	int64				offset;							// into the resource file, or into the uncompressed stream of a version 2 container
 	int 				length;
 	uint8				containerIndex;
 };
 
-static const uint32 RESOURCE_FILE_MAGIC = 0xD000000D;
 class idResourceContainer {
 	friend class	idFileSystemLocal;
+	friend class	idResourcePreloader;
 	//friend class	idReadSpawnThread;
 public:
 	idResourceContainer() {
@@ -78,30 +101,55 @@ public:
 		tableLength = 0;
 		resourceMagic = 0;
 		numFileResources = 0;
+		mappedData = NULL;
+		mappedLength = 0;
+		compressed = false;
+		chunkSize = RESOURCE_CHUNK_SIZE;
+		dataLength = 0;
 	}
 	~idResourceContainer() {
+		Sys_UnmapFile( mappedData );
 		delete resourceFile;
 		cacheTable.Clear();
 	}
 	bool Init( const char * fileName, uint8 containerIndex );
+	// opens a container for the resource tools, which only warn about bad files and don't map them
+	bool Open( const char * fileName );
 	static void WriteResourceFile( const char *fileName, const idStrList &manifest, const bool &_writeManifest );
 	static void WriteManifestFile( const char *name, const idStrList &list );
 	static int ReadManifestFile( const char *filename, idStrList &list );
 	static void ExtractResourceFile ( const char * fileName, const char * outPath, bool copyWavs );
 	static void UpdateResourceFile( const char *filename, const idStrList &filesToAdd );
 	idFile *OpenFile( const char *fileName );
+	idFile *OpenFile( const idResourceCacheEntry & rc );
+	// returns a pointer straight into the mapped container, or NULL if the container isn't mapped
+	// or is compressed
+	const byte * GetMappedData( const idResourceCacheEntry & rc ) const;
+	bool IsMapped() const { return mappedData != NULL; }
+	bool IsCompressed() const { return compressed; }
+	// reads the whole resource, decompressing it if needed; safe to call from several threads
+	bool ReadResource( const idResourceCacheEntry & rc, void * dest ) const;
+	bool DecompressRange( int64 offset, int length, byte * dest ) const;
+	static void FreeDecompressionJobs();
 	const char * GetFileName() const { return fileName.c_str(); }
 	void SetContainerIndex( const int & _idx );
 	void ReOpen();
 private:
+	bool ReadTable( uint8 containerIndex );
+
 	idStrStatic< 256 > fileName;
 	idFile *	resourceFile;			// open file handle
-	// offset should probably be a 64 bit value for development, but 4 gigs won't fit on
-	// a DVD layer, so it isn't a retail limitation.
-	int		tableOffset;			// table offset
+	// version 1 containers store it in 32 bits, which caps them at 2 gigs
+	int64	tableOffset;			// table offset
 	int		tableLength;			// table length
 	int		resourceMagic;			// magic
 	int		numFileResources;		// number of file resources in this container
+	const byte *	mappedData;		// read only view of the whole container when it is memory mapped
+	int64	mappedLength;
+	bool	compressed;				// version 2 container
+	int		chunkSize;				// uncompressed size of every chunk but the last
+	int64	dataLength;				// uncompressed size of all the resources
+	idList< resourceChunk_t, TAG_RESOURCE >	chunks;
 	idList< idResourceCacheEntry, TAG_RESOURCE>	cacheTable;
 	idHashIndex	cacheHash;
 };
@@ -37,6 +37,533 @@ If you have questions concerning this license or the applicable additional terms
 
 #undef new
 
+/*
+===============================================================================
+
+	Size class pool allocator
+
+	Small allocations are served from 64k pages that each hold blocks of a
+	single size class. Every thread keeps a cache of free blocks for each size
+	class and only touches the shared lock-free free lists when its cache runs
+	empty or grows too large.
+
+	All pages live in one reserved range of address space, so Mem_Free16 can
+	tell pool blocks from system heap allocations by their address alone. That
+	also means the pool can be switched on at startup while older allocations
+	from the system heap are still around.
+
+	The shared free lists link blocks by their 32 bit offset from the start of
+	the range and pack a change counter in the upper 32 bits of the list head,
+	so a single 64 bit compare-exchange avoids the ABA problem.
+
+===============================================================================
+*/
+
+static idCVar mem_poolAllocator( "mem_poolAllocator", "0", CVAR_SYSTEM | CVAR_INIT | CVAR_BOOL, "serve small allocations from the size class pool allocator instead of the system heap" );
+
+static const int	MEM_POOL_PAGE_SIZE		= 64 * 1024;
+static const int	MEM_POOL_MAX_ALLOC		= 2048;
+static const int	MEM_POOL_CACHE_BYTES	= 32 * 1024;	// per thread and size class before blocks go back to the shared lists
+#ifdef _WIN64
+static const UINT_PTR	MEM_POOL_RESERVE	= 1024 * 1024 * 1024;
+#else
+static const UINT_PTR	MEM_POOL_RESERVE	= 256 * 1024 * 1024;
+#endif
+
+static const int memPoolClassSizes[] = {
+	16, 32, 48, 64, 80, 96, 112, 128,
+	160, 192, 224, 256, 320, 384, 448, 512,
+	640, 768, 896, 1024, 1280, 1536, 1792, 2048
+};
+static const int MEM_POOL_NUM_CLASSES = sizeof( memPoolClassSizes ) / sizeof( memPoolClassSizes[0] );
+
+compile_time_assert( MEM_POOL_NUM_CLASSES <= 256 );
+compile_time_assert( TAG_NUM_TAGS <= 256 );
+
+// at the start of every page
+struct memPoolPage_t {
+	int						sizeClass;
+	int						blockSize;
+	int						firstBlock;		// offset of the first block from the start of the page
+	int						numBlocks;
+	byte					tags[1];		// tag of every allocated block so frees can update the per tag statistics
+};
+
+struct memPoolThreadCache_t {
+	unsigned int			free[MEM_POOL_NUM_CLASSES];		// offset of the first free block, 0 if empty
+	int						count[MEM_POOL_NUM_CLASSES];
+	int64					requestedBytes;
+	int64					blockBytes;
+	int64					numAllocs[TAG_NUM_TAGS];
+	int64					liveBytes[TAG_NUM_TAGS];		// may go negative when blocks are freed on another thread
+};
+
+class idMemPool {
+public:
+							idMemPool();
+
+	void					Init();
+	bool					IsInitialized() const { return base != NULL; }
+
+	bool					Owns( const void * ptr ) const { return ( (UINT_PTR)ptr - (UINT_PTR)base ) < reservedSize; }
+
+	// returns NULL if the allocation should come from the system heap instead
+	void *					Alloc( const int size, const memTag_t tag );
+	void					Free( void * ptr );
+
+	void					PrintStats();
+
+	// gives the cached blocks of an exiting thread back to the shared lists
+	void					ReleaseThreadCache( int index );
+
+private:
+	byte *					base;
+	UINT_PTR				reservedSize;		// zero until the pool is initialized so Owns() fails
+	int						maxPages;
+	idSysInterlockedInteger	numPages;
+	interlockedInt64_t		sharedFree[MEM_POOL_NUM_CLASSES];
+	byte					classForSize[MEM_POOL_MAX_ALLOC / 16 + 1];
+	int						cacheLimit[MEM_POOL_NUM_CLASSES];
+
+	memPoolThreadCache_t	threadCaches[MEM_MAX_THREADS];
+	interlockedInt64_t		sharedLiveBytes[TAG_NUM_TAGS];	// frees from threads without a cache, only ever goes down
+
+	// last PrintStats for the allocation rates
+	uint64					lastStatsTime;
+	int64					lastNumAllocs[TAG_NUM_TAGS];
+
+	unsigned int &			NextBlock( unsigned int block ) { return *(unsigned int *)( base + block ); }
+	memPoolPage_t *			PageForBlock( unsigned int block ) { return (memPoolPage_t *)( base + ( block & ~( MEM_POOL_PAGE_SIZE - 1 ) ) ); }
+
+	memPoolThreadCache_t *	GetThreadCache();
+	bool					Refill( memPoolThreadCache_t & cache, int sizeClass );
+	bool					AllocPage( memPoolThreadCache_t & cache, int sizeClass );
+	unsigned int			PopShared( int sizeClass );
+	void					PushShared( int sizeClass, unsigned int first, unsigned int last );
+};
+
+static idMemPool			memPool;
+static bool					memPoolEnabled;
+
+compile_time_assert( MEM_MAX_THREADS <= 64 );
+
+static interlockedInt64_t	memUsedThreadIndices;	// one bit per index that belongs to a running thread
+static ID_TLS				memThreadIndex;		// one based, -1 if the thread didn't get an index or released it
+
+/*
+========================
+Mem_ThreadIndex
+========================
+*/
+int Mem_ThreadIndex() {
+	int index = (int)(ptrdiff_t)memThreadIndex;
+	if ( index == 0 ) {
+		index = -1;
+		for ( ; ; ) {
+			const interlockedInt64_t used = memUsedThreadIndices;
+			int freeIndex = 0;
+			while ( freeIndex < MEM_MAX_THREADS && ( (uint64)used & ( (uint64)1 << freeIndex ) ) != 0 ) {
+				freeIndex++;
+			}
+			if ( freeIndex == MEM_MAX_THREADS ) {
+				break;
+			}
+			if ( Sys_InterlockedCompareExchange64( memUsedThreadIndices, used, (interlockedInt64_t)( (uint64)used | ( (uint64)1 << freeIndex ) ) ) == used ) {
+				index = freeIndex + 1;
+				break;
+			}
+		}
+		memThreadIndex = (ptrdiff_t)index;
+	}
+	return ( index < 0 ) ? -1 : index - 1;
+}
+
+/*
+========================
+Mem_ReleaseThreadIndex
+
+The blocks in the pool cache of the thread go back to the shared lists. The magazines of an
+idConcurrentBlockAlloc stay with the index and are used by the next thread that gets it.
+Allocations the thread still makes after this take the shared paths.
+========================
+*/
+void Mem_ReleaseThreadIndex() {
+	const int index = (int)(ptrdiff_t)memThreadIndex;
+	memThreadIndex = (ptrdiff_t)-1;
+	if ( index <= 0 ) {
+		return;
+	}
+	memPool.ReleaseThreadCache( index - 1 );
+	for ( ; ; ) {
+		const interlockedInt64_t used = memUsedThreadIndices;
+		if ( Sys_InterlockedCompareExchange64( memUsedThreadIndices, used, (interlockedInt64_t)( (uint64)used & ~( (uint64)1 << ( index - 1 ) ) ) ) == used ) {
+			break;
+		}
+	}
+}
+
+/*
+========================
+idMemPool::idMemPool
+
+Runs during static initialization, possibly after other constructors
+already allocated memory, so it must not touch anything else.
+========================
+*/
+idMemPool::idMemPool() :
+	base( NULL ),
+	reservedSize( 0 ),
+	maxPages( 0 ),
+	lastStatsTime( 0 ) {
+}
+
+/*
+========================
+idMemPool::Init
+========================
+*/
+void idMemPool::Init() {
+	if ( IsInitialized() ) {
+		return;
+	}
+
+	void * range = VirtualAlloc( NULL, MEM_POOL_RESERVE, MEM_RESERVE, PAGE_NOACCESS );
+	if ( range == NULL ) {
+		idLib::Warning( "couldn't reserve %d MB of address space for the pool allocator", (int)( MEM_POOL_RESERVE >> 20 ) );
+		return;
+	}
+
+	for ( int i = 0; i <= MEM_POOL_MAX_ALLOC / 16; i++ ) {
+		int sizeClass = 0;
+		while ( memPoolClassSizes[sizeClass] < i * 16 ) {
+			sizeClass++;
+		}
+		classForSize[i] = (byte)sizeClass;
+	}
+	for ( int i = 0; i < MEM_POOL_NUM_CLASSES; i++ ) {
+		cacheLimit[i] = Max( 16, MEM_POOL_CACHE_BYTES / memPoolClassSizes[i] );
+		sharedFree[i] = 0;
+	}
+	memset( threadCaches, 0, sizeof( threadCaches ) );
+	memset( sharedLiveBytes, 0, sizeof( sharedLiveBytes ) );
+	memset( lastNumAllocs, 0, sizeof( lastNumAllocs ) );
+	lastStatsTime = Sys_Microseconds();
+
+	maxPages = (int)( MEM_POOL_RESERVE / MEM_POOL_PAGE_SIZE );
+	base = (byte *)range;
+	reservedSize = MEM_POOL_RESERVE;
+}
+
+/*
+========================
+idMemPool::GetThreadCache
+========================
+*/
+memPoolThreadCache_t * idMemPool::GetThreadCache() {
+	const int index = Mem_ThreadIndex();
+	if ( index < 0 ) {
+		return NULL;
+	}
+	return &threadCaches[index];
+}
+
+/*
+========================
+idMemPool::PopShared
+========================
+*/
+unsigned int idMemPool::PopShared( int sizeClass ) {
+	interlockedInt64_t & head = sharedFree[sizeClass];
+	for ( ; ; ) {
+		const interlockedInt64_t current = head;
+		const unsigned int block = (unsigned int)current;
+		if ( block == 0 ) {
+			return 0;
+		}
+		// the block may be popped and reused by another thread right now, in which
+		// case the change counter in the head makes the compare-exchange fail
+		const interlockedInt64_t next = ( ( current >> 32 ) + 1 ) << 32 | NextBlock( block );
+		if ( Sys_InterlockedCompareExchange64( head, current, next ) == current ) {
+			return block;
+		}
+	}
+}
+
+/*
+========================
+idMemPool::PushShared
+
+Pushes a chain of blocks that is already linked from first to last.
+========================
+*/
+void idMemPool::PushShared( int sizeClass, unsigned int first, unsigned int last ) {
+	interlockedInt64_t & head = sharedFree[sizeClass];
+	for ( ; ; ) {
+		const interlockedInt64_t current = head;
+		NextBlock( last ) = (unsigned int)current;
+		const interlockedInt64_t next = ( ( current >> 32 ) + 1 ) << 32 | first;
+		if ( Sys_InterlockedCompareExchange64( head, current, next ) == current ) {
+			return;
+		}
+	}
+}
+
+/*
+========================
+idMemPool::AllocPage
+
+Commits a new page and hands all of its blocks to the thread's cache.
+========================
+*/
+bool idMemPool::AllocPage( memPoolThreadCache_t & cache, int sizeClass ) {
+	const int pageNum = numPages.Increment() - 1;
+	if ( pageNum >= maxPages ) {
+		return false;
+	}
+
+	byte * pageStart = base + pageNum * MEM_POOL_PAGE_SIZE;
+	if ( VirtualAlloc( pageStart, MEM_POOL_PAGE_SIZE, MEM_COMMIT, PAGE_READWRITE ) == NULL ) {
+		return false;
+	}
+
+	const int blockSize = memPoolClassSizes[sizeClass];
+	const int headerSize = (int)offsetof( memPoolPage_t, tags );
+	int numBlocks = ( MEM_POOL_PAGE_SIZE - headerSize ) / ( blockSize + 1 );
+	int firstBlock = ( headerSize + numBlocks + 15 ) & ~15;
+	while ( firstBlock + numBlocks * blockSize > MEM_POOL_PAGE_SIZE ) {
+		numBlocks--;
+		firstBlock = ( headerSize + numBlocks + 15 ) & ~15;
+	}
+
+	memPoolPage_t * page = (memPoolPage_t *)pageStart;
+	page->sizeClass = sizeClass;
+	page->blockSize = blockSize;
+	page->firstBlock = firstBlock;
+	page->numBlocks = numBlocks;
+
+	// link the blocks so they are handed out in address order
+	const unsigned int pageOffset = (unsigned int)( pageStart - base );
+	for ( int i = numBlocks - 1; i >= 0; i-- ) {
+		const unsigned int block = pageOffset + firstBlock + i * blockSize;
+		NextBlock( block ) = cache.free[sizeClass];
+		cache.free[sizeClass] = block;
+	}
+	cache.count[sizeClass] += numBlocks;
+	return true;
+}
+
+/*
+========================
+idMemPool::Refill
+========================
+*/
+bool idMemPool::Refill( memPoolThreadCache_t & cache, int sizeClass ) {
+	const int batch = cacheLimit[sizeClass] / 2;
+	for ( int i = 0; i < batch; i++ ) {
+		const unsigned int block = PopShared( sizeClass );
+		if ( block == 0 ) {
+			break;
+		}
+		NextBlock( block ) = cache.free[sizeClass];
+		cache.free[sizeClass] = block;
+		cache.count[sizeClass]++;
+	}
+	if ( cache.count[sizeClass] > 0 ) {
+		return true;
+	}
+	return AllocPage( cache, sizeClass );
+}
+
+/*
+========================
+idMemPool::Alloc
+========================
+*/
+void * idMemPool::Alloc( const int size, const memTag_t tag ) {
+	assert( size > 0 && size <= MEM_POOL_MAX_ALLOC );
+
+	memPoolThreadCache_t * cache = GetThreadCache();
+	if ( cache == NULL ) {
+		// more threads than caches, these use the system heap
+		return NULL;
+	}
+
+	const int sizeClass = classForSize[( size + 15 ) >> 4];
+	if ( cache->count[sizeClass] == 0 && !Refill( *cache, sizeClass ) ) {
+		// out of reserved address space
+		return NULL;
+	}
+
+	const unsigned int block = cache->free[sizeClass];
+	cache->free[sizeClass] = NextBlock( block );
+	cache->count[sizeClass]--;
+
+	memPoolPage_t * page = PageForBlock( block );
+	page->tags[( block - ( (byte *)page - base ) - page->firstBlock ) / page->blockSize] = (byte)tag;
+
+	cache->requestedBytes += size;
+	cache->blockBytes += page->blockSize;
+	cache->numAllocs[tag]++;
+	cache->liveBytes[tag] += page->blockSize;
+
+	return base + block;
+}
+
+/*
+========================
+idMemPool::Free
+========================
+*/
+void idMemPool::Free( void * ptr ) {
+	const unsigned int block = (unsigned int)( (byte *)ptr - base );
+	memPoolPage_t * page = PageForBlock( block );
+	const int sizeClass = page->sizeClass;
+
+	const byte tag = page->tags[( block - ( (byte *)page - base ) - page->firstBlock ) / page->blockSize];
+
+	memPoolThreadCache_t * cache = GetThreadCache();
+	if ( cache == NULL ) {
+		for ( ; ; ) {
+			const interlockedInt64_t liveBytes = sharedLiveBytes[tag];
+			if ( Sys_InterlockedCompareExchange64( sharedLiveBytes[tag], liveBytes, liveBytes - page->blockSize ) == liveBytes ) {
+				break;
+			}
+		}
+		PushShared( sizeClass, block, block );
+		return;
+	}
+
+	cache->liveBytes[tag] -= page->blockSize;
+
+	NextBlock( block ) = cache->free[sizeClass];
+	cache->free[sizeClass] = block;
+	cache->count[sizeClass]++;
+
+	if ( cache->count[sizeClass] > cacheLimit[sizeClass] ) {
+		// give half of the cached blocks back to the other threads
+		const int batch = cacheLimit[sizeClass] / 2;
+		const unsigned int first = cache->free[sizeClass];
+		unsigned int last = first;
+		for ( int i = 1; i < batch; i++ ) {
+			last = NextBlock( last );
+		}
+		cache->free[sizeClass] = NextBlock( last );
+		cache->count[sizeClass] -= batch;
+		PushShared( sizeClass, first, last );
+	}
+}
+
+/*
+========================
+idMemPool::ReleaseThreadCache
+
+The statistics stay in the cache, the next thread with the same index adds to them.
+========================
+*/
+void idMemPool::ReleaseThreadCache( int index ) {
+	if ( !IsInitialized() ) {
+		return;
+	}
+	memPoolThreadCache_t & cache = threadCaches[index];
+	for ( int sizeClass = 0; sizeClass < MEM_POOL_NUM_CLASSES; sizeClass++ ) {
+		if ( cache.count[sizeClass] == 0 ) {
+			continue;
+		}
+		const unsigned int first = cache.free[sizeClass];
+		unsigned int last = first;
+		for ( int i = 1; i < cache.count[sizeClass]; i++ ) {
+			last = NextBlock( last );
+		}
+		PushShared( sizeClass, first, last );
+		cache.free[sizeClass] = 0;
+		cache.count[sizeClass] = 0;
+	}
+}
+
+/*
+========================
+idMemPool::PrintStats
+
+The numbers are summed up from all thread caches without locking,
+so they can be slightly off while other threads allocate.
+========================
+*/
+void idMemPool::PrintStats() {
+	static const char * tagNames[] = {
+#define MEM_TAG( x )	#x,
+#include "sys/sys_alloc_tags.h"
+	};
+
+	if ( !IsInitialized() ) {
+		idLib::Printf( "pool allocator is not initialized\n" );
+		return;
+	}
+
+	const uint64 now = Sys_Microseconds();
+	const float seconds = Max( now - lastStatsTime, (uint64)1 ) * ( 1.0f / 1000000.0f );
+	lastStatsTime = now;
+
+	// caches of exited threads still hold their statistics
+	const int numCaches = MEM_MAX_THREADS;
+	int numThreads = 0;
+	for ( int i = 0; i < MEM_MAX_THREADS; i++ ) {
+		if ( ( (uint64)memUsedThreadIndices & ( (uint64)1 << i ) ) != 0 ) {
+			numThreads++;
+		}
+	}
+	int64 requestedBytes = 0;
+	int64 blockBytes = 0;
+	int64 liveBytes = 0;
+	int64 cachedBytes = 0;
+	for ( int i = 0; i < numCaches; i++ ) {
+		requestedBytes += threadCaches[i].requestedBytes;
+		blockBytes += threadCaches[i].blockBytes;
+		for ( int j = 0; j < MEM_POOL_NUM_CLASSES; j++ ) {
+			cachedBytes += (int64)threadCaches[i].count[j] * memPoolClassSizes[j];
+		}
+	}
+
+	idLib::Printf( "tag                   allocs/sec     live KB\n" );
+	for ( int tag = 0; tag < TAG_NUM_TAGS; tag++ ) {
+		int64 numAllocs = 0;
+		int64 tagLiveBytes = sharedLiveBytes[tag];
+		for ( int i = 0; i < numCaches; i++ ) {
+			numAllocs += threadCaches[i].numAllocs[tag];
+			tagLiveBytes += threadCaches[i].liveBytes[tag];
+		}
+		liveBytes += tagLiveBytes;
+		const int64 newAllocs = numAllocs - lastNumAllocs[tag];
+		lastNumAllocs[tag] = numAllocs;
+		if ( newAllocs == 0 && tagLiveBytes == 0 ) {
+			continue;
+		}
+		idLib::Printf( "%-20s %11.0f %11d\n", tagNames[tag], newAllocs / seconds, (int)( tagLiveBytes >> 10 ) );
+	}
+
+	const int committedPages = Min( numPages.GetValue(), maxPages );
+	const int64 committedBytes = (int64)committedPages * MEM_POOL_PAGE_SIZE;
+	idLib::Printf( "%d threads, %d pages, %d KB committed, %d KB live, %d KB in thread caches\n", numThreads, committedPages, (int)( committedBytes >> 10 ), (int)( liveBytes >> 10 ), (int)( cachedBytes >> 10 ) );
+	// internal: rounding requests up to the size class, external: committed memory not holding live blocks
+	idLib::Printf( "fragmentation: %.1f%% internal, %.1f%% external\n",
+					( blockBytes > 0 ) ? 100.0f * ( 1.0f - (float)requestedBytes / blockBytes ) : 0.0f,
+					( committedBytes > 0 ) ? 100.0f * ( 1.0f - (float)liveBytes / committedBytes ) : 0.0f );
+}
+
+/*
+==================
+Mem_Init
+
+Called once the command line has been parsed, the allocator
+can't be changed after this.
+==================
+*/
+void Mem_Init() {
+	if ( mem_poolAllocator.GetBool() ) {
+		memPool.Init();
+		memPoolEnabled = memPool.IsInitialized();
+	}
+}
+
 /*
 ==================
 Mem_Alloc16
@@ -46,6 +573,12 @@ void * Mem_Alloc16( const int size, const memTag_t tag ) {
 	if ( !size ) {
 		return NULL;
 	}
+	if ( memPoolEnabled && size <= MEM_POOL_MAX_ALLOC ) {
+		void * mem = memPool.Alloc( size, tag );
+		if ( mem != NULL ) {
+			return mem;
+		}
+	}
 	const int paddedSize = ( size + 15 ) & ~15;
 	return _aligned_malloc( paddedSize, 16 );
 }
@@ -59,6 +592,10 @@ void Mem_Free16( void *ptr ) {
 	if ( ptr == NULL ) {
 		return;
 	}
+	if ( memPool.Owns( ptr ) ) {
+		memPool.Free( ptr );
+		return;
+	}
 	_aligned_free( ptr );
 }
 
@@ -84,3 +621,212 @@ char *Mem_CopyString( const char *in ) {
 	return out;
 }
 
+/*
+==================
+mem_poolStats
+==================
+*/
+CONSOLE_COMMAND( mem_poolStats, "prints allocation rates and live memory per tag and the fragmentation of the pool allocator", 0 ) {
+	memPool.PrintStats();
+}
+
+/*
+==================
+testMemPool
+
+Every job churns through its own set of slots, freeing and allocating
+blocks of mostly small random sizes the way idStr and idList buffers
+come and go, first on the system heap and then on the pool.
+==================
+*/
+struct memPoolTest_t {
+	int				numOps;
+	int				seed;
+	bool			usePool;
+	uint64			time;
+};
+
+static void MemPoolTestJob( memPoolTest_t * test ) {
+	static const int NUM_SLOTS = 1024;
+	void * slots[NUM_SLOTS] = {};
+	idRandom random( test->seed );
+
+	const uint64 start = Sys_Microseconds();
+	for ( int i = 0; i < test->numOps; i++ ) {
+		const int slot = random.RandomInt( NUM_SLOTS );
+		if ( slots[slot] != NULL ) {
+			if ( test->usePool ) {
+				memPool.Free( slots[slot] );
+			} else {
+				_aligned_free( slots[slot] );
+			}
+		}
+		// mostly small strings and lists with the occasional bigger buffer
+		const int size = ( random.RandomInt( 8 ) == 0 ) ? 16 + random.RandomInt( MEM_POOL_MAX_ALLOC - 16 ) : 16 + random.RandomInt( 112 );
+		const memTag_t tag = ( slot & 1 ) ? TAG_STRING : TAG_IDLIB_LIST;
+		slots[slot] = test->usePool ? memPool.Alloc( size, tag ) : _aligned_malloc( ( size + 15 ) & ~15, 16 );
+		if ( slots[slot] != NULL ) {
+			*(int *)slots[slot] = i;
+		}
+	}
+	for ( int slot = 0; slot < NUM_SLOTS; slot++ ) {
+		if ( slots[slot] != NULL ) {
+			if ( test->usePool ) {
+				memPool.Free( slots[slot] );
+			} else {
+				_aligned_free( slots[slot] );
+			}
+		}
+	}
+	test->time = Sys_Microseconds() - start;
+}
+REGISTER_PARALLEL_JOB( MemPoolTestJob, "MemPoolTestJob" );
+
+CONSOLE_COMMAND( testMemPool, "compares the system heap against the pool allocator on all job threads, usage: testMemPool [opsPerThread]", 0 ) {
+	const int numOps = ( args.Argc() > 1 ) ? Max( 1000, atoi( args.Argv( 1 ) ) ) : 1000000;
+	const int numThreads = Max( 1, parallelJobManager->GetNumProcessingUnits() );
+
+	// the pool can be set up for testing even if it isn't serving Mem_Alloc16
+	memPool.Init();
+	if ( !memPool.IsInitialized() ) {
+		return;
+	}
+
+	idList< memPoolTest_t, TAG_IDLIB > tests;
+	tests.SetNum( numThreads );
+
+	idParallelJobList * jobList = parallelJobManager->AllocJobList( JOBLIST_UTILITY, JOBLIST_PRIORITY_MEDIUM, numThreads, 0, NULL );
+
+	for ( int usePool = 0; usePool < 2; usePool++ ) {
+		for ( int i = 0; i < numThreads; i++ ) {
+			tests[i].numOps = numOps;
+			tests[i].seed = i * 7919;
+			tests[i].usePool = ( usePool != 0 );
+			tests[i].time = 0;
+			jobList->AddJob( (jobRun_t)MemPoolTestJob, &tests[i] );
+		}
+		const uint64 start = Sys_Microseconds();
+		jobList->Submit( NULL, numThreads );
+		jobList->Wait();
+		const uint64 total = Max( Sys_Microseconds() - start, (uint64)1 );
+
+		idLib::Printf( "%-12s %d threads: %6.2f million ops per second\n", usePool ? "pool" : "system heap", numThreads, (float)numOps * numThreads / total );
+	}
+
+	parallelJobManager->FreeJobList( jobList );
+}
+
+/*
+==================
+testConcurrentBlockAlloc
+
+Every job allocates and frees nodes in random order, and passes some of them to the other
+jobs to be freed there. Each node is stamped with its job and slot when it's handed out, so a
+node handed out twice shows up as a wrong stamp, and once every node is freed again all blocks
+have to be empty.
+==================
+*/
+struct concurrentAllocTestNode_t {
+	int				job;
+	int				slot;
+	int				pad[6];
+};
+
+typedef idConcurrentBlockAlloc< concurrentAllocTestNode_t, 64, TAG_IDLIB > concurrentAllocTest_t;
+
+static const int CONCURRENT_ALLOC_TEST_EXCHANGE = 64;
+
+struct concurrentAllocTestParms_t {
+	concurrentAllocTest_t *	allocator;
+	void **					exchange;		// nodes on their way to another job, shared by all jobs
+	int						job;
+	int						numOps;
+	int						numErrors;
+};
+
+static void ConcurrentAllocTestJob( concurrentAllocTestParms_t * parms ) {
+	static const int NUM_SLOTS = 512;
+	concurrentAllocTestNode_t * slots[NUM_SLOTS] = {};
+	idRandom random( parms->job * 7919 + 1 );
+
+	for ( int i = 0; i < parms->numOps; i++ ) {
+		const int slot = random.RandomInt( NUM_SLOTS );
+		concurrentAllocTestNode_t * node = slots[slot];
+		if ( node == NULL ) {
+			node = parms->allocator->Alloc();
+			if ( node == NULL ) {
+				parms->numErrors++;
+				continue;
+			}
+			node->job = parms->job;
+			node->slot = slot;
+			slots[slot] = node;
+			continue;
+		}
+		if ( node->job != parms->job || node->slot != slot ) {
+			// another job got the same node
+			parms->numErrors++;
+		}
+		slots[slot] = NULL;
+		if ( random.RandomInt( 4 ) == 0 ) {
+			// free the node another job left instead
+			node = (concurrentAllocTestNode_t *)Sys_InterlockedExchangePointer( parms->exchange[random.RandomInt( CONCURRENT_ALLOC_TEST_EXCHANGE )], node );
+		}
+		parms->allocator->Free( node );
+	}
+	for ( int slot = 0; slot < NUM_SLOTS; slot++ ) {
+		if ( slots[slot] != NULL ) {
+			if ( slots[slot]->job != parms->job || slots[slot]->slot != slot ) {
+				parms->numErrors++;
+			}
+			parms->allocator->Free( slots[slot] );
+		}
+	}
+}
+REGISTER_PARALLEL_JOB( ConcurrentAllocTestJob, "ConcurrentAllocTestJob" );
+
+CONSOLE_COMMAND( testConcurrentBlockAlloc, "stresses idConcurrentBlockAlloc on all job threads and checks for nodes handed out twice or lost, usage: testConcurrentBlockAlloc [opsPerThread]", 0 ) {
+	const int numOps = ( args.Argc() > 1 ) ? Max( 1000, atoi( args.Argv( 1 ) ) ) : 1000000;
+	const int numThreads = Max( 1, parallelJobManager->GetNumProcessingUnits() );
+
+	concurrentAllocTest_t * allocator = new ( TAG_IDLIB ) concurrentAllocTest_t();
+	void * exchange[CONCURRENT_ALLOC_TEST_EXCHANGE] = {};
+
+	idList< concurrentAllocTestParms_t, TAG_IDLIB > tests;
+	tests.SetNum( numThreads );
+
+	idParallelJobList * jobList = parallelJobManager->AllocJobList( JOBLIST_UTILITY, JOBLIST_PRIORITY_MEDIUM, numThreads, 0, NULL );
+	for ( int i = 0; i < numThreads; i++ ) {
+		tests[i].allocator = allocator;
+		tests[i].exchange = exchange;
+		tests[i].job = i;
+		tests[i].numOps = numOps;
+		tests[i].numErrors = 0;
+		jobList->AddJob( (jobRun_t)ConcurrentAllocTestJob, &tests[i] );
+	}
+	const uint64 start = Sys_Microseconds();
+	jobList->Submit( NULL, numThreads );
+	jobList->Wait();
+	const uint64 total = Max( Sys_Microseconds() - start, (uint64)1 );
+	parallelJobManager->FreeJobList( jobList );
+
+	int numErrors = 0;
+	for ( int i = 0; i < numThreads; i++ ) {
+		numErrors += tests[i].numErrors;
+	}
+	for ( int i = 0; i < CONCURRENT_ALLOC_TEST_EXCHANGE; i++ ) {
+		allocator->Free( (concurrentAllocTestNode_t *)exchange[i] );
+	}
+	const int numBlocks = allocator->GetTotalCount() / 64;
+	const int numLeaked = allocator->GetAllocCount();
+	allocator->FreeEmptyBlocks();
+	const int numLeftOver = allocator->GetTotalCount();
+	delete allocator;
+
+	idLib::Printf( "%d threads: %6.2f million ops per second, %d blocks\n", numThreads, (float)numOps * numThreads / total, numBlocks );
+	if ( numErrors > 0 || numLeaked != 0 || numLeftOver != 0 ) {
+		idLib::Warning( "testConcurrentBlockAlloc: %d nodes handed out twice, %d leaked, %d left in blocks that should be empty", numErrors, numLeaked, numLeftOver );
+	} else {
+		idLib::Printf( "no nodes handed out twice or leaked\n" );
+	}
+}
@@ -49,6 +49,15 @@ static const int MAX_TAGS = 256;
 
 
 
+void		Mem_Init();
+
+// threads that allocate get a small index for their caches, once all indices are
+// taken Mem_ThreadIndex returns -1 and those threads have to use a shared path
+static const int MEM_MAX_THREADS = 64;
+int			Mem_ThreadIndex();
+// called when a thread exits, flushes its caches and lets another thread reuse the index
+void		Mem_ReleaseThreadIndex();
+
 void *		Mem_Alloc16( const int size, const memTag_t tag );
 void		Mem_Free16( void *ptr );
 
@@ -420,6 +429,452 @@ ID_INLINE void idBlockAlloc<_type_,_blockSize_,memTag>::FreeEmptyBlocks() {
 	}
 }
 
+/*
+================================================
+idConcurrentBlockAlloc is a drop-in replacement for idBlockAlloc that can be
+used from several threads at the same time.
+
+Every thread allocates from and frees into its own magazine of elements. Full
+magazines of _blockSize_ elements are traded through a lock-free stack, so a
+thread only touches shared memory about once every _blockSize_ allocations or
+frees. Elements freed on another thread simply move to that thread's magazine.
+
+Shutdown, SetFixedBlocks and FreeEmptyBlocks must not run while other threads
+use the allocator. After SetFixedBlocks, Alloc can return NULL while free
+elements are still cached by other threads.
+================================================
+*/
+template<class _type_, int _blockSize_, memTag_t memTag = TAG_BLOCKALLOC>
+class idConcurrentBlockAlloc {
+public:
+	ID_INLINE			idConcurrentBlockAlloc( bool clear = false );
+	ID_INLINE			~idConcurrentBlockAlloc();
+
+	// returns total size of allocated memory
+	size_t				Allocated() const { return total * sizeof( _type_ ); }
+
+	// returns total size of allocated memory including size of (*this)
+	size_t				Size() const { return sizeof( *this ) + Allocated(); }
+
+	ID_INLINE void		Shutdown();
+	ID_INLINE void		SetFixedBlocks( int numBlocks );
+	ID_INLINE void		FreeEmptyBlocks();
+
+	ID_INLINE _type_ *	Alloc();
+	ID_INLINE void		Free( _type_ *element );
+
+	int					GetTotalCount() const { return total; }
+	ID_INLINE int		GetAllocCount() const;
+	int					GetFreeCount() const { return total - GetAllocCount(); }
+
+private:
+	union element_t;
+
+	struct link_t {
+		element_t *		next;			// next element in the same magazine
+		element_t *		nextMagazine;	// next magazine on the shared stack, only set in the first element
+	};
+
+	union element_t {
+		_type_ *		data;	// this is a hack to make sure the save game system marks _type_ as saveable
+		link_t			link;
+		byte			buffer[( CONST_MAX( sizeof( _type_ ), sizeof( link_t ) ) + ( BLOCK_ALLOC_ALIGNMENT - 1 ) ) & ~( BLOCK_ALLOC_ALIGNMENT - 1 )];
+	};
+
+	class idBlock {
+	public:
+		element_t		elements[_blockSize_];
+		idBlock *		next;
+		element_t *		free;		// list with free elements in this block (temp used only by FreeEmptyBlocks)
+		int				freeCount;	// number of free elements in this block (temp used only by FreeEmptyBlocks)
+	};
+
+	// padded to a cache line so threads don't fight over them
+	struct magazine_t {
+		element_t *		free;
+		int				count;
+		int				active;		// allocs minus frees on this thread, negative if it freed elements from other threads
+		char			pad[64 - sizeof( element_t * ) - 2 * sizeof( int )];
+	};
+
+	// the upper bits of the stack head count changes to avoid the ABA problem,
+	// user mode pointers on 64 bit Windows fit in 48 bits
+	static const int	HEAD_TAG_SHIFT = ( sizeof( void * ) == 4 ) ? 32 : 48;
+
+	idBlock *			blocks;			// only grows while other threads use the allocator
+	interlockedInt64_t	fullMagazines;	// tagged head of the shared stack of full magazines
+	interlockedInt_t	total;
+	bool				allowAllocs;
+	bool				clearAllocs;
+
+	magazine_t			magazines[MEM_MAX_THREADS];
+	magazine_t			overflow;		// shared by threads without a Mem_ThreadIndex
+	mutexHandle_t		overflowLock;
+
+	static element_t *	HeadElement( interlockedInt64_t head ) { return (element_t *)(UINT_PTR)( (uint64)head & ( ( (uint64)1 << HEAD_TAG_SHIFT ) - 1 ) ); }
+	static interlockedInt64_t	NextHead( interlockedInt64_t head, element_t * element ) { return (interlockedInt64_t)( ( ( ( (uint64)head >> HEAD_TAG_SHIFT ) + 1 ) << HEAD_TAG_SHIFT ) | (UINT_PTR)element ); }
+
+	ID_INLINE element_t *	PopMagazine();
+	ID_INLINE void		PushMagazine( element_t * first );
+	ID_INLINE element_t *	AllocElement( magazine_t & magazine );
+	ID_INLINE void		FreeElement( magazine_t & magazine, element_t * element );
+	ID_INLINE void		GatherFree( magazine_t & magazine, element_t * & list );
+	ID_INLINE void		AllocNewBlock( magazine_t & magazine );
+};
+
+/*
+========================
+idConcurrentBlockAlloc<_type_,_blockSize_,memTag>::idConcurrentBlockAlloc
+========================
+*/
+template<class _type_, int _blockSize_, memTag_t memTag>
+ID_INLINE idConcurrentBlockAlloc<_type_,_blockSize_,memTag>::idConcurrentBlockAlloc( bool clear ) :
+	blocks( NULL ),
+	fullMagazines( 0 ),
+	total( 0 ),
+	allowAllocs( true ),
+	clearAllocs( clear )
+{
+	memset( magazines, 0, sizeof( magazines ) );
+	memset( &overflow, 0, sizeof( overflow ) );
+	Sys_MutexCreate( overflowLock );
+}
+
+/*
+========================
+idConcurrentBlockAlloc<_type_,_blockSize_,memTag>::~idConcurrentBlockAlloc
+========================
+*/
+template<class _type_, int _blockSize_, memTag_t memTag>
+ID_INLINE idConcurrentBlockAlloc<_type_,_blockSize_,memTag>::~idConcurrentBlockAlloc() {
+	Shutdown();
+	Sys_MutexDestroy( overflowLock );
+}
+
+/*
+========================
+idConcurrentBlockAlloc<_type_,_blockSize_,memTag>::Alloc
+========================
+*/
+template<class _type_, int _blockSize_, memTag_t memTag>
+ID_INLINE _type_ * idConcurrentBlockAlloc<_type_,_blockSize_,memTag>::Alloc() {
+#ifdef FORCE_DISCRETE_BLOCK_ALLOCS
+	// for debugging tools
+	return new _type_;
+#else
+	element_t * element;
+	const int threadIndex = Mem_ThreadIndex();
+	if ( threadIndex >= 0 ) {
+		element = AllocElement( magazines[threadIndex] );
+	} else {
+		Sys_MutexLock( overflowLock, true );
+		element = AllocElement( overflow );
+		Sys_MutexUnlock( overflowLock );
+	}
+	if ( element == NULL ) {
+		return NULL;
+	}
+
+	_type_ * t = (_type_ *) element->buffer;
+	if ( clearAllocs ) {
+		memset( t, 0, sizeof( _type_ ) );
+	}
+	new ( t ) _type_;
+	return t;
+#endif
+}
+
+/*
+========================
+idConcurrentBlockAlloc<_type_,_blockSize_,memTag>::Free
+========================
+*/
+template<class _type_, int _blockSize_, memTag_t memTag>
+ID_INLINE void idConcurrentBlockAlloc<_type_,_blockSize_,memTag>::Free( _type_ * t ) {
+#ifdef FORCE_DISCRETE_BLOCK_ALLOCS
+	// for debugging tools
+	delete t;
+#else
+	if ( t == NULL ) {
+		return;
+	}
+
+	t->~_type_();
+
+	element_t * element = (element_t *)( t );
+	const int threadIndex = Mem_ThreadIndex();
+	if ( threadIndex >= 0 ) {
+		magazines[threadIndex].active--;
+		FreeElement( magazines[threadIndex], element );
+	} else {
+		Sys_MutexLock( overflowLock, true );
+		overflow.active--;
+		FreeElement( overflow, element );
+		Sys_MutexUnlock( overflowLock );
+	}
+#endif
+}
+
+/*
+========================
+idConcurrentBlockAlloc<_type_,_blockSize_,memTag>::GetAllocCount
+
+Only exact while no other threads use the allocator.
+========================
+*/
+template<class _type_, int _blockSize_, memTag_t memTag>
+ID_INLINE int idConcurrentBlockAlloc<_type_,_blockSize_,memTag>::GetAllocCount() const {
+	int active = overflow.active;
+	for ( int i = 0; i < MEM_MAX_THREADS; i++ ) {
+		active += magazines[i].active;
+	}
+	return active;
+}
+
+/*
+========================
+idConcurrentBlockAlloc<_type_,_blockSize_,memTag>::PopMagazine
+========================
+*/
+template<class _type_, int _blockSize_, memTag_t memTag>
+ID_INLINE typename idConcurrentBlockAlloc<_type_,_blockSize_,memTag>::element_t * idConcurrentBlockAlloc<_type_,_blockSize_,memTag>::PopMagazine() {
+	for ( ; ; ) {
+		const interlockedInt64_t head = fullMagazines;
+		element_t * first = HeadElement( head );
+		if ( first == NULL ) {
+			return NULL;
+		}
+		// another thread may have taken this magazine already, in which case the
+		// link is stale but the tag in the head makes the compare-exchange fail
+		element_t * next = first->link.nextMagazine;
+		if ( Sys_InterlockedCompareExchange64( fullMagazines, head, NextHead( head, next ) ) == head ) {
+			return first;
+		}
+	}
+}
+
+/*
+========================
+idConcurrentBlockAlloc<_type_,_blockSize_,memTag>::PushMagazine
+========================
+*/
+template<class _type_, int _blockSize_, memTag_t memTag>
+ID_INLINE void idConcurrentBlockAlloc<_type_,_blockSize_,memTag>::PushMagazine( element_t * first ) {
+	for ( ; ; ) {
+		const interlockedInt64_t head = fullMagazines;
+		first->link.nextMagazine = HeadElement( head );
+		if ( Sys_InterlockedCompareExchange64( fullMagazines, head, NextHead( head, first ) ) == head ) {
+			return;
+		}
+	}
+}
+
+/*
+========================
+idConcurrentBlockAlloc<_type_,_blockSize_,memTag>::AllocElement
+========================
+*/
+template<class _type_, int _blockSize_, memTag_t memTag>
+ID_INLINE typename idConcurrentBlockAlloc<_type_,_blockSize_,memTag>::element_t * idConcurrentBlockAlloc<_type_,_blockSize_,memTag>::AllocElement( magazine_t & magazine ) {
+	if ( magazine.free == NULL ) {
+		element_t * full = PopMagazine();
+		if ( full != NULL ) {
+			magazine.free = full;
+			magazine.count = _blockSize_;
+		} else {
+			if ( !allowAllocs ) {
+				return NULL;
+			}
+			AllocNewBlock( magazine );
+		}
+	}
+
+	element_t * element = magazine.free;
+	magazine.free = element->link.next;
+	magazine.count--;
+	magazine.active++;
+	element->link.next = NULL;
+	return element;
+}
+
+/*
+========================
+idConcurrentBlockAlloc<_type_,_blockSize_,memTag>::FreeElement
+========================
+*/
+template<class _type_, int _blockSize_, memTag_t memTag>
+ID_INLINE void idConcurrentBlockAlloc<_type_,_blockSize_,memTag>::FreeElement( magazine_t & magazine, element_t * element ) {
+	element->link.next = magazine.free;
+	magazine.free = element;
+	magazine.count++;
+
+	if ( magazine.count >= 2 * _blockSize_ ) {
+		// hand a full magazine to the other threads
+		element_t * first = magazine.free;
+		element_t * last = first;
+		for ( int i = 1; i < _blockSize_; i++ ) {
+			last = last->link.next;
+		}
+		magazine.free = last->link.next;
+		magazine.count -= _blockSize_;
+		last->link.next = NULL;
+		PushMagazine( first );
+	}
+}
+
+/*
+========================
+idConcurrentBlockAlloc<_type_,_blockSize_,memTag>::AllocNewBlock
+========================
+*/
+template<class _type_, int _blockSize_, memTag_t memTag>
+ID_INLINE void idConcurrentBlockAlloc<_type_,_blockSize_,memTag>::AllocNewBlock( magazine_t & magazine ) {
+	idBlock * block = (idBlock *)Mem_Alloc( sizeof( idBlock ), memTag );
+	for ( ; ; ) {
+		idBlock * head = blocks;
+		block->next = head;
+		if ( Sys_InterlockedCompareExchangePointer( (void * &)blocks, head, block ) == head ) {
+			break;
+		}
+	}
+	for ( int i = 0; i < _blockSize_; i++ ) {
+		block->elements[i].link.next = magazine.free;
+		magazine.free = &block->elements[i];
+		assert( ( ( (UINT_PTR)magazine.free ) & ( BLOCK_ALLOC_ALIGNMENT - 1 ) ) == 0 );
+	}
+	magazine.count += _blockSize_;
+	Sys_InterlockedAdd( total, _blockSize_ );
+}
+
+/*
+========================
+idConcurrentBlockAlloc<_type_,_blockSize_,memTag>::Shutdown
+========================
+*/
+template<class _type_, int _blockSize_, memTag_t memTag>
+ID_INLINE void idConcurrentBlockAlloc<_type_,_blockSize_,memTag>::Shutdown() {
+	while( blocks != NULL ) {
+		idBlock * block = blocks;
+		blocks = blocks->next;
+		Mem_Free( block );
+	}
+	blocks = NULL;
+	fullMagazines = 0;
+	total = 0;
+	memset( magazines, 0, sizeof( magazines ) );
+	memset( &overflow, 0, sizeof( overflow ) );
+}
+
+/*
+========================
+idConcurrentBlockAlloc<_type_,_blockSize_,memTag>::SetFixedBlocks
+========================
+*/
+template<class _type_, int _blockSize_, memTag_t memTag>
+ID_INLINE void idConcurrentBlockAlloc<_type_,_blockSize_,memTag>::SetFixedBlocks( int numBlocks ) {
+	int currentNumBlocks = 0;
+	for ( idBlock * block = blocks; block != NULL; block = block->next ) {
+		currentNumBlocks++;
+	}
+	for ( int i = currentNumBlocks; i < numBlocks; i++ ) {
+		magazine_t magazine;
+		memset( &magazine, 0, sizeof( magazine ) );
+		AllocNewBlock( magazine );
+		PushMagazine( magazine.free );
+	}
+	allowAllocs = false;
+}
+
+/*
+========================
+idConcurrentBlockAlloc<_type_,_blockSize_,memTag>::GatherFree
+
+Moves the free elements of the magazine to the list.
+========================
+*/
+template<class _type_, int _blockSize_, memTag_t memTag>
+ID_INLINE void idConcurrentBlockAlloc<_type_,_blockSize_,memTag>::GatherFree( magazine_t & magazine, element_t * & list ) {
+	for ( element_t * element = magazine.free; element != NULL; ) {
+		element_t * next = element->link.next;
+		element->link.next = list;
+		list = element;
+		element = next;
+	}
+	magazine.free = NULL;
+	magazine.count = 0;
+}
+
+/*
+========================
+idConcurrentBlockAlloc<_type_,_blockSize_,memTag>::FreeEmptyBlocks
+========================
+*/
+template<class _type_, int _blockSize_, memTag_t memTag>
+ID_INLINE void idConcurrentBlockAlloc<_type_,_blockSize_,memTag>::FreeEmptyBlocks() {
+	// collect the free elements from all magazines
+	element_t * free = NULL;
+	for ( int i = 0; i < MEM_MAX_THREADS; i++ ) {
+		GatherFree( magazines[i], free );
+	}
+	GatherFree( overflow, free );
+	for ( element_t * first = PopMagazine(); first != NULL; first = PopMagazine() ) {
+		magazine_t magazine;
+		magazine.free = first;
+		GatherFree( magazine, free );
+	}
+
+	// count how many free elements are in each block
+	// and build up a free chain per block
+	for ( idBlock * block = blocks; block != NULL; block = block->next ) {
+		block->free = NULL;
+		block->freeCount = 0;
+	}
+	for ( element_t * element = free; element != NULL; ) {
+		element_t * next = element->link.next;
+		for ( idBlock * block = blocks; block != NULL; block = block->next ) {
+			if ( element >= block->elements && element < block->elements + _blockSize_ ) {
+				element->link.next = block->free;
+				block->free = element;
+				block->freeCount++;
+				break;
+			}
+		}
+		// if this assert fires, we couldn't find the element in any block
+		assert( element->link.next != next );
+		element = next;
+	}
+	// now free all blocks whose free count == _blockSize_
+	idBlock * prevBlock = NULL;
+	for ( idBlock * block = blocks; block != NULL; ) {
+		idBlock * next = block->next;
+		if ( block->freeCount == _blockSize_ ) {
+			if ( prevBlock == NULL ) {
+				assert( blocks == block );
+				blocks = block->next;
+			} else {
+				assert( prevBlock->next == block );
+				prevBlock->next = block->next;
+			}
+			Mem_Free( block );
+			total -= _blockSize_;
+		} else {
+			prevBlock = block;
+		}
+		block = next;
+	}
+	// now hand the remaining free elements back as full magazines,
+	// what is left over goes to the calling thread
+	const int threadIndex = Mem_ThreadIndex();
+	magazine_t & magazine = ( threadIndex >= 0 ) ? magazines[threadIndex] : overflow;
+	for ( idBlock * block = blocks; block != NULL; block = block->next ) {
+		for ( element_t * element = block->free; element != NULL; ) {
+			element_t * next = element->link.next;
+			FreeElement( magazine, element );
+			element = next;
+		}
+	}
+}
+
 /*
 ==============================================================================
 
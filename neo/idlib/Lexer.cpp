@@ -112,6 +112,159 @@ int default_setup;
 
 char idLexer::baseFolder[ 256 ];
 
+/*
+================================================
+Fast scanning
+
+Wherever the lexer loops over a run of characters that are all handled the same way, the
+fast path classifies 16 characters at a time and hands the first character that ends the
+run back to the scalar code. Only whole blocks before end_p are loaded, the rest of the
+script is still scanned one character at a time. The compares are signed like the scalar
+char compares, so characters above 127 are white space and never part of a name.
+================================================
+*/
+#ifdef ID_WIN_X86_SSE2_INTRIN
+
+ID_INLINE static int LexCountBits( unsigned int mask ) {
+	int count = 0;
+	for ( ; mask != 0; mask &= mask - 1 ) {
+		count++;
+	}
+	return count;
+}
+
+ID_INLINE static int LexFirstBit( unsigned int mask ) {
+	unsigned long index;
+	_BitScanForward( &index, mask );
+	return (int)index;
+}
+
+ID_INLINE static __m128i LexCharRange( const __m128i chars, const char lo, const char hi ) {
+	return _mm_and_si128( _mm_cmpgt_epi8( chars, _mm_set1_epi8( lo - 1 ) ), _mm_cmplt_epi8( chars, _mm_set1_epi8( hi + 1 ) ) );
+}
+
+ID_INLINE static __m128i LexCharEqual( const __m128i chars, const char c ) {
+	return _mm_cmpeq_epi8( chars, _mm_set1_epi8( c ) );
+}
+
+/*
+================
+LexSkipSpaces
+
+Skips characters <= ' ' except the terminating zero, counting the new lines.
+================
+*/
+static const char *LexSkipSpaces( const char *p, const char *end, int &lines ) {
+	const __m128i space = _mm_set1_epi8( ' ' );
+	while ( end - p >= 16 ) {
+		const __m128i chars = _mm_loadu_si128( (const __m128i *)p );
+		const unsigned int stop = _mm_movemask_epi8( _mm_or_si128( _mm_cmpgt_epi8( chars, space ), LexCharEqual( chars, '\0' ) ) );
+		const unsigned int newLines = _mm_movemask_epi8( LexCharEqual( chars, '\n' ) );
+		if ( stop != 0 ) {
+			const int n = LexFirstBit( stop );
+			lines += LexCountBits( newLines & ( ( 1u << n ) - 1 ) );
+			return p + n;
+		}
+		lines += LexCountBits( newLines );
+		p += 16;
+	}
+	return p;
+}
+
+/*
+================
+LexFindLineEnd
+
+Finds the first new line or terminating zero.
+================
+*/
+static const char *LexFindLineEnd( const char *p, const char *end ) {
+	while ( end - p >= 16 ) {
+		const __m128i chars = _mm_loadu_si128( (const __m128i *)p );
+		const unsigned int stop = _mm_movemask_epi8( _mm_or_si128( LexCharEqual( chars, '\n' ), LexCharEqual( chars, '\0' ) ) );
+		if ( stop != 0 ) {
+			return p + LexFirstBit( stop );
+		}
+		p += 16;
+	}
+	return p;
+}
+
+/*
+================
+LexFindCommentChar
+
+Finds the first character a block comment has to look at: a new line, a slash or the
+terminating zero.
+================
+*/
+static const char *LexFindCommentChar( const char *p, const char *end ) {
+	while ( end - p >= 16 ) {
+		const __m128i chars = _mm_loadu_si128( (const __m128i *)p );
+		const unsigned int stop = _mm_movemask_epi8( _mm_or_si128( _mm_or_si128( LexCharEqual( chars, '\n' ), LexCharEqual( chars, '/' ) ), LexCharEqual( chars, '\0' ) ) );
+		if ( stop != 0 ) {
+			return p + LexFirstBit( stop );
+		}
+		p += 16;
+	}
+	return p;
+}
+
+/*
+================
+LexSkipName
+
+Skips the characters idLexer::ReadName accepts after the first one.
+================
+*/
+static const char *LexSkipName( const char *p, const char *end, const int flags ) {
+	const bool dash = ( flags & LEXFL_ONLYSTRINGS ) != 0;
+	const bool paths = ( flags & LEXFL_ALLOWPATHNAMES ) != 0;
+	while ( end - p >= 16 ) {
+		const __m128i chars = _mm_loadu_si128( (const __m128i *)p );
+		__m128i name = _mm_or_si128( _mm_or_si128( LexCharRange( chars, 'a', 'z' ), LexCharRange( chars, 'A', 'Z' ) ),
+										_mm_or_si128( LexCharRange( chars, '0', '9' ), LexCharEqual( chars, '_' ) ) );
+		if ( dash ) {
+			name = _mm_or_si128( name, LexCharEqual( chars, '-' ) );
+		}
+		if ( paths ) {
+			name = _mm_or_si128( name, _mm_or_si128( _mm_or_si128( LexCharEqual( chars, '/' ), LexCharEqual( chars, '\\' ) ),
+														_mm_or_si128( LexCharEqual( chars, ':' ), LexCharEqual( chars, '.' ) ) ) );
+		}
+		const unsigned int stop = ~_mm_movemask_epi8( name ) & 0xFFFF;
+		if ( stop != 0 ) {
+			return p + LexFirstBit( stop );
+		}
+		p += 16;
+	}
+	return p;
+}
+
+/*
+================
+LexSkipDecimal
+
+Skips digits and dots, counting the dots.
+================
+*/
+static const char *LexSkipDecimal( const char *p, const char *end, int &dots ) {
+	while ( end - p >= 16 ) {
+		const __m128i chars = _mm_loadu_si128( (const __m128i *)p );
+		const unsigned int dotMask = _mm_movemask_epi8( LexCharEqual( chars, '.' ) );
+		const unsigned int stop = ~( _mm_movemask_epi8( LexCharRange( chars, '0', '9' ) ) | dotMask ) & 0xFFFF;
+		if ( stop != 0 ) {
+			const int n = LexFirstBit( stop );
+			dots += LexCountBits( dotMask & ( ( 1u << n ) - 1 ) );
+			return p + n;
+		}
+		dots += LexCountBits( dotMask );
+		p += 16;
+	}
+	return p;
+}
+
+#endif
+
 /*
 ================
 idLexer::CreatePunctuationTable
@@ -242,6 +395,8 @@ void idLexer::Warning( const char *str, ... ) {
 	char text[MAX_STRING_CHARS];
 	va_list ap;
 
+	hadWarning = true;
+
 	if ( idLexer::flags & LEXFL_NOWARNINGS ) {
 		return;
 	}
@@ -285,6 +440,11 @@ When a newline character is found the scripts line counter is increased.
 int idLexer::ReadWhiteSpace() {
 	while(1) {
 		// skip white space
+#ifdef ID_WIN_X86_SSE2_INTRIN
+		if ( !( idLexer::flags & LEXFL_NOFASTSCAN ) ) {
+			idLexer::script_p = LexSkipSpaces( idLexer::script_p, idLexer::end_p, idLexer::line );
+		}
+#endif
 		while(*idLexer::script_p <= ' ') {
 			if (!*idLexer::script_p) {
 				return 0;
@@ -299,6 +459,11 @@ int idLexer::ReadWhiteSpace() {
 			// comments //
 			if (*(idLexer::script_p+1) == '/') {
 				idLexer::script_p++;
+#ifdef ID_WIN_X86_SSE2_INTRIN
+				if ( !( idLexer::flags & LEXFL_NOFASTSCAN ) ) {
+					idLexer::script_p = LexFindLineEnd( idLexer::script_p + 1, idLexer::end_p ) - 1;
+				}
+#endif
 				do {
 					idLexer::script_p++;
 					if ( !*idLexer::script_p ) {
@@ -317,6 +482,11 @@ int idLexer::ReadWhiteSpace() {
 			else if (*(idLexer::script_p+1) == '*') {
 				idLexer::script_p++;
 				while( 1 ) {
+#ifdef ID_WIN_X86_SSE2_INTRIN
+					if ( !( idLexer::flags & LEXFL_NOFASTSCAN ) ) {
+						idLexer::script_p = LexFindCommentChar( idLexer::script_p + 1, idLexer::end_p ) - 1;
+					}
+#endif
 					idLexer::script_p++;
 					if ( !*idLexer::script_p ) {
 						return 0;
@@ -620,6 +790,15 @@ int idLexer::ReadName( idToken *token ) {
 	char c;
 
 	token->type = TT_NAME;
+#ifdef ID_WIN_X86_SSE2_INTRIN
+	if ( !( idLexer::flags & LEXFL_NOFASTSCAN ) ) {
+		// the first character is always taken, copy all but the last known name character,
+		// which leaves the loop below to check the character that ends the run
+		const char *p = LexSkipName( idLexer::script_p + 1, idLexer::end_p, idLexer::flags ) - 1;
+		token->Append( idLexer::script_p, p - idLexer::script_p );
+		idLexer::script_p = p;
+	}
+#endif
 	do {
 		token->AppendDirty( *idLexer::script_p++ );
 		c = *idLexer::script_p;
@@ -710,6 +889,14 @@ int idLexer::ReadNumber( idToken *token ) {
 	else {
 		// decimal integer or floating point number or ip address
 		dot = 0;
+#ifdef ID_WIN_X86_SSE2_INTRIN
+		if ( !( idLexer::flags & LEXFL_NOFASTSCAN ) ) {
+			const char *p = LexSkipDecimal( idLexer::script_p, idLexer::end_p, dot );
+			token->Append( idLexer::script_p, p - idLexer::script_p );
+			idLexer::script_p = p;
+			c = *idLexer::script_p;
+		}
+#endif
 		while( 1 ) {
 			if ( c >= '0' && c <= '9' ) {
 			}
@@ -1834,6 +2021,7 @@ idLexer::idLexer() {
 	idLexer::token = "";
 	idLexer::next = NULL;
 	idLexer::hadError = false;
+	idLexer::hadWarning = false;
 }
 
 /*
@@ -1855,6 +2043,7 @@ idLexer::idLexer( int flags ) {
 	idLexer::token = "";
 	idLexer::next = NULL;
 	idLexer::hadError = false;
+	idLexer::hadWarning = false;
 }
 
 /*
@@ -1870,6 +2059,7 @@ idLexer::idLexer( const char *filename, int flags, bool OSPath ) {
 	idLexer::token = "";
 	idLexer::next = NULL;
 	idLexer::hadError = false;
+	idLexer::hadWarning = false;
 	idLexer::LoadFile( filename, OSPath );
 }
 
@@ -1886,6 +2076,7 @@ idLexer::idLexer( const char *ptr, int length, const char *name, int flags ) {
 	idLexer::token = "";
 	idLexer::next = NULL;
 	idLexer::hadError = false;
+	idLexer::hadWarning = false;
 	idLexer::LoadMemory( ptr, length, name );
 }
 
@@ -1916,3 +2107,127 @@ bool idLexer::HadError() const {
 	return hadError;
 }
 
+/*
+================
+idLexer::HadWarning
+================
+*/
+bool idLexer::HadWarning() const {
+	return hadWarning;
+}
+
+
+/*
+================
+testLexer
+
+Lexes a corpus of shipped text files with the fast path and one character at a time, checks
+that both produce the same token streams and reports the throughput of each.
+================
+*/
+CONSOLE_COMMAND( testLexer, "checks the lexer fast path against the scalar lexer and measures both, usage: testLexer [folder extension] [passes]", 0 ) {
+	static const char *defaultCorpus[][2] = {
+		{ "def",		".def" },
+		{ "materials",	".mtr" },
+		{ "particles",	".prt" },
+		{ "fx",			".fx" },
+		{ "skins",		".skin" },
+		{ "af",			".af" },
+	};
+	// DECL_LEXER_FLAGS without the messages
+	const int testFlags = LEXFL_NOERRORS | LEXFL_NOWARNINGS | LEXFL_NOSTRINGCONCAT | LEXFL_NOSTRINGESCAPECHARS | LEXFL_ALLOWPATHNAMES |
+							LEXFL_ALLOWMULTICHARLITERALS | LEXFL_ALLOWBACKSLASHSTRINGCONCAT;
+
+	idStrList fileNames;
+	if ( args.Argc() >= 3 ) {
+		idFileList *fileList = idLib::fileSystem->ListFiles( args.Argv( 1 ), args.Argv( 2 ), true, true );
+		for ( int i = 0; i < fileList->GetNumFiles(); i++ ) {
+			fileNames.Append( fileList->GetFile( i ) );
+		}
+		idLib::fileSystem->FreeFileList( fileList );
+	} else {
+		for ( int c = 0; c < sizeof( defaultCorpus ) / sizeof( defaultCorpus[0] ); c++ ) {
+			idFileList *fileList = idLib::fileSystem->ListFiles( defaultCorpus[c][0], defaultCorpus[c][1], true, true );
+			for ( int i = 0; i < fileList->GetNumFiles(); i++ ) {
+				fileNames.Append( fileList->GetFile( i ) );
+			}
+			idLib::fileSystem->FreeFileList( fileList );
+		}
+	}
+	const int numPasses = ( args.Argc() == 2 || args.Argc() >= 4 ) ? idMath::ClampInt( 1, 100, atoi( args.Argv( args.Argc() - 1 ) ) ) : 3;
+
+	idList< char * > buffers;
+	idList< int > lengths;
+	int64 totalBytes = 0;
+	for ( int i = 0; i < fileNames.Num(); i++ ) {
+		char *buffer = NULL;
+		const int length = idLib::fileSystem->ReadFile( fileNames[i], (void **)&buffer, NULL );
+		if ( length <= 0 ) {
+			continue;
+		}
+		buffers.Append( buffer );
+		lengths.Append( length );
+		totalBytes += length;
+	}
+	if ( buffers.Num() == 0 ) {
+		idLib::Printf( "testLexer: no files found\n" );
+		return;
+	}
+
+	// token for token equivalence
+	int numTokens = 0;
+	int numMismatched = 0;
+	for ( int i = 0; i < buffers.Num(); i++ ) {
+		idLexer fast( buffers[i], lengths[i], fileNames[i], testFlags );
+		idLexer scalar( buffers[i], lengths[i], fileNames[i], testFlags | LEXFL_NOFASTSCAN );
+		idToken a, b;
+		while ( 1 ) {
+			const int readFast = fast.ReadToken( &a );
+			const int readScalar = scalar.ReadToken( &b );
+			if ( readFast != readScalar ) {
+				idLib::Printf( "%s, line %d: fast path %s\n", fileNames[i].c_str(), scalar.GetLineNum(), readFast ? "read too many tokens" : "stopped early" );
+				numMismatched++;
+				break;
+			}
+			if ( !readFast ) {
+				break;
+			}
+			if ( a.Cmp( b ) != 0 || a.type != b.type || a.subtype != b.subtype || a.flags != b.flags || a.line != b.line ||
+					a.linesCrossed != b.linesCrossed || fast.GetFileOffset() != scalar.GetFileOffset() ||
+					fast.GetLastWhiteSpaceStart() != scalar.GetLastWhiteSpaceStart() || fast.GetLastWhiteSpaceEnd() != scalar.GetLastWhiteSpaceEnd() ) {
+				idLib::Printf( "%s, line %d: fast path read '%s', expected '%s'\n", fileNames[i].c_str(), b.line, a.c_str(), b.c_str() );
+				numMismatched++;
+				break;
+			}
+			numTokens++;
+		}
+		if ( fast.HadError() != scalar.HadError() || fast.HadWarning() != scalar.HadWarning() || fast.GetLineNum() != scalar.GetLineNum() ) {
+			idLib::Printf( "%s: fast path ended in a different state\n", fileNames[i].c_str() );
+			numMismatched++;
+		}
+	}
+
+	// throughput
+	for ( int mode = 0; mode < 2; mode++ ) {
+		const int flags = ( mode == 0 ) ? testFlags | LEXFL_NOFASTSCAN : testFlags;
+		const uint64 start = Sys_Microseconds();
+		for ( int pass = 0; pass < numPasses; pass++ ) {
+			for ( int i = 0; i < buffers.Num(); i++ ) {
+				idLexer src( buffers[i], lengths[i], fileNames[i], flags );
+				idToken token;
+				while ( src.ReadToken( &token ) ) {
+				}
+			}
+		}
+		const uint64 elapsed = Max( Sys_Microseconds() - start, (uint64)1 );
+		idLib::Printf( "%-6s %8.1f MB/s, %lld msec\n", ( mode == 0 ) ? "scalar" : "fast",
+						(double)( totalBytes * numPasses ) / ( elapsed * 1.048576 ), elapsed / 1000 );
+	}
+
+	for ( int i = 0; i < buffers.Num(); i++ ) {
+		idLib::fileSystem->FreeFile( buffers[i] );
+	}
+
+	idLib::Printf( "%d files, %lld bytes, %d tokens\n", buffers.Num(), totalBytes, numTokens );
+	idLib::Printf( numMismatched == 0 ? "testLexer passed\n" : "testLexer FAILED on %d files\n", numMismatched );
+}
@@ -128,9 +128,149 @@ idParallelJobList_Threads
 */
 
 static idCVar jobs_longJobMicroSec( "jobs_longJobMicroSec", "10000", CVAR_INTEGER, "print a warning for jobs that take more than this number of microseconds" );
+static idCVar jobs_workStealing( "jobs_workStealing", "0", CVAR_BOOL | CVAR_NOCHEAT, "split job lists into per-thread job ranges and let idle threads steal from busy ones" );
 
 
 const static int		MAX_THREADS	= 32;
+const static int		MAX_STEAL_JOBS = 0xFFFF;	// job ranges are packed as two 16 bit indices
+
+/*
+================================================================================================
+
+	Job trace
+
+	When jobs_trace is set every executed job, every stall of a job thread on a sync point and
+	every wait of the host thread is recorded into a ring buffer per thread. The buffers can be
+	summarized or written out as a Chrome trace (chrome://tracing) for a range of frames.
+
+================================================================================================
+*/
+
+static idCVar jobs_trace( "jobs_trace", "0", CVAR_BOOL | CVAR_NOCHEAT, "record per job timings for jobs_traceSummary and jobs_dumpTrace" );
+
+enum jobTraceType_t {
+	JOB_TRACE_JOB,				// a job executed on a job thread
+	JOB_TRACE_STALL,			// a job thread stalled on a sync point
+	JOB_TRACE_WAIT				// the host thread waited for a job list to finish
+};
+
+struct jobTraceEvent_t {
+	uint64						startTime;
+	uint64						endTime;
+	jobRun_t					function;
+	int							frameNumber;
+	short						listId;
+	char						type;
+	char						signalIndex;	// sync point a stall was waiting on
+};
+
+const static int		JOB_TRACE_EVENTS		= 8192;			// per thread, must be a power of two
+const static int		JOB_TRACE_HOST_THREAD	= MAX_THREADS;	// the thread that submits and waits for job lists
+
+compile_time_assert( CONST_ISPOWEROFTWO( JOB_TRACE_EVENTS ) );
+
+struct jobTraceBuffer_t {
+	jobTraceEvent_t *			events;
+	idSysInterlockedInteger		writeIndex;
+	idSysInterlockedInteger		fetchCollisions;	// times the thread found another thread holding the fetch lock
+};
+
+class idJobTrace {
+public:
+	bool						IsActive() const { return buffers[0].events != NULL && jobs_trace.GetBool(); }
+
+	void						AllocBuffers();
+	void						FreeBuffers();
+	void						Clear();
+
+	void						Record( int thread, jobTraceType_t type, jobListId_t listId, jobRun_t function, int signalIndex, uint64 start, uint64 end );
+	void						AddFetchCollision( int thread ) { buffers[thread].fetchCollisions.Increment(); }
+
+	int							GetNumEvents( int thread ) const { return Min( buffers[thread].writeIndex.GetValue(), JOB_TRACE_EVENTS ); }
+	const jobTraceEvent_t &		GetEvent( int thread, int index ) const;
+	int							GetFetchCollisions( int thread ) const { return buffers[thread].fetchCollisions.GetValue(); }
+
+private:
+	jobTraceBuffer_t			buffers[MAX_THREADS + 1];
+};
+
+static idJobTrace jobTrace;
+
+/*
+========================
+idJobTrace::AllocBuffers
+
+Called from the host thread before any job threads can record.
+========================
+*/
+void idJobTrace::AllocBuffers() {
+	if ( buffers[0].events != NULL ) {
+		return;
+	}
+	// allocate the first buffer last because it is used to see if all buffers are there
+	for ( int i = MAX_THREADS; i >= 0; i-- ) {
+		buffers[i].events = (jobTraceEvent_t *) Mem_ClearedAlloc( JOB_TRACE_EVENTS * sizeof( jobTraceEvent_t ), TAG_JOBLIST );
+	}
+}
+
+/*
+========================
+idJobTrace::FreeBuffers
+
+Only safe once the job threads have stopped.
+========================
+*/
+void idJobTrace::FreeBuffers() {
+	for ( int i = 0; i <= MAX_THREADS; i++ ) {
+		Mem_Free( buffers[i].events );
+		buffers[i].events = NULL;
+	}
+	Clear();
+}
+
+/*
+========================
+idJobTrace::Clear
+========================
+*/
+void idJobTrace::Clear() {
+	for ( int i = 0; i <= MAX_THREADS; i++ ) {
+		buffers[i].writeIndex.SetValue( 0 );
+		buffers[i].fetchCollisions.SetValue( 0 );
+	}
+}
+
+/*
+========================
+idJobTrace::Record
+
+The host thread may run jobs inline while a job thread uses the same buffer,
+so slots are reserved with an interlocked increment.
+========================
+*/
+void idJobTrace::Record( int thread, jobTraceType_t type, jobListId_t listId, jobRun_t function, int signalIndex, uint64 start, uint64 end ) {
+	jobTraceBuffer_t & buffer = buffers[thread];
+	jobTraceEvent_t & event = buffer.events[( buffer.writeIndex.Increment() - 1 ) & ( JOB_TRACE_EVENTS - 1 )];
+	event.startTime = start;
+	event.endTime = end;
+	event.function = function;
+	event.frameNumber = idLib::frameNumber;
+	event.listId = (short)listId;
+	event.type = (char)type;
+	event.signalIndex = (char)signalIndex;
+}
+
+/*
+========================
+idJobTrace::GetEvent
+
+Returns the events in the order they were recorded.
+========================
+*/
+const jobTraceEvent_t & idJobTrace::GetEvent( int thread, int index ) const {
+	const int first = Max( 0, buffers[thread].writeIndex.GetValue() - JOB_TRACE_EVENTS );
+	return buffers[thread].events[( first + index ) & ( JOB_TRACE_EVENTS - 1 )];
+}
 
 struct threadJobListState_t {
 								threadJobListState_t() :
@@ -138,18 +278,27 @@ struct threadJobListState_t {
 									version( 0xFFFFFFFF ),
 									signalIndex( 0 ),
 									lastJobIndex( 0 ),
-									nextJobIndex( -1 ) {}
+									nextJobIndex( -1 ),
+									stealPhase( 0 ),
+									stallSignal( 0 ),
+									stallStart( 0 ) {}
 								threadJobListState_t( int _version ) :
 									jobList( NULL ),
 									version( _version ),
 									signalIndex( 0 ),
 									lastJobIndex( 0 ),
-									nextJobIndex( -1 ) {}
+									nextJobIndex( -1 ),
+									stealPhase( 0 ),
+									stallSignal( 0 ),
+									stallStart( 0 ) {}
 	idParallelJobList_Threads *	jobList;
 	int							version;
 	int							signalIndex;
 	int							lastJobIndex;
 	int							nextJobIndex;
+	int							stealPhase;
+	int							stallSignal;	// sync point the thread is stalled on for the job trace
+	uint64						stallStart;		// time at which the thread stalled, 0 if not stalled
 };
 
 struct threadStats_t {
@@ -195,6 +344,9 @@ public:
 
 	bool					WaitForOtherJobList();
 
+	// Distributes the submitted jobs over per-thread job ranges, called by the manager before handing out the list.
+	void					PrepareWorkStealing( int numWorkers );
+
 	//------------------------
 	// This is thread safe and called from the job threads.
 	//------------------------
@@ -237,7 +389,29 @@ private:
 	threadStats_t						deferredThreadStats;
 	threadStats_t						threadStats;
 
+	// work stealing state, only valid while 'stealing' is set
+	// the job list is split into phases at every synchronization point and each phase is split
+	// into one job range per worker thread, idle threads steal the back half of another thread's range
+	bool								stealing;
+	int									numStealSlots;
+	idList< int, TAG_JOBLIST >			phaseStart;		// first job of each phase with one extra entry for the end
+	idList< int, TAG_JOBLIST >			phaseGate;		// signal that has to be done before a phase can start or -1
+	idList< int, TAG_JOBLIST >			jobSignal;		// signal count each job decrements
+	idList< idSysInterlockedInteger, TAG_JOBLIST >	stealRanges;	// per phase and thread [begin, end) job range
+	idSysInterlockedInteger				numJobsRemaining;
+
 	int						RunJobsInternal( unsigned int threadNum, threadJobListState_t & state, bool singleJob );
+	void					BeginStall( threadJobListState_t & state, int signalIndex );
+	void					EndStall( unsigned int threadNum, threadJobListState_t & state );
+	int						RunJobsStealing( unsigned int threadNum, threadJobListState_t & state, bool singleJob );
+	void					ExecuteJob( unsigned int threadNum, int jobIndex );
+	bool					AllJobsDone() const;
+	int						PopJob( int phase, int slot );
+	int						StealJob( int phase, int slot );
+
+	static int				PackRange( int begin, int end ) { return (int)( ( (unsigned int)begin << 16 ) | (unsigned int)end ); }
+	static int				RangeBegin( int range ) { return (int)( (unsigned int)range >> 16 ); }
+	static int				RangeEnd( int range ) { return range & 0xFFFF; }
 
 	static void				Nop( void * data ) {}
 
@@ -265,7 +439,9 @@ idParallelJobList_Threads::idParallelJobList_Threads( jobListId_t id, jobListPri
 	lastSignalJob( 0 ),
 	waitForGuard( NULL ),
 	currentDoneGuard( 0 ),
-	jobList() {
+	jobList(),
+	stealing( false ),
+	numStealSlots( 0 ) {
 
 	assert( listPriority != JOBLIST_PRIORITY_NONE );
 
@@ -275,6 +451,14 @@ idParallelJobList_Threads::idParallelJobList_Threads( jobListId_t id, jobListPri
 	jobList.SetNum( 0 );
 	signalJobCount.AssureSize( maxSyncs + 1 );			// need one extra for submit
 	signalJobCount.SetNum( 0 );
+	phaseStart.AssureSize( maxSyncs + 2 );
+	phaseStart.SetNum( 0 );
+	phaseGate.AssureSize( maxSyncs + 1 );
+	phaseGate.SetNum( 0 );
+	jobSignal.AssureSize( maxJobs + maxSyncs * 2 + 1 );
+	jobSignal.SetNum( 0 );
+	stealRanges.AssureSize( ( maxSyncs + 1 ) * MAX_THREADS );
+	stealRanges.SetNum( 0 );
 
 	memset( &deferredThreadStats, 0, sizeof( threadStats_t ) );
 	memset( &threadStats, 0, sizeof( threadStats_t ) );
@@ -410,6 +594,9 @@ void idParallelJobList_Threads::Submit( idParallelJobList_Threads * waitForJobLi
 	job.function = Nop;
 	job.data = & JOB_LIST_DONE;
 
+	// the manager decides whether or not to steal once it knows the number of threads
+	stealing = false;
+
 	if ( threaded ) {
 		// hand over to the manager
 		void SubmitJobList( idParallelJobList_Threads * jobList, int parallelism );
@@ -436,7 +623,7 @@ void idParallelJobList_Threads::Wait() {
 		bool waited = false;
 		uint64 waitStart = Sys_Microseconds();
 
-		while ( signalJobCount[signalJobCount.Num() - 1].GetValue() > 0 ) {
+		while ( !AllJobsDone() ) {
 			Sys_Yield();
 			waited = true;
 		}
@@ -450,9 +637,14 @@ void idParallelJobList_Threads::Wait() {
 		signalJobCount.SetNum( 0 );
 		numSyncs = 0;
 		lastSignalJob = 0;
+		stealing = false;
 
 		uint64 waitEnd = Sys_Microseconds();
 		deferredThreadStats.waitTime = waited ? ( waitEnd - waitStart ) : 0;
+
+		if ( waited && jobTrace.IsActive() ) {
+			jobTrace.Record( JOB_TRACE_HOST_THREAD, JOB_TRACE_WAIT, GetId(), NULL, -1, waitStart, waitEnd );
+		}
 	}
 	memcpy( & threadStats, & deferredThreadStats, sizeof( threadStats ) );
 	done = true;
@@ -464,13 +656,26 @@ idParallelJobList_Threads::TryWait
 ========================
 */
 bool idParallelJobList_Threads::TryWait() {
-	if ( jobList.Num() == 0 || signalJobCount[signalJobCount.Num() - 1].GetValue() <= 0 ) {
+	if ( jobList.Num() == 0 || AllJobsDone() ) {
 		Wait();
 		return true;
 	}
 	return false;
 }
 
+/*
+========================
+idParallelJobList_Threads::AllJobsDone
+========================
+*/
+bool idParallelJobList_Threads::AllJobsDone() const {
+	if ( stealing ) {
+		// jobs from earlier signals may still be waiting in another thread's range
+		return ( numJobsRemaining.GetValue() <= 0 );
+	}
+	return ( signalJobCount[signalJobCount.Num() - 1].GetValue() <= 0 );
+}
+
 /*
 ========================
 idParallelJobList_Threads::IsSubmitted
@@ -536,6 +741,63 @@ volatile jobRun_t longJobFunc;
 volatile void * longJobData;
 #endif
 
+/*
+========================
+idParallelJobList_Threads::ExecuteJob
+========================
+*/
+void idParallelJobList_Threads::ExecuteJob( unsigned int threadNum, int jobIndex ) {
+	uint64 jobStart = Sys_Microseconds();
+
+	jobList[jobIndex].function( jobList[jobIndex].data );
+	jobList[jobIndex].executed = 1;
+
+	uint64 jobEnd = Sys_Microseconds();
+	deferredThreadStats.threadExecTime[threadNum] += jobEnd - jobStart;
+
+	if ( jobTrace.IsActive() ) {
+		jobTrace.Record( threadNum, JOB_TRACE_JOB, GetId(), jobList[jobIndex].function, 0, jobStart, jobEnd );
+	}
+
+#ifndef _DEBUG
+	if ( jobs_longJobMicroSec.GetInteger() > 0 ) {
+		if ( jobEnd - jobStart > jobs_longJobMicroSec.GetInteger()
+			&& GetId() != JOBLIST_UTILITY ) {
+			longJobTime = ( jobEnd - jobStart ) * ( 1.0f / 1000.0f );
+			longJobFunc = jobList[jobIndex].function;
+			longJobData = jobList[jobIndex].data;
+			const char * jobName = GetJobName( jobList[jobIndex].function );
+			const char * jobListName = GetJobListName( GetId() );
+			idLib::Printf( "%1.1f milliseconds for a single '%s' job from job list %s on thread %d\n", longJobTime, jobName, jobListName, threadNum );
+		}
+	}
+#endif
+}
+
+/*
+========================
+idParallelJobList_Threads::BeginStall
+========================
+*/
+ID_INLINE void idParallelJobList_Threads::BeginStall( threadJobListState_t & state, int signalIndex ) {
+	if ( state.stallStart == 0 && jobTrace.IsActive() ) {
+		state.stallStart = Sys_Microseconds();
+		state.stallSignal = signalIndex;
+	}
+}
+
+/*
+========================
+idParallelJobList_Threads::EndStall
+========================
+*/
+ID_INLINE void idParallelJobList_Threads::EndStall( unsigned int threadNum, threadJobListState_t & state ) {
+	if ( state.stallStart != 0 ) {
+		jobTrace.Record( threadNum, JOB_TRACE_STALL, GetId(), NULL, state.stallSignal, state.stallStart, Sys_Microseconds() );
+		state.stallStart = 0;
+	}
+}
+
 /*
 ========================
 idParallelJobList_Threads::RunJobsInternal
@@ -567,11 +829,13 @@ int idParallelJobList_Threads::RunJobsInternal( unsigned int threadNum, threadJo
 				assert( state.signalIndex > 0 );
 				if ( signalJobCount[state.signalIndex - 1].GetValue() > 0 ) {
 					// stalled on a synchronization point
+					BeginStall( state, state.signalIndex - 1 );
 					return ( result | RUN_STALLED );
 				}
 			} else if ( jobList[state.lastJobIndex].data == & JOB_LIST_DONE ) {
 				if ( signalJobCount[signalJobCount.Num() - 1].GetValue() > 0 ) {
 					// stalled on a synchronization point
+					BeginStall( state, signalJobCount.Num() - 1 );
 					return ( result | RUN_STALLED );
 				}
 			}
@@ -596,6 +860,7 @@ int idParallelJobList_Threads::RunJobsInternal( unsigned int threadNum, threadJo
 						// release the fetch lock
 						fetchLock.Decrement();
 						// stalled on a synchronization point
+						BeginStall( state, state.signalIndex - 1 );
 						return ( result | RUN_STALLED );
 					}
 				} else if ( jobList[state.lastJobIndex].data == & JOB_LIST_DONE ) {
@@ -605,6 +870,7 @@ int idParallelJobList_Threads::RunJobsInternal( unsigned int threadNum, threadJo
 						// release the fetch lock
 						fetchLock.Decrement();
 						// stalled on a synchronization point
+						BeginStall( state, signalJobCount.Num() - 1 );
 						return ( result | RUN_STALLED );
 					}
 					// decrement the done count
@@ -616,6 +882,9 @@ int idParallelJobList_Threads::RunJobsInternal( unsigned int threadNum, threadJo
 		} else {
 			// release the fetch lock
 			fetchLock.Decrement();
+			if ( jobTrace.IsActive() ) {
+				jobTrace.AddFetchCollision( threadNum );
+			}
 			// another thread is fetching right now so consider stalled
 			return ( result | RUN_STALLED );
 		}
@@ -626,29 +895,8 @@ int idParallelJobList_Threads::RunJobsInternal( unsigned int threadNum, threadJo
 		}
 
 		// execute the next job
-		{
-			uint64 jobStart = Sys_Microseconds();
-
-			jobList[state.nextJobIndex].function( jobList[state.nextJobIndex].data );
-			jobList[state.nextJobIndex].executed = 1;
-
-			uint64 jobEnd = Sys_Microseconds();
-			deferredThreadStats.threadExecTime[threadNum] += jobEnd - jobStart;
-
-#ifndef _DEBUG
-			if ( jobs_longJobMicroSec.GetInteger() > 0 ) {
-				if ( jobEnd - jobStart > jobs_longJobMicroSec.GetInteger()
-					&& GetId() != JOBLIST_UTILITY ) {
-					longJobTime = ( jobEnd - jobStart ) * ( 1.0f / 1000.0f );
-					longJobFunc = jobList[state.nextJobIndex].function;
-					longJobData = jobList[state.nextJobIndex].data;
-					const char * jobName = GetJobName( jobList[state.nextJobIndex].function );
-					const char * jobListName = GetJobListName( GetId() );
-					idLib::Printf( "%1.1f milliseconds for a single '%s' job from job list %s on thread %d\n", longJobTime, jobName, jobListName, threadNum );
-				}
-			}
-#endif
-		}
+		EndStall( threadNum, state );
+		ExecuteJob( threadNum, state.nextJobIndex );
 
 		result |= RUN_PROGRESS;
 
@@ -666,6 +914,173 @@ int idParallelJobList_Threads::RunJobsInternal( unsigned int threadNum, threadJo
 	return result;
 }
 
+/*
+========================
+idParallelJobList_Threads::PrepareWorkStealing
+========================
+*/
+void idParallelJobList_Threads::PrepareWorkStealing( int numWorkers ) {
+	assert( !done );
+
+	const int numJobs = jobList.Num() - 1;	// leave out the JOB_LIST_DONE marker
+	if ( numWorkers <= 1 || numJobs <= 0 || numJobs > MAX_STEAL_JOBS ) {
+		stealing = false;
+		return;
+	}
+
+	// the signal and synchronize markers are kept as Nop jobs so the signal counts work out
+	// the same as when the jobs are fetched one at a time
+	phaseStart.SetNum( 0 );
+	phaseGate.SetNum( 0 );
+	jobSignal.SetNum( numJobs );
+
+	phaseStart.Append( 0 );
+	phaseGate.Append( -1 );
+
+	int signalIndex = 0;
+	for ( int i = 0; i < numJobs; i++ ) {
+		if ( jobList[i].data == & JOB_SIGNAL ) {
+			signalIndex++;
+		} else if ( jobList[i].data == & JOB_SYNCHRONIZE ) {
+			// nothing from here on can run until all jobs up to the last signal are done
+			phaseStart.Append( i );
+			phaseGate.Append( signalIndex - 1 );
+		}
+		jobSignal[i] = signalIndex;
+	}
+	phaseStart.Append( numJobs );
+
+	const int numPhases = phaseGate.Num();
+
+	numStealSlots = idMath::ClampInt( 1, MAX_THREADS, numWorkers );
+	stealRanges.SetNum( numPhases * numStealSlots );
+	for ( int phase = 0; phase < numPhases; phase++ ) {
+		const int first = phaseStart[phase];
+		const int count = phaseStart[phase + 1] - first;
+		for ( int slot = 0; slot < numStealSlots; slot++ ) {
+			const int begin = first + count * slot / numStealSlots;
+			const int end = first + count * ( slot + 1 ) / numStealSlots;
+			stealRanges[phase * numStealSlots + slot].SetValue( PackRange( begin, end ) );
+		}
+	}
+
+	numJobsRemaining.SetValue( numJobs );
+	stealing = true;
+}
+
+/*
+========================
+idParallelJobList_Threads::PopJob
+
+Takes the first job from the given thread's own range.
+========================
+*/
+int idParallelJobList_Threads::PopJob( int phase, int slot ) {
+	idSysInterlockedInteger & range = stealRanges[phase * numStealSlots + slot];
+	for ( ; ; ) {
+		const int current = range.GetValue();
+		const int begin = RangeBegin( current );
+		const int end = RangeEnd( current );
+		if ( begin >= end ) {
+			return -1;
+		}
+		if ( range.CompareExchange( current, PackRange( begin + 1, end ) ) == current ) {
+			return begin;
+		}
+	}
+}
+
+/*
+========================
+idParallelJobList_Threads::StealJob
+
+Steals the back half of another thread's range. The first stolen job is returned
+and the rest is stored in the (empty) range of the stealing thread, where it
+can be stolen again.
+========================
+*/
+int idParallelJobList_Threads::StealJob( int phase, int slot ) {
+	for ( int i = 1; i < numStealSlots; i++ ) {
+		idSysInterlockedInteger & victim = stealRanges[phase * numStealSlots + ( slot + i ) % numStealSlots];
+		for ( ; ; ) {
+			const int current = victim.GetValue();
+			const int begin = RangeBegin( current );
+			const int end = RangeEnd( current );
+			if ( begin >= end ) {
+				break;
+			}
+			const int middle = begin + ( end - begin ) / 2;
+			if ( victim.CompareExchange( current, PackRange( begin, middle ) ) == current ) {
+				// only the owner ever writes an empty range so this does not need to be atomic
+				stealRanges[phase * numStealSlots + slot].SetValue( PackRange( middle + 1, end ) );
+				return middle;
+			}
+		}
+	}
+	return -1;
+}
+
+/*
+========================
+idParallelJobList_Threads::RunJobsStealing
+========================
+*/
+int idParallelJobList_Threads::RunJobsStealing( unsigned int threadNum, threadJobListState_t & state, bool singleJob ) {
+	if ( state.version != version.GetValue() ) {
+		// trying to run an old version of this list that is already done
+		return RUN_DONE;
+	}
+
+	assert( threadNum < MAX_THREADS );
+
+	if ( deferredThreadStats.startTime == 0 ) {
+		deferredThreadStats.startTime = Sys_Microseconds();	// first time any thread is running jobs from this list
+	}
+
+	const int slot = threadNum % numStealSlots;
+	int result = RUN_OK;
+
+	while ( state.stealPhase < phaseGate.Num() ) {
+
+		const int gate = phaseGate[state.stealPhase];
+		if ( gate >= 0 && signalJobCount[gate].GetValue() > 0 ) {
+			// stalled on a synchronization point
+			BeginStall( state, gate );
+			return ( result | RUN_STALLED );
+		}
+
+		int jobIndex = PopJob( state.stealPhase, slot );
+		if ( jobIndex < 0 ) {
+			jobIndex = StealJob( state.stealPhase, slot );
+			if ( jobIndex < 0 ) {
+				// every job in this phase has been taken so move on to the next phase
+				state.stealPhase++;
+				continue;
+			}
+		}
+
+		EndStall( threadNum, state );
+		ExecuteJob( threadNum, jobIndex );
+
+		result |= RUN_PROGRESS;
+
+		signalJobCount[jobSignal[jobIndex]].Decrement();
+
+		if ( numJobsRemaining.Decrement() == 0 ) {
+			// this was the very last job of the job list
+			deferredThreadStats.endTime = Sys_Microseconds();
+			doneGuards[currentDoneGuard].Decrement();
+			return ( result | RUN_DONE );
+		}
+
+		if ( singleJob ) {
+			return result;
+		}
+	}
+
+	return ( result | RUN_DONE );
+}
+
 /*
 ========================
 idParallelJobList_Threads::RunJobs
@@ -676,7 +1091,12 @@ int idParallelJobList_Threads::RunJobs( unsigned int threadNum, threadJobListSta
 
 	numThreadsExecuting.Increment();
 
-	int result = RunJobsInternal( threadNum, state, singleJob );
+	int result = stealing ? RunJobsStealing( threadNum, state, singleJob ) : RunJobsInternal( threadNum, state, singleJob );
+
+	if ( ( result & RUN_DONE ) != 0 ) {
+		// a thread stalled at the end of the list until the last job finished
+		EndStall( threadNum, state );
+	}
 
 	numThreadsExecuting.Decrement();
 
@@ -914,6 +1334,8 @@ struct threadJobList_t {
 
 static idCVar jobs_prioritize( "jobs_prioritize", "1", CVAR_BOOL | CVAR_NOCHEAT, "prioritize job lists" );
 
+static ID_TLS isJobThread;
+
 class idJobThread : public idSysThread {
 public:
 								idJobThread();
@@ -990,6 +1412,8 @@ idJobThread::Run
 int idJobThread::Run() {
 	threadJobListState_t threadJobListState[MAX_JOBLISTS];
 	int numJobLists = 0;
+
+	isJobThread = 1;
 	int lastStalledJobList = -1;
 
 	while ( !IsTerminating() ) {
@@ -1001,6 +1425,9 @@ int idJobThread::Run() {
 			threadJobListState[numJobLists].signalIndex = 0;
 			threadJobListState[numJobLists].lastJobIndex = 0;
 			threadJobListState[numJobLists].nextJobIndex = -1;
+			threadJobListState[numJobLists].stealPhase = 0;
+			threadJobListState[numJobLists].stallSignal = 0;
+			threadJobListState[numJobLists].stallStart = 0;
 			numJobLists++;
 			firstJobList++;
 		}
@@ -1090,9 +1517,11 @@ extern void Sys_CPUCount( int & logicalNum, int & coreNum, int & packageNum );
 //
 // Hyperthreading is not dead yet.  Intel's Core i7 Processor is quad-core with HT for 8 logicals.
 
-// DOOM3: We don't have that many jobs, so just set this fairly low so we don't spin up a ton of idle threads
-#define MAX_JOB_THREADS		2
-#define NUM_JOB_THREADS		"2"
+// DOOM3: Allow up to one thread per logical core so work stealing can spread job lists over big
+// machines.  Only as many threads as there are logical cores are started so we don't spin up a
+// ton of idle threads, and by default one thread per physical core, less the main thread, is used.
+#define MAX_JOB_THREADS		32
+#define NUM_JOB_THREADS		"-1"
 #define JOB_THREAD_CORES	{	CORE_ANY, CORE_ANY, CORE_ANY, CORE_ANY,	\
 								CORE_ANY, CORE_ANY, CORE_ANY, CORE_ANY,	\
 								CORE_ANY, CORE_ANY, CORE_ANY, CORE_ANY,	\
@@ -1103,7 +1532,7 @@ extern void Sys_CPUCount( int & logicalNum, int & coreNum, int & packageNum );
 								CORE_ANY, CORE_ANY, CORE_ANY, CORE_ANY }
 
 
-idCVar jobs_numThreads( "jobs_numThreads", NUM_JOB_THREADS, CVAR_INTEGER | CVAR_NOCHEAT, "number of threads used to crunch through jobs", 0, MAX_JOB_THREADS );
+idCVar jobs_numThreads( "jobs_numThreads", NUM_JOB_THREADS, CVAR_INTEGER | CVAR_NOCHEAT, "number of threads used to crunch through jobs, -1 = one per physical core less the main thread", -1, MAX_JOB_THREADS );
 
 class idParallelJobManagerLocal : public idParallelJobManager {
 public:
@@ -1121,12 +1550,19 @@ public:
 
 	virtual int					GetNumProcessingUnits();
 
+	virtual bool				IsJobThread() const;
+
 	virtual void				WaitForAllJobLists();
 
 	void						Submit( idParallelJobList_Threads * jobList, int parallelism );
 
+	int							GetNumJobThreads() const { return numJobThreads; }
+
 private:
+	void						UpdateMaxThreads();
+
 	idJobThread						threads[MAX_JOB_THREADS];
+	unsigned int					numJobThreads;		// number of threads that were actually started
 	unsigned int					maxThreads;
 	int								numPhysicalCpuCores;
 	int								numLogicalCpuCores;
@@ -1156,12 +1592,28 @@ void idParallelJobManagerLocal::Init() {
 	core_t cores[] = JOB_THREAD_CORES;
 	assert( sizeof( cores ) / sizeof( cores[0] ) >= MAX_JOB_THREADS );
 
-	for ( int i = 0; i < MAX_JOB_THREADS; i++ ) {
+	Sys_CPUCount( numLogicalCpuCores, numPhysicalCpuCores, numCpuPackages );
+
+	// always start at least two threads, which is what the job lists were tuned for
+	numJobThreads = idMath::ClampInt( 2, MAX_JOB_THREADS, numLogicalCpuCores );
+	for ( unsigned int i = 0; i < numJobThreads; i++ ) {
 		threads[i].Start( cores[i], i );
 	}
-	maxThreads = jobs_numThreads.GetInteger();
+	UpdateMaxThreads();
+}
 
-	Sys_CPUCount( numPhysicalCpuCores, numLogicalCpuCores, numCpuPackages );
+/*
+========================
+idParallelJobManagerLocal::UpdateMaxThreads
+========================
+*/
+void idParallelJobManagerLocal::UpdateMaxThreads() {
+	int numThreads = jobs_numThreads.GetInteger();
+	if ( numThreads < 0 ) {
+		// leave a core to the main thread, but never go below two threads
+		numThreads = Max( 2, numPhysicalCpuCores - 1 );
+	}
+	maxThreads = idMath::ClampInt( 0, (int)numJobThreads, numThreads );
 }
 
 /*
@@ -1170,9 +1622,10 @@ idParallelJobManagerLocal::Shutdown
 ========================
 */
 void idParallelJobManagerLocal::Shutdown() {
-	for ( int i = 0; i < MAX_JOB_THREADS; i++ ) {
+	for ( unsigned int i = 0; i < numJobThreads; i++ ) {
 		threads[i].StopThread();
 	}
+	jobTrace.FreeBuffers();
 }
 
 /*
@@ -1201,7 +1654,7 @@ void idParallelJobManagerLocal::FreeJobList( idParallelJobList * jobList ) {
 		return;
 	}
 	// wait for all job threads to finish because job list deletion is not thread safe
-	for ( unsigned int i = 0; i < maxThreads; i++ ) {
+	for ( unsigned int i = 0; i < numJobThreads; i++ ) {
 		threads[i].WaitForThread();
 	}
 	int index = jobLists.FindIndex( jobList );
@@ -1247,6 +1700,15 @@ int idParallelJobManagerLocal::GetNumProcessingUnits() {
 	return maxThreads;
 }
 
+/*
+========================
+idParallelJobManagerLocal::IsJobThread
+========================
+*/
+bool idParallelJobManagerLocal::IsJobThread() const {
+	return ( isJobThread == 1 );
+}
+
 /*
 ========================
 idParallelJobManagerLocal::WaitForAllJobLists
@@ -1266,23 +1728,26 @@ idParallelJobManagerLocal::Submit
 */
 void idParallelJobManagerLocal::Submit( idParallelJobList_Threads * jobList, int parallelism ) {
 	if ( jobs_numThreads.IsModified() ) {
-		maxThreads = idMath::ClampInt( 0, MAX_JOB_THREADS, jobs_numThreads.GetInteger() );
+		UpdateMaxThreads();
 		jobs_numThreads.ClearModified();
 	}
 
+	if ( jobs_trace.GetBool() ) {
+		jobTrace.AllocBuffers();
+	}
+
 	// determine the number of threads to use
 	int numThreads = maxThreads;
 	if ( parallelism == JOBLIST_PARALLELISM_DEFAULT ) {
 		numThreads = maxThreads;
 	} else if ( parallelism == JOBLIST_PARALLELISM_MAX_CORES ) {
-		numThreads = numLogicalCpuCores;
+		numThreads = numPhysicalCpuCores;
 	} else if ( parallelism == JOBLIST_PARALLELISM_MAX_THREADS ) {
-		numThreads = MAX_JOB_THREADS;
-	} else if ( parallelism > MAX_JOB_THREADS ) {
-		numThreads = MAX_JOB_THREADS;
+		numThreads = numJobThreads;
 	} else {
 		numThreads = parallelism;
 	}
+	numThreads = Min( numThreads, (int)numJobThreads );
 
 	if ( numThreads <= 0 ) {
 		threadJobListState_t state( jobList->GetVersion() );
@@ -1290,8 +1755,310 @@ void idParallelJobManagerLocal::Submit( idParallelJobList_Threads * jobList, int
 		return;
 	}
 
+	if ( jobs_workStealing.GetBool() ) {
+		jobList->PrepareWorkStealing( numThreads );
+	}
+
 	for ( int i = 0; i < numThreads; i++ ) {
 		threads[i].AddJobList( jobList );
 		threads[i].SignalWork();
 	}
-}
\ No newline at end of file
+}
+
+/*
+================================================================================================
+
+	Job trace commands
+
+================================================================================================
+*/
+
+/*
+========================
+JobTrace_ThreadName
+========================
+*/
+static const char * JobTrace_ThreadName( int thread ) {
+	if ( thread == JOB_TRACE_HOST_THREAD ) {
+		return "host";
+	}
+	return va( "JobListProcessor_%d", thread );
+}
+
+/*
+========================
+JobTrace_ListName
+========================
+*/
+static const char * JobTrace_ListName( int listId ) {
+	// jobNames[] is not indexed by the job list id for the utility list
+	switch( listId ) {
+		case JOBLIST_RENDERER_FRONTEND:	return jobNames[0];
+		case JOBLIST_RENDERER_BACKEND:	return jobNames[1];
+		case JOBLIST_UTILITY:			return jobNames[2];
+		default:						return "unknown";
+	}
+}
+
+/*
+========================
+jobs_traceClear
+========================
+*/
+CONSOLE_COMMAND( jobs_traceClear, "clears the per thread job trace buffers", 0 ) {
+	jobTrace.Clear();
+}
+
+/*
+========================
+jobs_traceSummary
+
+Prints the time spent in each registered job and how the work
+and the sync point stalls were spread over the threads.
+========================
+*/
+CONSOLE_COMMAND( jobs_traceSummary, "prints a summary of the recorded job trace", 0 ) {
+	if ( !jobTrace.IsActive() ) {
+		idLib::Printf( "jobs_trace is not enabled\n" );
+		return;
+	}
+
+	struct jobSummary_t {
+		int		count;
+		uint64	total;
+		uint64	max;
+	} jobSummary[MAX_REGISTERED_JOBS + 1] = {};	// the last one is for unregistered jobs
+
+	idLib::Printf( "thread               jobs   busy ms  stall ms   wait ms  fetch collisions\n" );
+	for ( int thread = 0; thread <= MAX_THREADS; thread++ ) {
+		const int numEvents = jobTrace.GetNumEvents( thread );
+		if ( numEvents == 0 ) {
+			continue;
+		}
+		int numJobs = 0;
+		uint64 busy = 0;
+		uint64 stalled = 0;
+		uint64 waited = 0;
+		for ( int i = 0; i < numEvents; i++ ) {
+			const jobTraceEvent_t & event = jobTrace.GetEvent( thread, i );
+			const uint64 duration = event.endTime - event.startTime;
+			if ( event.type == JOB_TRACE_JOB ) {
+				int job = 0;
+				for ( ; job < numRegisteredJobs; job++ ) {
+					if ( registeredJobs[job].function == event.function ) {
+						break;
+					}
+				}
+				if ( job == numRegisteredJobs ) {
+					job = MAX_REGISTERED_JOBS;
+				}
+				jobSummary[job].count++;
+				jobSummary[job].total += duration;
+				jobSummary[job].max = Max( jobSummary[job].max, duration );
+				numJobs++;
+				busy += duration;
+			} else if ( event.type == JOB_TRACE_STALL ) {
+				stalled += duration;
+			} else {
+				waited += duration;
+			}
+		}
+		idLib::Printf( "%-18s %6d %9.2f %9.2f %9.2f %17d\n", JobTrace_ThreadName( thread ), numJobs, busy * 0.001f, stalled * 0.001f, waited * 0.001f, jobTrace.GetFetchCollisions( thread ) );
+	}
+
+	idLib::Printf( "\njob                                 count  total ms   avg us   max us\n" );
+	for ( int job = 0; job <= MAX_REGISTERED_JOBS; job++ ) {
+		if ( jobSummary[job].count == 0 ) {
+			continue;
+		}
+		const char * name = ( job < MAX_REGISTERED_JOBS ) ? registeredJobs[job].name : "unknown";
+		idLib::Printf( "%-34s %7d %9.2f %8d %8d\n", name, jobSummary[job].count, jobSummary[job].total * 0.001f,
+						(int)( jobSummary[job].total / jobSummary[job].count ), (int)jobSummary[job].max );
+	}
+}
+
+/*
+========================
+jobs_dumpTrace
+
+Writes the recorded events as a Chrome trace, load it with chrome://tracing.
+========================
+*/
+CONSOLE_COMMAND( jobs_dumpTrace, "writes the recorded job trace as Chrome trace JSON, usage: jobs_dumpTrace <file> [firstFrame] [lastFrame]", 0 ) {
+	if ( args.Argc() < 2 ) {
+		idLib::Printf( "usage: jobs_dumpTrace <file> [firstFrame] [lastFrame]\n" );
+		return;
+	}
+	if ( !jobTrace.IsActive() ) {
+		idLib::Printf( "jobs_trace is not enabled\n" );
+		return;
+	}
+
+	const int firstFrame = ( args.Argc() > 2 ) ? atoi( args.Argv( 2 ) ) : 0;
+	const int lastFrame = ( args.Argc() > 3 ) ? atoi( args.Argv( 3 ) ) : idLib::frameNumber;
+
+	idStr fileName = args.Argv( 1 );
+	fileName.DefaultFileExtension( ".json" );
+
+	idFile * file = idLib::fileSystem->OpenFileWrite( fileName );
+	if ( file == NULL ) {
+		idLib::Printf( "couldn't open %s\n", fileName.c_str() );
+		return;
+	}
+
+	file->Printf( "{\"traceEvents\":[\n" );
+
+	int numWritten = 0;
+	for ( int thread = 0; thread <= MAX_THREADS; thread++ ) {
+		const int numEvents = jobTrace.GetNumEvents( thread );
+		if ( numEvents == 0 ) {
+			continue;
+		}
+		file->Printf( "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", ( numWritten > 0 ) ? ",\n" : "", thread, JobTrace_ThreadName( thread ) );
+		numWritten++;
+
+		for ( int i = 0; i < numEvents; i++ ) {
+			const jobTraceEvent_t & event = jobTrace.GetEvent( thread, i );
+			if ( event.frameNumber < firstFrame || event.frameNumber > lastFrame ) {
+				continue;
+			}
+			const char * name;
+			if ( event.type == JOB_TRACE_JOB ) {
+				name = GetJobName( event.function );
+			} else if ( event.type == JOB_TRACE_STALL ) {
+				name = va( "stall on sync %d", event.signalIndex );
+			} else {
+				name = "wait";
+			}
+			file->Printf( ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":0,\"tid\":%d,\"args\":{\"frame\":%d}}",
+							name, JobTrace_ListName( event.listId ), event.startTime, event.endTime - event.startTime, thread, event.frameNumber );
+			numWritten++;
+		}
+	}
+
+	file->Printf( "\n]}\n" );
+
+	idLib::fileSystem->CloseFile( file );
+
+	idLib::Printf( "wrote %d events for frames %d to %d to %s\n", numWritten, firstFrame, lastFrame, fileName.c_str() );
+}
+
+/*
+================================================================================================
+
+	Job scheduler benchmark
+
+================================================================================================
+*/
+
+struct jobSchedulerTest_t {
+	int							iterations;
+	bool						afterSync;
+	bool						syncViolated;
+	float						result;
+};
+
+static idSysInterlockedInteger	jobSchedulerTestSignaled;
+static int						jobSchedulerTestNumBeforeSync;
+
+/*
+========================
+JobSchedulerTestJob
+========================
+*/
+static void JobSchedulerTestJob( jobSchedulerTest_t * test ) {
+	// everything before the synchronization point must be done before any job after it starts
+	test->syncViolated = test->afterSync && ( jobSchedulerTestSignaled.GetValue() != jobSchedulerTestNumBeforeSync );
+
+	float x = 0.0f;
+	for ( int i = 0; i < test->iterations; i++ ) {
+		x += idMath::Sqrt( (float)i ) * 0.5f;
+	}
+	test->result = x;
+
+	if ( !test->afterSync ) {
+		jobSchedulerTestSignaled.Increment();
+	}
+}
+REGISTER_PARALLEL_JOB( JobSchedulerTestJob, "JobSchedulerTestJob" );
+
+/*
+========================
+TestJobScheduler
+
+Runs a frontend-like job list with a few long jobs mixed in between many short
+ones through both schedulers and reports how much of the wall time the threads
+sat idle, which is mostly the tail end of the list where one thread is still
+chewing on a long job. The list is submitted with 1, 2, 4 ... threads up to all
+the job threads that were started, to show how each scheduler scales.
+========================
+*/
+CONSOLE_COMMAND( testJobScheduler, "compares the job list scheduler with and without work stealing, usage: testJobScheduler [numJobs] [numFrames]", 0 ) {
+	const int numJobs = ( args.Argc() > 1 ) ? idMath::ClampInt( 2, MAX_STEAL_JOBS / 2, atoi( args.Argv( 1 ) ) ) : 1024;
+	const int numFrames = ( args.Argc() > 2 ) ? Max( 1, atoi( args.Argv( 2 ) ) ) : 100;
+
+	idList< jobSchedulerTest_t, TAG_JOBLIST > tests;
+	tests.SetNum( numJobs );
+
+	jobSchedulerTestNumBeforeSync = numJobs / 2;
+	for ( int i = 0; i < numJobs; i++ ) {
+		// every 64th job is a long one, like a shadow volume job for a big light
+		tests[i].iterations = ( ( i & 63 ) == 17 ) ? 200000 : 2000;
+		tests[i].afterSync = ( i >= jobSchedulerTestNumBeforeSync );
+	}
+
+	idParallelJobList * jobList = parallelJobManager->AllocJobList( JOBLIST_UTILITY, JOBLIST_PRIORITY_MEDIUM, numJobs, 1, NULL );
+
+	const bool oldWorkStealing = jobs_workStealing.GetBool();
+
+	const int numJobThreads = parallelJobManagerLocal.GetNumJobThreads();
+	idLib::Printf( "%d jobs, %d frames, %d job threads\n", numJobs, numFrames, numJobThreads );
+
+	for ( int numThreads = 1; ; numThreads = Min( numThreads * 2, numJobThreads ) ) {
+		for ( int mode = 0; mode < 2; mode++ ) {
+			jobs_workStealing.SetBool( mode != 0 );
+
+			uint64 totalWall = 0;
+			uint64 totalProcessing = 0;
+			uint64 totalWasted = 0;
+			int numViolations = 0;
+
+			for ( int frame = 0; frame < numFrames; frame++ ) {
+				jobSchedulerTestSignaled.SetValue( 0 );
+				for ( int i = 0; i < numJobs; i++ ) {
+					if ( i == jobSchedulerTestNumBeforeSync ) {
+						jobList->InsertSyncPoint( SYNC_SIGNAL );
+						jobList->InsertSyncPoint( SYNC_SYNCHRONIZE );
+					}
+					tests[i].syncViolated = false;
+					jobList->AddJob( (jobRun_t)JobSchedulerTestJob, &tests[i] );
+				}
+
+				const uint64 start = Sys_Microseconds();
+				jobList->Submit( NULL, numThreads );
+				jobList->Wait();
+				totalWall += Sys_Microseconds() - start;
+
+				totalProcessing += jobList->GetTotalProcessingTimeMicroSec();
+				totalWasted += jobList->GetTotalWastedTimeMicroSec();
+
+				for ( int i = 0; i < numJobs; i++ ) {
+					numViolations += tests[i].syncViolated ? 1 : 0;
+				}
+			}
+
+			const float wallMS = totalWall * ( 1.0f / 1000.0f ) / numFrames;
+			const float processingMS = totalProcessing * ( 1.0f / 1000.0f ) / numFrames;
+			const float wastedMS = totalWasted * ( 1.0f / 1000.0f ) / numFrames;
+			idLib::Printf( "%2d threads, %-14s: %6.2f ms per frame, %6.2f ms processing, %6.2f ms wasted in job threads, %d sync violations\n",
+							numThreads, mode ? "work stealing" : "shared list", wallMS, processingMS, wastedMS, numViolations );
+		}
+		if ( numThreads >= numJobThreads ) {
+			break;
+		}
+	}
+
+	jobs_workStealing.SetBool( oldWorkStealing );
+
+	parallelJobManager->FreeJobList( jobList );
+}
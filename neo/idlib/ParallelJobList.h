@@ -59,7 +59,7 @@ enum jobListPriority_t {
 
 enum jobListParallelism_t {
 	JOBLIST_PARALLELISM_DEFAULT			= -1,	// use "jobs_numThreads" number of threads
-	JOBLIST_PARALLELISM_MAX_CORES		= -2,	// use a thread for each logical core (includes hyperthreads)
+	JOBLIST_PARALLELISM_MAX_CORES		= -2,	// use a thread for each physical core (excludes hyperthreads)
 	JOBLIST_PARALLELISM_MAX_THREADS		= -3	// use the maximum number of job threads, which can help if there is IO to overlap
 };
 
@@ -152,6 +152,9 @@ public:
 
 	virtual int					GetNumProcessingUnits() = 0;
 
+	// true when called from a job thread, which must not wait on other job lists
+	virtual bool				IsJobThread() const = 0;
+
 	virtual void				WaitForAllJobLists() = 0;
 };
 
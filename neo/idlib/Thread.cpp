@@ -218,6 +218,9 @@ int idSysThread::ThreadProc( idSysThread * thread ) {
 		_exit( 0 );
 	}
 
+	// hand the thread's allocator caches to the threads that are still running
+	Mem_ReleaseThreadIndex();
+
 	thread->isRunning = false;
 
 	return retVal;
@@ -0,0 +1,485 @@
+/*
+===========================================================================
+
+Doom 3 BFG Edition GPL Source Code
+Copyright (C) 1993-2012 id Software LLC, a ZeniMax Media company. 
+
+This file is part of the Doom 3 BFG Edition GPL Source Code ("Doom 3 BFG Edition Source Code").  
+
+Doom 3 BFG Edition Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 BFG Edition Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 BFG Edition Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 BFG Edition Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 BFG Edition Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+#pragma hdrstop
+#include "../precompiled.h"
+#include "Simd_Generic.h"
+#include "Simd_SSE.h"
+#include "Simd_AVX2.h"
+
+//===============================================================
+//
+//	AVX2 & FMA implementation of idSIMDProcessor
+//
+//	Only used when the CPU and the OS support AVX2 and FMA3. The
+//	8 wide paths keep the lane layout of the SSE versions and fall
+//	back to them for the left over elements.
+//
+//===============================================================
+
+#include <immintrin.h>
+
+#define M_PI	3.14159265358979323846f
+
+// two 16 byte aligned vectors into the low and high half of a register
+#define _mm256_load2_ps( lo, hi )			_mm256_insertf128_ps( _mm256_castps128_ps256( _mm_load_ps( lo ) ), _mm_load_ps( hi ), 1 )
+#define _mm256_loadu2_ps( lo, hi )			_mm256_insertf128_ps( _mm256_castps128_ps256( _mm_loadu_ps( lo ) ), _mm_loadu_ps( hi ), 1 )
+#define _mm256_store2_ps( lo, hi, x )		_mm_store_ps( lo, _mm256_castps256_ps128( x ) ); _mm_store_ps( hi, _mm256_extractf128_ps( x, 1 ) )
+#define _mm256_splat4_ps( a, b, c, d )		_mm256_setr_ps( a, b, c, d, a, b, c, d )
+
+/*
+============
+idSIMD_AVX2::GetName
+============
+*/
+const char * idSIMD_AVX2::GetName() const {
+	return "MMX & SSE & AVX2 & FMA";
+}
+
+/*
+============
+idSIMD_AVX2::MinMax
+============
+*/
+void VPCALL idSIMD_AVX2::MinMax( idVec3 &min, idVec3 &max, const idDrawVert *src, const int count ) {
+	// the fourth float of every load is the first texture coordinate and is ignored
+	__m256 min0 = _mm256_set1_ps( idMath::INFINITY );
+	__m256 max0 = _mm256_set1_ps( -idMath::INFINITY );
+	__m256 min1 = min0;
+	__m256 max1 = max0;
+
+	int i = 0;
+	for ( ; i + 3 < count; i += 4 ) {
+		__m256 v0 = _mm256_loadu2_ps( src[i+0].xyz.ToFloatPtr(), src[i+1].xyz.ToFloatPtr() );
+		__m256 v1 = _mm256_loadu2_ps( src[i+2].xyz.ToFloatPtr(), src[i+3].xyz.ToFloatPtr() );
+		min0 = _mm256_min_ps( min0, v0 );
+		max0 = _mm256_max_ps( max0, v0 );
+		min1 = _mm256_min_ps( min1, v1 );
+		max1 = _mm256_max_ps( max1, v1 );
+	}
+
+	min0 = _mm256_min_ps( min0, min1 );
+	max0 = _mm256_max_ps( max0, max1 );
+
+	__m128 min2 = _mm_min_ps( _mm256_castps256_ps128( min0 ), _mm256_extractf128_ps( min0, 1 ) );
+	__m128 max2 = _mm_max_ps( _mm256_castps256_ps128( max0 ), _mm256_extractf128_ps( max0, 1 ) );
+
+	for ( ; i < count; i++ ) {
+		__m128 v0 = _mm_loadu_ps( src[i].xyz.ToFloatPtr() );
+		min2 = _mm_min_ps( min2, v0 );
+		max2 = _mm_max_ps( max2, v0 );
+	}
+
+	_mm256_zeroupper();
+
+	ALIGN16( float mins[4] );
+	ALIGN16( float maxs[4] );
+	_mm_store_ps( mins, min2 );
+	_mm_store_ps( maxs, max2 );
+
+	min[0] = mins[0];
+	min[1] = mins[1];
+	min[2] = mins[2];
+	max[0] = maxs[0];
+	max[1] = maxs[1];
+	max[2] = maxs[2];
+}
+
+/*
+============
+idSIMD_AVX2::MinMax
+============
+*/
+void VPCALL idSIMD_AVX2::MinMax( idVec3 &min, idVec3 &max, const idDrawVert *src, const triIndex_t *indexes, const int count ) {
+	__m256 min0 = _mm256_set1_ps( idMath::INFINITY );
+	__m256 max0 = _mm256_set1_ps( -idMath::INFINITY );
+	__m256 min1 = min0;
+	__m256 max1 = max0;
+
+	int i = 0;
+	for ( ; i + 3 < count; i += 4 ) {
+		__m256 v0 = _mm256_loadu2_ps( src[indexes[i+0]].xyz.ToFloatPtr(), src[indexes[i+1]].xyz.ToFloatPtr() );
+		__m256 v1 = _mm256_loadu2_ps( src[indexes[i+2]].xyz.ToFloatPtr(), src[indexes[i+3]].xyz.ToFloatPtr() );
+		min0 = _mm256_min_ps( min0, v0 );
+		max0 = _mm256_max_ps( max0, v0 );
+		min1 = _mm256_min_ps( min1, v1 );
+		max1 = _mm256_max_ps( max1, v1 );
+	}
+
+	min0 = _mm256_min_ps( min0, min1 );
+	max0 = _mm256_max_ps( max0, max1 );
+
+	__m128 min2 = _mm_min_ps( _mm256_castps256_ps128( min0 ), _mm256_extractf128_ps( min0, 1 ) );
+	__m128 max2 = _mm_max_ps( _mm256_castps256_ps128( max0 ), _mm256_extractf128_ps( max0, 1 ) );
+
+	for ( ; i < count; i++ ) {
+		__m128 v0 = _mm_loadu_ps( src[indexes[i]].xyz.ToFloatPtr() );
+		min2 = _mm_min_ps( min2, v0 );
+		max2 = _mm_max_ps( max2, v0 );
+	}
+
+	_mm256_zeroupper();
+
+	ALIGN16( float mins[4] );
+	ALIGN16( float maxs[4] );
+	_mm_store_ps( mins, min2 );
+	_mm_store_ps( maxs, max2 );
+
+	min[0] = mins[0];
+	min[1] = mins[1];
+	min[2] = mins[2];
+	max[0] = maxs[0];
+	max[1] = maxs[1];
+	max[2] = maxs[2];
+}
+
+/*
+============
+idSIMD_AVX2::BlendJoints
+
+Same approximations as idSIMD_SSE::BlendJoints on 8 joints at a time,
+joint n and n+4 share a register so the SSE transpose works per lane.
+============
+*/
+void VPCALL idSIMD_AVX2::BlendJoints( idJointQuat *joints, const idJointQuat *blendJoints, const float lerp, const int *index, const int numJoints ) {
+
+	if ( lerp <= 0.0f ) {
+		return;
+	} else if ( lerp >= 1.0f ) {
+		for ( int i = 0; i < numJoints; i++ ) {
+			int j = index[i];
+			joints[j] = blendJoints[j];
+		}
+		return;
+	}
+
+	const __m256 vlerp = _mm256_set1_ps( lerp );
+
+	const __m256 vector_float_one		= _mm256_set1_ps( 1.0f );
+	const __m256 vector_float_sign_bit	= _mm256_castsi256_ps( _mm256_set1_epi32( 0x80000000 ) );
+	const __m256 vector_float_rsqrt_c0	= _mm256_set1_ps( -3.0f );
+	const __m256 vector_float_rsqrt_c1	= _mm256_set1_ps( -0.5f );
+	const __m256 vector_float_tiny		= _mm256_set1_ps( 1e-10f );
+	const __m256 vector_float_half_pi	= _mm256_set1_ps( M_PI*0.5f );
+
+	const __m256 vector_float_sin_c0	= _mm256_set1_ps( -2.39e-08f );
+	const __m256 vector_float_sin_c1	= _mm256_set1_ps(  2.7526e-06f );
+	const __m256 vector_float_sin_c2	= _mm256_set1_ps( -1.98409e-04f );
+	const __m256 vector_float_sin_c3	= _mm256_set1_ps(  8.3333315e-03f );
+	const __m256 vector_float_sin_c4	= _mm256_set1_ps( -1.666666664e-01f );
+
+	const __m256 vector_float_atan_c0	= _mm256_set1_ps(  0.0028662257f );
+	const __m256 vector_float_atan_c1	= _mm256_set1_ps( -0.0161657367f );
+	const __m256 vector_float_atan_c2	= _mm256_set1_ps(  0.0429096138f );
+	const __m256 vector_float_atan_c3	= _mm256_set1_ps( -0.0752896400f );
+	const __m256 vector_float_atan_c4	= _mm256_set1_ps(  0.1065626393f );
+	const __m256 vector_float_atan_c5	= _mm256_set1_ps( -0.1420889944f );
+	const __m256 vector_float_atan_c6	= _mm256_set1_ps(  0.1999355085f );
+	const __m256 vector_float_atan_c7	= _mm256_set1_ps( -0.3333314528f );
+
+	int i = 0;
+	for ( ; i < numJoints - 7; i += 8 ) {
+		const int n0 = index[i+0];
+		const int n1 = index[i+1];
+		const int n2 = index[i+2];
+		const int n3 = index[i+3];
+		const int n4 = index[i+4];
+		const int n5 = index[i+5];
+		const int n6 = index[i+6];
+		const int n7 = index[i+7];
+
+		__m256 jqa = _mm256_load2_ps( joints[n0].q.ToFloatPtr(), joints[n4].q.ToFloatPtr() );
+		__m256 jqb = _mm256_load2_ps( joints[n1].q.ToFloatPtr(), joints[n5].q.ToFloatPtr() );
+		__m256 jqc = _mm256_load2_ps( joints[n2].q.ToFloatPtr(), joints[n6].q.ToFloatPtr() );
+		__m256 jqd = _mm256_load2_ps( joints[n3].q.ToFloatPtr(), joints[n7].q.ToFloatPtr() );
+
+		__m256 jta = _mm256_load2_ps( joints[n0].t.ToFloatPtr(), joints[n4].t.ToFloatPtr() );
+		__m256 jtb = _mm256_load2_ps( joints[n1].t.ToFloatPtr(), joints[n5].t.ToFloatPtr() );
+		__m256 jtc = _mm256_load2_ps( joints[n2].t.ToFloatPtr(), joints[n6].t.ToFloatPtr() );
+		__m256 jtd = _mm256_load2_ps( joints[n3].t.ToFloatPtr(), joints[n7].t.ToFloatPtr() );
+
+		__m256 bqa = _mm256_load2_ps( blendJoints[n0].q.ToFloatPtr(), blendJoints[n4].q.ToFloatPtr() );
+		__m256 bqb = _mm256_load2_ps( blendJoints[n1].q.ToFloatPtr(), blendJoints[n5].q.ToFloatPtr() );
+		__m256 bqc = _mm256_load2_ps( blendJoints[n2].q.ToFloatPtr(), blendJoints[n6].q.ToFloatPtr() );
+		__m256 bqd = _mm256_load2_ps( blendJoints[n3].q.ToFloatPtr(), blendJoints[n7].q.ToFloatPtr() );
+
+		__m256 bta = _mm256_load2_ps( blendJoints[n0].t.ToFloatPtr(), blendJoints[n4].t.ToFloatPtr() );
+		__m256 btb = _mm256_load2_ps( blendJoints[n1].t.ToFloatPtr(), blendJoints[n5].t.ToFloatPtr() );
+		__m256 btc = _mm256_load2_ps( blendJoints[n2].t.ToFloatPtr(), blendJoints[n6].t.ToFloatPtr() );
+		__m256 btd = _mm256_load2_ps( blendJoints[n3].t.ToFloatPtr(), blendJoints[n7].t.ToFloatPtr() );
+
+		jta = _mm256_fmadd_ps( vlerp, _mm256_sub_ps( bta, jta ), jta );
+		jtb = _mm256_fmadd_ps( vlerp, _mm256_sub_ps( btb, jtb ), jtb );
+		jtc = _mm256_fmadd_ps( vlerp, _mm256_sub_ps( btc, jtc ), jtc );
+		jtd = _mm256_fmadd_ps( vlerp, _mm256_sub_ps( btd, jtd ), jtd );
+
+		_mm256_store2_ps( joints[n0].t.ToFloatPtr(), joints[n4].t.ToFloatPtr(), jta );
+		_mm256_store2_ps( joints[n1].t.ToFloatPtr(), joints[n5].t.ToFloatPtr(), jtb );
+		_mm256_store2_ps( joints[n2].t.ToFloatPtr(), joints[n6].t.ToFloatPtr(), jtc );
+		_mm256_store2_ps( joints[n3].t.ToFloatPtr(), joints[n7].t.ToFloatPtr(), jtd );
+
+		__m256 jqr = _mm256_unpacklo_ps( jqa, jqc );
+		__m256 jqs = _mm256_unpackhi_ps( jqa, jqc );
+		__m256 jqt = _mm256_unpacklo_ps( jqb, jqd );
+		__m256 jqu = _mm256_unpackhi_ps( jqb, jqd );
+
+		__m256 bqr = _mm256_unpacklo_ps( bqa, bqc );
+		__m256 bqs = _mm256_unpackhi_ps( bqa, bqc );
+		__m256 bqt = _mm256_unpacklo_ps( bqb, bqd );
+		__m256 bqu = _mm256_unpackhi_ps( bqb, bqd );
+
+		__m256 jqx = _mm256_unpacklo_ps( jqr, jqt );
+		__m256 jqy = _mm256_unpackhi_ps( jqr, jqt );
+		__m256 jqz = _mm256_unpacklo_ps( jqs, jqu );
+		__m256 jqw = _mm256_unpackhi_ps( jqs, jqu );
+
+		__m256 bqx = _mm256_unpacklo_ps( bqr, bqt );
+		__m256 bqy = _mm256_unpackhi_ps( bqr, bqt );
+		__m256 bqz = _mm256_unpacklo_ps( bqs, bqu );
+		__m256 bqw = _mm256_unpackhi_ps( bqs, bqu );
+
+		__m256 cosomg = _mm256_mul_ps( jqx, bqx );
+		cosomg = _mm256_fmadd_ps( jqy, bqy, cosomg );
+		cosomg = _mm256_fmadd_ps( jqz, bqz, cosomg );
+		cosomg = _mm256_fmadd_ps( jqw, bqw, cosomg );
+
+		__m256 sign = _mm256_and_ps( cosomg, vector_float_sign_bit );
+		__m256 cosom = _mm256_xor_ps( cosomg, sign );
+		__m256 ss = _mm256_fnmadd_ps( cosom, cosom, vector_float_one );
+
+		ss = _mm256_max_ps( ss, vector_float_tiny );
+
+		__m256 rs = _mm256_rsqrt_ps( ss );
+		__m256 sq = _mm256_mul_ps( rs, rs );
+		__m256 sh = _mm256_mul_ps( rs, vector_float_rsqrt_c1 );
+		__m256 sx = _mm256_fmadd_ps( ss, sq, vector_float_rsqrt_c0 );
+		__m256 sinom = _mm256_mul_ps( sh, sx );						// sinom = sqrt( ss );
+
+		ss = _mm256_mul_ps( ss, sinom );
+
+		__m256 min = _mm256_min_ps( ss, cosom );
+		__m256 max = _mm256_max_ps( ss, cosom );
+		__m256 mask = _mm256_cmp_ps( min, cosom, _CMP_EQ_OQ );
+		__m256 masksign = _mm256_and_ps( mask, vector_float_sign_bit );
+		__m256 maskPI = _mm256_and_ps( mask, vector_float_half_pi );
+
+		__m256 rcpa = _mm256_rcp_ps( max );
+		__m256 rcpb = _mm256_mul_ps( max, rcpa );
+		__m256 rcpd = _mm256_add_ps( rcpa, rcpa );
+		__m256 rcp = _mm256_fnmadd_ps( rcpb, rcpa, rcpd );			// 1 / y or 1 / x
+		__m256 ata = _mm256_mul_ps( min, rcp );						// x / y or y / x
+
+		__m256 atb = _mm256_xor_ps( ata, masksign );				// -x / y or y / x
+		__m256 atc = _mm256_mul_ps( atb, atb );
+		__m256 atd = _mm256_fmadd_ps( atc, vector_float_atan_c0, vector_float_atan_c1 );
+
+		atd = _mm256_fmadd_ps( atd, atc, vector_float_atan_c2 );
+		atd = _mm256_fmadd_ps( atd, atc, vector_float_atan_c3 );
+		atd = _mm256_fmadd_ps( atd, atc, vector_float_atan_c4 );
+		atd = _mm256_fmadd_ps( atd, atc, vector_float_atan_c5 );
+		atd = _mm256_fmadd_ps( atd, atc, vector_float_atan_c6 );
+		atd = _mm256_fmadd_ps( atd, atc, vector_float_atan_c7 );
+		atd = _mm256_fmadd_ps( atd, atc, vector_float_one );
+
+		__m256 omega_a = _mm256_fmadd_ps( atd, atb, maskPI );
+		__m256 omega_b = _mm256_mul_ps( vlerp, omega_a );
+		omega_a = _mm256_sub_ps( omega_a, omega_b );
+
+		__m256 sinsa = _mm256_mul_ps( omega_a, omega_a );
+		__m256 sinsb = _mm256_mul_ps( omega_b, omega_b );
+		__m256 sina = _mm256_fmadd_ps( sinsa, vector_float_sin_c0, vector_float_sin_c1 );
+		__m256 sinb = _mm256_fmadd_ps( sinsb, vector_float_sin_c0, vector_float_sin_c1 );
+		sina = _mm256_fmadd_ps( sina, sinsa, vector_float_sin_c2 );
+		sinb = _mm256_fmadd_ps( sinb, sinsb, vector_float_sin_c2 );
+		sina = _mm256_fmadd_ps( sina, sinsa, vector_float_sin_c3 );
+		sinb = _mm256_fmadd_ps( sinb, sinsb, vector_float_sin_c3 );
+		sina = _mm256_fmadd_ps( sina, sinsa, vector_float_sin_c4 );
+		sinb = _mm256_fmadd_ps( sinb, sinsb, vector_float_sin_c4 );
+		sina = _mm256_fmadd_ps( sina, sinsa, vector_float_one );
+		sinb = _mm256_fmadd_ps( sinb, sinsb, vector_float_one );
+		sina = _mm256_mul_ps( sina, omega_a );
+		sinb = _mm256_mul_ps( sinb, omega_b );
+		__m256 scalea = _mm256_mul_ps( sina, sinom );
+		__m256 scaleb = _mm256_mul_ps( sinb, sinom );
+
+		scaleb = _mm256_xor_ps( scaleb, sign );
+
+		jqx = _mm256_fmadd_ps( bqx, scaleb, _mm256_mul_ps( jqx, scalea ) );
+		jqy = _mm256_fmadd_ps( bqy, scaleb, _mm256_mul_ps( jqy, scalea ) );
+		jqz = _mm256_fmadd_ps( bqz, scaleb, _mm256_mul_ps( jqz, scalea ) );
+		jqw = _mm256_fmadd_ps( bqw, scaleb, _mm256_mul_ps( jqw, scalea ) );
+
+		__m256 tp0 = _mm256_unpacklo_ps( jqx, jqz );
+		__m256 tp1 = _mm256_unpackhi_ps( jqx, jqz );
+		__m256 tp2 = _mm256_unpacklo_ps( jqy, jqw );
+		__m256 tp3 = _mm256_unpackhi_ps( jqy, jqw );
+
+		__m256 p0 = _mm256_unpacklo_ps( tp0, tp2 );
+		__m256 p1 = _mm256_unpackhi_ps( tp0, tp2 );
+		__m256 p2 = _mm256_unpacklo_ps( tp1, tp3 );
+		__m256 p3 = _mm256_unpackhi_ps( tp1, tp3 );
+
+		_mm256_store2_ps( joints[n0].q.ToFloatPtr(), joints[n4].q.ToFloatPtr(), p0 );
+		_mm256_store2_ps( joints[n1].q.ToFloatPtr(), joints[n5].q.ToFloatPtr(), p1 );
+		_mm256_store2_ps( joints[n2].q.ToFloatPtr(), joints[n6].q.ToFloatPtr(), p2 );
+		_mm256_store2_ps( joints[n3].q.ToFloatPtr(), joints[n7].q.ToFloatPtr(), p3 );
+	}
+
+	_mm256_zeroupper();
+
+	if ( i < numJoints ) {
+		idSIMD_SSE::BlendJoints( joints, blendJoints, lerp, index + i, numJoints - i );
+	}
+}
+
+/*
+============
+idSIMD_AVX2::ConvertJointQuatsToJointMats
+
+The SSE conversion with two joints per register, the shuffles stay
+within the 128 bit lanes.
+============
+*/
+void VPCALL idSIMD_AVX2::ConvertJointQuatsToJointMats( idJointMat *jointMats, const idJointQuat *jointQuats, const int numJoints ) {
+	assert( sizeof( idJointQuat ) == JOINTQUAT_SIZE );
+	assert( sizeof( idJointMat ) == JOINTMAT_SIZE );
+
+	const float * jointQuatPtr = (float *)jointQuats;
+	float * jointMatPtr = (float *)jointMats;
+
+	const __m256 vector_float_first_sign_bit		= _mm256_castsi256_ps( _mm256_setr_epi32( 0x80000000, 0x00000000, 0x00000000, 0x00000000, 0x80000000, 0x00000000, 0x00000000, 0x00000000 ) );
+	const __m256 vector_float_last_three_sign_bits	= _mm256_castsi256_ps( _mm256_setr_epi32( 0x00000000, 0x80000000, 0x80000000, 0x80000000, 0x00000000, 0x80000000, 0x80000000, 0x80000000 ) );
+	const __m256 vector_float_first_pos_half		= _mm256_splat4_ps(   0.5f,   0.0f,   0.0f,   0.0f );	// +.5 0 0 0
+	const __m256 vector_float_first_neg_half		= _mm256_splat4_ps(  -0.5f,   0.0f,   0.0f,   0.0f );	// -.5 0 0 0
+	const __m256 vector_float_quat2mat_mad1			= _mm256_splat4_ps(  -1.0f,  -1.0f,  +1.0f,  -1.0f );	//  - - + -
+	const __m256 vector_float_quat2mat_mad2			= _mm256_splat4_ps(  -1.0f,  +1.0f,  -1.0f,  -1.0f );	//  - + - -
+	const __m256 vector_float_quat2mat_mad3			= _mm256_splat4_ps(  +1.0f,  -1.0f,  -1.0f,  +1.0f );	//  + - - +
+
+	int i = 0;
+	for ( ; i + 1 < numJoints; i += 2 ) {
+
+		__m256 q = _mm256_load2_ps( &jointQuatPtr[i*8+0*8+0], &jointQuatPtr[i*8+1*8+0] );
+		__m256 t = _mm256_load2_ps( &jointQuatPtr[i*8+0*8+4], &jointQuatPtr[i*8+1*8+4] );
+
+		__m256 d = _mm256_add_ps( q, q );
+
+		__m256 sa = _mm256_permute_ps( q, _MM_SHUFFLE( 1, 0, 0, 1 ) );								//   y,   x,   x,   y
+		__m256 sb = _mm256_permute_ps( d, _MM_SHUFFLE( 2, 2, 1, 1 ) );								//  y2,  y2,  z2,  z2
+		__m256 sc = _mm256_permute_ps( q, _MM_SHUFFLE( 3, 3, 3, 2 ) );								//   z,   w,   w,   w
+		__m256 sd = _mm256_permute_ps( d, _MM_SHUFFLE( 0, 1, 2, 2 ) );								//  z2,  z2,  y2,  x2
+
+		sa = _mm256_xor_ps( sa, vector_float_first_sign_bit );
+		sc = _mm256_xor_ps( sc, vector_float_last_three_sign_bits );								// flip stupid inverse quaternions
+
+		__m256 ma = _mm256_fmadd_ps( sa, sb, vector_float_first_pos_half );						//  .5 - yy2,  xy2,  xz2,  yz2		//  .5 0 0 0
+		__m256 mb = _mm256_fmadd_ps( sc, sd, vector_float_first_neg_half );						// -.5 + zz2,  wz2,  wy2,  wx2		// -.5 0 0 0
+		__m256 mc = _mm256_fnmadd_ps( q, d, vector_float_first_pos_half );						//  .5 - xx2, -yy2, -zz2, -ww2		//  .5 0 0 0
+
+		__m256 mf = _mm256_shuffle_ps( ma, mc, _MM_SHUFFLE( 0, 0, 1, 1 ) );						//       xy2,  xy2, .5 - xx2, .5 - xx2	// 01, 01, 10, 10
+		__m256 md = _mm256_shuffle_ps( mf, ma, _MM_SHUFFLE( 3, 2, 0, 2 ) );						//  .5 - xx2,  xy2,  xz2,  yz2			// 10, 01, 02, 03
+		__m256 me = _mm256_shuffle_ps( ma, mb, _MM_SHUFFLE( 3, 2, 1, 0 ) );						//  .5 - yy2,  xy2,  wy2,  wx2			// 00, 01, 12, 13
+
+		__m256 ra = _mm256_fmadd_ps( mb, vector_float_quat2mat_mad1, ma );						// 1 - yy2 - zz2, xy2 - wz2, xz2 + wy2,					// - - + -
+		__m256 rb = _mm256_fmadd_ps( mb, vector_float_quat2mat_mad2, md );						// 1 - xx2 - zz2, xy2 + wz2,          , yz2 - wx2		// - + - -
+		__m256 rc = _mm256_fmadd_ps( me, vector_float_quat2mat_mad3, md );						// 1 - xx2 - yy2,          , xz2 - wy2, yz2 + wx2		// + - - +
+
+		__m256 ta = _mm256_shuffle_ps( ra, t, _MM_SHUFFLE( 0, 0, 2, 2 ) );
+		__m256 tb = _mm256_shuffle_ps( rb, t, _MM_SHUFFLE( 1, 1, 3, 3 ) );
+		__m256 tc = _mm256_shuffle_ps( rc, t, _MM_SHUFFLE( 2, 2, 0, 0 ) );
+
+		ra = _mm256_shuffle_ps( ra, ta, _MM_SHUFFLE( 2, 0, 1, 0 ) );								// 00 01 02 10
+		rb = _mm256_shuffle_ps( rb, tb, _MM_SHUFFLE( 2, 0, 0, 1 ) );								// 01 00 03 11
+		rc = _mm256_shuffle_ps( rc, tc, _MM_SHUFFLE( 2, 0, 3, 2 ) );								// 02 03 00 12
+
+		// the two matrices are 24 consecutive floats
+		_mm256_storeu_ps( &jointMatPtr[i*12+ 0], _mm256_permute2f128_ps( ra, rb, 0x20 ) );
+		_mm256_storeu_ps( &jointMatPtr[i*12+ 8], _mm256_permute2f128_ps( rc, ra, 0x30 ) );
+		_mm256_storeu_ps( &jointMatPtr[i*12+16], _mm256_permute2f128_ps( rb, rc, 0x31 ) );
+	}
+
+	_mm256_zeroupper();
+
+	if ( i < numJoints ) {
+		idSIMD_SSE::ConvertJointQuatsToJointMats( jointMats + i, jointQuats + i, numJoints - i );
+	}
+}
+
+/*
+============
+idSIMD_AVX2::TransformJoints
+
+The first two rows of the parent share a register, so every joint
+takes three fused multiply-adds on 8 floats plus three on 4.
+============
+*/
+void VPCALL idSIMD_AVX2::TransformJoints( idJointMat *jointMats, const int *parents, const int firstJoint, const int lastJoint ) {
+	const __m256 vector_float_mask_keep_last	= _mm256_castsi256_ps( _mm256_setr_epi32( 0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFF, 0x00000000, 0x00000000, 0x00000000, 0xFFFFFFFF ) );
+
+	const float *__restrict firstMatrix = jointMats->ToFloatPtr() + ( firstJoint + firstJoint + firstJoint - 3 ) * 4;
+
+	__m256 pmab = _mm256_loadu_ps( firstMatrix + 0 );
+	__m128 pmc = _mm_load_ps( firstMatrix + 8 );
+
+	for ( int joint = firstJoint; joint <= lastJoint; joint++ ) {
+		const int parent = parents[joint];
+		const float *__restrict parentMatrix = jointMats->ToFloatPtr() + ( parent + parent + parent ) * 4;
+		float *__restrict childMatrix = jointMats->ToFloatPtr() + ( joint + joint + joint ) * 4;
+
+		if ( parent != joint - 1 ) {
+			pmab = _mm256_loadu_ps( parentMatrix + 0 );
+			pmc = _mm_load_ps( parentMatrix + 8 );
+		}
+
+		// every child row in both halves
+		__m256 cma = _mm256_broadcast_ps( (const __m128 *)( childMatrix + 0 ) );
+		__m256 cmb = _mm256_broadcast_ps( (const __m128 *)( childMatrix + 4 ) );
+		__m256 cmc = _mm256_broadcast_ps( (const __m128 *)( childMatrix + 8 ) );
+
+		__m256 tab = _mm256_permute_ps( pmab, _MM_SHUFFLE( 0, 0, 0, 0 ) );
+		__m256 tde = _mm256_permute_ps( pmab, _MM_SHUFFLE( 1, 1, 1, 1 ) );
+		__m256 tgh = _mm256_permute_ps( pmab, _MM_SHUFFLE( 2, 2, 2, 2 ) );
+
+		__m128 tc = _mm_permute_ps( pmc, _MM_SHUFFLE( 0, 0, 0, 0 ) );
+		__m128 tf = _mm_permute_ps( pmc, _MM_SHUFFLE( 1, 1, 1, 1 ) );
+		__m128 ti = _mm_permute_ps( pmc, _MM_SHUFFLE( 2, 2, 2, 2 ) );
+
+		pmab = _mm256_fmadd_ps( tab, cma, _mm256_and_ps( pmab, vector_float_mask_keep_last ) );
+		pmc = _mm_fmadd_ps( tc, _mm256_castps256_ps128( cma ), _mm_and_ps( pmc, _mm256_castps256_ps128( vector_float_mask_keep_last ) ) );
+
+		pmab = _mm256_fmadd_ps( tde, cmb, pmab );
+		pmc = _mm_fmadd_ps( tf, _mm256_castps256_ps128( cmb ), pmc );
+
+		pmab = _mm256_fmadd_ps( tgh, cmc, pmab );
+		pmc = _mm_fmadd_ps( ti, _mm256_castps256_ps128( cmc ), pmc );
+
+		_mm256_storeu_ps( childMatrix + 0, pmab );
+		_mm_store_ps( childMatrix + 8, pmc );
+	}
+
+	_mm256_zeroupper();
+}
@@ -41,6 +41,7 @@ If you have questions concerning this license or the applicable additional terms
 	typedef CRITICAL_SECTION		mutexHandle_t;
 	typedef HANDLE					signalHandle_t;
 	typedef LONG					interlockedInt_t;
+	typedef LONGLONG				interlockedInt64_t;
 
 	// _ReadWriteBarrier() does not translate to any instructions but keeps the compiler
 	// from reordering read and write instructions across the barrier.
@@ -151,6 +152,8 @@ interlockedInt_t	Sys_InterlockedSub( interlockedInt_t & value, interlockedInt_t
 interlockedInt_t	Sys_InterlockedExchange( interlockedInt_t & value, interlockedInt_t exchange );
 interlockedInt_t	Sys_InterlockedCompareExchange( interlockedInt_t & value, interlockedInt_t comparand, interlockedInt_t exchange );
 
+interlockedInt64_t	Sys_InterlockedCompareExchange64( interlockedInt64_t & value, interlockedInt64_t comparand, interlockedInt64_t exchange );
+
 void *				Sys_InterlockedExchangePointer( void * & ptr, void * exchange );
 void *				Sys_InterlockedCompareExchangePointer( void * & ptr, void * comparand, void * exchange );
 
@@ -331,6 +331,15 @@ interlockedInt_t Sys_InterlockedCompareExchange( interlockedInt_t & value, inter
 	return InterlockedCompareExchange( & value, exchange, comparand );
 }
 
+/*
+========================
+Sys_InterlockedCompareExchange64
+========================
+*/
+interlockedInt64_t Sys_InterlockedCompareExchange64( interlockedInt64_t & value, interlockedInt64_t comparand, interlockedInt64_t exchange ) {
+	return InterlockedCompareExchange64( & value, exchange, comparand );
+}
+
 /*
 ================================================================================================
 
@@ -41,6 +41,22 @@ If you have questions concerning this license or the applicable additional terms
 #include "color/ColorSpace.h"
 
 idCVar image_highQualityCompression( "image_highQualityCompression", "0", CVAR_BOOL, "Use high quality (slow) compression" );
+idCVar image_parallelCompression( "image_parallelCompression", "1", CVAR_BOOL, "split large images into bands that are mip mapped and compressed in parallel with the job system" );
+
+/*
+========================
+R_ImageCompressionJobList
+
+The image manager's compression job list may only be used by one thread at a time,
+so images compressed on other threads are compressed serially.
+========================
+*/
+static idParallelJobList * R_ImageCompressionJobList() {
+	if ( !image_parallelCompression.GetBool() || !idLib::IsMainThread() ) {
+		return NULL;
+	}
+	return globalImages->compressionJobList;
+}
 
 /*
 ========================
@@ -85,27 +101,35 @@ void idBinaryImage::Load2DFromMemory( int width, int height, const byte * pic_co
 		}
 	}
 
+	// downsample all the levels up front, they share one allocation
+	idList< const byte * > levelPics;
+	levelPics.SetNum( numLevels );
+	byte * mipChain = R_MipMapChain( pic, width, height, numLevels, gammaMips, levelPics.Ptr(), R_ImageCompressionJobList() );
+
 	int	scaledWidth = width;
 	int scaledHeight = height;
 	images.SetNum( numLevels );
 	for ( int level = 0; level < images.Num(); level++ ) {
 		idBinaryImageData &img = images[ level ];
+		const byte * levelPic = levelPics[ level ];
 
 		// Images that are going to be DXT compressed and aren't multiples of 4 need to be 
 		// padded out before compressing.
-		byte * dxtPic = pic;
+		byte * paddedPic = NULL;
+		const byte * dxtPic = levelPic;
 		int	dxtWidth = 0;
 		int	dxtHeight = 0;
 		if ( textureFormat == FMT_DXT5 || textureFormat == FMT_DXT1 ) {
 			if ( ( scaledWidth & 3 ) || ( scaledHeight & 3 ) ) {
 				dxtWidth = ( scaledWidth + 3 ) & ~3;
 				dxtHeight = ( scaledHeight + 3 ) & ~3;
-				dxtPic = (byte *)Mem_ClearedAlloc( dxtWidth*4*dxtHeight, TAG_IMAGE );
+				paddedPic = (byte *)Mem_ClearedAlloc( dxtWidth*4*dxtHeight, TAG_IMAGE );
 				for ( int i = 0; i < scaledHeight; i++ ) {
-					memcpy( dxtPic + i*dxtWidth*4, pic + i*scaledWidth*4, scaledWidth*4 );
+					memcpy( paddedPic + i*dxtWidth*4, levelPic + i*scaledWidth*4, scaledWidth*4 );
 				}
+				dxtPic = paddedPic;
 			} else {
-				dxtPic = pic;
+				dxtPic = levelPic;
 				dxtWidth = scaledWidth;
 				dxtHeight = scaledHeight;
 			}
@@ -123,7 +147,7 @@ void idBinaryImage::Load2DFromMemory( int width, int height, const byte * pic_co
 			if ( image_highQualityCompression.GetBool() ) {
 				dxt.CompressImageDXT1HQ( dxtPic, img.data, dxtWidth, dxtHeight );
 			} else {
-				dxt.CompressImageDXT1Fast( dxtPic, img.data, dxtWidth, dxtHeight );
+				dxt.CompressImageFastParallel( DXT_FAST_DXT1, dxtPic, img.data, dxtWidth, dxtHeight, R_ImageCompressionJobList() );
 			}
 		} else if ( textureFormat == FMT_DXT5 ) {
 			idDxtEncoder dxt;
@@ -132,27 +156,27 @@ void idBinaryImage::Load2DFromMemory( int width, int height, const byte * pic_co
 				if ( image_highQualityCompression.GetBool() ) {
 					dxt.CompressNormalMapDXT5HQ( dxtPic, img.data, dxtWidth, dxtHeight );
 				} else {
-					dxt.CompressNormalMapDXT5Fast( dxtPic, img.data, dxtWidth, dxtHeight );
+					dxt.CompressImageFastParallel( DXT_FAST_NORMAL_DXT5, dxtPic, img.data, dxtWidth, dxtHeight, R_ImageCompressionJobList() );
 				}
 			} else if ( colorFormat == CFM_YCOCG_DXT5 ) {
 				if ( image_highQualityCompression.GetBool() ) {
 					dxt.CompressYCoCgDXT5HQ( dxtPic, img.data, dxtWidth, dxtHeight );
 				} else {
-					dxt.CompressYCoCgDXT5Fast( dxtPic, img.data, dxtWidth, dxtHeight );
+					dxt.CompressImageFastParallel( DXT_FAST_YCOCG_DXT5, dxtPic, img.data, dxtWidth, dxtHeight, R_ImageCompressionJobList() );
 				}
 			} else {
 				fileData.colorFormat = colorFormat = CFM_DEFAULT;
 				if ( image_highQualityCompression.GetBool() ) {
 					dxt.CompressImageDXT5HQ( dxtPic, img.data, dxtWidth, dxtHeight );
 				} else {
-					dxt.CompressImageDXT5Fast( dxtPic, img.data, dxtWidth, dxtHeight );
+					dxt.CompressImageFastParallel( DXT_FAST_DXT5, dxtPic, img.data, dxtWidth, dxtHeight, R_ImageCompressionJobList() );
 				}
 			}
 		} else if ( textureFormat == FMT_LUM8 || textureFormat == FMT_INT8 ) {
 			// LUM8 and INT8 just read the red channel
 			img.Alloc( scaledWidth * scaledHeight );
 			for ( int i = 0; i < img.dataSize; i++ ) {
-				img.data[ i ] = pic[ i * 4 ];
+				img.data[ i ] = levelPic[ i * 4 ];
 			}
 		} else if ( textureFormat == FMT_ALPHA ) {
 			// ALPHA reads the alpha channel
@@ -161,26 +185,26 @@ void idBinaryImage::Load2DFromMemory( int width, int height, const byte * pic_co
 				img.data[ i + 0 ] = 255;
 				img.data[ i + 1 ] = 255;
 				img.data[ i + 2 ] = 255;
-				img.data[ i + 3 ] = pic[ i + 3 ];
+				img.data[ i + 3 ] = levelPic[ i + 3 ];
 			}
 		} else if ( textureFormat == FMT_L8A8 ) {
 			// L8A8 reads the alpha and red channels
 			img.Alloc( scaledWidth * scaledHeight * 2 );
 			for ( int i = 0; i < img.dataSize / 2; i++ ) {
-				img.data[ i * 2 + 0 ] = pic[ i * 4 + 0 ];
-				img.data[ i * 2 + 1 ] = pic[ i * 4 + 3 ];
+				img.data[ i * 2 + 0 ] = levelPic[ i * 4 + 0 ];
+				img.data[ i * 2 + 1 ] = levelPic[ i * 4 + 3 ];
 			}
 		} else if ( textureFormat == FMT_RGB565 ) {
 			img.Alloc( scaledWidth * scaledHeight * 2 );
 			for ( int i = 0; i < img.dataSize / 2; i++ ) {
-				unsigned short color = ( ( pic[ i * 4 + 0 ] >> 3 ) << 11 ) | ( ( pic[ i * 4 + 1 ] >> 2 ) << 5 ) | ( pic[ i * 4 + 2 ] >> 3 );
+				unsigned short color = ( ( levelPic[ i * 4 + 0 ] >> 3 ) << 11 ) | ( ( levelPic[ i * 4 + 1 ] >> 2 ) << 5 ) | ( levelPic[ i * 4 + 2 ] >> 3 );
 				img.data[ i * 2 + 0 ] = ( color >> 8 ) & 0xFF;
 				img.data[ i * 2 + 1 ] = color & 0xFF;
 			}
 		} else if ( textureFormat == FMT_BGR565 ) {
 			img.Alloc( scaledWidth * scaledHeight * 2 );
 			for ( int i = 0; i < img.dataSize / 2; i++ ) {
-				unsigned short color = ( ( pic[ i * 4 + 2 ] >> 3 ) << 11 ) | ( ( pic[ i * 4 + 1 ] >> 2 ) << 5 ) | ( pic[ i * 4 + 0 ] >> 3 );
+				unsigned short color = ( ( levelPic[ i * 4 + 2 ] >> 3 ) << 11 ) | ( ( levelPic[ i * 4 + 1 ] >> 2 ) << 5 ) | ( levelPic[ i * 4 + 0 ] >> 3 );
 				img.data[ i * 2 + 1 ] = ( color >> 8 ) & 0xFF;
 				img.data[ i * 2 + 0 ] = color & 0xFF;
 			}
@@ -188,30 +212,21 @@ void idBinaryImage::Load2DFromMemory( int width, int height, const byte * pic_co
 			fileData.format = textureFormat = FMT_RGBA8;
 			img.Alloc( scaledWidth * scaledHeight * 4 );
 			for ( int i = 0; i < img.dataSize; i++ ) {
-				img.data[ i ] = pic[ i ];
+				img.data[ i ] = levelPic[ i ];
 			}
 		}
 
 		// if we had to pad to quads, free the padded version
-		if ( pic != dxtPic ) {
-			Mem_Free( dxtPic );
-			dxtPic = NULL;
-		}
-
-		// downsample for the next level
-		byte * shrunk = NULL;
-		if ( gammaMips ) {
-			shrunk = R_MipMapWithGamma( pic, scaledWidth, scaledHeight );
-		} else {
-			shrunk = R_MipMap( pic, scaledWidth, scaledHeight );
+		if ( paddedPic != NULL ) {
+			Mem_Free( paddedPic );
+			paddedPic = NULL;
 		}
-		Mem_Free( pic );
-		pic = shrunk;
 
 		scaledWidth = Max( 1, scaledWidth >> 1 );
 		scaledHeight = Max( 1, scaledHeight >> 1 );
 	}
 
+	Mem_Free( mipChain );
 	Mem_Free( pic );
 }
 
@@ -254,13 +269,16 @@ void idBinaryImage::LoadCubeFromMemory( int width, const byte * pics[6], int num
 
 	images.SetNum( fileData.numLevels * 6 );
 
+	idList< const byte * > levelPics;
+	levelPics.SetNum( fileData.numLevels );
+
 	for ( int side = 0; side < 6; side++ ) {
-		const byte *orig = pics[side];
-		const byte *pic = orig;
+		byte * mipChain = R_MipMapChain( pics[side], fileData.width, fileData.width, fileData.numLevels, gammaMips, levelPics.Ptr(), R_ImageCompressionJobList() );
 		int	scaledWidth = fileData.width;
 		for ( int level = 0; level < fileData.numLevels; level++ ) {
 			// compress data or convert floats as necessary
 			idBinaryImageData &img = images[ level * 6 + side ];
+			const byte * pic = levelPics[ level ];
 
 			// handle padding blocks less than 4x4 for the DXT compressors
 			ALIGN16( byte padBlock[64] );
@@ -282,37 +300,21 @@ void idBinaryImage::LoadCubeFromMemory( int width, const byte * pics[6], int num
 			if ( textureFormat == FMT_DXT1 ) {
 				img.Alloc( padSize * padSize / 2 );
 				idDxtEncoder dxt;
-				dxt.CompressImageDXT1Fast( padSrc, img.data, padSize, padSize );
+				dxt.CompressImageFastParallel( DXT_FAST_DXT1, padSrc, img.data, padSize, padSize, R_ImageCompressionJobList() );
 			} else if ( textureFormat == FMT_DXT5 ) {
 				img.Alloc( padSize * padSize );
 				idDxtEncoder dxt;
-				dxt.CompressImageDXT5Fast( padSrc, img.data, padSize, padSize );
+				dxt.CompressImageFastParallel( DXT_FAST_DXT5, padSrc, img.data, padSize, padSize, R_ImageCompressionJobList() );
 			} else {
 				fileData.format = textureFormat = FMT_RGBA8;
 				img.Alloc( padSize * padSize * 4 );
 				memcpy( img.data, pic, img.dataSize );
 			}
 
-			// downsample for the next level
-			byte * shrunk = NULL;
-			if ( gammaMips ) {
-				shrunk = R_MipMapWithGamma( pic, scaledWidth, scaledWidth );
-			} else {
-				shrunk = R_MipMap( pic, scaledWidth, scaledWidth );
-			}
-			if ( pic != orig ) {
-				Mem_Free( (void *)pic );
-				pic = NULL;
-			}
-			pic = shrunk;
-
 			scaledWidth = Max( 1, scaledWidth >> 1 );
 		}
-		if ( pic != orig ) {
-			// free the down sampled version
-			Mem_Free( (void *)pic );
-			pic = NULL;
-		}
+		// free the down sampled versions
+		Mem_Free( mipChain );
 	}
 }
 
@@ -357,19 +359,19 @@ ID_TIME_T idBinaryImage::WriteGeneratedFile( ID_TIME_T sourceFileTime ) {
 
 /*
 ==========================
-idBinaryImage::LoadFromGeneratedFile
+idBinaryImage::LoadHeaderFromGeneratedFile
 
-Load the preprocessed image from the generated folder.
+Only reads the header of the preprocessed image, GetFileHeader() is valid on success.
 ==========================
 */
-ID_TIME_T idBinaryImage::LoadFromGeneratedFile( ID_TIME_T sourceFileTime ) {
+ID_TIME_T idBinaryImage::LoadHeaderFromGeneratedFile( ID_TIME_T sourceFileTime ) {
 	idStr binaryFileName;
 	MakeGeneratedFileName( binaryFileName );
 	idFileLocal bFile = fileSystem->OpenFileRead( binaryFileName );
 	if ( bFile == NULL ) {
 		return FILE_NOT_FOUND_TIMESTAMP;
 	}
-	if ( LoadFromGeneratedFile( bFile, sourceFileTime ) ) {
+	if ( LoadHeaderFromGeneratedFile( bFile, sourceFileTime ) ) {
 		return bFile->Timestamp();
 	}
 	return FILE_NOT_FOUND_TIMESTAMP;
@@ -377,12 +379,10 @@ ID_TIME_T idBinaryImage::LoadFromGeneratedFile( ID_TIME_T sourceFileTime ) {
 
 /*
 ==========================
-idBinaryImage::LoadFromGeneratedFile
-
-Load the preprocessed image from the generated folder.
+idBinaryImage::LoadHeaderFromGeneratedFile
 ==========================
 */
-bool idBinaryImage::LoadFromGeneratedFile( idFile * bFile, ID_TIME_T sourceFileTime ) {
+bool idBinaryImage::LoadHeaderFromGeneratedFile( idFile * bFile, ID_TIME_T sourceFileTime ) {
 	if ( bFile->Read( &fileData, sizeof( fileData ) ) <= 0 ) {
 		return false;
 	}
@@ -402,6 +402,40 @@ bool idBinaryImage::LoadFromGeneratedFile( idFile * bFile, ID_TIME_T sourceFileT
 	if ( fileData.sourceFileTime != sourceFileTime && !fileSystem->InProductionMode() ) {
 		return false;
 	}
+	return true;
+}
+
+/*
+==========================
+idBinaryImage::LoadFromGeneratedFile
+
+Load the preprocessed image from the generated folder.
+==========================
+*/
+ID_TIME_T idBinaryImage::LoadFromGeneratedFile( ID_TIME_T sourceFileTime ) {
+	idStr binaryFileName;
+	MakeGeneratedFileName( binaryFileName );
+	idFileLocal bFile = fileSystem->OpenFileRead( binaryFileName );
+	if ( bFile == NULL ) {
+		return FILE_NOT_FOUND_TIMESTAMP;
+	}
+	if ( LoadFromGeneratedFile( bFile, sourceFileTime ) ) {
+		return bFile->Timestamp();
+	}
+	return FILE_NOT_FOUND_TIMESTAMP;
+}
+
+/*
+==========================
+idBinaryImage::LoadFromGeneratedFile
+
+Load the preprocessed image from the generated folder.
+==========================
+*/
+bool idBinaryImage::LoadFromGeneratedFile( idFile * bFile, ID_TIME_T sourceFileTime ) {
+	if ( !LoadHeaderFromGeneratedFile( bFile, sourceFileTime ) ) {
+		return false;
+	}
 
 	int numImages = fileData.numLevels;
 	if ( fileData.textureType == TT_CUBIC ) {
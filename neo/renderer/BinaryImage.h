@@ -49,6 +49,7 @@ public:
 	void				LoadCubeFromMemory( int width, const byte * pics[6], int numLevels, textureFormat_t & textureFormat, bool gammaMips );
 
 	ID_TIME_T			LoadFromGeneratedFile( ID_TIME_T sourceFileTime );
+	ID_TIME_T			LoadHeaderFromGeneratedFile( ID_TIME_T sourceFileTime );	// only reads the file header, for checking if the file is current
 	ID_TIME_T			WriteGeneratedFile( ID_TIME_T sourceFileTime );
 
 	const bimageFile_t &	GetFileHeader() { return fileData; }
@@ -102,6 +103,7 @@ private:
 private:
 	void				MakeGeneratedFileName( idStr & gfn );
 	bool				LoadFromGeneratedFile( idFile * f, ID_TIME_T sourceFileTime );
+	bool				LoadHeaderFromGeneratedFile( idFile * f, ID_TIME_T sourceFileTime );
 };
 
 #endif // __BINARYIMAGE_H__
@@ -50,6 +50,26 @@ The supported formats are:
 	* DXN2 = two DXT5 alpha blocks (aka 3Dc, or ATI2N)
 ================================================
 */
+
+/*
+================================================
+dxtFastFormat_t selects one of the fast compressors for the
+format-generic entry points, which can also split the image
+into bands of block rows and compress them in parallel.
+================================================
+*/
+enum dxtFastFormat_t {
+	DXT_FAST_DXT1,
+	DXT_FAST_DXT1_ALPHA,
+	DXT_FAST_DXT5,
+	DXT_FAST_YCOCG_DXT5,
+	DXT_FAST_NORMAL_DXT5,
+	DXT_FAST_MAX
+};
+
+static const int DXT_MAX_PARALLEL_BANDS		= 64;			// job lists passed to CompressImageFastParallel need room for this many jobs
+static const int DXT_MIN_PARALLEL_PIXELS	= 64 * 1024;	// smallest band that is worth a job
+
 class idDxtEncoder {
 public:
 			idDxtEncoder() { srcPadding = dstPadding = 0; }
@@ -58,6 +78,16 @@ public:
 	void	SetSrcPadding( int pad ) { srcPadding = pad; }
 	void	SetDstPadding( int pad ) { dstPadding = pad; }
 
+	// fast compression into any of the dxtFastFormat_t formats
+	void	CompressImageFast( dxtFastFormat_t format, const byte *inBuf, byte *outBuf, int width, int height );
+
+	// fast compression with bands of block rows compressed in parallel on the job list, the output is
+	// identical to CompressImageFast, small images or a NULL job list are compressed serially
+	void	CompressImageFastParallel( dxtFastFormat_t format, const byte *inBuf, byte *outBuf, int width, int height, idParallelJobList *jobList );
+
+	// number of bytes in a compressed 4x4 block
+	static int	GetFastFormatBlockSize( dxtFastFormat_t format ) { return ( format == DXT_FAST_DXT1 || format == DXT_FAST_DXT1_ALPHA ) ? 8 : 16; }
+
 	// high quality DXT1 compression (no alpha), uses exhaustive search to find a line through color space and is very slow
 	void	CompressImageDXT1HQ( const byte *inBuf, byte *outBuf, int width, int height );
 	
@@ -65,6 +95,7 @@ public:
 	void	CompressImageDXT1Fast( const byte *inBuf, byte *outBuf, int width, int height );
 	void	CompressImageDXT1Fast_Generic( const byte *inBuf, byte *outBuf, int width, int height );
 	void	CompressImageDXT1Fast_SSE2( const byte *inBuf, byte *outBuf, int width, int height );
+	void	CompressImageDXT1Fast_AVX2( const byte *inBuf, byte *outBuf, int width, int height );
 
 	// high quality DXT1 compression (with alpha), uses exhaustive search to find a line through color space and is very slow
 	void	CompressImageDXT1AlphaHQ( const byte *inBuf, byte *outBuf, int width, int height ) { /* not implemented */ assert( 0 ); }
@@ -82,6 +113,7 @@ public:
 	void	CompressImageDXT5Fast( const byte *inBuf, byte *outBuf, int width, int height );
 	void	CompressImageDXT5Fast_Generic( const byte *inBuf, byte *outBuf, int width, int height );
 	void	CompressImageDXT5Fast_SSE2( const byte *inBuf, byte *outBuf, int width, int height );
+	void	CompressImageDXT5Fast_AVX2( const byte *inBuf, byte *outBuf, int width, int height );
 
 	// high quality CTX1 compression, uses exhaustive search to find a line through 2D space and is very slow
 	void	CompressImageCTX1HQ( const byte *inBuf, byte *outBuf, int width, int height );
@@ -240,6 +272,15 @@ private:
 	void				InsetYCoCgBBox_SSE2( byte *minColor, byte *maxColor ) const;
 	void				SelectYCoCgDiagonal_SSE2( const byte *colorBlock, byte *minColor, byte *maxColor ) const;
 
+	// The AVX2 versions work on two horizontally adjacent blocks at a time, with the rows of both blocks
+	// interleaved: each 32 byte row holds the first block in the low and the second block in the high half.
+	// The colors and indices of the two blocks are returned next to each other for the caller to emit.
+	void				ExtractBlocks_AVX2( const byte *inPtr, int width, int numBlocks, byte *colorBlocks ) const;
+	void				GetMinMaxBBox_AVX2( const byte *colorBlocks, byte *minColors, byte *maxColors ) const;
+	void				InsetColorsBBox_AVX2( byte *minColors, byte *maxColors ) const;
+	void				GetColorIndices_AVX2( const byte *colorBlocks, const byte *minColors, const byte *maxColors, unsigned int *colorIndices ) const;
+	void				GetAlphaIndices_AVX2( const byte *colorBlocks, const byte *minColors, const byte *maxColors, byte *alphaIndices ) const;
+
 
 
 	void				EmitNormalYIndices( const byte *normalBlock, const int offset, const byte minNormalY, const byte maxNormalY );
@@ -259,6 +300,10 @@ idDxtEncoder::CompressImageDXT1Fast
 */
 ID_INLINE void idDxtEncoder::CompressImageDXT1Fast( const byte *inBuf, byte *outBuf, int width, int height ) {
 #ifdef ID_WIN_X86_SSE2_INTRIN
+	if ( SIMDProcessor->cpuid & CPUID_AVX2 ) {
+		CompressImageDXT1Fast_AVX2( inBuf, outBuf, width, height );
+		return;
+	}
 	CompressImageDXT1Fast_SSE2( inBuf, outBuf, width, height );
 #else
 	CompressImageDXT1Fast_Generic( inBuf, outBuf, width, height );
@@ -285,6 +330,10 @@ idDxtEncoder::CompressImageDXT5Fast
 */
 ID_INLINE void idDxtEncoder::CompressImageDXT5Fast( const byte *inBuf, byte *outBuf, int width, int height ) {
 #ifdef ID_WIN_X86_SSE2_INTRIN
+	if ( SIMDProcessor->cpuid & CPUID_AVX2 ) {
+		CompressImageDXT5Fast_AVX2( inBuf, outBuf, width, height );
+		return;
+	}
 	CompressImageDXT5Fast_SSE2( inBuf, outBuf, width, height );
 #else
 	CompressImageDXT5Fast_Generic( inBuf, outBuf, width, height );
@@ -4746,3 +4746,303 @@ void idDxtEncoder::ConvertImageDXN1_DXT1( const byte *inBuf, byte *outBuf, int w
 		inBuf += srcPadding;
 	}
 }
+
+/*
+========================
+idDxtEncoder::CompressImageFast
+
+params:	format		- fast compressor to use
+params:	inBuf		- image to compress
+paramO:	outBuf		- result of compression
+params:	width		- width of image
+params:	height		- height of image
+========================
+*/
+void idDxtEncoder::CompressImageFast( dxtFastFormat_t format, const byte *inBuf, byte *outBuf, int width, int height ) {
+	switch( format ) {
+		case DXT_FAST_DXT1:			CompressImageDXT1Fast( inBuf, outBuf, width, height ); break;
+		case DXT_FAST_DXT1_ALPHA:	CompressImageDXT1AlphaFast( inBuf, outBuf, width, height ); break;
+		case DXT_FAST_DXT5:			CompressImageDXT5Fast( inBuf, outBuf, width, height ); break;
+		case DXT_FAST_YCOCG_DXT5:	CompressYCoCgDXT5Fast( inBuf, outBuf, width, height ); break;
+		case DXT_FAST_NORMAL_DXT5:	CompressNormalMapDXT5Fast( inBuf, outBuf, width, height ); break;
+		default:					assert( 0 ); break;
+	}
+}
+
+/*
+================================================
+dxtBandParms_t
+================================================
+*/
+struct dxtBandParms_t {
+	dxtFastFormat_t		format;
+	const byte *		inBuf;
+	byte *				outBuf;
+	int					width;
+	int					height;
+	int					srcPadding;
+	int					dstPadding;
+};
+
+/*
+========================
+DxtCompressBandJob
+
+The encoder keeps its output pointer in the class, so every band gets its own encoder.
+========================
+*/
+static void DxtCompressBandJob( dxtBandParms_t * parms ) {
+	idDxtEncoder dxt;
+	dxt.SetSrcPadding( parms->srcPadding );
+	dxt.SetDstPadding( parms->dstPadding );
+	dxt.CompressImageFast( parms->format, parms->inBuf, parms->outBuf, parms->width, parms->height );
+}
+
+REGISTER_PARALLEL_JOB( DxtCompressBandJob, "DxtCompressBandJob" );
+
+/*
+========================
+idDxtEncoder::CompressImageFastParallel
+
+Blocks only depend on their own 16 pixels, so splitting the image into bands of whole block
+rows gives exactly the same output as compressing the image in one go. The padding is applied
+per block row, so each band starts at a whole multiple of the padded row pitch.
+
+params:	format		- fast compressor to use
+params:	inBuf		- image to compress
+paramO:	outBuf		- result of compression
+params:	width		- width of image
+params:	height		- height of image
+params:	jobList		- job list with room for DXT_MAX_PARALLEL_BANDS jobs, or NULL
+========================
+*/
+void idDxtEncoder::CompressImageFastParallel( dxtFastFormat_t format, const byte *inBuf, byte *outBuf, int width, int height, idParallelJobList *jobList ) {
+	assert( width >= 4 && ( width & 3 ) == 0 );
+	assert( height >= 4 && ( height & 3 ) == 0 );
+
+	const int numBlockRows = height / 4;
+	int numBands = 0;
+	if ( jobList != NULL ) {
+		numBands = Max( 1, parallelJobManager->GetNumProcessingUnits() ) * 4;
+		numBands = Min( numBands, DXT_MAX_PARALLEL_BANDS );
+		numBands = Min( numBands, numBlockRows );
+		numBands = Min( numBands, width * height / DXT_MIN_PARALLEL_PIXELS );
+	}
+
+	if ( numBands <= 1 ) {
+		CompressImageFast( format, inBuf, outBuf, width, height );
+		return;
+	}
+
+	const int srcBlockRowPitch = width * 4 * 4 + srcPadding;
+	const int dstBlockRowPitch = ( width / 4 ) * GetFastFormatBlockSize( format ) + dstPadding;
+
+	dxtBandParms_t bands[DXT_MAX_PARALLEL_BANDS];
+	for ( int i = 0, blockRow = 0; i < numBands; i++ ) {
+		const int bandBlockRows = numBlockRows / numBands + ( i < numBlockRows % numBands );
+		dxtBandParms_t & band = bands[i];
+		band.format = format;
+		band.inBuf = inBuf + blockRow * srcBlockRowPitch;
+		band.outBuf = outBuf + blockRow * dstBlockRowPitch;
+		band.width = width;
+		band.height = bandBlockRows * 4;
+		band.srcPadding = srcPadding;
+		band.dstPadding = dstPadding;
+		blockRow += bandBlockRows;
+
+		jobList->AddJob( (jobRun_t)DxtCompressBandJob, &band );
+	}
+
+	jobList->Submit();
+	jobList->Wait();
+}
+
+/*
+========================
+testDxtCompression
+
+Compresses a synthetic image with every fast compressor, serially and in parallel
+bands, and checks that both produce the same blocks.
+========================
+*/
+CONSOLE_COMMAND( testDxtCompression, "measures fast DXT compression throughput with and without parallel bands, usage: testDxtCompression [size]", 0 ) {
+	const int size = ( args.Argc() > 1 ) ? idMath::ClampInt( 64, 8192, atoi( args.Argv( 1 ) ) ) & ~3 : 2048;
+	const int numRuns = 10;
+	const char * formatNames[DXT_FAST_MAX] = { "DXT1", "DXT1 alpha", "DXT5", "YCoCg DXT5", "normal DXT5" };
+
+	byte * image = (byte *)Mem_Alloc16( size * size * 4, TAG_TEMP );
+	byte * serialOut = (byte *)Mem_Alloc16( size * size, TAG_TEMP );
+	byte * parallelOut = (byte *)Mem_Alloc16( size * size, TAG_TEMP );
+
+	// smooth gradients with some noise so the blocks are not trivial
+	idRandom random( 0x0d7c0de );
+	for ( int y = 0; y < size; y++ ) {
+		for ( int x = 0; x < size; x++ ) {
+			byte * pixel = image + ( y * size + x ) * 4;
+			const int noise = random.RandomInt( 32 );
+			pixel[0] = (byte)( ( x * 255 / size + noise ) & 255 );
+			pixel[1] = (byte)( ( y * 255 / size + noise ) & 255 );
+			pixel[2] = (byte)( ( ( x ^ y ) + noise ) & 255 );
+			pixel[3] = (byte)( ( ( x + y ) * 255 / ( 2 * size ) + noise ) & 255 );
+		}
+	}
+
+	idParallelJobList * jobList = parallelJobManager->AllocJobList( JOBLIST_UTILITY, JOBLIST_PRIORITY_MEDIUM, DXT_MAX_PARALLEL_BANDS, 0, NULL );
+
+	common->Printf( "%dx%d image, %d runs, %d processing units\n", size, size, numRuns, parallelJobManager->GetNumProcessingUnits() );
+	common->Printf( "format           serial  parallel  (megapixels per second)\n" );
+
+	idDxtEncoder dxt;
+	const double megaPixels = (double)size * size * numRuns / 1000000.0;
+	for ( int format = 0; format < DXT_FAST_MAX; format++ ) {
+		const int outSize = size * size / 4 * idDxtEncoder::GetFastFormatBlockSize( (dxtFastFormat_t)format ) / 4;
+
+		uint64 start = Sys_Microseconds();
+		for ( int run = 0; run < numRuns; run++ ) {
+			dxt.CompressImageFast( (dxtFastFormat_t)format, image, serialOut, size, size );
+		}
+		const uint64 serialTime = Max( Sys_Microseconds() - start, (uint64)1 );
+
+		start = Sys_Microseconds();
+		for ( int run = 0; run < numRuns; run++ ) {
+			dxt.CompressImageFastParallel( (dxtFastFormat_t)format, image, parallelOut, size, size, jobList );
+		}
+		const uint64 parallelTime = Max( Sys_Microseconds() - start, (uint64)1 );
+
+		common->Printf( "%-12s %10.1f %9.1f%s\n", formatNames[format], megaPixels * 1000000.0 / serialTime, megaPixels * 1000000.0 / parallelTime,
+			memcmp( serialOut, parallelOut, outSize ) != 0 ? "  MISMATCH" : "" );
+	}
+
+	parallelJobManager->FreeJobList( jobList );
+
+	Mem_Free16( parallelOut );
+	Mem_Free16( serialOut );
+	Mem_Free16( image );
+}
+
+/*
+================================================
+dxtEncoderTest_t
+================================================
+*/
+typedef void ( idDxtEncoder::*dxtCompressFunc_t )( const byte *inBuf, byte *outBuf, int width, int height );
+
+struct dxtEncoderTest_t {
+	const char *		format;
+	const char *		tier;
+	cpuid_t				requiredCPU;
+	int					blockSize;
+	dxtCompressFunc_t	reference;
+	dxtCompressFunc_t	compress;
+};
+
+/*
+========================
+DxtTestPattern
+
+Fills an image with one of the golden test patterns.
+========================
+*/
+static void DxtTestPattern( byte * image, int width, int height, int pattern, idRandom & random ) {
+	for ( int y = 0; y < height; y++ ) {
+		for ( int x = 0; x < width; x++ ) {
+			byte * pixel = image + ( y * width + x ) * 4;
+			for ( int c = 0; c < 4; c++ ) {
+				int value;
+				switch( pattern ) {
+					case 0:		value = random.RandomInt( 256 ); break;											// noise
+					case 1:		value = ( x * 255 / width + c * 64 ) & 255; break;								// horizontal ramps
+					case 2:		value = ( ( y * 255 / height ) ^ ( c * 85 ) ) & 255; break;						// vertical ramps
+					case 3:		value = ( ( ( x >> 1 ) + ( y >> 1 ) ) & 1 ) ? 255 : 0; break;					// checkerboard within the blocks
+					case 4:		value = 128 + c; break;															// constant
+					case 5:		value = random.RandomInt( 2 ) ? 255 : 0; break;									// extremes
+					default:	value = ( ( x * y + c * 37 ) + random.RandomInt( 16 ) ) & 255; break;			// noisy gradients
+				}
+				pixel[c] = (byte)value;
+			}
+		}
+	}
+}
+
+/*
+========================
+testDxtEncoders
+
+Compresses a set of synthetic images with the generic encoder and every SIMD tier the CPU
+supports, and checks that all tiers produce exactly the same blocks as the generic encoder.
+The SSE2 DXT1 with alpha encoder is not bit exact with the generic one, so it is not tested.
+========================
+*/
+CONSOLE_COMMAND( testDxtEncoders, "checks that the SIMD DXT encoders produce the same blocks as the generic encoder", 0 ) {
+	static const int NUM_PATTERNS = 7;
+	static const int sizes[][2] = { { 4, 4 }, { 8, 4 }, { 12, 8 }, { 20, 12 }, { 64, 64 }, { 256, 128 }, { 1024, 1024 } };
+
+	const dxtEncoderTest_t tests[] = {
+#ifdef ID_WIN_X86_SSE2_INTRIN
+		{ "DXT1",			"SSE2",	CPUID_SSE2,	8,	&idDxtEncoder::CompressImageDXT1Fast_Generic,		&idDxtEncoder::CompressImageDXT1Fast_SSE2 },
+		{ "DXT1",			"AVX2",	CPUID_AVX2,	8,	&idDxtEncoder::CompressImageDXT1Fast_Generic,		&idDxtEncoder::CompressImageDXT1Fast_AVX2 },
+		{ "DXT5",			"SSE2",	CPUID_SSE2,	16,	&idDxtEncoder::CompressImageDXT5Fast_Generic,		&idDxtEncoder::CompressImageDXT5Fast_SSE2 },
+		{ "DXT5",			"AVX2",	CPUID_AVX2,	16,	&idDxtEncoder::CompressImageDXT5Fast_Generic,		&idDxtEncoder::CompressImageDXT5Fast_AVX2 },
+		{ "YCoCg DXT5",		"SSE2",	CPUID_SSE2,	16,	&idDxtEncoder::CompressYCoCgDXT5Fast_Generic,		&idDxtEncoder::CompressYCoCgDXT5Fast_SSE2 },
+		{ "normal DXT5",	"SSE2",	CPUID_SSE2,	16,	&idDxtEncoder::CompressNormalMapDXT5Fast_Generic,	&idDxtEncoder::CompressNormalMapDXT5Fast_SSE2 },
+#endif
+		{ NULL, NULL, CPUID_NONE, 0, NULL, NULL }
+	};
+
+	const int numSizes = sizeof( sizes ) / sizeof( sizes[0] );
+	const int maxSize = sizes[numSizes - 1][0];
+	const cpuid_t cpuid = idLib::sys->GetProcessorId();
+
+	byte * image = (byte *)Mem_Alloc16( maxSize * maxSize * 4, TAG_TEMP );
+	byte * golden = (byte *)Mem_Alloc16( maxSize * maxSize, TAG_TEMP );
+	byte * output = (byte *)Mem_Alloc16( maxSize * maxSize, TAG_TEMP );
+
+	int numPassed = 0;
+	int numFailed = 0;
+	for ( int t = 0; tests[t].format != NULL; t++ ) {
+		const dxtEncoderTest_t & test = tests[t];
+		if ( ( cpuid & test.requiredCPU ) == 0 ) {
+			common->Printf( "%-12s %s: not supported by this CPU\n", test.format, test.tier );
+			continue;
+		}
+
+		int numMismatches = 0;
+		for ( int pattern = 0; pattern < NUM_PATTERNS; pattern++ ) {
+			for ( int s = 0; s < numSizes; s++ ) {
+				const int width = sizes[s][0];
+				const int height = sizes[s][1];
+				const int numBlocks = ( width / 4 ) * ( height / 4 );
+
+				idRandom random( pattern * 1000 + s );
+				DxtTestPattern( image, width, height, pattern, random );
+
+				idDxtEncoder dxt;
+				( dxt.*test.reference )( image, golden, width, height );
+				( dxt.*test.compress )( image, output, width, height );
+
+				for ( int b = 0; b < numBlocks; b++ ) {
+					if ( memcmp( golden + b * test.blockSize, output + b * test.blockSize, test.blockSize ) != 0 ) {
+						if ( numMismatches == 0 ) {
+							common->Printf( "%-12s %s: first mismatch in pattern %d, %dx%d, block %d\n", test.format, test.tier, pattern, width, height, b );
+						}
+						numMismatches++;
+					}
+				}
+			}
+		}
+
+		if ( numMismatches != 0 ) {
+			common->Printf( "%-12s %s: FAILED, %d blocks differ\n", test.format, test.tier, numMismatches );
+			numFailed++;
+		} else {
+			common->Printf( "%-12s %s: ok\n", test.format, test.tier );
+			numPassed++;
+		}
+	}
+
+	common->Printf( "%d passed, %d failed\n", numPassed, numFailed );
+
+	Mem_Free16( output );
+	Mem_Free16( golden );
+	Mem_Free16( image );
+}
@@ -0,0 +1,564 @@
+/*
+===========================================================================
+
+Doom 3 BFG Edition GPL Source Code
+Copyright (C) 1993-2012 id Software LLC, a ZeniMax Media company. 
+
+This file is part of the Doom 3 BFG Edition GPL Source Code ("Doom 3 BFG Edition Source Code").  
+
+Doom 3 BFG Edition Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 BFG Edition Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 BFG Edition Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 BFG Edition Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 BFG Edition Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+/*
+================================================================================================
+Contains the DxtEncoder implementation for AVX2.
+
+The AVX2 versions compress two horizontally adjacent 4x4 blocks at a time. Each 32 byte row of
+the extracted blocks holds a row of the first block in the low 16 bytes and the same row of the
+second block in the high 16 bytes, so every step of the SSE2 versions runs unchanged in both
+128-bit lanes. The result is identical to the SSE2 and generic encoders.
+This file is compiled as SSE code, so the helpers call _mm256_zeroupper before they go
+on with 128-bit code or return, like Simd_AVX2.cpp.
+================================================================================================
+*/
+#pragma hdrstop
+#include "DXTCodec_local.h"
+#include "DXTCodec.h"
+
+#if defined( ID_WIN_X86_SSE2_INTRIN )
+
+#include <immintrin.h>
+
+#define INSET_COLOR_SHIFT		4		// inset the bounding box with ( range >> shift )
+#define INSET_ALPHA_SHIFT		5		// inset alpha channel
+
+#define C565_5_MASK				0xF8	// 0xFF minus last three bits
+#define C565_6_MASK				0xFC	// 0xFF minus last two bits
+
+#if !defined( R_SHUFFLE_D )
+#define R_SHUFFLE_D( x, y, z, w )	(( (w) & 3 ) << 6 | ( (z) & 3 ) << 4 | ( (y) & 3 ) << 2 | ( (x) & 3 ))
+#endif
+
+// one 32-bit value in the low dword of each lane
+#define _mm256_setlanes_epi32( lo, hi )		_mm256_setr_epi32( lo, 0, 0, 0, hi, 0, 0, 0 )
+
+/*
+========================
+idDxtEncoder::ExtractBlocks_AVX2
+
+params:	inPtr		- input image, 4 bytes per pixel
+params:	numBlocks	- 2 to extract two adjacent blocks, 1 to extract a single block into both halves
+paramO:	colorBlocks	- 2 interleaved 4*4 output tiles, 4 bytes per pixel
+========================
+*/
+ID_INLINE void idDxtEncoder::ExtractBlocks_AVX2( const byte * inPtr, int width, int numBlocks, byte * colorBlocks ) const {
+	if ( numBlocks == 2 ) {
+		_mm256_storeu_si256( (__m256i *)( colorBlocks +  0 ), _mm256_loadu_si256( (const __m256i *)( inPtr + width * 4 * 0 ) ) );
+		_mm256_storeu_si256( (__m256i *)( colorBlocks + 32 ), _mm256_loadu_si256( (const __m256i *)( inPtr + width * 4 * 1 ) ) );
+		_mm256_storeu_si256( (__m256i *)( colorBlocks + 64 ), _mm256_loadu_si256( (const __m256i *)( inPtr + width * 4 * 2 ) ) );
+		_mm256_storeu_si256( (__m256i *)( colorBlocks + 96 ), _mm256_loadu_si256( (const __m256i *)( inPtr + width * 4 * 3 ) ) );
+	} else {
+		// the last block of a row, don't read past the end of the image
+		_mm256_storeu_si256( (__m256i *)( colorBlocks +  0 ), _mm256_broadcastsi128_si256( _mm_loadu_si128( (const __m128i *)( inPtr + width * 4 * 0 ) ) ) );
+		_mm256_storeu_si256( (__m256i *)( colorBlocks + 32 ), _mm256_broadcastsi128_si256( _mm_loadu_si128( (const __m128i *)( inPtr + width * 4 * 1 ) ) ) );
+		_mm256_storeu_si256( (__m256i *)( colorBlocks + 64 ), _mm256_broadcastsi128_si256( _mm_loadu_si128( (const __m128i *)( inPtr + width * 4 * 2 ) ) ) );
+		_mm256_storeu_si256( (__m256i *)( colorBlocks + 96 ), _mm256_broadcastsi128_si256( _mm_loadu_si128( (const __m128i *)( inPtr + width * 4 * 3 ) ) ) );
+	}
+}
+
+/*
+========================
+idDxtEncoder::GetMinMaxBBox_AVX2
+
+Takes the extents of the bounding boxes of the colors in both 4x4 blocks.
+
+params:	colorBlocks	- 2 interleaved 4*4 input tiles, 4 bytes per pixel
+paramO:	minColors	- Min 4 byte output color of each block
+paramO:	maxColors	- Max 4 byte output color of each block
+========================
+*/
+ID_INLINE void idDxtEncoder::GetMinMaxBBox_AVX2( const byte * colorBlocks, byte * minColors, byte * maxColors ) const {
+	__m256i block0 = _mm256_loadu_si256( (const __m256i *)( colorBlocks +  0 ) );
+	__m256i block1 = _mm256_loadu_si256( (const __m256i *)( colorBlocks + 32 ) );
+	__m256i block2 = _mm256_loadu_si256( (const __m256i *)( colorBlocks + 64 ) );
+	__m256i block3 = _mm256_loadu_si256( (const __m256i *)( colorBlocks + 96 ) );
+
+	__m256i max1 = _mm256_max_epu8( block0, block1 );
+	__m256i min1 = _mm256_min_epu8( block0, block1 );
+	__m256i max2 = _mm256_max_epu8( block2, block3 );
+	__m256i min2 = _mm256_min_epu8( block2, block3 );
+
+	__m256i max3 = _mm256_max_epu8( max1, max2 );
+	__m256i min3 = _mm256_min_epu8( min1, min2 );
+
+	__m256i max4 = _mm256_shuffle_epi32( max3, R_SHUFFLE_D( 2, 3, 2, 3 ) );
+	__m256i min4 = _mm256_shuffle_epi32( min3, R_SHUFFLE_D( 2, 3, 2, 3 ) );
+
+	__m256i max5 = _mm256_max_epu8( max3, max4 );
+	__m256i min5 = _mm256_min_epu8( min3, min4 );
+
+	__m256i max6 = _mm256_shufflelo_epi16( max5, R_SHUFFLE_D( 2, 3, 2, 3 ) );
+	__m256i min6 = _mm256_shufflelo_epi16( min5, R_SHUFFLE_D( 2, 3, 2, 3 ) );
+
+	max6 = _mm256_max_epu8( max5, max6 );
+	min6 = _mm256_min_epu8( min5, min6 );
+
+	__m128i maxLo = _mm256_castsi256_si128( max6 );
+	__m128i maxHi = _mm256_extracti128_si256( max6, 1 );
+	__m128i minLo = _mm256_castsi256_si128( min6 );
+	__m128i minHi = _mm256_extracti128_si256( min6, 1 );
+
+	_mm256_zeroupper();
+
+	((int *)maxColors)[0] = _mm_cvtsi128_si32( maxLo );
+	((int *)maxColors)[1] = _mm_cvtsi128_si32( maxHi );
+	((int *)minColors)[0] = _mm_cvtsi128_si32( minLo );
+	((int *)minColors)[1] = _mm_cvtsi128_si32( minHi );
+}
+
+/*
+========================
+idDxtEncoder::InsetColorsBBox_AVX2
+
+Both bounding boxes fit in a single 128-bit register as words.
+========================
+*/
+ID_INLINE void idDxtEncoder::InsetColorsBBox_AVX2( byte * minColors, byte * maxColors ) const {
+	const __m128i insetShift = _mm_setr_epi16( 1 << ( 16 - INSET_COLOR_SHIFT ), 1 << ( 16 - INSET_COLOR_SHIFT ), 1 << ( 16 - INSET_COLOR_SHIFT ), 1 << ( 16 - INSET_ALPHA_SHIFT ),
+												1 << ( 16 - INSET_COLOR_SHIFT ), 1 << ( 16 - INSET_COLOR_SHIFT ), 1 << ( 16 - INSET_COLOR_SHIFT ), 1 << ( 16 - INSET_ALPHA_SHIFT ) );
+	const __m128i zero = _mm_setzero_si128();
+
+	__m128i xmm0 = _mm_unpacklo_epi8( _mm_loadl_epi64( (const __m128i *)minColors ), zero );
+	__m128i xmm1 = _mm_unpacklo_epi8( _mm_loadl_epi64( (const __m128i *)maxColors ), zero );
+
+	__m128i xmm2 = _mm_sub_epi16( xmm1, xmm0 );
+
+	xmm2 = _mm_mulhi_epi16( xmm2, insetShift );
+
+	xmm0 = _mm_add_epi16( xmm0, xmm2 );
+	xmm1 = _mm_sub_epi16( xmm1, xmm2 );
+
+	xmm0 = _mm_packus_epi16( xmm0, xmm0 );
+	xmm1 = _mm_packus_epi16( xmm1, xmm1 );
+
+	_mm_storel_epi64( (__m128i *)minColors, xmm0 );
+	_mm_storel_epi64( (__m128i *)maxColors, xmm1 );
+}
+
+/*
+========================
+idDxtEncoder::GetColorIndices_AVX2
+
+params:	colorBlocks		- 2 interleaved 16 pixel blocks for which to find color indices
+params:	minColors		- Min color of each block
+params:	maxColors		- Max color of each block
+paramO:	colorIndices	- 4 byte color index block for each block
+========================
+*/
+ID_INLINE void idDxtEncoder::GetColorIndices_AVX2( const byte * colorBlocks, const byte * minColors, const byte * maxColors, unsigned int * colorIndices ) const {
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i colorMask = _mm256_setr_epi8( (char)C565_5_MASK, (char)C565_6_MASK, (char)C565_5_MASK, 0, 0, 0, 0, 0, (char)C565_5_MASK, (char)C565_6_MASK, (char)C565_5_MASK, 0, 0, 0, 0, 0,
+												(char)C565_5_MASK, (char)C565_6_MASK, (char)C565_5_MASK, 0, 0, 0, 0, 0, (char)C565_5_MASK, (char)C565_6_MASK, (char)C565_5_MASK, 0, 0, 0, 0, 0 );
+	const __m256i divBy3 = _mm256_set1_epi16( (1<<16)/3+1 );
+	const __m256i word1 = _mm256_set1_epi16( 1 );
+	const __m256i word2 = _mm256_set1_epi16( 2 );
+
+	__m256i result = zero;
+	__m256i color0, color1, color2, color3;
+	__m256i temp0, temp1, temp2, temp3, temp4, temp5, temp6, temp7;
+	__m256i minColor = _mm256_setlanes_epi32( ((const int *)minColors)[0], ((const int *)minColors)[1] );
+	__m256i maxColor = _mm256_setlanes_epi32( ((const int *)maxColors)[0], ((const int *)maxColors)[1] );
+	__m256i blocka[2], blockb[2];
+	blocka[0] = _mm256_loadu_si256( (const __m256i *)( colorBlocks +  0 ) );
+	blocka[1] = _mm256_loadu_si256( (const __m256i *)( colorBlocks + 64 ) );
+	blockb[0] = _mm256_loadu_si256( (const __m256i *)( colorBlocks + 32 ) );
+	blockb[1] = _mm256_loadu_si256( (const __m256i *)( colorBlocks + 96 ) );
+
+	temp0 = _mm256_and_si256( maxColor, colorMask );
+	temp0 = _mm256_unpacklo_epi8( temp0, zero );
+	temp4 = _mm256_shufflelo_epi16( temp0, R_SHUFFLE_D( 0, 3, 2, 3 ) );
+	temp5 = _mm256_shufflelo_epi16( temp0, R_SHUFFLE_D( 3, 1, 3, 3 ) );
+	temp4 = _mm256_srli_epi16( temp4, 5 );
+	temp5 = _mm256_srli_epi16( temp5, 6 );
+	temp0 = _mm256_or_si256( temp0, temp4 );
+	temp0 = _mm256_or_si256( temp0, temp5 );
+
+	temp1 = _mm256_and_si256( minColor, colorMask );
+	temp1 = _mm256_unpacklo_epi8( temp1, zero );
+	temp4 = _mm256_shufflelo_epi16( temp1, R_SHUFFLE_D( 0, 3, 2, 3 ) );
+	temp5 = _mm256_shufflelo_epi16( temp1, R_SHUFFLE_D( 3, 1, 3, 3 ) );
+	temp4 = _mm256_srli_epi16( temp4, 5 );
+	temp5 = _mm256_srli_epi16( temp5, 6 );
+	temp1 = _mm256_or_si256( temp1, temp4 );
+	temp1 = _mm256_or_si256( temp1, temp5 );
+
+	temp2 = _mm256_packus_epi16( temp0, zero );
+	color0 = _mm256_shuffle_epi32( temp2, R_SHUFFLE_D( 0, 1, 0, 1 ) );
+
+	temp6 = _mm256_add_epi16( temp0, temp0 );
+	temp6 = _mm256_add_epi16( temp6, temp1 );
+	temp6 = _mm256_mulhi_epi16( temp6, divBy3 );		// * ( ( 1 << 16 ) / 3 + 1 ) ) >> 16
+	temp6 = _mm256_packus_epi16( temp6, zero );
+	color2 = _mm256_shuffle_epi32( temp6, R_SHUFFLE_D( 0, 1, 0, 1 ) );
+
+	temp3 = _mm256_packus_epi16( temp1, zero );
+	color1 = _mm256_shuffle_epi32( temp3, R_SHUFFLE_D( 0, 1, 0, 1 ) );
+
+	temp1 = _mm256_add_epi16( temp1, temp1 );
+	temp0 = _mm256_add_epi16( temp0, temp1 );
+	temp0 = _mm256_mulhi_epi16( temp0, divBy3 );		// * ( ( 1 << 16 ) / 3 + 1 ) ) >> 16
+	temp0 = _mm256_packus_epi16( temp0, zero );
+	color3 = _mm256_shuffle_epi32( temp0, R_SHUFFLE_D( 0, 1, 0, 1 ) );
+
+	for ( int i = 1; i >= 0; i-- ) {
+		// Load block
+		temp3 = _mm256_shuffle_epi32( blocka[i], R_SHUFFLE_D( 0, 2, 1, 3 ) );
+		temp5 = _mm256_castps_si256( _mm256_shuffle_ps( _mm256_castsi256_ps( blocka[i] ), _mm256_castsi256_ps( zero ), R_SHUFFLE_D( 2, 3, 0, 1 ) ) );
+		temp5 = _mm256_shuffle_epi32( temp5, R_SHUFFLE_D( 0, 2, 1, 3 ) );
+
+		temp0 = _mm256_sad_epu8( temp3, color0 );
+		temp6 = _mm256_sad_epu8( temp5, color0 );
+		temp0 = _mm256_packs_epi32( temp0, temp6 );
+
+		temp1 = _mm256_sad_epu8( temp3, color1 );
+		temp6 = _mm256_sad_epu8( temp5, color1 );
+		temp1 = _mm256_packs_epi32( temp1, temp6 );
+
+		temp2 = _mm256_sad_epu8( temp3, color2 );
+		temp6 = _mm256_sad_epu8( temp5, color2 );
+		temp2 = _mm256_packs_epi32( temp2, temp6 );
+
+		temp3 = _mm256_sad_epu8( temp3, color3 );
+		temp5 = _mm256_sad_epu8( temp5, color3 );
+		temp3 = _mm256_packs_epi32( temp3, temp5 );
+
+		// Load block
+		temp4 = _mm256_shuffle_epi32( blockb[i], R_SHUFFLE_D( 0, 2, 1, 3 ) );
+		temp5 = _mm256_castps_si256( _mm256_shuffle_ps( _mm256_castsi256_ps( blockb[i] ), _mm256_castsi256_ps( zero ), R_SHUFFLE_D( 2, 3, 0, 1 ) ) );
+		temp5 = _mm256_shuffle_epi32( temp5, R_SHUFFLE_D( 0, 2, 1, 3 ) );
+
+		temp6 = _mm256_sad_epu8( temp4, color0 );
+		temp7 = _mm256_sad_epu8( temp5, color0 );
+		temp6 = _mm256_packs_epi32( temp6, temp7 );
+		temp0 = _mm256_packs_epi32( temp0, temp6 );	// d0
+
+		temp6 = _mm256_sad_epu8( temp4, color1 );
+		temp7 = _mm256_sad_epu8( temp5, color1 );
+		temp6 = _mm256_packs_epi32( temp6, temp7 );
+		temp1 = _mm256_packs_epi32( temp1, temp6 );	// d1
+
+		temp6 = _mm256_sad_epu8( temp4, color2 );
+		temp7 = _mm256_sad_epu8( temp5, color2 );
+		temp6 = _mm256_packs_epi32( temp6, temp7 );
+		temp2 = _mm256_packs_epi32( temp2, temp6 );	// d2
+
+		temp4 = _mm256_sad_epu8( temp4, color3 );
+		temp5 = _mm256_sad_epu8( temp5, color3 );
+		temp4 = _mm256_packs_epi32( temp4, temp5 );
+		temp3 = _mm256_packs_epi32( temp3, temp4 );	// d3
+
+		temp7 = _mm256_slli_epi32( result, 16 );
+
+		temp4 = _mm256_cmpgt_epi16( temp0, temp2 );	// b2
+		temp5 = _mm256_cmpgt_epi16( temp1, temp3 );	// b3
+		temp0 = _mm256_cmpgt_epi16( temp0, temp3 );	// b0
+		temp1 = _mm256_cmpgt_epi16( temp1, temp2 );	// b1
+		temp2 = _mm256_cmpgt_epi16( temp2, temp3 );	// b4
+
+		temp4 = _mm256_and_si256( temp4, temp1 );		// x0
+		temp5 = _mm256_and_si256( temp5, temp0 );		// x1
+		temp2 = _mm256_and_si256( temp2, temp0 );		// x2
+		temp4 = _mm256_or_si256( temp4, temp5 );
+		temp2 = _mm256_and_si256( temp2, word1 );
+		temp4 = _mm256_and_si256( temp4, word2 );
+		temp2 = _mm256_or_si256( temp2, temp4 );
+
+		temp5 = _mm256_shuffle_epi32( temp2, R_SHUFFLE_D( 2, 3, 0, 1 ) );
+		temp2 = _mm256_unpacklo_epi16( temp2, zero );
+		temp5 = _mm256_unpacklo_epi16( temp5, zero );
+		temp5 = _mm256_slli_epi32( temp5, 8 );
+		temp7 = _mm256_or_si256( temp7, temp5 );
+		result = _mm256_or_si256( temp7, temp2 );
+	}
+
+	temp4 = _mm256_shuffle_epi32( result, R_SHUFFLE_D( 1, 2, 3, 0 ) );
+	temp5 = _mm256_shuffle_epi32( result, R_SHUFFLE_D( 2, 3, 0, 1 ) );
+	temp6 = _mm256_shuffle_epi32( result, R_SHUFFLE_D( 3, 0, 1, 2 ) );
+	temp4 = _mm256_slli_epi32( temp4, 2 );
+	temp5 = _mm256_slli_epi32( temp5, 4 );
+	temp6 = _mm256_slli_epi32( temp6, 6 );
+	temp7 = _mm256_or_si256( result, temp4 );
+	temp7 = _mm256_or_si256( temp7, temp5 );
+	temp7 = _mm256_or_si256( temp7, temp6 );
+
+	__m128i indicesLo = _mm256_castsi256_si128( temp7 );
+	__m128i indicesHi = _mm256_extracti128_si256( temp7, 1 );
+
+	_mm256_zeroupper();
+
+	colorIndices[0] = _mm_cvtsi128_si32( indicesLo );
+	colorIndices[1] = _mm_cvtsi128_si32( indicesHi );
+}
+
+/*
+========================
+idDxtEncoder::GetAlphaIndices_AVX2
+
+params:	colorBlocks		- 2 interleaved 16 pixel blocks for which to find alpha indices
+params:	minColors		- Min color of each block, the alpha is used
+params:	maxColors		- Max color of each block, the alpha is used
+paramO:	alphaIndices	- 6 byte alpha index block for each block, 8 bytes apart
+========================
+*/
+ID_INLINE void idDxtEncoder::GetAlphaIndices_AVX2( const byte * colorBlocks, const byte * minColors, const byte * maxColors, byte * alphaIndices ) const {
+	__m256i block0 = _mm256_loadu_si256( (const __m256i *)( colorBlocks +  0 ) );
+	__m256i block1 = _mm256_loadu_si256( (const __m256i *)( colorBlocks + 32 ) );
+	__m256i block2 = _mm256_loadu_si256( (const __m256i *)( colorBlocks + 64 ) );
+	__m256i block3 = _mm256_loadu_si256( (const __m256i *)( colorBlocks + 96 ) );
+	__m256i temp0, temp1, temp2, temp3, temp4, temp5, temp6, temp7;
+
+	temp0 = _mm256_srli_epi32( block0, 24 );
+	temp5 = _mm256_srli_epi32( block1, 24 );
+	temp6 = _mm256_srli_epi32( block2, 24 );
+	temp4 = _mm256_srli_epi32( block3, 24 );
+
+	temp0 = _mm256_packus_epi16( temp0, temp5 );
+	temp6 = _mm256_packus_epi16( temp6, temp4 );
+
+	//---------------------
+
+	// ab0 = (  7 * maxAlpha +  7 * minAlpha + ALPHA_RANGE ) / 14
+	// ab3 = (  9 * maxAlpha +  5 * minAlpha + ALPHA_RANGE ) / 14
+	// ab2 = ( 11 * maxAlpha +  3 * minAlpha + ALPHA_RANGE ) / 14
+	// ab1 = ( 13 * maxAlpha +  1 * minAlpha + ALPHA_RANGE ) / 14
+
+	// ab4 = (  7 * maxAlpha +  7 * minAlpha + ALPHA_RANGE ) / 14
+	// ab5 = (  5 * maxAlpha +  9 * minAlpha + ALPHA_RANGE ) / 14
+	// ab6 = (  3 * maxAlpha + 11 * minAlpha + ALPHA_RANGE ) / 14
+	// ab7 = (  1 * maxAlpha + 13 * minAlpha + ALPHA_RANGE ) / 14
+
+	const __m256i scale_7_5_3_1 = _mm256_setr_epi16( 7, 7, 5, 5, 3, 3, 1, 1, 7, 7, 5, 5, 3, 3, 1, 1 );
+	const __m256i scale_7_9_11_13 = _mm256_setr_epi16( 7, 7, 9, 9, 11, 11, 13, 13, 7, 7, 9, 9, 11, 11, 13, 13 );
+
+	temp5 = _mm256_inserti128_si256( _mm256_castsi128_si256( _mm_set1_epi16( maxColors[3] ) ), _mm_set1_epi16( maxColors[7] ), 1 );
+	temp2 = _mm256_inserti128_si256( _mm256_castsi128_si256( _mm_set1_epi16( minColors[3] ) ), _mm_set1_epi16( minColors[7] ), 1 );
+
+	temp7 = _mm256_mullo_epi16( temp5, scale_7_5_3_1 );
+	temp5 = _mm256_mullo_epi16( temp5, scale_7_9_11_13 );
+	temp3 = _mm256_mullo_epi16( temp2, scale_7_9_11_13 );
+	temp2 = _mm256_mullo_epi16( temp2, scale_7_5_3_1 );
+
+	temp5 = _mm256_add_epi16( temp5, temp2 );
+	temp7 = _mm256_add_epi16( temp7, temp3 );
+
+	temp5 = _mm256_add_epi16( temp5, _mm256_set1_epi16( 7 ) );
+	temp7 = _mm256_add_epi16( temp7, _mm256_set1_epi16( 7 ) );
+
+	temp5 = _mm256_mulhi_epi16( temp5, _mm256_set1_epi16( (1<<16)/14+1 ) );
+	temp7 = _mm256_mulhi_epi16( temp7, _mm256_set1_epi16( (1<<16)/14+1 ) );
+
+	temp1 = _mm256_shuffle_epi32( temp5, R_SHUFFLE_D( 3, 3, 3, 3 ) );
+	temp2 = _mm256_shuffle_epi32( temp5, R_SHUFFLE_D( 2, 2, 2, 2 ) );
+	temp3 = _mm256_shuffle_epi32( temp5, R_SHUFFLE_D( 1, 1, 1, 1 ) );
+	temp1 = _mm256_packus_epi16( temp1, temp1 );
+	temp2 = _mm256_packus_epi16( temp2, temp2 );
+	temp3 = _mm256_packus_epi16( temp3, temp3 );
+
+	temp0 = _mm256_packus_epi16( temp0, temp6 );
+
+	temp4 = _mm256_shuffle_epi32( temp7, R_SHUFFLE_D( 0, 0, 0, 0 ) );
+	temp5 = _mm256_shuffle_epi32( temp7, R_SHUFFLE_D( 1, 1, 1, 1 ) );
+	temp6 = _mm256_shuffle_epi32( temp7, R_SHUFFLE_D( 2, 2, 2, 2 ) );
+	temp7 = _mm256_shuffle_epi32( temp7, R_SHUFFLE_D( 3, 3, 3, 3 ) );
+	temp4 = _mm256_packus_epi16( temp4, temp4 );
+	temp5 = _mm256_packus_epi16( temp5, temp5 );
+	temp6 = _mm256_packus_epi16( temp6, temp6 );
+	temp7 = _mm256_packus_epi16( temp7, temp7 );
+
+	temp1 = _mm256_max_epu8( temp1, temp0 );
+	temp2 = _mm256_max_epu8( temp2, temp0 );
+	temp3 = _mm256_max_epu8( temp3, temp0 );
+	temp1 = _mm256_cmpeq_epi8( temp1, temp0 );
+	temp2 = _mm256_cmpeq_epi8( temp2, temp0 );
+	temp3 = _mm256_cmpeq_epi8( temp3, temp0 );
+	temp4 = _mm256_max_epu8( temp4, temp0 );
+	temp5 = _mm256_max_epu8( temp5, temp0 );
+	temp6 = _mm256_max_epu8( temp6, temp0 );
+	temp7 = _mm256_max_epu8( temp7, temp0 );
+	temp4 = _mm256_cmpeq_epi8( temp4, temp0 );
+	temp5 = _mm256_cmpeq_epi8( temp5, temp0 );
+	temp6 = _mm256_cmpeq_epi8( temp6, temp0 );
+	temp7 = _mm256_cmpeq_epi8( temp7, temp0 );
+	temp0 = _mm256_adds_epi8( _mm256_set1_epi8( 8 ), temp1 );
+	temp2 = _mm256_adds_epi8( temp2, temp3 );
+	temp4 = _mm256_adds_epi8( temp4, temp5 );
+	temp6 = _mm256_adds_epi8( temp6, temp7 );
+	temp0 = _mm256_adds_epi8( temp0, temp2 );
+	temp4 = _mm256_adds_epi8( temp4, temp6 );
+	temp0 = _mm256_adds_epi8( temp0, temp4 );
+	temp0 = _mm256_and_si256( temp0, _mm256_set1_epi8( 7 ) );
+	temp1 = _mm256_cmpgt_epi8( _mm256_set1_epi8( 2 ), temp0 );
+	temp1 = _mm256_and_si256( temp1, _mm256_set1_epi8( 1 ) );
+	temp0 = _mm256_xor_si256( temp0, temp1 );
+
+	temp1 = _mm256_srli_epi64( temp0,  8 -  3 );
+	temp2 = _mm256_srli_epi64( temp0, 16 -  6 );
+	temp3 = _mm256_srli_epi64( temp0, 24 -  9 );
+	temp4 = _mm256_srli_epi64( temp0, 32 - 12 );
+	temp5 = _mm256_srli_epi64( temp0, 40 - 15 );
+	temp6 = _mm256_srli_epi64( temp0, 48 - 18 );
+	temp7 = _mm256_srli_epi64( temp0, 56 - 21 );
+	temp0 = _mm256_and_si256( temp0, _mm256_setr_epi32( 7<<0, 0, 7<<0, 0, 7<<0, 0, 7<<0, 0 ) );
+	temp1 = _mm256_and_si256( temp1, _mm256_setr_epi32( 7<<3, 0, 7<<3, 0, 7<<3, 0, 7<<3, 0 ) );
+	temp2 = _mm256_and_si256( temp2, _mm256_setr_epi32( 7<<6, 0, 7<<6, 0, 7<<6, 0, 7<<6, 0 ) );
+	temp3 = _mm256_and_si256( temp3, _mm256_setr_epi32( 7<<9, 0, 7<<9, 0, 7<<9, 0, 7<<9, 0 ) );
+	temp4 = _mm256_and_si256( temp4, _mm256_setr_epi32( 7<<12, 0, 7<<12, 0, 7<<12, 0, 7<<12, 0 ) );
+	temp5 = _mm256_and_si256( temp5, _mm256_setr_epi32( 7<<15, 0, 7<<15, 0, 7<<15, 0, 7<<15, 0 ) );
+	temp6 = _mm256_and_si256( temp6, _mm256_setr_epi32( 7<<18, 0, 7<<18, 0, 7<<18, 0, 7<<18, 0 ) );
+	temp7 = _mm256_and_si256( temp7, _mm256_setr_epi32( 7<<21, 0, 7<<21, 0, 7<<21, 0, 7<<21, 0 ) );
+	temp0 = _mm256_or_si256( temp0, temp1 );
+	temp2 = _mm256_or_si256( temp2, temp3 );
+	temp4 = _mm256_or_si256( temp4, temp5 );
+	temp6 = _mm256_or_si256( temp6, temp7 );
+	temp0 = _mm256_or_si256( temp0, temp2 );
+	temp4 = _mm256_or_si256( temp4, temp6 );
+	temp0 = _mm256_or_si256( temp0, temp4 );
+
+	__m128i lanes[2];
+	lanes[0] = _mm256_castsi256_si128( temp0 );
+	lanes[1] = _mm256_extracti128_si256( temp0, 1 );
+
+	_mm256_zeroupper();
+
+	// the indices of each block are in the low 24 bits of the first and third dword of its lane
+	for ( int k = 0; k < 2; k++ ) {
+		__m128i lane = lanes[k];
+		unsigned int bits0 = _mm_cvtsi128_si32( lane );
+		unsigned int bits1 = _mm_cvtsi128_si32( _mm_shuffle_epi32( lane, R_SHUFFLE_D( 2, 3, 0, 1 ) ) );
+		byte * out = alphaIndices + k * 8;
+		out[0] = (byte)( bits0 >>  0 );
+		out[1] = (byte)( bits0 >>  8 );
+		out[2] = (byte)( bits0 >> 16 );
+		out[3] = (byte)( bits1 >>  0 );
+		out[4] = (byte)( bits1 >>  8 );
+		out[5] = (byte)( bits1 >> 16 );
+	}
+}
+
+/*
+========================
+idDxtEncoder::CompressImageDXT1Fast_AVX2
+
+params:	inBuf		- image to compress
+paramO:	outBuf		- result of compression
+params:	width		- width of image
+params:	height		- height of image
+========================
+*/
+void idDxtEncoder::CompressImageDXT1Fast_AVX2( const byte *inBuf, byte *outBuf, int width, int height ) {
+	ALIGN16( byte blocks[128] );
+	ALIGN16( byte minColors[8] );
+	ALIGN16( byte maxColors[8] );
+	unsigned int colorIndices[2];
+
+	assert( width >= 4 && ( width & 3 ) == 0 );
+	assert( height >= 4 && ( height & 3 ) == 0 );
+
+	this->width = width;
+	this->height = height;
+	this->outData = outBuf;
+
+	for ( int j = 0; j < height; j += 4, inBuf += width * 4*4 ) {
+		for ( int i = 0; i < width; i += 8 ) {
+			const int numBlocks = ( i + 8 <= width ) ? 2 : 1;
+
+			ExtractBlocks_AVX2( inBuf + i * 4, width, numBlocks, blocks );
+			GetMinMaxBBox_AVX2( blocks, minColors, maxColors );
+			InsetColorsBBox_AVX2( minColors, maxColors );
+			GetColorIndices_AVX2( blocks, minColors, maxColors, colorIndices );
+
+			for ( int k = 0; k < numBlocks; k++ ) {
+				EmitUShort( ColorTo565( maxColors + k * 4 ) );
+				EmitUShort( ColorTo565( minColors + k * 4 ) );
+				EmitUInt( colorIndices[k] );
+			}
+		}
+		outData += dstPadding;
+		inBuf += srcPadding;
+	}
+
+	_mm256_zeroupper();
+}
+
+/*
+========================
+idDxtEncoder::CompressImageDXT5Fast_AVX2
+
+params:	inBuf		- image to compress
+paramO:	outBuf		- result of compression
+params:	width		- width of image
+params:	height		- height of image
+========================
+*/
+void idDxtEncoder::CompressImageDXT5Fast_AVX2( const byte *inBuf, byte *outBuf, int width, int height ) {
+	ALIGN16( byte blocks[128] );
+	ALIGN16( byte minColors[8] );
+	ALIGN16( byte maxColors[8] );
+	ALIGN16( byte alphaIndices[16] );
+	unsigned int colorIndices[2];
+
+	assert( width >= 4 && ( width & 3 ) == 0 );
+	assert( height >= 4 && ( height & 3 ) == 0 );
+
+	this->width = width;
+	this->height = height;
+	this->outData = outBuf;
+
+	for ( int j = 0; j < height; j += 4, inBuf += width * 4*4 ) {
+		for ( int i = 0; i < width; i += 8 ) {
+			const int numBlocks = ( i + 8 <= width ) ? 2 : 1;
+
+			ExtractBlocks_AVX2( inBuf + i * 4, width, numBlocks, blocks );
+			GetMinMaxBBox_AVX2( blocks, minColors, maxColors );
+			InsetColorsBBox_AVX2( minColors, maxColors );
+			GetAlphaIndices_AVX2( blocks, minColors, maxColors, alphaIndices );
+			GetColorIndices_AVX2( blocks, minColors, maxColors, colorIndices );
+
+			for ( int k = 0; k < numBlocks; k++ ) {
+				EmitByte( maxColors[k * 4 + 3] );
+				EmitByte( minColors[k * 4 + 3] );
+
+				for ( int b = 0; b < 6; b++ ) {
+					EmitByte( alphaIndices[k * 8 + b] );
+				}
+
+				EmitUShort( ColorTo565( maxColors + k * 4 ) );
+				EmitUShort( ColorTo565( minColors + k * 4 ) );
+
+				EmitUInt( colorIndices[k] );
+			}
+		}
+		outData += dstPadding;
+		inBuf += srcPadding;
+	}
+
+	_mm256_zeroupper();
+}
+
+#endif
@@ -222,6 +222,7 @@ public:
 	{
 		insideLevelLoad = false;
 		preloadingMapImages = false;
+		compressionJobList = NULL;
 	}
 
 	void				Init();
@@ -264,6 +265,10 @@ public:
 
 	void				Preload( const idPreloadManifest &manifest, const bool & mapPreload );
 
+	// writes the generated binary file of every out of date image in the manifest,
+	// the images are compressed in parallel on the job threads
+	void				BakeImages( const idPreloadManifest &manifest );
+
 	// Loads unloaded level images
 	int					LoadLevelImages( bool pacifier );
 
@@ -304,6 +309,8 @@ public:
 
 	bool				insideLevelLoad;			// don't actually load images now
 	bool				preloadingMapImages;		// unless this is set
+
+	idParallelJobList *	compressionJobList;			// bands of large images are mip mapped and DXT compressed in parallel on this
 };
 
 extern idImageManager	*globalImages;		// pointer to global list for the rest of the system
@@ -325,6 +332,13 @@ byte *R_MipMapWithAlphaSpecularity( const byte *in, int width, int height );
 byte *R_MipMapWithGamma( const byte *in, int width, int height );
 byte *R_MipMap( const byte *in, int width, int height );
 
+static const int MIP_MAX_PARALLEL_BANDS		= 64;			// job lists passed to R_MipMapChain need room for this many jobs
+static const int MIP_MIN_PARALLEL_PIXELS	= 64 * 1024;	// smallest share of a level that is worth a job
+
+// generates a whole mip chain in one banded pass, with the same results as R_MipMap and R_MipMapWithGamma
+void R_InitMipMapTables();
+byte *R_MipMapChain( const byte *in, int width, int height, int numLevels, bool gammaMips, const byte **levels, idParallelJobList *jobList );
+
 // these operate in-place on the provided pixels
 void R_BlendOverTexture( byte *data, int pixelCount, const byte blend[4] );
 void R_HorizontalFlip( byte *data, int width, int height );
@@ -31,6 +31,7 @@ If you have questions concerning this license or the applicable additional terms
 
 
 #include "tr_local.h"
+#include "DXT/DXTCodec.h"
 
 // do this with a pointer, in case we want to make the actual manager
 // a private virtual subclass
@@ -648,6 +649,10 @@ void idImageManager::Init() {
 
 	CreateIntrinsicImages();
 
+	R_InitMipMapTables();
+
+	compressionJobList = parallelJobManager->AllocJobList( JOBLIST_UTILITY, JOBLIST_PRIORITY_MEDIUM, Max( DXT_MAX_PARALLEL_BANDS, MIP_MAX_PARALLEL_BANDS ), 0, NULL );
+
 	cmdSystem->AddCommand( "reloadImages", R_ReloadImages_f, CMD_FL_RENDERER, "reloads images" );
 	cmdSystem->AddCommand( "listImages", R_ListImages_f, CMD_FL_RENDERER, "lists images" );
 	cmdSystem->AddCommand( "combineCubeImages", R_CombineCubeImages_f, CMD_FL_RENDERER, "combines six images for roq compression" );
@@ -664,6 +669,9 @@ void idImageManager::Shutdown() {
 	images.DeleteContents( true );
 	imageHash.Clear();
 
+	parallelJobManager->FreeJobList( compressionJobList );
+	compressionJobList = NULL;
+
 }
 
 /*
@@ -744,6 +752,204 @@ void idImageManager::Preload( const idPreloadManifest &manifest, const bool & ma
 	}
 }
 
+/*
+================================================================================================
+
+	Baking generated images
+
+================================================================================================
+*/
+
+static const int BAKE_IMAGE_BATCH_IMAGES	= 256;					// most images that are compressed together
+static const int BAKE_IMAGE_BATCH_PIXELS	= 64 * 1024 * 1024;		// most source pixels that are held in memory at once
+
+struct imageBake_t {
+	idImage *			image;					// standalone image, only used to derive the options
+	idBinaryImage *		binary;
+	idImageOpts			opts;
+	byte *				pics[6];
+	uint64				loadMicroseconds;		// reading the source on the main thread
+	uint64				compressMicroseconds;	// mip mapping and compressing on a job thread
+};
+
+/*
+========================
+BakeImageJob
+
+Images compressed off the main thread are compressed serially, so every job is one image.
+========================
+*/
+static void BakeImageJob( imageBake_t * bake ) {
+	const uint64 start = Sys_Microseconds();
+	idImageOpts & opts = bake->opts;
+	if ( opts.textureType == TT_CUBIC ) {
+		bake->binary->LoadCubeFromMemory( opts.width, (const byte **)bake->pics, opts.numLevels, opts.format, opts.gammaMips );
+	} else {
+		bake->binary->Load2DFromMemory( opts.width, opts.height, bake->pics[0], opts.numLevels, opts.format, opts.colorFormat, opts.gammaMips );
+	}
+	bake->compressMicroseconds = Sys_Microseconds() - start;
+}
+
+REGISTER_PARALLEL_JOB( BakeImageJob, "BakeImageJob" );
+
+/*
+========================
+FreeImageBake
+========================
+*/
+static void FreeImageBake( imageBake_t & bake ) {
+	for ( int i = 0; i < 6; i++ ) {
+		if ( bake.pics[i] != NULL ) {
+			Mem_Free( bake.pics[i] );
+			bake.pics[i] = NULL;
+		}
+	}
+	delete bake.binary;
+	delete bake.image;
+}
+
+/*
+====================
+idImageManager::BakeImages
+
+The source images are read on the main thread, because the file system is not thread safe.
+====================
+*/
+void idImageManager::BakeImages( const idPreloadManifest &manifest ) {
+	common->Printf( "Baking images...\n" );
+	const int start = Sys_Milliseconds();
+	int numBaked = 0;
+	int numCurrent = 0;
+	int numFailed = 0;
+
+	idStrList bakedNames;
+	idHashIndex bakedHash;
+	idList< imageBake_t > batch;
+	batch.Resize( BAKE_IMAGE_BATCH_IMAGES );
+	int batchPixels = 0;
+
+	idParallelJobList * bakeJobs = parallelJobManager->AllocJobList( JOBLIST_UTILITY, JOBLIST_PRIORITY_MEDIUM, BAKE_IMAGE_BATCH_IMAGES, 0, NULL );
+
+	for ( int i = 0; i <= manifest.NumResources(); i++ ) {
+		if ( i < manifest.NumResources() ) {
+			const preloadEntry_s & p = manifest.GetPreloadByIndex( i );
+			if ( p.resType != PRELOAD_IMAGE || ExcludePreloadImage( p.resourceName ) ) {
+				continue;
+			}
+
+			imageBake_t bake = {};
+			bake.loadMicroseconds = Sys_Microseconds();
+			bake.image = AllocStandaloneImage( p.resourceName );
+			idImage * image = bake.image;
+			image->filter = ( textureFilter_t )p.imgData.filter;
+			image->repeat = ( textureRepeat_t )p.imgData.repeat;
+			image->usage = ( textureUsage_t )p.imgData.usage;
+			image->cubeFiles = ( cubeFiles_t )p.imgData.cubeMap;
+
+			// the same steps as idImage::ActuallyLoadImage, up to the upload
+			if ( image->cubeFiles != CF_2D ) {
+				image->opts.textureType = TT_CUBIC;
+				image->repeat = TR_CLAMP;
+				R_LoadCubeImages( image->GetName(), image->cubeFiles, NULL, NULL, &image->sourceFileTime );
+			} else {
+				image->opts.textureType = TT_2D;
+				R_LoadImageProgram( image->GetName(), NULL, NULL, NULL, &image->sourceFileTime, &image->usage );
+			}
+			image->DeriveOpts();
+
+			idStrStatic< MAX_OSPATH > generatedName = image->GetName();
+			idImage::GetGeneratedName( generatedName, image->usage, image->cubeFiles );
+
+			// several manifest entries can only differ in the sampler settings
+			const int key = bakedHash.GenerateKey( generatedName, false );
+			bool duplicate = false;
+			for ( int j = bakedHash.First( key ); j != -1; j = bakedHash.Next( j ) ) {
+				if ( bakedNames[j].Icmp( generatedName ) == 0 ) {
+					duplicate = true;
+					break;
+				}
+			}
+			if ( duplicate ) {
+				FreeImageBake( bake );
+				continue;
+			}
+			bakedHash.Add( key, bakedNames.Append( generatedName ) );
+
+			bake.binary = new (TAG_IMAGE) idBinaryImage( generatedName );
+			if ( bake.binary->LoadHeaderFromGeneratedFile( image->sourceFileTime ) != FILE_NOT_FOUND_TIMESTAMP ) {
+				const bimageFile_t & header = bake.binary->GetFileHeader();
+				if ( header.colorFormat == image->opts.colorFormat && header.format == image->opts.format && header.textureType == image->opts.textureType ) {
+					numCurrent++;
+					FreeImageBake( bake );
+					continue;
+				}
+			}
+
+			if ( image->cubeFiles != CF_2D ) {
+				int size;
+				if ( !R_LoadCubeImages( image->GetName(), image->cubeFiles, bake.pics, &size, &image->sourceFileTime ) || size == 0 ) {
+					idLib::Warning( "Couldn't load cube image: %s", image->GetName() );
+					numFailed++;
+					FreeImageBake( bake );
+					continue;
+				}
+				image->opts.width = size;
+				image->opts.height = size;
+			} else {
+				int width, height;
+				R_LoadImageProgram( image->GetName(), &bake.pics[0], &width, &height, &image->sourceFileTime, &image->usage );
+				if ( bake.pics[0] == NULL ) {
+					idLib::Warning( "Couldn't load image: %s : %s", image->GetName(), generatedName.c_str() );
+					numFailed++;
+					FreeImageBake( bake );
+					continue;
+				}
+				image->opts.width = width;
+				image->opts.height = height;
+			}
+			image->opts.numLevels = 0;
+			image->DeriveOpts();
+			bake.opts = image->opts;
+			bake.loadMicroseconds = Sys_Microseconds() - bake.loadMicroseconds;
+
+			batch.Append( bake );
+			batchPixels += image->opts.width * image->opts.height * ( image->opts.textureType == TT_CUBIC ? 6 : 1 );
+			if ( batch.Num() < BAKE_IMAGE_BATCH_IMAGES && batchPixels < BAKE_IMAGE_BATCH_PIXELS ) {
+				continue;
+			}
+		}
+
+		if ( batch.Num() == 0 ) {
+			continue;
+		}
+
+		// compress the batch on the job threads, and write the files in manifest order
+		for ( int j = 0; j < batch.Num(); j++ ) {
+			bakeJobs->AddJob( (jobRun_t)BakeImageJob, &batch[j] );
+		}
+		bakeJobs->Submit();
+		bakeJobs->Wait();
+
+		for ( int j = 0; j < batch.Num(); j++ ) {
+			imageBake_t & bake = batch[j];
+			const uint64 writeStart = Sys_Microseconds();
+			bake.binary->WriteGeneratedFile( bake.image->sourceFileTime );
+			const uint64 total = bake.loadMicroseconds + bake.compressMicroseconds + ( Sys_Microseconds() - writeStart );
+			common->Printf( "%8.1f ms ( %6.1f ms compressing ) %s\n", total * 0.001f, bake.compressMicroseconds * 0.001f, bake.binary->GetName() );
+			FreeImageBake( bake );
+			numBaked++;
+		}
+		batch.SetNum( 0 );
+		batchPixels = 0;
+	}
+
+	parallelJobManager->FreeJobList( bakeJobs );
+
+	const int end = Sys_Milliseconds();
+	common->Printf( "%05d images baked, %05d were current, %05d failed in %5.1f seconds\n", numBaked, numCurrent, numFailed, ( end - start ) * 0.001 );
+	common->Printf( "----------------------------------------\n" );
+}
+
 /*
 ===============
 idImageManager::LoadLevelImages
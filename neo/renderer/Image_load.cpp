@@ -63,7 +63,7 @@ int BitsForFormat( textureFormat_t format ) {
 idImage::DeriveOpts
 ========================
 */
-ID_INLINE void idImage::DeriveOpts() {
+void idImage::DeriveOpts() {
 
 	if ( opts.format == FMT_NONE ) {
 		opts.colorFormat = CFM_DEFAULT;
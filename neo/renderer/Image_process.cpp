@@ -415,6 +415,491 @@ byte * R_MipMap( const byte *in, int width, int height ) {
 	return out;
 }
 
+/*
+================================================================================================
+
+	Mip chain generation
+
+R_MipMapChain produces exactly the same levels as calling R_MipMap or R_MipMapWithGamma
+on every level in turn, but it walks the source image in bands of rows and generates several
+levels from each band while the band is still in the cache. Bands are independent, so large
+images are split across jobs.
+
+The gamma correct filter replaces the pow() per channel with a search of the linear values at
+which the encoded byte changes. The thresholds are found with the same pow() the scalar filter
+uses, so both filters always agree.
+
+================================================================================================
+*/
+
+static const int MIP_BAND_LEVELS			= 4;			// a band of 16 source rows produces whole rows on the next 4 levels
+static const int MIP_GAMMA_MIN_EXPONENT		= 127 - 24;		// linear values below 2^-24 always encode to 0
+static const int MIP_GAMMA_MANTISSA_BITS	= 8;			// buckets per power of two in the gamma lookup
+static const int MIP_GAMMA_BUCKET_SHIFT		= IEEE_FLT_MANTISSA_BITS - MIP_GAMMA_MANTISSA_BITS;
+static const int MIP_GAMMA_FIRST_BUCKET		= MIP_GAMMA_MIN_EXPONENT << MIP_GAMMA_MANTISSA_BITS;
+static const int MIP_GAMMA_BUCKETS			= ( ( 127 - MIP_GAMMA_MIN_EXPONENT ) << MIP_GAMMA_MANTISSA_BITS ) + 1;
+
+static byte		mip_gammaBucket[MIP_GAMMA_BUCKETS];		// encoded byte at the start of each bucket
+static float	mip_gammaThreshold[257];				// smallest linear value that encodes to each byte
+static bool		mip_gammaTablesInitialized = false;
+
+/*
+================
+R_GammaEncode
+
+Converts an averaged linear value back to a gamma space byte, exactly like R_MipMapWithGamma.
+================
+*/
+static byte R_GammaEncode( float linear ) {
+	return idMath::Ftob( 255.0f * idMath::Pow( linear, 1.0f / 2.2f ) );
+}
+
+/*
+================
+R_GammaEncodeFast
+
+Same result as R_GammaEncode. Each bucket holds the encoded byte at its start and
+no bucket spans more than one step, so at most one threshold has to be tested.
+================
+*/
+ID_INLINE static byte R_GammaEncodeFast( float linear ) {
+	linear = idMath::ClampFloat( mip_gammaThreshold[0], 1.0f, linear );
+	const int bucket = ( *reinterpret_cast<const int *>( &linear ) >> MIP_GAMMA_BUCKET_SHIFT ) - MIP_GAMMA_FIRST_BUCKET;
+	const int b = mip_gammaBucket[bucket];
+	return (byte)( b + ( linear >= mip_gammaThreshold[b + 1] ) );
+}
+
+/*
+================
+R_InitMipMapTables
+================
+*/
+void R_InitMipMapTables() {
+	if ( mip_gammaTablesInitialized ) {
+		return;
+	}
+
+	// binary search the float bit patterns in [0,1] for the first value of each byte
+	for ( int b = 1; b < 256; b++ ) {
+		int low = 0;
+		int high = 0x3F800000;
+		while ( low < high ) {
+			const int mid = low + ( high - low ) / 2;
+			if ( R_GammaEncode( *reinterpret_cast<const float *>( &mid ) ) >= b ) {
+				high = mid;
+			} else {
+				low = mid + 1;
+			}
+		}
+		mip_gammaThreshold[b] = *reinterpret_cast<const float *>( &low );
+	}
+	mip_gammaThreshold[0] = 1.0f / ( 1 << 24 );
+	mip_gammaThreshold[256] = idMath::INFINITY;
+	assert( R_GammaEncode( mip_gammaThreshold[0] ) == 0 );
+
+	for ( int i = 0; i < MIP_GAMMA_BUCKETS; i++ ) {
+		const int bits = ( MIP_GAMMA_FIRST_BUCKET + i ) << MIP_GAMMA_BUCKET_SHIFT;
+		mip_gammaBucket[i] = R_GammaEncode( *reinterpret_cast<const float *>( &bits ) );
+	}
+
+	for ( int i = 0; i < MIP_GAMMA_BUCKETS - 1; i++ ) {
+		const int b = mip_gammaBucket[i];
+		const int nextBits = ( MIP_GAMMA_FIRST_BUCKET + i + 1 ) << MIP_GAMMA_BUCKET_SHIFT;
+		if ( b < 255 && mip_gammaThreshold[b + 2] < *reinterpret_cast<const float *>( &nextBits ) ) {
+			common->Error( "R_InitMipMapTables: gamma bucket %d spans more than one step", i );
+		}
+	}
+
+	mip_gammaTablesInitialized = true;
+}
+
+/*
+================
+R_MipMapRowBox
+
+Filters two source rows into one destination row like R_MipMap.
+================
+*/
+static void R_MipMapRowBox( const byte *in0, const byte *in1, byte *out, int outWidth ) {
+	int x = 0;
+#ifdef ID_WIN_X86_SSE2_INTRIN
+	const __m128i zero = _mm_setzero_si128();
+	for ( ; x + 4 <= outWidth; x += 4 ) {
+		const __m128i a0 = _mm_loadu_si128( (const __m128i *)( in0 + x * 8 + 0 ) );
+		const __m128i a1 = _mm_loadu_si128( (const __m128i *)( in0 + x * 8 + 16 ) );
+		const __m128i b0 = _mm_loadu_si128( (const __m128i *)( in1 + x * 8 + 0 ) );
+		const __m128i b1 = _mm_loadu_si128( (const __m128i *)( in1 + x * 8 + 16 ) );
+
+		// vertical sums with two pixels per register
+		const __m128i s0 = _mm_add_epi16( _mm_unpacklo_epi8( a0, zero ), _mm_unpacklo_epi8( b0, zero ) );
+		const __m128i s1 = _mm_add_epi16( _mm_unpackhi_epi8( a0, zero ), _mm_unpackhi_epi8( b0, zero ) );
+		const __m128i s2 = _mm_add_epi16( _mm_unpacklo_epi8( a1, zero ), _mm_unpacklo_epi8( b1, zero ) );
+		const __m128i s3 = _mm_add_epi16( _mm_unpackhi_epi8( a1, zero ), _mm_unpackhi_epi8( b1, zero ) );
+
+		// horizontal sums of the pixel pairs
+		const __m128i h0 = _mm_add_epi16( _mm_unpacklo_epi64( s0, s1 ), _mm_unpackhi_epi64( s0, s1 ) );
+		const __m128i h1 = _mm_add_epi16( _mm_unpacklo_epi64( s2, s3 ), _mm_unpackhi_epi64( s2, s3 ) );
+
+		_mm_storeu_si128( (__m128i *)( out + x * 4 ), _mm_packus_epi16( _mm_srli_epi16( h0, 2 ), _mm_srli_epi16( h1, 2 ) ) );
+	}
+#endif
+	for ( ; x < outWidth; x++ ) {
+		const byte * p0 = in0 + x * 8;
+		const byte * p1 = in1 + x * 8;
+		byte * o = out + x * 4;
+		o[0] = ( p0[0] + p0[4] + p1[0] + p1[4] ) >> 2;
+		o[1] = ( p0[1] + p0[5] + p1[1] + p1[5] ) >> 2;
+		o[2] = ( p0[2] + p0[6] + p1[2] + p1[6] ) >> 2;
+		o[3] = ( p0[3] + p0[7] + p1[3] + p1[7] ) >> 2;
+	}
+}
+
+/*
+================
+R_MipMapRowGamma
+
+Filters two source rows into one destination row like R_MipMapWithGamma.
+================
+*/
+static void R_MipMapRowGamma( const byte *in0, const byte *in1, byte *out, int outWidth ) {
+	const float * table = mip_gammaTable;
+#ifdef ID_WIN_X86_SSE2_INTRIN
+	const __m128 quarter = _mm_set1_ps( 0.25f );
+	const __m128 minLinear = _mm_set1_ps( mip_gammaThreshold[0] );
+	const __m128 maxLinear = _mm_set1_ps( 1.0f );
+	const __m128i firstBucket = _mm_set1_epi32( MIP_GAMMA_FIRST_BUCKET );
+	ALIGN16( float linear[4] );
+	ALIGN16( int buckets[4] );
+#endif
+	for ( int x = 0; x < outWidth; x++, in0 += 8, in1 += 8, out += 4 ) {
+#ifdef ID_WIN_X86_SSE2_INTRIN
+		// one channel per lane, summed in the same order as R_MipMapWithGamma
+		__m128 sum = _mm_add_ps( _mm_setr_ps( table[in0[0]], table[in0[1]], table[in0[2]], table[in0[3]] ),
+								 _mm_setr_ps( table[in0[4]], table[in0[5]], table[in0[6]], table[in0[7]] ) );
+		sum = _mm_add_ps( sum, _mm_setr_ps( table[in1[0]], table[in1[1]], table[in1[2]], table[in1[3]] ) );
+		sum = _mm_add_ps( sum, _mm_setr_ps( table[in1[4]], table[in1[5]], table[in1[6]], table[in1[7]] ) );
+		sum = _mm_min_ps( _mm_max_ps( _mm_mul_ps( sum, quarter ), minLinear ), maxLinear );
+
+		_mm_store_ps( linear, sum );
+		_mm_store_si128( (__m128i *)buckets, _mm_sub_epi32( _mm_srli_epi32( _mm_castps_si128( sum ), MIP_GAMMA_BUCKET_SHIFT ), firstBucket ) );
+
+		for ( int c = 0; c < 4; c++ ) {
+			const int b = mip_gammaBucket[buckets[c]];
+			out[c] = (byte)( b + ( linear[c] >= mip_gammaThreshold[b + 1] ) );
+		}
+#else
+		for ( int c = 0; c < 4; c++ ) {
+			out[c] = R_GammaEncodeFast( 0.25f * ( table[in0[c]] + table[in0[c + 4]] + table[in1[c]] + table[in1[c + 4]] ) );
+		}
+#endif
+	}
+}
+
+/*
+================
+R_MipMapLinear
+
+Filters a level that is only one pixel wide or high, which pairs up neighbouring pixels
+in memory order like R_MipMap and R_MipMapWithGamma.
+================
+*/
+static void R_MipMapLinear( const byte *in, int width, int height, byte *out, bool gammaMips ) {
+	if ( width == 1 && height == 1 ) {
+		memcpy( out, in, 4 );
+		return;
+	}
+	const int outPixels = ( width >> 1 ) + ( height >> 1 );
+	for ( int i = 0; i < outPixels; i++, in += 8, out += 4 ) {
+		for ( int c = 0; c < 4; c++ ) {
+			if ( gammaMips ) {
+				out[c] = R_GammaEncodeFast( 0.5f * ( mip_gammaTable[in[c]] + mip_gammaTable[in[c + 4]] ) );
+			} else {
+				out[c] = ( in[c] + in[c + 4] ) >> 1;
+			}
+		}
+	}
+}
+
+/*
+================
+R_MipLevelSize
+================
+*/
+ID_INLINE static int R_MipLevelSize( int size, int level ) {
+	return Max( 1, size >> level );
+}
+
+/*
+================
+R_MipChainOffset
+
+Byte offset of a level inside the block returned by R_MipMapChain.
+================
+*/
+static int R_MipChainOffset( int width, int height, int level ) {
+	int offset = 0;
+	for ( int i = 1; i < level; i++ ) {
+		offset += R_MipLevelSize( width, i ) * R_MipLevelSize( height, i ) * 4;
+	}
+	return offset;
+}
+
+/*
+================================================
+mipBandParms_t
+================================================
+*/
+struct mipBandParms_t {
+	const byte *	in;				// level 0
+	byte *			chain;			// levels 1 and up
+	int				width;			// level 0 width
+	int				height;			// level 0 height
+	int				baseLevel;		// level the bands are cut from
+	int				numBandLevels;	// levels generated from each band
+	int				firstBand;
+	int				numBands;
+	bool			gammaMips;
+};
+
+/*
+================
+R_MipMapBands
+
+Every band covers ( 1 << numBandLevels ) rows of the base level, so it produces whole rows on
+all of the levels it generates and only reads rows that it wrote itself or that were complete
+before the bands started.
+================
+*/
+static void R_MipMapBands( const mipBandParms_t * parms ) {
+	const int bandRows = 1 << parms->numBandLevels;
+	for ( int band = parms->firstBand; band < parms->firstBand + parms->numBands; band++ ) {
+		for ( int i = 1; i <= parms->numBandLevels; i++ ) {
+			const int srcLevel = parms->baseLevel + i - 1;
+			const int dstLevel = srcLevel + 1;
+			const int srcWidth = R_MipLevelSize( parms->width, srcLevel );
+			const int dstWidth = R_MipLevelSize( parms->width, dstLevel );
+			const int dstHeight = R_MipLevelSize( parms->height, dstLevel );
+			const byte * src = ( srcLevel == 0 ) ? parms->in : parms->chain + R_MipChainOffset( parms->width, parms->height, srcLevel );
+			byte * dst = parms->chain + R_MipChainOffset( parms->width, parms->height, dstLevel );
+
+			// the scalar filters step dstWidth pixel pairs plus one row per destination row, which
+			// drifts by a pixel per row on odd widths, and the chain has to match them exactly
+			const int srcPitch = srcWidth * 4;
+			const int srcStep = dstWidth * 8 + srcPitch;
+
+			const int firstRow = ( band * bandRows ) >> i;
+			const int lastRow = Min( ( ( band + 1 ) * bandRows ) >> i, dstHeight );
+			for ( int y = firstRow; y < lastRow; y++ ) {
+				const byte * in0 = src + y * srcStep;
+				const byte * in1 = in0 + srcPitch;
+				if ( parms->gammaMips ) {
+					R_MipMapRowGamma( in0, in1, dst + y * dstWidth * 4, dstWidth );
+				} else {
+					R_MipMapRowBox( in0, in1, dst + y * dstWidth * 4, dstWidth );
+				}
+			}
+		}
+	}
+}
+
+/*
+================
+R_MipMapBandJob
+================
+*/
+static void R_MipMapBandJob( mipBandParms_t * parms ) {
+	R_MipMapBands( parms );
+}
+
+REGISTER_PARALLEL_JOB( R_MipMapBandJob, "R_MipMapBandJob" );
+
+/*
+================
+R_MipMapChain
+
+Generates levels 1 to numLevels - 1 from the level 0 pixels and points levels[] at all of
+them, levels[0] is the input. The generated levels share the returned allocation, which the
+caller releases with Mem_Free. Large levels are split across the job list when one is given,
+which needs room for MIP_MAX_PARALLEL_BANDS jobs.
+================
+*/
+byte *R_MipMapChain( const byte *in, int width, int height, int numLevels, bool gammaMips, const byte **levels, idParallelJobList *jobList ) {
+	assert( mip_gammaTablesInitialized || !gammaMips );
+
+	levels[0] = in;
+	if ( numLevels <= 1 ) {
+		return NULL;
+	}
+
+	byte * chain = (byte *)R_StaticAlloc( R_MipChainOffset( width, height, numLevels ), TAG_IMAGE );
+	for ( int level = 1; level < numLevels; level++ ) {
+		levels[level] = chain + R_MipChainOffset( width, height, level );
+	}
+
+	int baseLevel = 0;
+	while ( baseLevel < numLevels - 1 ) {
+		const int srcWidth = R_MipLevelSize( width, baseLevel );
+		const int srcHeight = R_MipLevelSize( height, baseLevel );
+		if ( srcWidth == 1 || srcHeight == 1 ) {
+			R_MipMapLinear( levels[baseLevel], srcWidth, srcHeight, chain + R_MipChainOffset( width, height, baseLevel + 1 ), gammaMips );
+			baseLevel++;
+			continue;
+		}
+
+		// go as deep as the levels stay two dimensional, an odd width drifts the source rows
+		// into the previous band so it has to wait for the next pass
+		int numBandLevels = 1;
+		while ( numBandLevels < MIP_BAND_LEVELS && baseLevel + numBandLevels < numLevels - 1 ) {
+			const int levelWidth = R_MipLevelSize( width, baseLevel + numBandLevels );
+			const int levelHeight = R_MipLevelSize( height, baseLevel + numBandLevels );
+			if ( levelWidth == 1 || levelHeight == 1 || ( levelWidth & 1 ) ) {
+				break;
+			}
+			numBandLevels++;
+		}
+		const int bandRows = 1 << numBandLevels;
+		const int numBands = ( srcHeight + bandRows - 1 ) / bandRows;
+
+		mipBandParms_t parms;
+		parms.in = in;
+		parms.chain = chain;
+		parms.width = width;
+		parms.height = height;
+		parms.baseLevel = baseLevel;
+		parms.numBandLevels = numBandLevels;
+		parms.firstBand = 0;
+		parms.numBands = numBands;
+		parms.gammaMips = gammaMips;
+
+		int numJobs = 0;
+		if ( jobList != NULL ) {
+			numJobs = Max( 1, parallelJobManager->GetNumProcessingUnits() ) * 4;
+			numJobs = Min( numJobs, MIP_MAX_PARALLEL_BANDS );
+			numJobs = Min( numJobs, numBands );
+			numJobs = Min( numJobs, srcWidth * srcHeight / MIP_MIN_PARALLEL_PIXELS );
+		}
+
+		if ( numJobs <= 1 ) {
+			R_MipMapBands( &parms );
+		} else {
+			mipBandParms_t jobParms[MIP_MAX_PARALLEL_BANDS];
+			for ( int i = 0, band = 0; i < numJobs; i++ ) {
+				jobParms[i] = parms;
+				jobParms[i].firstBand = band;
+				jobParms[i].numBands = numBands / numJobs + ( i < numBands % numJobs );
+				band += jobParms[i].numBands;
+
+				jobList->AddJob( (jobRun_t)R_MipMapBandJob, &jobParms[i] );
+			}
+			jobList->Submit();
+			jobList->Wait();
+		}
+
+		baseLevel += numBandLevels;
+	}
+
+	return chain;
+}
+
+/*
+================
+testMipMap
+
+Builds the mip chain of a synthetic image with the scalar filters one level at a time, with
+R_MipMapChain and with R_MipMapChain split across jobs, and checks that all of them produce
+the same levels. Nothing is uploaded, so this also works without a renderer.
+================
+*/
+CONSOLE_COMMAND( testMipMap, "measures mip chain generation throughput, usage: testMipMap [size]", 0 ) {
+	static const int MAX_TEST_LEVELS = 14;
+	const int size = ( args.Argc() > 1 ) ? idMath::ClampInt( 16, 8192, atoi( args.Argv( 1 ) ) ) : 2048;
+	const int numRuns = 5;
+
+	int numLevels = 1;
+	while ( ( size >> numLevels ) > 0 ) {
+		numLevels++;
+	}
+	assert( numLevels <= MAX_TEST_LEVELS );
+
+	byte * image = (byte *)Mem_Alloc( size * size * 4, TAG_TEMP );
+	idRandom random( 0x0d7c0de );
+	for ( int y = 0; y < size; y++ ) {
+		for ( int x = 0; x < size; x++ ) {
+			byte * pixel = image + ( y * size + x ) * 4;
+			const int noise = random.RandomInt( 32 );
+			pixel[0] = (byte)( ( x * 255 / size + noise ) & 255 );
+			pixel[1] = (byte)( ( y * 255 / size + noise ) & 255 );
+			pixel[2] = (byte)( ( ( x ^ y ) + noise ) & 255 );
+			pixel[3] = (byte)( ( ( x + y ) * 255 / ( 2 * size ) + noise ) & 255 );
+		}
+	}
+
+	R_InitMipMapTables();
+	idParallelJobList * jobList = parallelJobManager->AllocJobList( JOBLIST_UTILITY, JOBLIST_PRIORITY_MEDIUM, MIP_MAX_PARALLEL_BANDS, 0, NULL );
+
+	common->Printf( "%dx%d image, %d levels, %d runs, %d processing units\n", size, size, numLevels, numRuns, parallelJobManager->GetNumProcessingUnits() );
+	common->Printf( "filter     scalar    banded  parallel  (megapixels per second)\n" );
+
+	const double megaPixels = (double)size * size * numRuns / ( 1024.0 * 1024.0 );
+	for ( int gammaMips = 0; gammaMips < 2; gammaMips++ ) {
+		byte * scalarLevels[MAX_TEST_LEVELS] = { NULL };
+		uint64 start = Sys_Microseconds();
+		for ( int run = 0; run < numRuns; run++ ) {
+			const byte * pic = image;
+			for ( int level = 1; level < numLevels; level++ ) {
+				const int levelSize = Max( 1, size >> ( level - 1 ) );
+				Mem_Free( scalarLevels[level] );
+				scalarLevels[level] = gammaMips ? R_MipMapWithGamma( pic, levelSize, levelSize ) : R_MipMap( pic, levelSize, levelSize );
+				pic = scalarLevels[level];
+			}
+		}
+		const uint64 scalarTime = Max( Sys_Microseconds() - start, (uint64)1 );
+
+		const byte * bandedLevels[MAX_TEST_LEVELS];
+		byte * bandedChain = NULL;
+		start = Sys_Microseconds();
+		for ( int run = 0; run < numRuns; run++ ) {
+			Mem_Free( bandedChain );
+			bandedChain = R_MipMapChain( image, size, size, numLevels, gammaMips != 0, bandedLevels, NULL );
+		}
+		const uint64 bandedTime = Max( Sys_Microseconds() - start, (uint64)1 );
+
+		const byte * parallelLevels[MAX_TEST_LEVELS];
+		byte * parallelChain = NULL;
+		start = Sys_Microseconds();
+		for ( int run = 0; run < numRuns; run++ ) {
+			Mem_Free( parallelChain );
+			parallelChain = R_MipMapChain( image, size, size, numLevels, gammaMips != 0, parallelLevels, jobList );
+		}
+		const uint64 parallelTime = Max( Sys_Microseconds() - start, (uint64)1 );
+
+		int mismatchLevel = -1;
+		for ( int level = 1; level < numLevels && mismatchLevel == -1; level++ ) {
+			const int levelSize = Max( 1, size >> level );
+			if ( memcmp( scalarLevels[level], bandedLevels[level], levelSize * levelSize * 4 ) != 0 ||
+					memcmp( scalarLevels[level], parallelLevels[level], levelSize * levelSize * 4 ) != 0 ) {
+				mismatchLevel = level;
+			}
+		}
+
+		common->Printf( "%-8s %8.1f %9.1f %9.1f", gammaMips ? "gamma" : "box", megaPixels * 1000000.0 / scalarTime,
+			megaPixels * 1000000.0 / bandedTime, megaPixels * 1000000.0 / parallelTime );
+		if ( mismatchLevel != -1 ) {
+			common->Printf( "  MISMATCH on level %d", mismatchLevel );
+		}
+		common->Printf( "\n" );
+
+		for ( int level = 1; level < numLevels; level++ ) {
+			Mem_Free( scalarLevels[level] );
+		}
+		Mem_Free( bandedChain );
+		Mem_Free( parallelChain );
+	}
+
+	parallelJobManager->FreeJobList( jobList );
+	Mem_Free( image );
+}
+
 /*
 ==================
 R_BlendOverTexture
@@ -212,6 +212,54 @@ private:
 	void						ParseJoint( idLexer &parser, idMD5Joint *joint, idJointQuat *defaultPose );
 };
 
+/*
+===============================================================================
+
+	Batched MD5 skinning
+
+	While a thread has a skinning batch set, MD5 models instantiated on that
+	thread leave their joint palette transform to the batch, which then
+	transforms the palettes of all instances with one job per batch of joints.
+
+===============================================================================
+*/
+
+struct skinningInstance_t {
+	idJointMat *				outJoints;
+	const idJointMat *			entJoints;
+	const idJointMat *			invertedDefaultPose;
+	int							numJoints;
+};
+
+struct skinningBatch_t {
+	const skinningInstance_t *	instances;
+	int							numInstances;
+};
+
+class idSkinningBatch {
+public:
+								idSkinningBatch();
+
+	// both arrays must be able to hold maxInstances entries
+	void						Init( skinningInstance_t * instances, skinningBatch_t * batches, int maxInstances );
+	// thread safe, returns false if the batch is full and the caller should transform the joints itself
+	bool						AddInstance( idJointMat * outJoints, const idJointMat * entJoints, const idJointMat * invertedDefaultPose, int numJoints );
+	// transforms all added joint palettes and empties the batch, runs serially if jobList is NULL
+	void						Transform( idParallelJobList * jobList );
+
+	int							GetNumInstances() const { return Min( numInstances.GetValue(), maxInstances ); }
+	int							GetNumBatches() const { return numBatches; }
+
+private:
+	skinningInstance_t *		instances;
+	skinningBatch_t *			batches;
+	int							maxInstances;
+	int							numBatches;
+	idSysInterlockedInteger		numInstances;
+};
+
+void R_SetThreadSkinningBatch( idSkinningBatch * batch );
+
 /*
 ===============================================================================
 
@@ -1183,6 +1183,214 @@ static void TransformJoints( idJointMat *__restrict outJoints, const int numJoin
 #endif
 }
 
+/***********************************************************************
+
+	idSkinningBatch
+
+***********************************************************************/
+
+static const int SKINNING_BATCH_JOINTS = 1024;		// joints transformed per job
+
+static ID_TLS threadSkinningBatch;
+
+/*
+====================
+R_SetThreadSkinningBatch
+
+MD5 models instantiated on the calling thread add their joint palettes
+to the given batch until this is called again with NULL.
+====================
+*/
+void R_SetThreadSkinningBatch( idSkinningBatch * batch ) {
+	threadSkinningBatch = (ptrdiff_t)batch;
+}
+
+/*
+====================
+R_SkinningBatchJob
+====================
+*/
+static void R_SkinningBatchJob( const skinningBatch_t * batch ) {
+	for ( int i = 0; i < batch->numInstances; i++ ) {
+		const skinningInstance_t & instance = batch->instances[i];
+		TransformJoints( instance.outJoints, instance.numJoints, instance.entJoints, instance.invertedDefaultPose );
+	}
+}
+
+REGISTER_PARALLEL_JOB( R_SkinningBatchJob, "R_SkinningBatchJob" );
+
+/*
+========================
+idSort_SkinningInstance
+========================
+*/
+class idSort_SkinningInstance : public idSort_Quick< skinningInstance_t, idSort_SkinningInstance > {
+public:
+	int Compare( const skinningInstance_t & a, const skinningInstance_t & b ) const {
+		if ( a.invertedDefaultPose < b.invertedDefaultPose ) {
+			return -1;
+		}
+		if ( a.invertedDefaultPose > b.invertedDefaultPose ) {
+			return 1;
+		}
+		return 0;
+	}
+};
+
+/*
+====================
+idSkinningBatch::idSkinningBatch
+====================
+*/
+idSkinningBatch::idSkinningBatch() {
+	Init( NULL, NULL, 0 );
+}
+
+/*
+====================
+idSkinningBatch::Init
+====================
+*/
+void idSkinningBatch::Init( skinningInstance_t * instances_, skinningBatch_t * batches_, int maxInstances_ ) {
+	instances = instances_;
+	batches = batches_;
+	maxInstances = maxInstances_;
+	numBatches = 0;
+	numInstances.SetValue( 0 );
+}
+
+/*
+====================
+idSkinningBatch::AddInstance
+====================
+*/
+bool idSkinningBatch::AddInstance( idJointMat * outJoints, const idJointMat * entJoints, const idJointMat * invertedDefaultPose, int numJoints ) {
+	const int index = numInstances.Increment() - 1;
+	if ( index >= maxInstances ) {
+		return false;
+	}
+	skinningInstance_t & instance = instances[index];
+	instance.outJoints = outJoints;
+	instance.entJoints = entJoints;
+	instance.invertedDefaultPose = invertedDefaultPose;
+	instance.numJoints = numJoints;
+	return true;
+}
+
+/*
+====================
+idSkinningBatch::Transform
+
+Instances of the same model are sorted next to each other so a job
+keeps reusing the same inverted default pose, and consecutive instances
+are packed into jobs of roughly SKINNING_BATCH_JOINTS joints.
+====================
+*/
+void idSkinningBatch::Transform( idParallelJobList * jobList ) {
+	const int num = GetNumInstances();
+
+	if ( num > 1 ) {
+		idSort_SkinningInstance().Sort( instances, num );
+	}
+
+	numBatches = 0;
+	for ( int i = 0; i < num; ) {
+		skinningBatch_t & batch = batches[numBatches++];
+		batch.instances = &instances[i];
+		batch.numInstances = 0;
+		for ( int numJoints = 0; i < num && ( batch.numInstances == 0 || numJoints + instances[i].numJoints <= SKINNING_BATCH_JOINTS ); i++ ) {
+			numJoints += instances[i].numJoints;
+			batch.numInstances++;
+		}
+	}
+
+	if ( jobList != NULL && numBatches > 1 ) {
+		for ( int i = 0; i < numBatches; i++ ) {
+			jobList->AddJob( (jobRun_t)R_SkinningBatchJob, &batches[i] );
+		}
+		jobList->Submit();
+		jobList->Wait();
+	} else {
+		for ( int i = 0; i < numBatches; i++ ) {
+			R_SkinningBatchJob( &batches[i] );
+		}
+	}
+
+	numInstances.SetValue( 0 );
+}
+
+/*
+====================
+testSkinning
+
+Skins a number of instances of a synthetic mesh, once with a
+TransformJoints call per instance and once through an idSkinningBatch.
+====================
+*/
+CONSOLE_COMMAND( testSkinning, "measures joint transform throughput with and without batched skinning jobs, usage: testSkinning [numInstances] [numJoints]", 0 ) {
+	const int numInstances = ( args.Argc() > 1 ) ? idMath::ClampInt( 1, 2048, atoi( args.Argv( 1 ) ) ) : 256;
+	const int numJoints = ( args.Argc() > 2 ) ? idMath::ClampInt( 1, 1024, atoi( args.Argv( 2 ) ) ) : 72;
+	const int numPaletteJoints = SIMD_ROUND_JOINTS( numJoints );
+	const int numRuns = 50;
+
+	idRandom random( 0x5ca1ab1e );
+
+	idList< idJointMat, TAG_JOINTMAT > invertedDefaultPose;
+	idList< idJointMat, TAG_JOINTMAT > entJoints;
+	idList< idJointMat, TAG_JOINTMAT > inlineJoints;
+	idList< idJointMat, TAG_JOINTMAT > batchedJoints;
+	invertedDefaultPose.SetNum( numPaletteJoints );
+	entJoints.SetNum( numInstances * numPaletteJoints );
+	inlineJoints.SetNum( numInstances * numPaletteJoints );
+	batchedJoints.SetNum( numInstances * numPaletteJoints );
+
+	for ( int i = 0; i < invertedDefaultPose.Num(); i++ ) {
+		invertedDefaultPose[i].SetRotation( idAngles( random.CRandomFloat() * 180.0f, random.CRandomFloat() * 180.0f, random.CRandomFloat() * 180.0f ).ToMat3() );
+		invertedDefaultPose[i].SetTranslation( idVec3( random.CRandomFloat(), random.CRandomFloat(), random.CRandomFloat() ) * 64.0f );
+	}
+	for ( int i = 0; i < entJoints.Num(); i++ ) {
+		entJoints[i].SetRotation( idAngles( random.CRandomFloat() * 180.0f, random.CRandomFloat() * 180.0f, random.CRandomFloat() * 180.0f ).ToMat3() );
+		entJoints[i].SetTranslation( idVec3( random.CRandomFloat(), random.CRandomFloat(), random.CRandomFloat() ) * 64.0f );
+	}
+
+	idList< skinningInstance_t, TAG_JOINTMAT > instances;
+	idList< skinningBatch_t, TAG_JOINTMAT > batches;
+	instances.SetNum( numInstances );
+	batches.SetNum( numInstances );
+
+	idSkinningBatch skinningBatch;
+	idParallelJobList * jobList = parallelJobManager->AllocJobList( JOBLIST_UTILITY, JOBLIST_PRIORITY_MEDIUM, numInstances, 0, NULL );
+
+	uint64 inlineTime = 0;
+	uint64 batchedTime = 0;
+	for ( int run = 0; run < numRuns; run++ ) {
+		uint64 start = Sys_Microseconds();
+		for ( int i = 0; i < numInstances; i++ ) {
+			TransformJoints( &inlineJoints[i * numPaletteJoints], numJoints, &entJoints[i * numPaletteJoints], invertedDefaultPose.Ptr() );
+		}
+		inlineTime += Sys_Microseconds() - start;
+
+		start = Sys_Microseconds();
+		skinningBatch.Init( instances.Ptr(), batches.Ptr(), numInstances );
+		for ( int i = 0; i < numInstances; i++ ) {
+			skinningBatch.AddInstance( &batchedJoints[i * numPaletteJoints], &entJoints[i * numPaletteJoints], invertedDefaultPose.Ptr(), numJoints );
+		}
+		skinningBatch.Transform( jobList );
+		batchedTime += Sys_Microseconds() - start;
+	}
+
+	parallelJobManager->FreeJobList( jobList );
+
+	const double totalJoints = (double)numInstances * numJoints * numRuns;
+	common->Printf( "%d instances of %d joints, %d runs, %d jobs per run\n", numInstances, numJoints, numRuns, skinningBatch.GetNumBatches() );
+	common->Printf( "inline:  %7.2f million joints per second\n", totalJoints / Max( inlineTime, (uint64)1 ) );
+	common->Printf( "batched: %7.2f million joints per second\n", totalJoints / Max( batchedTime, (uint64)1 ) );
+
+	if ( memcmp( inlineJoints.Ptr(), batchedJoints.Ptr(), inlineJoints.Num() * sizeof( idJointMat ) ) != 0 ) {
+		common->Warning( "testSkinning: batched joints differ from the inline joints" );
+	}
+}
+
 /*
 ====================
 idRenderModelMD5::InstantiateDynamicModel
@@ -1247,7 +1455,13 @@ idRenderModel *idRenderModelMD5::InstantiateDynamicModel( const struct renderEnt
 		assert( staticModel->numInvertedJoints == numInvertedJoints );
 	}
 
-	TransformJoints( staticModel->jointsInverted, joints.Num(), ent->joints, invertedDefaultPose.Ptr() );
+	// with GPU skinning the inverted joints are not needed until the surfaces
+	// are added to the view, so they can be transformed with the other instances
+	idSkinningBatch * skinningBatch = (idSkinningBatch *)(ptrdiff_t)threadSkinningBatch;
+	if ( skinningBatch == NULL || !r_useGPUSkinning.GetBool() ||
+			!skinningBatch->AddInstance( staticModel->jointsInverted, ent->joints, invertedDefaultPose.Ptr(), joints.Num() ) ) {
+		TransformJoints( staticModel->jointsInverted, joints.Num(), ent->joints, invertedDefaultPose.Ptr() );
+	}
 
 	// create all the surfaces
 	idMD5Mesh * mesh = meshes.Ptr();
@@ -35,6 +35,7 @@ If you have questions concerning this license or the applicable additional terms
 idCVar r_skipStaticShadows( "r_skipStaticShadows", "0", CVAR_RENDERER | CVAR_BOOL, "skip static shadows" );
 idCVar r_skipDynamicShadows( "r_skipDynamicShadows", "0", CVAR_RENDERER | CVAR_BOOL, "skip dynamic shadows" );
 idCVar r_useParallelAddModels( "r_useParallelAddModels", "1", CVAR_RENDERER | CVAR_BOOL, "add all models in parallel with jobs" );
+idCVar r_useBatchedSkinning( "r_useBatchedSkinning", "1", CVAR_RENDERER | CVAR_BOOL, "transform the joints of all visible MD5 models in a view in batched jobs" );
 idCVar r_useParallelAddShadows( "r_useParallelAddShadows", "1", CVAR_RENDERER | CVAR_INTEGER, "0 = off, 1 = threaded", 0, 1 );
 idCVar r_useShadowPreciseInsideTest( "r_useShadowPreciseInsideTest", "1", CVAR_RENDERER | CVAR_BOOL, "use a precise and more expensive test to determine whether the view is inside a shadow volume" );
 idCVar r_cullDynamicShadowTriangles( "r_cullDynamicShadowTriangles", "1", CVAR_RENDERER | CVAR_BOOL, "cull occluder triangles that are outside the light frustum so they do not contribute to the dynamic shadow volume" );
@@ -964,6 +965,83 @@ void R_AddSingleModel( viewEntity_t * vEntity ) {
 
 REGISTER_PARALLEL_JOB( R_AddSingleModel, "R_AddSingleModel" );
 
+static idSkinningBatch viewSkinningBatch;
+
+/*
+===================
+R_InstantiateDynamicModelJob
+
+May be run in parallel.
+
+Instantiates the dynamic model of a visible entity ahead of R_AddSingleModel,
+leaving the MD5 joint transforms to the view's skinning batch.
+===================
+*/
+static void R_InstantiateDynamicModelJob( viewEntity_t * vEntity ) {
+	R_SetThreadSkinningBatch( &viewSkinningBatch );
+	R_EntityDefDynamicModel( vEntity->entityDef );
+	R_SetThreadSkinningBatch( NULL );
+}
+
+REGISTER_PARALLEL_JOB( R_InstantiateDynamicModelJob, "R_InstantiateDynamicModelJob" );
+
+/*
+===================
+R_InstantiateDynamicModels
+
+Instantiates the dynamic models that are directly visible and then transforms
+the joints of all MD5 models among them in a few batched jobs instead of one
+small transform per entity. Entities that are only added for their shadows are
+left to R_AddSingleModel, which may still cull them.
+===================
+*/
+static void R_InstantiateDynamicModels() {
+	SCOPED_PROFILE_EVENT( "R_InstantiateDynamicModels" );
+
+	const viewDef_t * viewDef = tr.viewDef;
+
+	// R_SortViewEntities placed all the dynamic models first
+	int numDynamicEntities = 0;
+	for ( viewEntity_t * vEntity = viewDef->viewEntitys; vEntity != NULL; vEntity = vEntity->next ) {
+		if ( vEntity->entityDef->parms.hModel->IsDynamicModel() == DM_STATIC ) {
+			break;
+		}
+		numDynamicEntities++;
+	}
+	if ( numDynamicEntities == 0 ) {
+		return;
+	}
+
+	skinningInstance_t * instances = (skinningInstance_t *)R_FrameAlloc( numDynamicEntities * sizeof( instances[0] ), FRAME_ALLOC_UNKNOWN );
+	skinningBatch_t * batches = (skinningBatch_t *)R_FrameAlloc( numDynamicEntities * sizeof( batches[0] ), FRAME_ALLOC_UNKNOWN );
+	viewSkinningBatch.Init( instances, batches, numDynamicEntities );
+
+	viewEntity_t * vEntity = viewDef->viewEntitys;
+	for ( int i = 0; i < numDynamicEntities; i++, vEntity = vEntity->next ) {
+		const idRenderEntityLocal * entityDef = vEntity->entityDef;
+		if ( vEntity->scissorRect.IsEmpty() ) {
+			continue;
+		}
+		if ( viewDef->isXraySubview && entityDef->parms.xrayIndex == 1 ) {
+			continue;
+		} else if ( !viewDef->isXraySubview && entityDef->parms.xrayIndex == 2 ) {
+			continue;
+		}
+		if ( r_useParallelAddModels.GetBool() ) {
+			tr.frontEndJobList->AddJob( (jobRun_t)R_InstantiateDynamicModelJob, vEntity );
+		} else {
+			R_InstantiateDynamicModelJob( vEntity );
+		}
+	}
+
+	if ( r_useParallelAddModels.GetBool() ) {
+		tr.frontEndJobList->Submit();
+		tr.frontEndJobList->Wait();
+	}
+
+	viewSkinningBatch.Transform( r_useParallelAddModels.GetBool() ? tr.frontEndJobList : NULL );
+}
+
 /*
 =================
 R_LinkDrawSurfToView
@@ -1006,6 +1084,15 @@ void R_AddModels() {
 
 	tr.viewDef->viewEntitys = R_SortViewEntities( tr.viewDef->viewEntitys );
 
+	//-------------------------------------------------
+	// Instantiate the visible dynamic models up front so the
+	// MD5 joints can be transformed in batches.
+	//-------------------------------------------------
+
+	if ( r_useBatchedSkinning.GetBool() && r_useGPUSkinning.GetBool() ) {
+		R_InstantiateDynamicModels();
+	}
+
 	//-------------------------------------------------
 	// Go through each view entity that is either visible to the view, or to
 	// any light that intersects the view (for shadows).
@@ -43,10 +43,32 @@ static const unsigned int NUM_FRAME_DATA = 2;
 static const unsigned int FRAME_ALLOC_ALIGNMENT = 128;
 static const unsigned int MAX_FRAME_MEMORY = 64 * 1024 * 1024;	// larger so that we can noclip on PC for dev purposes
 
+// Each thread that allocates frame memory bumps through its own chunk of the
+// frame memory so the front end jobs don't all hammer the same interlocked integer.
+// Anything larger than FRAME_ARENA_MAX_ALLOC goes straight to the shared frame memory.
+static const int FRAME_ARENA_CHUNK_SIZE = 64 * 1024;
+static const int FRAME_ARENA_MAX_ALLOC = FRAME_ARENA_CHUNK_SIZE / 4;
+static const int MAX_FRAME_ARENAS = 64;
+
+compile_time_assert( ( FRAME_ARENA_CHUNK_SIZE % FRAME_ALLOC_ALIGNMENT ) == 0 );
+
+idCVar r_frameArenas( "r_frameArenas", "1", CVAR_RENDERER | CVAR_BOOL, "allocate frame memory from per thread chunks" );
+
 idFrameData		smpFrameData[NUM_FRAME_DATA];
 idFrameData *	frameData;
 unsigned int	smpFrame;
 
+struct ALIGNTYPE128 frameArena_t {
+	unsigned int	generation;		// frameAllocGeneration when the chunk was taken
+	byte *			current;
+	byte *			end;
+};
+
+static frameArena_t				frameArenas[MAX_FRAME_ARENAS];
+static idSysInterlockedInteger	numFrameArenas;
+static ID_TLS					frameArenaIndex;		// one based index in frameArenas for each thread
+static unsigned int				frameAllocGeneration;	// changed whenever the frame memory is reset
+
 //#define TRACK_FRAME_ALLOCS
 
 #if defined( TRACK_FRAME_ALLOCS )
@@ -80,6 +102,9 @@ void R_ToggleSmpFrame() {
 	frameData->frameMemoryAllocated.SetValue( bytesNeededForAlignment );
 	frameData->frameMemoryUsed.SetValue( 0 );
 
+	// all per thread chunks are from the previous frame now
+	frameAllocGeneration++;
+
 #if defined( TRACK_FRAME_ALLOCS )
 	for ( int i = 0; i < FRAME_ALLOC_MAX; i++ ) {
 		frameAllocTypeCount[i].SetValue( 0 );
@@ -123,6 +148,56 @@ void R_InitFrameData() {
 	R_ToggleSmpFrame();
 }
 
+/*
+================
+R_FrameAllocShared
+
+Bumps the frame memory shared by all threads.
+================
+*/
+static byte * R_FrameAllocShared( int bytes ) {
+	// thread safe add
+	int	end = frameData->frameMemoryAllocated.Add( bytes );
+	if ( end > MAX_FRAME_MEMORY ) {
+		idLib::Error( "R_FrameAlloc ran out of memory. bytes = %d, end = %d, highWaterAllocated = %d\n", bytes, end, frameData->highWaterAllocated );
+	}
+
+	return frameData->frameMemory + end - bytes;
+}
+
+/*
+================
+R_FrameAllocArena
+
+Bumps the calling thread's chunk of the frame memory and takes
+a new chunk from the shared frame memory when it runs out.
+Returns NULL if there are more threads than arenas.
+================
+*/
+static byte * R_FrameAllocArena( int bytes ) {
+	int index = (int)(ptrdiff_t)frameArenaIndex;
+	if ( index == 0 ) {
+		index = numFrameArenas.Increment();
+		if ( index > MAX_FRAME_ARENAS ) {
+			numFrameArenas.Decrement();
+			return NULL;
+		}
+		frameArenaIndex = (ptrdiff_t)index;
+	}
+
+	frameArena_t & arena = frameArenas[index - 1];
+	if ( arena.generation != frameAllocGeneration || arena.current + bytes > arena.end ) {
+		// the rest of the old chunk is wasted, it is never more than FRAME_ARENA_MAX_ALLOC
+		arena.current = R_FrameAllocShared( FRAME_ARENA_CHUNK_SIZE );
+		arena.end = arena.current + FRAME_ARENA_CHUNK_SIZE;
+		arena.generation = frameAllocGeneration;
+	}
+
+	byte * ptr = arena.current;
+	arena.current += bytes;
+	return ptr;
+}
+
 /*
 ================
 R_FrameAlloc
@@ -147,13 +222,13 @@ void *R_FrameAlloc( int bytes, frameAllocType_t type ) {
 
 	bytes = ( bytes + FRAME_ALLOC_ALIGNMENT - 1 ) & ~ ( FRAME_ALLOC_ALIGNMENT - 1 );
 
-	// thread safe add
-	int	end = frameData->frameMemoryAllocated.Add( bytes );
-	if ( end > MAX_FRAME_MEMORY ) {
-		idLib::Error( "R_FrameAlloc ran out of memory. bytes = %d, end = %d, highWaterAllocated = %d\n", bytes, end, frameData->highWaterAllocated );
+	byte * ptr = NULL;
+	if ( bytes <= FRAME_ARENA_MAX_ALLOC && r_frameArenas.GetBool() ) {
+		ptr = R_FrameAllocArena( bytes );
+	}
+	if ( ptr == NULL ) {
+		ptr = R_FrameAllocShared( bytes );
 	}
-
-	byte * ptr = frameData->frameMemory + end - bytes;
 
 	// cache line clear the memory
 	for ( int offset = 0; offset < bytes; offset += CACHE_LINE_SIZE ) {
@@ -173,6 +248,96 @@ void *R_ClearedFrameAlloc( int bytes, frameAllocType_t type ) {
 	return R_FrameAlloc( bytes, type );
 }
 
+/*
+==================
+R_FrameAllocTestJob
+==================
+*/
+struct frameAllocTest_t {
+	int		numAllocs;
+	int		seed;
+};
+
+static void R_FrameAllocTestJob( frameAllocTest_t * test ) {
+	// roughly the mix of view entities, interaction states and draw surfaces
+	static const int sizes[] = { sizeof( viewEntity_t ), sizeof( drawSurf_t ), sizeof( viewLight_t ), 48, 256, 96 };
+	for ( int i = 0; i < test->numAllocs; i++ ) {
+		R_FrameAlloc( sizes[( test->seed + i ) % ( sizeof( sizes ) / sizeof( sizes[0] ) )], FRAME_ALLOC_UNKNOWN );
+	}
+}
+REGISTER_PARALLEL_JOB( R_FrameAllocTestJob, "R_FrameAllocTestJob" );
+
+/*
+==================
+testFrameAlloc
+
+Runs batches of small frame allocations on an increasing number of job threads
+with and without the per thread chunks. This swaps in its own frame memory so it
+never touches the frame that is being built.
+==================
+*/
+CONSOLE_COMMAND( testFrameAlloc, "measures frame memory allocation throughput for an increasing number of threads, usage: testFrameAlloc [allocsPerBatch] [numBatches]", 0 ) {
+	const int numAllocs = ( args.Argc() > 1 ) ? idMath::ClampInt( 1024, 200000, atoi( args.Argv( 1 ) ) ) : 100000;
+	const int numBatches = ( args.Argc() > 2 ) ? Max( 1, atoi( args.Argv( 2 ) ) ) : 20;
+	const int jobsPerThread = 4;
+	const int maxThreads = parallelJobManager->GetNumProcessingUnits();
+
+	idFrameData testFrameData;
+	testFrameData.frameMemory = (byte *) Mem_Alloc16( MAX_FRAME_MEMORY, TAG_RENDER );
+	testFrameData.highWaterAllocated = 0;
+	testFrameData.highWaterUsed = 0;
+	testFrameData.cmdHead = testFrameData.cmdTail = NULL;
+
+	idFrameData * oldFrameData = frameData;
+	const bool oldFrameArenas = r_frameArenas.GetBool();
+	frameData = &testFrameData;
+
+	idList< frameAllocTest_t, TAG_RENDER > tests;
+	tests.SetNum( Max( 1, maxThreads ) * jobsPerThread );
+
+	idParallelJobList * jobList = parallelJobManager->AllocJobList( JOBLIST_UTILITY, JOBLIST_PRIORITY_MEDIUM, tests.Num(), 0, NULL );
+
+	common->Printf( "%d allocations per batch, %d batches\n", numAllocs, numBatches );
+	common->Printf( "threads     shared    arenas  (million allocs per second)\n" );
+
+	for ( int numThreads = 1; numThreads <= Max( 1, maxThreads ); numThreads *= 2 ) {
+		const int numJobs = numThreads * jobsPerThread;
+		for ( int i = 0; i < numJobs; i++ ) {
+			tests[i].numAllocs = numAllocs / numJobs;
+			tests[i].seed = i;
+		}
+
+		float rate[2];
+		for ( int mode = 0; mode < 2; mode++ ) {
+			r_frameArenas.SetBool( mode != 0 );
+
+			uint64 total = 0;
+			for ( int batch = 0; batch < numBatches; batch++ ) {
+				testFrameData.frameMemoryAllocated.SetValue( FRAME_ALLOC_ALIGNMENT - ( (unsigned int)testFrameData.frameMemory & ( FRAME_ALLOC_ALIGNMENT - 1 ) ) );
+				frameAllocGeneration++;
+
+				for ( int i = 0; i < numJobs; i++ ) {
+					jobList->AddJob( (jobRun_t)R_FrameAllocTestJob, &tests[i] );
+				}
+				const uint64 start = Sys_Microseconds();
+				jobList->Submit( NULL, numThreads );
+				jobList->Wait();
+				total += Sys_Microseconds() - start;
+			}
+			rate[mode] = (float)( numJobs * tests[0].numAllocs ) * numBatches / Max( total, (uint64)1 );
+		}
+		common->Printf( "%7d %10.2f %9.2f\n", numThreads, rate[0], rate[1] );
+	}
+
+	parallelJobManager->FreeJobList( jobList );
+
+	r_frameArenas.SetBool( oldFrameArenas );
+	frameData = oldFrameData;
+	frameAllocGeneration++;
+
+	Mem_Free16( testFrameData.frameMemory );
+}
+
 /*
 ==========================================================================================
 
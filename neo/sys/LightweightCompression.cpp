@@ -38,6 +38,28 @@ static int HashIndex( int w, int k ) {
 	return ( w ^ k ) & idLZWCompressor::HASH_MASK;
 }
 
+static const int	RANGE_PROB_BITS	= 11;
+static const int	RANGE_PROB_ONE	= 1 << RANGE_PROB_BITS;
+static const int	RANGE_MOVE_BITS	= 5;					// How fast the bit probabilities adapt
+static const uint32	RANGE_TOP		= 1 << 24;
+
+/*
+========================
+RangeContext
+Zero runs, small values and small negative values each get their own probabilities
+========================
+*/
+static int RangeContext( uint8 prevByte ) {
+	if ( prevByte == 0 ) {
+		return 0;		// zrle run length or the high byte of a small value
+	} else if ( prevByte < 0x10 ) {
+		return 1;
+	} else if ( prevByte >= 0xF0 ) {
+		return 2;
+	}
+	return 3;
+}
+
 /*
 ========================
 idLZWCompressor::Start
@@ -47,7 +69,9 @@ void idLZWCompressor::Start( uint8 * data_, int maxSize_, bool append ) {
 	// Clear hash
 	ClearHash();
 	
-	if ( append ) {
+	if ( codec == LZW_CODEC_RANGE ) {
+		StartRange( append );
+	} else if ( append ) {
 		assert( lzwData->nextCode > LZW_FIRST_CODE );
 		
 		int originalNextCode = lzwData->nextCode;
@@ -90,6 +114,40 @@ void idLZWCompressor::Start( uint8 * data_, int maxSize_, bool append ) {
 	saveCodeBits		= 0;
 	savedTempValue		= 0;
 	savedTempBits		= 0;
+	savedRangeLow		= 0;
+	savedRange			= 0;
+	savedRangeCacheSize	= 0;
+	savedRangeCache		= 0;
+	savedRangeBytes		= 0;
+}
+
+/*
+========================
+idLZWCompressor::StartRange
+========================
+*/
+void idLZWCompressor::StartRange( bool append ) {
+	if ( append ) {
+		return;		// Everything the coder needs to continue is in lzwData
+	}
+
+	for ( int i = 0; i < lzwCompressionData_t::RANGE_CONTEXTS; i++ ) {
+		for ( int j = 0; j < 256; j++ ) {
+			lzwData->rangeProbs[i][j] = RANGE_PROB_ONE / 2;
+		}
+	}
+
+	lzwData->rangeLow		= 0;
+	lzwData->range			= 0xFFFFFFFF;
+	lzwData->rangeCode		= 0;
+	lzwData->rangeCacheSize	= 1;
+	lzwData->rangeCache		= 0;
+	lzwData->rangePrevByte	= 0;
+	lzwData->rangeBytes		= 0;
+
+	// The first byte out of the coder is always zero, and the reader shifts it straight back out,
+	// so it goes in the last byte of the header which End then overwrites
+	lzwData->bytesWritten	= RANGE_HEADER_SIZE - 1;
 }
 
 /*
@@ -214,6 +272,10 @@ idLZWCompressor::ReadByte
 ========================
 */
 int idLZWCompressor::ReadByte( bool ignoreOverflow ) {
+	if ( codec == LZW_CODEC_RANGE ) {
+		return ReadByteRange( ignoreOverflow );
+	}
+
 	if ( blockIndex == blockSize ) {
 		DecompressBlock();
 	}
@@ -229,6 +291,66 @@ int idLZWCompressor::ReadByte( bool ignoreOverflow ) {
 	return block[blockIndex++];
 }
 
+/*
+========================
+idLZWCompressor::ReadByteRange
+========================
+*/
+int idLZWCompressor::ReadByteRange( bool ignoreOverflow ) {
+	if ( bytesRead == 0 ) {
+		// Get the byte count, then prime the code with the coder's first five bytes (see StartRange)
+		lzwData->rangeBytes = ( maxSize >= RANGE_HEADER_SIZE ) ? ( data[0] | ( data[1] << 8 ) ) : 0;
+		bytesRead = RANGE_HEADER_SIZE - 1;
+		for ( int i = 0; i < 5; i++ ) {
+			lzwData->rangeCode = ( lzwData->rangeCode << 8 ) | ( bytesRead < maxSize ? data[bytesRead] : 0 );
+			bytesRead++;
+		}
+	}
+
+	if ( lzwData->rangeBytes == 0 ) {
+		if ( !ignoreOverflow ) {
+			overflowed = true;
+			assert( !"idLZWCompressor::ReadByte overflowed!" );
+		}
+		return -1;
+	}
+
+	lzwData->rangeBytes--;
+
+	uint16 * probs = lzwData->rangeProbs[RangeContext( lzwData->rangePrevByte )];
+
+	// Work on locals, stores through data could otherwise alias lzwData
+	uint32 range = lzwData->range;
+	uint32 code = lzwData->rangeCode;
+
+	int node = 1;
+	while ( node < 256 ) {
+		uint32 bound = ( range >> RANGE_PROB_BITS ) * probs[node];
+		if ( code < bound ) {
+			range = bound;
+			probs[node] += ( RANGE_PROB_ONE - probs[node] ) >> RANGE_MOVE_BITS;
+			node = node << 1;
+		} else {
+			code -= bound;
+			range -= bound;
+			probs[node] -= probs[node] >> RANGE_MOVE_BITS;
+			node = ( node << 1 ) | 1;
+		}
+		if ( range < RANGE_TOP ) {
+			// The writer doesn't flush the trailing zero bytes, so reading past the end is expected
+			range <<= 8;
+			code = ( code << 8 ) | ( bytesRead < maxSize ? data[bytesRead] : 0 );
+			bytesRead++;
+		}
+	}
+
+	lzwData->range = range;
+	lzwData->rangeCode = code;
+	lzwData->rangePrevByte = (uint8)node;
+	
+	return (uint8)node;
+}
+
 
 /*
 ========================
@@ -236,6 +358,11 @@ idLZWCompressor::WriteByte
 ========================
 */
 void idLZWCompressor::WriteByte( uint8 value ) {
+	if ( codec == LZW_CODEC_RANGE ) {
+		WriteByteRange( value );
+		return;
+	}
+
 	int code = Lookup( lzwData->codeWord, value );
 	if ( code >= 0 ) {
 		lzwData->codeWord = code;
@@ -253,6 +380,76 @@ void idLZWCompressor::WriteByte( uint8 value ) {
 	}
 }
 
+/*
+========================
+idLZWCompressor::WriteByteRange
+========================
+*/
+void idLZWCompressor::WriteByteRange( uint8 value ) {
+	uint16 * probs = lzwData->rangeProbs[RangeContext( lzwData->rangePrevByte )];
+
+	// Work on locals, ShiftLowRange stores through data which could otherwise alias lzwData
+	uint32 range = lzwData->range;
+	uint64 low = lzwData->rangeLow;
+
+	int node = 1;
+	for ( int i = 7; i >= 0; i-- ) {
+		int bit = ( value >> i ) & 1;
+		uint32 bound = ( range >> RANGE_PROB_BITS ) * probs[node];
+		if ( bit == 0 ) {
+			range = bound;
+			probs[node] += ( RANGE_PROB_ONE - probs[node] ) >> RANGE_MOVE_BITS;
+		} else {
+			low += bound;
+			range -= bound;
+			probs[node] -= probs[node] >> RANGE_MOVE_BITS;
+		}
+		if ( range < RANGE_TOP ) {
+			range <<= 8;
+			lzwData->rangeLow = low;
+			ShiftLowRange();
+			low = lzwData->rangeLow;
+		}
+		node = ( node << 1 ) | bit;
+	}
+
+	lzwData->range = range;
+	lzwData->rangeLow = low;
+	lzwData->rangePrevByte = value;
+	lzwData->rangeBytes++;
+
+	if ( lzwData->rangeBytes >= RANGE_MAX_BYTES || lzwData->bytesWritten >= maxSize - ( lzwData->rangeCacheSize + RANGE_FLUSH_SIZE ) ) {
+		overflowed = true;	// At any point, if we can't perform an End call, then trigger an overflow
+		return;
+	}
+}
+
+/*
+========================
+idLZWCompressor::ShiftLowRange
+
+Moves the top byte of low out.  Bytes that a carry could still change are held back
+in rangeCache/rangeCacheSize, so everything before bytesWritten is final.
+========================
+*/
+void idLZWCompressor::ShiftLowRange() {
+	if ( (uint32)lzwData->rangeLow < 0xFF000000 || ( lzwData->rangeLow >> 32 ) != 0 ) {
+		uint8 carry = (uint8)( lzwData->rangeLow >> 32 );
+		uint8 temp = lzwData->rangeCache;
+		do {
+			if ( lzwData->bytesWritten >= maxSize ) {
+				overflowed = true;
+			} else {
+				data[lzwData->bytesWritten++] = (uint8)( temp + carry );
+			}
+			temp = 0xFF;
+		} while ( --lzwData->rangeCacheSize != 0 );
+		lzwData->rangeCache = (uint8)( lzwData->rangeLow >> 24 );
+	}
+	lzwData->rangeCacheSize++;
+	lzwData->rangeLow = ( lzwData->rangeLow & 0x00FFFFFF ) << 8;
+}
+
 /*
 ========================
 idLZWCompressor::Lookup 
@@ -319,6 +516,10 @@ idLZWCompressor::End
 ========================
 */
 int idLZWCompressor::End() {
+	if ( codec == LZW_CODEC_RANGE ) {
+		return EndRange();
+	}
+
 	assert( lzwData->tempBits < 8 );
 	assert( lzwData->bytesWritten < maxSize - ( lzwData->codeBits + lzwData->tempBits + 7 ) / 8 );
 
@@ -339,6 +540,30 @@ int idLZWCompressor::End() {
 	return Length() > 0 ? Length() : -1;		// Total bytes written (or failure)
 }
 
+/*
+========================
+idLZWCompressor::EndRange
+========================
+*/
+int idLZWCompressor::EndRange() {
+	if ( lzwData->bytesWritten > maxSize - ( lzwData->rangeCacheSize + RANGE_FLUSH_SIZE ) ) {
+		overflowed = true;
+		return -1;
+	}
+
+	// Any value in [low, low + range) reads back the same bytes.  Range is at least RANGE_TOP, so there is
+	// always one ending in three zero bytes, and those are left for the reader to fill in.
+	lzwData->rangeLow = ( lzwData->rangeLow + RANGE_TOP - 1 ) & ~(uint64)( RANGE_TOP - 1 );
+	ShiftLowRange();
+	ShiftLowRange();
+
+	assert( lzwData->rangeBytes <= RANGE_MAX_BYTES );
+	data[0] = (uint8)( lzwData->rangeBytes & 255 );
+	data[1] = (uint8)( lzwData->rangeBytes >> 8 );
+
+	return Length();
+}
+
 /*
 ========================
 idLZWCompressor::Save
@@ -347,13 +572,19 @@ idLZWCompressor::Save
 void idLZWCompressor::Save() { 
 	assert( !overflowed );
 	// Check and make sure we are at a good spot (can call End)
-	assert( lzwData->bytesWritten < maxSize - ( lzwData->codeBits + lzwData->tempBits + 7 ) / 8 );
+	assert( codec == LZW_CODEC_RANGE || lzwData->bytesWritten < maxSize - ( lzwData->codeBits + lzwData->tempBits + 7 ) / 8 );
+	assert( codec != LZW_CODEC_RANGE || lzwData->bytesWritten < maxSize - ( lzwData->rangeCacheSize + RANGE_FLUSH_SIZE ) );
 
 	savedBytesWritten	= lzwData->bytesWritten;
 	savedCodeWord		= lzwData->codeWord;
 	saveCodeBits		= lzwData->codeBits;
 	savedTempValue		= lzwData->tempValue;
 	savedTempBits		= lzwData->tempBits;
+	savedRangeLow		= lzwData->rangeLow;
+	savedRange			= lzwData->range;
+	savedRangeCacheSize	= lzwData->rangeCacheSize;
+	savedRangeCache		= lzwData->rangeCache;
+	savedRangeBytes		= lzwData->rangeBytes;
 }
 
 /*
@@ -367,6 +598,11 @@ void idLZWCompressor::Restore() {
 	lzwData->codeBits		= saveCodeBits;
 	lzwData->tempValue		= savedTempValue;
 	lzwData->tempBits		= savedTempBits;
+	lzwData->rangeLow		= savedRangeLow;
+	lzwData->range			= savedRange;
+	lzwData->rangeCacheSize	= savedRangeCacheSize;
+	lzwData->rangeCache		= savedRangeCache;
+	lzwData->rangeBytes		= savedRangeBytes;
 }
 
 /*
@@ -28,6 +28,12 @@ If you have questions concerning this license or the applicable additional terms
 #ifndef __LIGHTWEIGHT_COMPRESSION_H__
 #define __LIGHTWEIGHT_COMPRESSION_H__
 
+// Codecs an idLZWCompressor can run. Both share the same byte interface and Save/Restore rules.
+enum lzwCodec_t {
+	LZW_CODEC_LZW,				// Dictionary coder
+	LZW_CODEC_RANGE,			// Adaptive binary range coder with a small previous byte context
+	LZW_CODEC_MAX
+};
 		
 struct lzwCompressionData_t {
 	static const int	LZW_DICT_BITS	= 12;
@@ -44,6 +50,18 @@ struct lzwCompressionData_t {
 	uint64					tempValue;
 	int						tempBits;
 	int						bytesWritten;
+
+	// LZW_CODEC_RANGE state, kept here so an appended Start can pick up where the last one left off
+	static const int	RANGE_CONTEXTS	= 4;
+
+	uint16					rangeProbs[RANGE_CONTEXTS][256];
+	uint64					rangeLow;
+	uint32					range;
+	uint32					rangeCode;				// Reading only
+	int						rangeCacheSize;
+	uint8					rangeCache;
+	uint8					rangePrevByte;
+	int						rangeBytes;				// Bytes put through the coder, End writes this in front of the stream
 };
 
 /*
@@ -54,12 +72,16 @@ Simple lzw based encoder/decoder
 */
 class idLZWCompressor {
 public:
-	idLZWCompressor( lzwCompressionData_t * lzwData_ ) : lzwData( lzwData_ ) {}
+	idLZWCompressor( lzwCompressionData_t * lzwData_, int codec_ = LZW_CODEC_LZW ) : lzwData( lzwData_ ), codec( codec_ ) {}
 
 	static const int	LZW_BLOCK_SIZE	= ( 1 << 15 );
 	static const int	LZW_START_BITS	= 9;
 	static const int	LZW_FIRST_CODE	= ( 1 << ( LZW_START_BITS - 1 ) );
 
+	static const int	RANGE_HEADER_SIZE	= 2;		// uint16 byte count in front of a range coded stream
+	static const int	RANGE_FLUSH_SIZE	= 4;		// Bytes End needs on top of the pending carry bytes
+	static const int	RANGE_MAX_BYTES		= 0xFFFF;
+
 	void	Start( uint8 * data_, int maxSize, bool append = false );
 	int		ReadBits( int bits );
 	int		WriteChain( int code );
@@ -79,6 +101,8 @@ public:
 	void	Restore();
 
 	bool	IsOverflowed() { return overflowed; }
+
+	int		GetCodec() const { return codec; }
 	
 	int		Write( const void * data, int length ) {
 		uint8 * src = (uint8*)data;
@@ -106,6 +130,16 @@ public:
 		return length;
 	}
 
+	int		Skip( int length, bool ignoreOverflow = false ) {
+		for ( int i = 0; i < length; i++ ) {
+			if ( ReadByte( ignoreOverflow ) == -1 ) {
+				return i;
+			}
+		}
+		
+		return length;
+	}
+
 	int		WriteR( const void * data, int length ) {
 		uint8 * src = (uint8*)data;
 		
@@ -147,8 +181,15 @@ public:
 	
 private:
 	void ClearHash();
+
+	void	StartRange( bool append );
+	int		ReadByteRange( bool ignoreOverflow );
+	void	WriteByteRange( uint8 value );
+	void	ShiftLowRange();
+	int		EndRange();
 		
 	lzwCompressionData_t *	lzwData;
+	int						codec;		// lzwCodec_t
 	uint16					hash[MAX_DICTIONARY_HASH];
 	uint16					nextHash[lzwCompressionData_t::LZW_DICT_SIZE];
 	
@@ -172,6 +213,11 @@ private:
 	int					saveCodeBits;
 	uint64				savedTempValue;
 	int					savedTempBits;
+	uint64				savedRangeLow;
+	uint32				savedRange;
+	int					savedRangeCacheSize;
+	uint8				savedRangeCache;
+	int					savedRangeBytes;
 };
 
 /*
@@ -54,7 +54,7 @@ void idPacketProcessor::QueueReliableAck( int lastReliable ) {
 idPacketProcessor::FinalizeRead
 ================================================
 */
-int idPacketProcessor::FinalizeRead( idBitMsg & inMsg, idBitMsg & outMsg, int & userValue ) {
+int idPacketProcessor::FinalizeRead( idBitMsg & inMsg, idBitMsg & outMsg, int & userValue, bool inPlace ) {
 	userValue = 0;
 	
 	idInnerPacketHeader header;	
@@ -105,13 +105,11 @@ int idPacketProcessor::FinalizeRead( idBitMsg & inMsg, idBitMsg & outMsg, int &
 			lzwCompressor.ReadAgnostic< int >( reliableSequence );
 
 			for ( int r = 0; r < numReliableRecv; r++ ) {
-				uint8 uncompMem[ MAX_MSG_SIZE ];
-
 				uint16 reliableDataLength = 0;
 				lzwCompressor.ReadAgnostic< uint16 >( reliableDataLength );
-				lzwCompressor.Read( uncompMem, reliableDataLength );
 
 				if ( reliableSequence + r > reliableSequenceRecv ) {		// Only accept newer reliable msg's than we've currently already received
+					// Decompress straight into the reliable buffer
 					if ( !verify( bufferPos + reliableDataLength <= sizeof( reliableBuffer ) ) ) {
 						idLib::Printf( "Reliable msg size overflow.\n" );
 						return RETURN_TYPE_NONE;
@@ -120,11 +118,13 @@ int idPacketProcessor::FinalizeRead( idBitMsg & inMsg, idBitMsg & outMsg, int &
 						idLib::Printf( "Reliable msg count overflow.\n" );
 						return RETURN_TYPE_NONE;
 					}
-					memcpy( reliableBuffer + bufferPos, uncompMem, reliableDataLength );
+					lzwCompressor.Read( reliableBuffer + bufferPos, reliableDataLength );
 					reliableMsgSize[ numReliable ] = reliableDataLength;
 					reliableMsgPtrs[ numReliable++ ] = &reliableBuffer[ bufferPos ];
 					bufferPos += reliableDataLength;					
 				} else {
+					// Resent msg's we already have don't take up any of the reliable buffer
+					lzwCompressor.Skip( reliableDataLength );
 					extern idCVar net_verboseReliable;
 					if ( net_verboseReliable.GetBool() ) {
 						idLib::Printf( "Ignoring reliable msg %i because %i was already acked\n", ( reliableSequence + r ), reliableSequenceRecv );
@@ -144,9 +144,13 @@ int idPacketProcessor::FinalizeRead( idBitMsg & inMsg, idBitMsg & outMsg, int &
 	}
 	
 	// Load actual msg
-	outMsg.BeginWriting();
-	outMsg.WriteData( inMsg.GetReadData() + inMsg.GetReadCount(), inMsg.GetRemainingData() );
-	outMsg.SetSize( inMsg.GetRemainingData() );
+	if ( inPlace ) {
+		outMsg.InitRead( inMsg.GetReadData() + inMsg.GetReadCount(), inMsg.GetRemainingData() );
+	} else {
+		outMsg.BeginWriting();
+		outMsg.WriteData( inMsg.GetReadData() + inMsg.GetReadCount(), inMsg.GetRemainingData() );
+		outMsg.SetSize( inMsg.GetRemainingData() );
+	}
 	
 	return ( header.Type() == PACKET_TYPE_OOB ) ? RETURN_TYPE_OOB : RETURN_TYPE_INBAND;
 }
@@ -384,12 +388,30 @@ bool idPacketProcessor::GetSendFragment( const int time, sessionId_t sessionID,
 	return true;
 }
 
+/*
+================================================
+idPacketProcessor::GetSendFragments
+================================================
+*/
+int idPacketProcessor::GetSendFragments( const int time, sessionId_t sessionID, idPacketBatch & batch, int peer, int maxFragments ) {
+	int numFragments = 0;
+	while ( numFragments < maxFragments && HasMoreFragments() && !batch.IsFull() ) {
+		idPacketBatch::packet_t & packet = batch.Alloc();
+		idBitMsg msg( packet.data, sizeof( packet.data ) );
+		GetSendFragment( time, sessionID, msg );
+		packet.peer = peer;
+		packet.size = msg.GetSize();
+		numFragments++;
+	}
+	return numFragments;
+}
+
 /*
 ================================================
 idPacketProcessor::ProcessIncoming
 ================================================
 */
-int idPacketProcessor::ProcessIncoming( int time, sessionId_t expectedSessionID, idBitMsg & msg, idBitMsg & out, int & userData, const int peerNum ) {
+int idPacketProcessor::ProcessIncoming( int time, sessionId_t expectedSessionID, idBitMsg & msg, idBitMsg & out, int & userData, const int peerNum, bool inPlace ) {
 	assert( msg.GetSize() <= MAX_FINAL_PACKET_SIZE );
 	
 	UpdateIncomingRate( time, msg.GetSize() );
@@ -420,7 +442,7 @@ int idPacketProcessor::ProcessIncoming( int time, sessionId_t expectedSessionID,
 	if ( header.Type() != PACKET_TYPE_FRAGMENTED ) {
 		// Non fragmented
 		msg.RestoreReadState( c, b );		// Reset since we took a byte to check the type
-		return FinalizeRead( msg, out, userData );
+		return FinalizeRead( msg, out, userData, inPlace );
 	} 
 
 	// Decode fragmented packet
@@ -450,7 +472,7 @@ int idPacketProcessor::ProcessIncoming( int time, sessionId_t expectedSessionID,
 		// Done reconstructing the msg
 		idBitMsg msg( msgBuffer, sizeof( msgBuffer ) );
 		msg.SetSize( msgWritePos );
-		return FinalizeRead( msg, out, userData );
+		return FinalizeRead( msg, out, userData, inPlace );
 	}
 		
 	if ( !verify( header.Value() == FRAGMENT_START || header.Value() == FRAGMENT_MIDDLE ) ) {
@@ -588,3 +610,354 @@ void idPacketProcessor::VerifyEmptyReliableQueue( byte keepMsgBelowThis, byte re
 
 	reliable = clean;
 }
+
+/*
+================================================
+idPacketLoopback
+================================================
+*/
+
+/*
+========================
+idPacketLoopback::idPacketLoopback
+========================
+*/
+idPacketLoopback::idPacketLoopback() :
+	first( 0 ),
+	numQueued( 0 ),
+	dropRate( 0.0f ) {
+	queue.SetNum( MAX_QUEUED_PACKETS );
+}
+
+/*
+========================
+idPacketLoopback::SendPacket
+Returns false if the queue is full, a packet that is dropped on purpose counts as sent
+========================
+*/
+bool idPacketLoopback::SendPacket( int peer, const void * data, int size ) {
+	if ( numQueued >= queue.Num() || !verify( size <= idPacketProcessor::MAX_FINAL_PACKET_SIZE ) ) {
+		return false;
+	}
+	if ( dropRate > 0.0f && random.RandomFloat() < dropRate ) {
+		return true;
+	}
+	idPacketBatch::packet_t & packet = queue[ ( first + numQueued ) % queue.Num() ];
+	packet.peer = peer;
+	packet.size = size;
+	memcpy( packet.data, data, size );
+	numQueued++;
+	return true;
+}
+
+/*
+========================
+idPacketLoopback::ReceivePacket
+========================
+*/
+bool idPacketLoopback::ReceivePacket( int & peer, void * data, int & size, int maxSize ) {
+	if ( numQueued == 0 ) {
+		return false;
+	}
+	const idPacketBatch::packet_t & packet = queue[ first ];
+	assert( packet.size <= maxSize );
+	peer = packet.peer;
+	size = packet.size;
+	memcpy( data, packet.data, packet.size );
+	first = ( first + 1 ) % queue.Num();
+	numQueued--;
+	return true;
+}
+
+/*
+========================
+idPacketLoopback::SendPackets
+========================
+*/
+int idPacketLoopback::SendPackets( const idPacketBatch & batch ) {
+	int numSent = 0;
+	for ( int i = 0; i < batch.Num(); i++ ) {
+		if ( !SendPacket( batch[i].peer, batch[i].data, batch[i].size ) ) {
+			break;
+		}
+		numSent++;
+	}
+	return numSent;
+}
+
+/*
+========================
+idPacketLoopback::ReceivePackets
+========================
+*/
+int idPacketLoopback::ReceivePackets( idPacketBatch & batch ) {
+	int numReceived = 0;
+	while ( numQueued > 0 && !batch.IsFull() ) {
+		idPacketBatch::packet_t & packet = batch.Alloc();
+		ReceivePacket( packet.peer, packet.data, packet.size, sizeof( packet.data ) );
+		numReceived++;
+	}
+	return numReceived;
+}
+
+/*
+================================================
+Packet path load test
+================================================
+*/
+
+struct packetTestStats_t {
+	int		numPackets;
+	int64	numBytes;
+	uint64	sendTime;
+	uint64	recvTime;
+	int		numMsgs;
+	int		numReliables;
+	int		numErrors;
+};
+
+/*
+========================
+RunPacketTest
+
+The host sends every peer a msg each frame, some big enough to fragment, and a reliable every 8
+frames. Each peer answers with a small msg that acks the reliables. With batched the packets go
+through idPacketBatch and are read in place, otherwise one at a time like idLobby does.
+========================
+*/
+static void RunPacketTest( int numPeers, int numFrames, float dropRate, bool batched, packetTestStats_t & stats ) {
+	const idPacketProcessor::sessionId_t sessionID = ( 1 << idPacketProcessor::NUM_LOBBY_TYPE_BITS ) | idPacketProcessor::SESSION_ID_CONNECTIONLESS_GAME_STATE;
+	const int maxPayload = 2400;
+
+	memset( &stats, 0, sizeof( stats ) );
+
+	idList< idPacketProcessor * > hostProcs;
+	idList< idPacketProcessor * > clientProcs;
+	idList< int > reliablesSent;
+	idList< int > reliablesReceived;
+	hostProcs.SetNum( numPeers );
+	clientProcs.SetNum( numPeers );
+	reliablesSent.SetNum( numPeers );
+	reliablesReceived.SetNum( numPeers );
+	for ( int p = 0; p < numPeers; p++ ) {
+		hostProcs[p] = new ( TAG_NETWORKING ) idPacketProcessor();
+		clientProcs[p] = new ( TAG_NETWORKING ) idPacketProcessor();
+		reliablesSent[p] = 0;
+		reliablesReceived[p] = 0;
+	}
+
+	idPacketLoopback * toClients = new ( TAG_NETWORKING ) idPacketLoopback();
+	idPacketLoopback * toHost = new ( TAG_NETWORKING ) idPacketLoopback();
+	idPacketBatch * batch = new ( TAG_NETWORKING ) idPacketBatch();
+	toClients->SetDropRate( dropRate );
+	toHost->SetDropRate( dropRate );
+
+	byte payload[ maxPayload ];
+	for ( int i = 0; i < maxPayload; i++ ) {
+		payload[i] = (byte)i;
+	}
+	byte reply[ 16 ];
+	memset( reply, 0, sizeof( reply ) );
+
+	idRandom random( 0x7e57 );
+
+	for ( int frame = 0; frame < numFrames; frame++ ) {
+		const int time = frame * 16;
+
+		// host sends to every peer
+		uint64 start = Sys_Microseconds();
+		for ( int p = 0; p < numPeers; p++ ) {
+			idPacketProcessor & proc = *hostProcs[p];
+			if ( ( frame & 7 ) == ( p & 7 ) ) {
+				int counter = reliablesSent[p] + 1;
+				if ( proc.QueueReliableMessage( 0, (const byte *)&counter, sizeof( counter ) ) ) {
+					reliablesSent[p] = counter;
+				}
+			}
+
+			const int size = 9 + random.RandomInt( maxPayload - 9 );
+			memcpy( payload, &frame, sizeof( frame ) );
+			memcpy( payload + 4, &p, sizeof( p ) );
+			idBitMsg msg( (const byte *)payload, size );
+			proc.ProcessOutgoing( time, msg, false, 0 );
+
+			if ( batched ) {
+				while ( proc.HasMoreFragments() ) {
+					if ( batch->IsFull() ) {
+						toClients->SendPackets( *batch );
+						batch->Clear();
+					}
+					stats.numPackets += proc.GetSendFragments( time, sessionID, *batch, p );
+				}
+			} else {
+				while ( proc.HasMoreFragments() ) {
+					byte buffer[ idPacketProcessor::MAX_FINAL_PACKET_SIZE ];
+					idBitMsg fragment;
+					fragment.InitWrite( buffer, sizeof( buffer ) );
+					proc.GetSendFragment( time, sessionID, fragment );
+					toClients->SendPacket( p, buffer, fragment.GetSize() );
+					stats.numPackets++;
+				}
+			}
+		}
+		if ( batched ) {
+			toClients->SendPackets( *batch );
+			batch->Clear();
+		}
+		stats.sendTime += Sys_Microseconds() - start;
+
+		// peers receive, check what arrived
+		start = Sys_Microseconds();
+		while ( toClients->NumQueued() > 0 ) {
+			if ( batched ) {
+				batch->Clear();
+				toClients->ReceivePackets( *batch );
+			}
+			const int numPackets = batched ? batch->Num() : 1;
+			for ( int i = 0; i < numPackets; i++ ) {
+				byte buffer[ idPacketProcessor::MAX_FINAL_PACKET_SIZE ];
+				byte msgBuffer[ idPacketProcessor::MAX_MSG_SIZE ];
+				idBitMsg fragment;
+				idBitMsg msg;
+				int p = 0;
+				if ( batched ) {
+					p = (*batch)[i].peer;
+					fragment.InitRead( (*batch)[i].data, (*batch)[i].size );
+				} else {
+					int size = 0;
+					toClients->ReceivePacket( p, buffer, size, sizeof( buffer ) );
+					fragment.InitRead( buffer, size );
+					msg.InitWrite( msgBuffer, sizeof( msgBuffer ) );
+				}
+
+				int userData = 0;
+				idPacketProcessor & proc = *clientProcs[p];
+				if ( proc.ProcessIncoming( time, sessionID, fragment, msg, userData, p, batched ) != idPacketProcessor::RETURN_TYPE_INBAND ) {
+					continue;
+				}
+				for ( int r = 0; r < proc.GetNumReliables(); r++ ) {
+					int counter = 0;
+					memcpy( &counter, proc.GetReliable( r ) + 1, sizeof( counter ) );
+					if ( proc.GetReliableSize( r ) != 1 + sizeof( counter ) || counter != reliablesReceived[p] + 1 ) {
+						stats.numErrors++;
+					}
+					reliablesReceived[p] = counter;
+					stats.numReliables++;
+				}
+				const byte * data = msg.GetReadData();
+				int msgPeer = -1;
+				if ( msg.GetSize() > 8 ) {
+					memcpy( &msgPeer, data + 4, sizeof( msgPeer ) );
+				}
+				if ( msgPeer != p || data[ msg.GetSize() - 1 ] != (byte)( msg.GetSize() - 1 ) ) {
+					stats.numErrors++;
+				}
+				stats.numMsgs++;
+			}
+		}
+		batch->Clear();
+		stats.recvTime += Sys_Microseconds() - start;
+
+		// peers answer, which acks the reliables
+		start = Sys_Microseconds();
+		for ( int p = 0; p < numPeers; p++ ) {
+			idPacketProcessor & proc = *clientProcs[p];
+			idBitMsg msg( (const byte *)reply, sizeof( reply ) );
+			proc.ProcessOutgoing( time, msg, false, 0 );
+			if ( batched ) {
+				if ( batch->IsFull() ) {
+					toHost->SendPackets( *batch );
+					batch->Clear();
+				}
+				stats.numPackets += proc.GetSendFragments( time, sessionID, *batch, p );
+			} else {
+				byte buffer[ idPacketProcessor::MAX_FINAL_PACKET_SIZE ];
+				idBitMsg fragment;
+				fragment.InitWrite( buffer, sizeof( buffer ) );
+				proc.GetSendFragment( time, sessionID, fragment );
+				toHost->SendPacket( p, buffer, fragment.GetSize() );
+				stats.numPackets++;
+			}
+		}
+		if ( batched ) {
+			toHost->SendPackets( *batch );
+			batch->Clear();
+		}
+		stats.sendTime += Sys_Microseconds() - start;
+
+		// host receives the answers
+		start = Sys_Microseconds();
+		while ( toHost->NumQueued() > 0 ) {
+			if ( batched ) {
+				batch->Clear();
+				toHost->ReceivePackets( *batch );
+			}
+			const int numPackets = batched ? batch->Num() : 1;
+			for ( int i = 0; i < numPackets; i++ ) {
+				byte buffer[ idPacketProcessor::MAX_FINAL_PACKET_SIZE ];
+				byte msgBuffer[ idPacketProcessor::MAX_MSG_SIZE ];
+				idBitMsg fragment;
+				idBitMsg msg;
+				int p = 0;
+				if ( batched ) {
+					p = (*batch)[i].peer;
+					fragment.InitRead( (*batch)[i].data, (*batch)[i].size );
+				} else {
+					int size = 0;
+					toHost->ReceivePacket( p, buffer, size, sizeof( buffer ) );
+					fragment.InitRead( buffer, size );
+					msg.InitWrite( msgBuffer, sizeof( msgBuffer ) );
+				}
+				int userData = 0;
+				hostProcs[p]->ProcessIncoming( time, sessionID, fragment, msg, userData, p, batched );
+			}
+		}
+		batch->Clear();
+		stats.recvTime += Sys_Microseconds() - start;
+	}
+
+	stats.numBytes = 0;
+	for ( int p = 0; p < numPeers; p++ ) {
+		stats.numBytes += hostProcs[p]->GetOutgoingBytes() + clientProcs[p]->GetOutgoingBytes();
+		if ( reliablesReceived[p] > reliablesSent[p] ) {
+			stats.numErrors++;
+		}
+		delete hostProcs[p];
+		delete clientProcs[p];
+	}
+	delete toClients;
+	delete toHost;
+	delete batch;
+}
+
+/*
+========================
+testPacketBatch
+
+Runs the packet path of a host and numPeers peers over idPacketLoopback, once a packet at a time
+and once batched. The loopback has no syscall cost, so this only measures what the packet
+processors and the copies in and out of the transport cost.
+========================
+*/
+CONSOLE_COMMAND( testPacketBatch, "measures the packet path with many simulated peers over a loopback transport, usage: testPacketBatch [numPeers] [numFrames] [dropPercent]", 0 ) {
+	const int numPeers = ( args.Argc() > 1 ) ? idMath::ClampInt( 1, 1024, atoi( args.Argv( 1 ) ) ) : 256;
+	const int numFrames = ( args.Argc() > 2 ) ? idMath::ClampInt( 1, 100000, atoi( args.Argv( 2 ) ) ) : 300;
+	const float dropRate = ( args.Argc() > 3 ) ? idMath::ClampFloat( 0.0f, 100.0f, (float)atof( args.Argv( 3 ) ) ) * 0.01f : 0.0f;
+
+	idLib::Printf( "%d peers, %d frames, %.1f%% dropped\n", numPeers, numFrames, dropRate * 100.0f );
+	idLib::Printf( "path       packets        MB  send us/packet  recv us/packet  packets/s      msgs  reliables\n" );
+
+	for ( int batched = 0; batched < 2; batched++ ) {
+		packetTestStats_t stats;
+		RunPacketTest( numPeers, numFrames, dropRate, batched != 0, stats );
+
+		const uint64 totalTime = Max( stats.sendTime + stats.recvTime, (uint64)1 );
+		const float numPackets = (float)Max( stats.numPackets, 1 );
+		idLib::Printf( "%-8s %9d  %8.1f  %14.3f  %14.3f  %9.0f  %8d  %9d\n", batched ? "batched" : "single", stats.numPackets, stats.numBytes / ( 1024.0f * 1024.0f ),
+			stats.sendTime / numPackets, stats.recvTime / numPackets, stats.numPackets * 1000000.0 / totalTime, stats.numMsgs, stats.numReliables );
+
+		if ( stats.numErrors > 0 ) {
+			idLib::Warning( "testPacketBatch: %d msgs or reliables arrived wrong on the %s path", stats.numErrors, batched ? "batched" : "single" );
+		}
+	}
+}
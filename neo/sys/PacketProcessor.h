@@ -28,6 +28,8 @@ If you have questions concerning this license or the applicable additional terms
 #ifndef __PACKET_PROCESSOR_H__
 #define __PACKET_PROCESSOR_H__
 
+class idPacketBatch;
+
 /*
 ================================================
 idPacketProcessor
@@ -105,7 +107,7 @@ public:
 	
 private:
 	void QueueReliableAck( int lastReliable );
-	int FinalizeRead( idBitMsg & inMsg, idBitMsg & outMsg, int & userValue );
+	int FinalizeRead( idBitMsg & inMsg, idBitMsg & outMsg, int & userValue, bool inPlace );
 
 public:		
 	bool CanSendMoreData() const;
@@ -120,8 +122,12 @@ public:
 	bool ProcessOutgoing( const int time, const idBitMsg & msg, bool isOOB, int userData );
 	// Used to get each fragment for sending through the actual net connection
 	bool GetSendFragment( const int time, sessionId_t sessionID, idBitMsg & outMsg );
+	// Writes up to maxFragments of the remaining fragments straight into the packets of the batch, returns how many
+	int GetSendFragments( const int time, sessionId_t sessionID, idPacketBatch & batch, int peer, int maxFragments = INT_MAX );
 	// Used to process a fragment received.  Returns true when msg was reconstructed.
-	int ProcessIncoming( int time, sessionId_t expectedSessionID, idBitMsg & msg, idBitMsg & out, int & userData, const int peerNum );
+	// With inPlace, out points at the msg instead of getting a copy of it. It stays valid until msg is reused,
+	// or for a fragmented msg until the next fragment is processed.
+	int ProcessIncoming( int time, sessionId_t expectedSessionID, idBitMsg & msg, idBitMsg & out, int & userData, const int peerNum, bool inPlace = false );
 
 	// Returns true if there are more fragments to send
 	bool HasMoreFragments() const { return ( unsentMsg.GetRemainingData() > 0 ); }
@@ -259,4 +265,70 @@ private:
 	int				fragmentAccumulator;	// counts max size packets we are sending for the net debug hud
 };
 
+/*
+================================================
+idPacketBatch
+Packets on their way to or from the transport, so they can be sent and received many at a time.
+The packet memory is part of the batch and is reused, nothing is allocated per packet.
+================================================
+*/
+class idPacketBatch {
+public:
+	static const int MAX_PACKETS = 64;
+
+	struct packet_t {
+		int		peer;												// Who the packet goes to or came from, up to the caller
+		int		size;
+		byte	data[ idPacketProcessor::MAX_FINAL_PACKET_SIZE ];
+	};
+
+	idPacketBatch() : num( 0 ) { }
+
+	void				Clear()							{ num = 0; }
+	int					Num() const						{ return num; }
+	bool				IsFull() const					{ return num >= MAX_PACKETS; }
+	packet_t &			Alloc()							{ assert( !IsFull() ); packets[ num ].size = 0; return packets[ num++ ]; }
+	void				RemoveLast()					{ assert( num > 0 ); num--; }
+	packet_t &			operator[]( int i )				{ assert( i >= 0 && i < num ); return packets[ i ]; }
+	const packet_t &	operator[]( int i ) const		{ assert( i >= 0 && i < num ); return packets[ i ]; }
+
+private:
+	packet_t			packets[ MAX_PACKETS ];
+	int					num;
+};
+
+/*
+================================================
+idPacketLoopback
+Stand-in for the network when load testing the packet path. Packets are received in the order they
+were sent, optionally dropping some, and are copied in and out the way a socket would.
+================================================
+*/
+class idPacketLoopback {
+public:
+	static const int MAX_QUEUED_PACKETS = 4096;
+
+	idPacketLoopback();
+
+	void	SetDropRate( float rate ) { dropRate = rate; }
+	void	Clear() { first = 0; numQueued = 0; }
+	int		NumQueued() const { return numQueued; }
+
+	// One packet at a time, like idNetSessionPort
+	bool	SendPacket( int peer, const void * data, int size );
+	bool	ReceivePacket( int & peer, void * data, int & size, int maxSize );
+
+	// Returns how many were queued, the rest are dropped like on a full socket buffer
+	int		SendPackets( const idPacketBatch & batch );
+	// Fills the batch until it's full or nothing is left, returns how many were added
+	int		ReceivePackets( idPacketBatch & batch );
+
+private:
+	idList< idPacketBatch::packet_t >	queue;			// Ring buffer, allocated once
+	int									first;
+	int									numQueued;
+	float								dropRate;
+	idRandom							random;
+};
+
 #endif /* !__PACKET_PROCESSOR_H__ */
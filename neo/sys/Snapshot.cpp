@@ -35,6 +35,7 @@ idCVar net_verboseSnapshotReport( "net_verboseSnapshotReport", "0", CVAR_INTEGER
 idCVar net_ssTemplateDebug( "net_ssTemplateDebug", "0", CVAR_BOOL, "Debug snapshot template states" );
 idCVar net_ssTemplateDebug_len( "net_ssTemplateDebug_len", "32", CVAR_INTEGER, "Offset to start template state debugging" );
 idCVar net_ssTemplateDebug_start( "net_ssTemplateDebug_start", "0", CVAR_INTEGER, "length of template state to print in debugging" );
+idCVar net_ssDiffByGeneration( "net_ssDiffByGeneration", "1", CVAR_BOOL, "Skip comparing the bytes of snapshot objects that haven't changed since the base snapshot" );
 
 /*
 ========================
@@ -74,6 +75,12 @@ void idSnapShot::objectState_t::Print( const char * name ) {
 	idLib::Printf("\n");
 }
 
+int idSnapShot::bufferMemory = 0;
+int idSnapShot::peakBufferMemory = 0;
+
+// Never destroyed, snapshots owned by globals can still free their objects after the static destructors ran
+idConcurrentBlockAlloc< idSnapShot::objectState_t, 64, TAG_NETWORKING > & idSnapShot::allocatedObjs = *new ( TAG_NETWORKING ) idConcurrentBlockAlloc< idSnapShot::objectState_t, 64, TAG_NETWORKING >();
+
 /*
 ========================
 idSnapShot::objectBuffer_t::Alloc
@@ -88,6 +95,8 @@ void idSnapShot::objectBuffer_t::Alloc( int s ) {
 	data = (byte *)Mem_Alloc( s + 1, TAG_NETWORKING );
 	size = s;
 	data[size] = 1;
+	bufferMemory += s;
+	peakBufferMemory = Max( peakBufferMemory, bufferMemory );
 }
 
 /*
@@ -114,6 +123,7 @@ void idSnapShot::objectBuffer_t::_Release() {
 		assert( size > 0 );
 		if ( --data[size] == 0 ) {
 			Mem_Free( data );
+			bufferMemory -= size;
 		}
 		data = NULL;
 		size = 0;
@@ -144,6 +154,7 @@ idSnapShot::idSnapShot() :
 	time( 0 ),
 	recvTime( 0 )
 {
+	objectsById.SetGranularity( 256 );
 }
 
 /*
@@ -152,6 +163,7 @@ idSnapShot::idSnapShot
 ========================
 */
 idSnapShot::idSnapShot( const idSnapShot & other ) : time( 0 ), recvTime(0) {
+	objectsById.SetGranularity( 256 );
 	*this = other;
 }
 
@@ -176,7 +188,7 @@ void idSnapShot::Clear() {
 		FreeObjectState( i );
 	}
 	objectStates.Clear();
-	allocatedObjs.Shutdown();
+	objectsById.Clear();
 }
 
 /*
@@ -206,22 +218,46 @@ void idSnapShot::operator=( const idSnapShot & other ) {
 			state.changedCount	= otherState.changedCount;
 			state.expectedSequence = otherState.expectedSequence;
 			state.createdFromTemplate = otherState.createdFromTemplate;
+			state.generation	= otherState.generation;
 		}
+		RebuildObjectsById();
 		time = other.time;
 		recvTime = other.recvTime;
 	}
 }
 
+/*
+========================
+GetDeltaCodec
+Returns the lzwCodec_t a delta was written with (see NewLZWStream), or -1 if it isn't one we know
+========================
+*/
+static int GetDeltaCodec( const char * deltaMem, int deltaSize ) {
+	if ( deltaSize < SNAP_DELTA_CODEC_SIZE ) {
+		return -1;
+	}
+	int codec = (uint8)deltaMem[0];
+	return ( codec < LZW_CODEC_MAX ) ? codec : -1;
+}
+
 /*
 ========================
 idSnapShot::PeekDeltaSequence
 ========================
 */
 void idSnapShot::PeekDeltaSequence( const char * deltaMem, int deltaSize, int & sequence, int & baseSequence ) {
+	int codec = GetDeltaCodec( deltaMem, deltaSize );
+	if ( codec == -1 ) {
+		// Makes the delta look older than anything we have, so it gets rejected
+		sequence		= -1;
+		baseSequence	= -1;
+		return;
+	}
+
 	lzwCompressionData_t	lzwData;
-	idLZWCompressor			lzwCompressor( &lzwData );
+	idLZWCompressor			lzwCompressor( &lzwData, codec );
 	
-	lzwCompressor.Start( (uint8*)deltaMem, deltaSize );	
+	lzwCompressor.Start( (uint8*)deltaMem + SNAP_DELTA_CODEC_SIZE, deltaSize - SNAP_DELTA_CODEC_SIZE );	
 	lzwCompressor.ReadAgnostic( sequence );
 	lzwCompressor.ReadAgnostic( baseSequence );
 }
@@ -231,17 +267,23 @@ void idSnapShot::PeekDeltaSequence( const char * deltaMem, int deltaSize, int &
 idSnapShot::ReadDeltaForJob
 ========================
 */
-bool idSnapShot::ReadDeltaForJob( const char * deltaMem, int deltaSize, int visIndex, idSnapShot * templateStates ) {
+bool idSnapShot::ReadDeltaForJob( const char * deltaMem, int deltaSize, int visIndex, idSnapShot * templateStates, const objectGeneration_t * generations, int numGenerations ) {
 
 	bool report = net_verboseSnapshotReport.GetBool();
 	net_verboseSnapshotReport.SetBool( false );
 
+	int codec = GetDeltaCodec( deltaMem, deltaSize );
+	if ( codec == -1 ) {
+		idLib::Warning( "ReadDeltaForJob: unknown snapshot codec" );
+		return false;
+	}
+
 	lzwCompressionData_t		lzwData;
 	idZeroRunLengthCompressor	rleCompressor;
-	idLZWCompressor				lzwCompressor( &lzwData );
+	idLZWCompressor				lzwCompressor( &lzwData, codec );
 	int bytesRead = 0; // how many uncompressed bytes we read in. Used to figure out compression ratio
 
-	lzwCompressor.Start( (uint8*)deltaMem, deltaSize );
+	lzwCompressor.Start( (uint8*)deltaMem + SNAP_DELTA_CODEC_SIZE, deltaSize - SNAP_DELTA_CODEC_SIZE );
 
 	// Skip past sequence and baseSequence
 	int sequence		= 0;
@@ -254,7 +296,7 @@ bool idSnapShot::ReadDeltaForJob( const char * deltaMem, int deltaSize, int visI
 
 	int objectNum = 0;
 	uint16 delta = 0;
-	
+	int generationIndex = 0;
 
 	while ( lzwCompressor.ReadAgnostic( delta, true ) == sizeof( delta ) ) {
 		bytesRead += sizeof( delta );
@@ -313,6 +355,7 @@ bool idSnapShot::ReadDeltaForJob( const char * deltaMem, int deltaSize, int visI
 			state.visMask = 0;
 			state.buffer._Release();
 			state.createdFromTemplate = false;
+			state.generation = 0;
 
 			if ( objTemplateState != NULL && objTemplateState->buffer.Size() && objTemplateState->expectedSequence < baseSequence ) {
 				idLib::PrintfIf( net_ssTemplateDebug.GetBool(), "Clearing old template state[%d] [%d<%d]\n", objectNum, objTemplateState->expectedSequence, baseSequence );
@@ -322,6 +365,7 @@ bool idSnapShot::ReadDeltaForJob( const char * deltaMem, int deltaSize, int visI
 				objTemplateState->expectedSequence = 0;
 				objTemplateState->visMask = 0;
 				objTemplateState->buffer._Release();
+				objTemplateState->generation = 0;
 			}
 
 		} else {
@@ -373,6 +417,15 @@ bool idSnapShot::ReadDeltaForJob( const char * deltaMem, int deltaSize, int visI
 
 			}
 			state.buffer = newbuffer;
+
+			// The rebuilt bytes are the ones the delta was written from, so they can keep that generation
+			for ( ; generationIndex < numGenerations && generations[generationIndex].objectNum < objectNum; generationIndex++ ) {
+			}
+			if ( generationIndex < numGenerations && generations[generationIndex].objectNum == objectNum && generations[generationIndex].generation != 0 ) {
+				state.generation = generations[generationIndex].generation;
+			} else {
+				state.generation = NewGeneration();
+			}
 			state.changedCount = sequence;
 			bytesRead += sizeof( byte ) * newsize;
 			if ( debug ) {
@@ -442,6 +495,7 @@ void idSnapShot::SubmitObjectJob(	const submitDeltaJobsInfo_t &	submitDeltaJobsI
 	curObjParm->visIndex	= submitDeltaJobsInfo.visIndex;
 	curObjParm->destHeader	= curHeader;
 	curObjParm->dest		= curObjDest;
+	curObjParm->share		= submitDeltaJobsInfo.share;
 
 	memset( &curObjParm->newState, 0, sizeof( curObjParm->newState ) );
 	memset( &curObjParm->oldState, 0, sizeof( curObjParm->oldState ) );
@@ -454,6 +508,7 @@ void idSnapShot::SubmitObjectJob(	const submitDeltaJobsInfo_t &	submitDeltaJobsI
 		curObjParm->newState.size		= newState->buffer.Size();
 		curObjParm->newState.objectNum	= newState->objectNum;
 		curObjParm->newState.visMask	= newState->visMask;
+		curObjParm->newState.generation	= newState->generation;
 	}
 	
 	if ( oldState != NULL ) {
@@ -532,11 +587,8 @@ newState parameter is optional and is just used for debugging/printf comparison
 ========================
 */
 idSnapShot::objectState_t * idSnapShot::GetTemplateState( int objNum, idSnapShot * templateStates, idSnapShot::objectState_t * newState /*=NULL*/ ) {
-	objectState_t * oldState = NULL;
-	int spawnedStateIndex = templateStates->FindObjectIndexByID( objNum );
-	if ( spawnedStateIndex >= 0 ) {
-		oldState = templateStates->objectStates[ spawnedStateIndex ];
-		
+	objectState_t * oldState = templateStates->FindObjectByID( objNum );
+	if ( oldState != NULL ) {
 		if ( net_ssTemplateDebug.GetBool() ) {
 			idLib::Printf( "\nGetTemplateState[%d]\n", objNum );
 			oldState->Print( "SPAWN STATE" );
@@ -548,6 +600,38 @@ idSnapShot::objectState_t * idSnapShot::GetTemplateState( int objNum, idSnapShot
 	return oldState;
 }
 
+/*
+========================
+idSnapShot::NewGeneration
+========================
+*/
+uint32 idSnapShot::NewGeneration() {
+	static interlockedInt_t generation = 0;
+	uint32 newGeneration = (uint32)Sys_InterlockedIncrement( generation );
+	if ( newGeneration == 0 ) {
+		newGeneration = (uint32)Sys_InterlockedIncrement( generation );		// 0 is reserved for unknown
+	}
+	return newGeneration;
+}
+
+/*
+========================
+idSnapShot::UnchangedSinceBase
+True if nothing would be written for newState when delta'd against oldState, without comparing the bytes.
+========================
+*/
+bool idSnapShot::UnchangedSinceBase( const objectState_t & newState, const objectState_t & oldState, int visIndex ) {
+	if ( newState.generation == 0 || newState.generation != oldState.generation || !net_ssDiffByGeneration.GetBool() ) {
+		return false;
+	}
+	assert( newState.buffer.Size() == oldState.buffer.Size() );
+	if ( visIndex > 0 ) {
+		// A visibility change has to be written even if the state is the same
+		return ( ( newState.visMask ^ oldState.visMask ) & ( 1 << visIndex ) ) == 0;
+	}
+	return true;
+}
+
 /*
 ========================
 idSnapShot::SubmitWriteDeltaToJobs
@@ -609,6 +693,10 @@ void idSnapShot::SubmitWriteDeltaToJobs( const submitDeltaJobsInfo_t & submitDel
 			if ( oldState->buffer.Size() == 0 ) {
 				// New state (even though snapObj existed, its size was zero)
 				oldState = GetTemplateState( newState.objectNum, submitDeltaJobInfo.templateStates, &newState );
+			} else if ( UnchangedSinceBase( newState, *oldState, submitDeltaJobInfo.visIndex ) ) {
+				// The object job would just ack this, so don't submit it
+				j++;
+				continue;
 			}
 
 			SubmitObjectJob( submitDeltaJobInfo, &newState, oldState, baseObjParms, curObjParms, curHeader, curObjMemory, curlzwParms );
@@ -633,8 +721,22 @@ void idSnapShot::SubmitWriteDeltaToJobs( const submitDeltaJobsInfo_t & submitDel
 				
 	// Submit any objects that are left over (will be all if they all fit up to this point)
 	SubmitLZWJob( submitDeltaJobInfo, baseObjParms, curObjParms, curlzwParms, false );
+
+	submitDeltaJobInfo.lzwInOutData->numObjParms = curObjParms - submitDeltaJobInfo.objParms;
+}
+
+/*
+========================
+SnapshotWriteDeltaJob
+Only touches the memory in parms->info, and reads the snaps, so the snaps of several peers can be written at once.
+========================
+*/
+void SnapshotWriteDeltaJob( snapWriteDeltaParms_t * parms ) {
+	parms->snap->SubmitWriteDeltaToJobs( parms->info );
 }
 
+REGISTER_PARALLEL_JOB( SnapshotWriteDeltaJob, "SnapshotWriteDeltaJob" );
+
 /*
 ========================
 idSnapShot::ReadDelta
@@ -685,6 +787,7 @@ bool idSnapShot::ReadDelta( idFile * file, int visIndex ) {
 		if ( newsize == 0 ) {
 			// object deleted
 			state.buffer._Release();
+			state.generation = 0;
 		} else {						
 			objectBuffer_t newbuffer( newsize );
 			objectSize_t compareSize = Min( newsize, state.buffer.Size() );
@@ -700,6 +803,7 @@ bool idSnapShot::ReadDelta( idFile * file, int visIndex ) {
 			}
 			
 			state.buffer = newbuffer;			
+			state.generation = NewGeneration();
 			state.changedCount++;
 		}
 		
@@ -756,6 +860,10 @@ void idSnapShot::WriteObject( idFile * file, int visIndex, objectState_t * newSt
 		}
 		
 		// Same object, write a delta (never early out during vis changes)
+		if ( !visChange && newState->generation != 0 && newState->generation == oldState->generation && net_ssDiffByGeneration.GetBool() ) {
+			// same state since the base, write nothing
+			return;
+		}
 		if ( !visChange && newState->buffer.Size() == oldState->buffer.Size() &&
 			( ( newState->buffer.Ptr() == oldState->buffer.Ptr() ) || memcmp( newState->buffer.Ptr(), oldState->buffer.Ptr(), newState->buffer.Size() ) == 0 ) ) {
 			// same state, write nothing
@@ -930,6 +1038,66 @@ bool idSnapShot::WriteDelta( idSnapShot & old, int visIndex, idFile * file, int
 	return true;
 }
 
+/*
+========================
+idSnapShot::WriteToFile
+========================
+*/
+void idSnapShot::WriteToFile( idFile * file ) const {
+	file->WriteBig( time );
+	file->WriteBig( objectStates.Num() );
+	for ( int i = 0; i < objectStates.Num(); i++ ) {
+		objectState_t & state = *objectStates[i];
+		file->WriteBig( state.objectNum );
+		file->WriteBig( state.visMask );
+		file->WriteBig<uint8>( state.stale ? 1 : 0 );
+		file->WriteBig( state.buffer.Size() );
+		if ( state.buffer.Size() > 0 ) {
+			file->Write( state.buffer.Ptr(), state.buffer.Size() );
+		}
+	}
+}
+
+/*
+========================
+idSnapShot::ReadFromFile
+Returns false if the file ends or is corrupt before the whole snapshot is read
+========================
+*/
+bool idSnapShot::ReadFromFile( idFile * file ) {
+	Clear();
+
+	int numObjects = 0;
+	if ( file->ReadBig( time ) != sizeof( time ) || file->ReadBig( numObjects ) != sizeof( numObjects ) ) {
+		return false;
+	}
+	if ( numObjects < 0 || numObjects > 0xFFFF ) {
+		return false;
+	}
+	for ( int i = 0; i < numObjects; i++ ) {
+		uint16 objectNum = 0;
+		uint32 visMask = 0;
+		uint8 stale = 0;
+		objectSize_t size = 0;
+		file->ReadBig( objectNum );
+		file->ReadBig( visMask );
+		file->ReadBig( stale );
+		if ( file->ReadBig( size ) != sizeof( size ) || size < 0 || size > file->Length() - file->Tell() ) {
+			return false;
+		}
+		objectState_t & state = FindOrCreateObjectByID( objectNum );
+		state.visMask = visMask;
+		state.stale = ( stale != 0 );
+		if ( size > 0 ) {
+			objectBuffer_t buffer( size );
+			file->Read( buffer.Ptr(), size );
+			state.buffer = buffer;
+			state.generation = NewGeneration();
+		}
+	}
+	return true;
+}
+
 /*
 ========================
 idSnapShot::AddObject
@@ -939,6 +1107,10 @@ idSnapShot::objectState_t * idSnapShot::S_AddObject( int objectNum, uint32 visMa
 	objectSize_t size = _size;
 	objectState_t & state = FindOrCreateObjectByID( objectNum );
 	state.visMask = visMask;
+	if ( state.buffer.Size() == size && state.generation != 0 && memcmp( state.buffer.Ptr(), data, size ) == 0 ) {
+		// unchanged, keep the generation so deltas against copies of this snap can skip it
+		return &state;
+	}
 	if ( state.buffer.Size() == size && state.buffer.NumRefs() == 1 ) {
 		// re-use the same buffer
 		memcpy( state.buffer.Ptr(), data, size );
@@ -947,6 +1119,7 @@ idSnapShot::objectState_t * idSnapShot::S_AddObject( int objectNum, uint32 visMa
 		memcpy( buffer.Ptr(), data, size );
 		state.buffer = buffer;
 	}
+	state.generation = NewGeneration();
 	return &state;
 }
 
@@ -973,6 +1146,7 @@ bool idSnapShot::CopyObject( const idSnapShot & oldss, int objectNum, bool force
 	newState.changedCount	= oldState.changedCount;
 	newState.expectedSequence = oldState.expectedSequence;
 	newState.createdFromTemplate = oldState.createdFromTemplate;
+	newState.generation		= oldState.generation;
 
 	if ( forceStale ) {
 		newState.visMask = 0;
@@ -981,6 +1155,26 @@ bool idSnapShot::CopyObject( const idSnapShot & oldss, int objectNum, bool force
 	return true;
 }
 
+/*
+========================
+idSnapShot::InheritGenerations
+The server writes a new snapshot every frame, so without this every object in it would have a new
+generation and no delta could skip it.
+========================
+*/
+void idSnapShot::InheritGenerations( const idSnapShot & oldss ) {
+	for ( int i = 0; i < objectStates.Num(); i++ ) {
+		objectState_t & state = *objectStates[i];
+		objectState_t * oldState = oldss.FindObjectByID( state.objectNum );
+		if ( oldState == NULL || oldState->generation == 0 || oldState->generation == state.generation ) {
+			continue;
+		}
+		if ( state.buffer.Size() == oldState->buffer.Size() && memcmp( state.buffer.Ptr(), oldState->buffer.Ptr(), state.buffer.Size() ) == 0 ) {
+			state.generation = oldState->generation;
+		}
+	}
+}
+
 /*
 ========================
 idSnapShot::CompareObject
@@ -1076,6 +1270,9 @@ idSnapShot::FindObjectIndexByID
 ========================
 */
 int idSnapShot::FindObjectIndexByID( int objectNum ) const {
+	if ( FindObjectByID( objectNum ) == NULL ) {
+		return -1;
+	}
 	int i = BinarySearch( objectNum );
 	if ( i >= 0 && i < objectStates.Num() && objectStates[i]->objectNum == objectNum ) {
 		return i;
@@ -1115,18 +1312,51 @@ idSnapShot::FindOrCreateObjectByID
 idSnapShot::objectState_t & idSnapShot::FindOrCreateObjectByID( int objectNum ) {
 	//assert( mem.IsMapHeap() );
 
-	int i = BinarySearch( objectNum );
-
-	if ( i >= 0 && i < objectStates.Num() && objectStates[i]->objectNum == objectNum ) {
-		return *objectStates[i];
+	if ( objectNum < objectsById.Num() && objectsById[objectNum] != NULL ) {
+		return *objectsById[objectNum];
 	}
 
 	objectState_t * newstate = allocatedObjs.Alloc();
 	newstate->objectNum = objectNum;
 
+	// Objects are almost always added in order, only search when inserting in the middle
+	int i = objectStates.Num();
+	if ( i > 0 && objectStates[i - 1]->objectNum > objectNum ) {
+		i = BinarySearch( objectNum );
+	}
+
 	objectStates.Insert( newstate, i );
 
-	return *objectStates[i];
+	// AssureSize sets the count even when it's smaller, and doesn't clear entries it didn't allocate
+	const int numIds = objectsById.Num();
+	if ( objectNum >= numIds ) {
+		objectsById.AssureSize( objectNum + 1 );
+		for ( int j = numIds; j < objectNum; j++ ) {
+			objectsById[j] = NULL;
+		}
+	}
+	objectsById[objectNum] = newstate;
+
+	return *newstate;
+}
+
+/*
+========================
+idSnapShot::RebuildObjectsById
+========================
+*/
+void idSnapShot::RebuildObjectsById() {
+	// objectStates is sorted, so the last object has the highest number
+	const int numIds = ( objectStates.Num() > 0 ) ? objectStates[objectStates.Num() - 1]->objectNum + 1 : 0;
+
+	objectsById.SetNum( numIds );
+	if ( numIds > 0 ) {
+		memset( objectsById.Ptr(), 0, numIds * sizeof( objectState_t * ) );
+	}
+
+	for ( int i = 0; i < objectStates.Num(); i++ ) {
+		objectsById[objectStates[i]->objectNum] = objectStates[i];
+	}
 }
 
 /*
@@ -1138,13 +1368,11 @@ idSnapShot::objectState_t * idSnapShot::FindObjectByID( int objectNum ) const {
 
 	//assert( mem.IsMapHeap() );
 
-	int i = BinarySearch( objectNum );
-
-	if ( i >= 0 && i < objectStates.Num() && objectStates[i]->objectNum == objectNum ) {
-		return objectStates[i];
+	if ( objectNum < 0 || objectNum >= objectsById.Num() ) {
+		return NULL;
 	}
 
-	return NULL;
+	return objectsById[objectNum];
 }
 
 /*
@@ -1182,6 +1410,8 @@ idSnapShot::FreeObjectState
 void idSnapShot::FreeObjectState( int index ) {
 	assert( objectStates[index] != NULL );
 	//assert( mem.IsMapHeap() );
+	assert( objectsById[objectStates[index]->objectNum] == objectStates[index] );
+	objectsById[objectStates[index]->objectNum] = NULL;
 	objectStates[index]->buffer._Release();
 	allocatedObjs.Free( objectStates[index] );
 	objectStates[index] = NULL;
@@ -1226,6 +1456,7 @@ void idSnapShot::ApplyToExistingState( int objId, idBitMsg & msg ) {
 	for ( objectSize_t i = 0; i < Min( objectState->buffer.Size(), msg.GetSize() ); i++ ) {
 		objectState->buffer[i] += msg.GetReadData()[i];
 	}
+	objectState->generation = NewGeneration();
 
 	// Debug print the final state
 	if ( net_ssTemplateDebug.GetBool() ) {
@@ -1279,3 +1510,124 @@ CONSOLE_COMMAND( serializeQTest, "Serialization Sanity Test", 0 ) {
 	}
 }
 #endif
+
+/*
+========================
+testSnapshotDelta
+
+Builds a synthetic snapshot, changes some of its objects, and writes and reads the delta
+against the original, with and without skipping objects by generation. No network involved.
+The new snapshot starts as a copy of the base, which is the best case for generations,
+testSnapshotGenerations measures them on a recording going through the ack path.
+========================
+*/
+CONSOLE_COMMAND( testSnapshotDelta, "measures snapshot object lookup and delta throughput, usage: testSnapshotDelta [numObjects] [percentChanged]", 0 ) {
+	const int numObjects = ( args.Argc() > 1 ) ? idMath::ClampInt( 1, 0xFFF0, atoi( args.Argv( 1 ) ) ) : 4096;
+	const int percentChanged = ( args.Argc() > 2 ) ? idMath::ClampInt( 0, 100, atoi( args.Argv( 2 ) ) ) : 10;
+	const int numRuns = 20;
+	const int maxObjectSize = 256;
+
+	idRandom random( 0x5ca1ab1e );
+
+	idList< byte > bytes;
+	idList< int > sizes;
+	bytes.SetNum( numObjects * maxObjectSize );
+	sizes.SetNum( numObjects );
+	for ( int i = 0; i < numObjects; i++ ) {
+		sizes[i] = 16 + random.RandomInt( maxObjectSize - 16 );
+		for ( int b = 0; b < sizes[i]; b++ ) {
+			bytes[i * maxObjectSize + b] = ( random.RandomInt( 4 ) == 0 ) ? (byte)random.RandomInt( 256 ) : 0;
+		}
+	}
+
+	const int deltaSize = numObjects * ( maxObjectSize + 16 ) + 64;
+	idList< char > deltaMem;
+	deltaMem.SetNum( deltaSize );
+
+	const bool diffByGeneration = net_ssDiffByGeneration.GetBool();
+
+	uint64 buildTime = 0;
+	uint64 lookupTime = 0;
+	uint64 searchTime = 0;
+	uint64 updateTime = 0;
+	uint64 writeTime[2] = { 0, 0 };
+	uint64 readTime = 0;
+	int deltaLength = 0;
+	int numMismatches = 0;
+	int numFound = 0;
+
+	for ( int run = 0; run < numRuns; run++ ) {
+		uint64 start = Sys_Microseconds();
+		idSnapShot base;
+		for ( int i = 0; i < numObjects; i++ ) {
+			base.S_AddObject( i + 1, ~0U, &bytes[i * maxObjectSize], sizes[i] );
+		}
+		buildTime += Sys_Microseconds() - start;
+
+		start = Sys_Microseconds();
+		for ( int i = 0; i < numObjects; i++ ) {
+			numFound += ( base.FindObjectByID( i + 1 ) != NULL ) ? 1 : 0;
+		}
+		lookupTime += Sys_Microseconds() - start;
+
+		start = Sys_Microseconds();
+		for ( int i = 0; i < numObjects; i++ ) {
+			numFound += ( base.FindObjectIndexByID( i + 1 ) >= 0 ) ? 1 : 0;
+		}
+		searchTime += Sys_Microseconds() - start;
+
+		// Every object is written again each frame, like idGameLocal::ServerWriteSnapshot, but only some change
+		for ( int i = 0; i < numObjects; i++ ) {
+			if ( random.RandomInt( 100 ) < percentChanged ) {
+				bytes[i * maxObjectSize + random.RandomInt( sizes[i] )]++;
+			}
+		}
+		idSnapShot current = base;
+		start = Sys_Microseconds();
+		for ( int i = 0; i < numObjects; i++ ) {
+			current.S_AddObject( i + 1, ~0U, &bytes[i * maxObjectSize], sizes[i] );
+		}
+		updateTime += Sys_Microseconds() - start;
+
+		for ( int pass = 0; pass < 2; pass++ ) {
+			net_ssDiffByGeneration.SetBool( pass == 1 );
+			idFile_Memory deltaFile( "testSnapshotDelta", deltaMem.Ptr(), deltaSize );
+			start = Sys_Microseconds();
+			current.WriteDelta( base, 0, &deltaFile, deltaSize );
+			writeTime[pass] += Sys_Microseconds() - start;
+			deltaLength = deltaFile.Length();
+		}
+
+		idSnapShot applied = base;
+		idFile_Memory readFile( "testSnapshotDelta", (const char *)deltaMem.Ptr(), deltaLength );
+		start = Sys_Microseconds();
+		applied.ReadDelta( &readFile, 0 );
+		readTime += Sys_Microseconds() - start;
+
+		for ( int i = 0; i < numObjects; i++ ) {
+			idSnapShot::objectState_t * state = applied.FindObjectByID( i + 1 );
+			if ( state == NULL || state->buffer.Size() != sizes[i] || memcmp( state->buffer.Ptr(), &bytes[i * maxObjectSize], sizes[i] ) != 0 ) {
+				numMismatches++;
+			}
+		}
+	}
+
+	net_ssDiffByGeneration.SetBool( diffByGeneration );
+
+	const double numProcessed = (double)numObjects * numRuns;
+	idLib::Printf( "%d objects, %d%% changed per run, %d runs, %d byte delta\n", numObjects, percentChanged, numRuns, deltaLength );
+	idLib::Printf( "build:                %7.1f ns per object\n", buildTime * 1000.0 / numProcessed );
+	idLib::Printf( "FindObjectByID:       %7.1f ns per object\n", lookupTime * 1000.0 / numProcessed );
+	idLib::Printf( "FindObjectIndexByID:  %7.1f ns per object\n", searchTime * 1000.0 / numProcessed );
+	idLib::Printf( "update:               %7.1f ns per object\n", updateTime * 1000.0 / numProcessed );
+	idLib::Printf( "write, compare bytes: %7.1f ns per object\n", writeTime[0] * 1000.0 / numProcessed );
+	idLib::Printf( "write, by generation: %7.1f ns per object\n", writeTime[1] * 1000.0 / numProcessed );
+	idLib::Printf( "read:                 %7.1f ns per object\n", readTime * 1000.0 / numProcessed );
+
+	if ( numMismatches > 0 ) {
+		idLib::Warning( "testSnapshotDelta: %d objects differ after applying the delta", numMismatches );
+	}
+	if ( numFound != numObjects * numRuns * 2 ) {
+		idLib::Warning( "testSnapshotDelta: %d lookups failed", numObjects * numRuns * 2 - numFound );
+	}
+}
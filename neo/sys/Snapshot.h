@@ -57,8 +57,15 @@ public:
 	// Loads only sequence and baseSequence values from the compressed stream
 	static void PeekDeltaSequence( const char * deltaMem, int deltaSize, int & sequence, int & baseSequence );
 
+	// Generation an object had in the snapshot a delta was written from
+	struct objectGeneration_t {
+		int		objectNum;
+		uint32	generation;
+	};
+
 	// Reads a new object state packet, which is assumed to be delta compressed against this snapshot
-	bool ReadDeltaForJob( const char * deltaMem, int deltaSize, int visIndex, idSnapShot * templateStates );
+	// Objects the delta rebuilds take their generation from generations (sorted by objectNum) when they are in it
+	bool ReadDeltaForJob( const char * deltaMem, int deltaSize, int visIndex, idSnapShot * templateStates, const objectGeneration_t * generations = NULL, int numGenerations = 0 );
 	bool ReadDelta( idFile * file, int visIndex );
 
 	// Writes an object state packet which is delta compressed against the old snapshot
@@ -91,7 +98,8 @@ public:
 			changedCount( 0 ),
 			createdFromTemplate( false ),
 			
-			expectedSequence( 0 )
+			expectedSequence( 0 ),
+			generation( 0 )
 			{ }
 		void Print( const char * name );
 
@@ -103,6 +111,7 @@ public:
 		int				changedCount;	// Incremented each time the state changed
 		int				expectedSequence;
 		bool			createdFromTemplate;
+		uint32			generation;		// New value each time the buffer bytes change, copies keep it. 0 means unknown
 	};
 
 	struct submitDeltaJobsInfo_t {
@@ -122,17 +131,25 @@ public:
 		idSnapShot *		templateStates;			// states for new snapObj that arent in old states
 		
 		lzwInOutData_t *	lzwInOutData;
+
+		objShareTable_t *	share;					// Optional, shares object encodes between peers
 	};
 
 	void SubmitWriteDeltaToJobs( const submitDeltaJobsInfo_t & submitDeltaJobInfo );
 
 	bool WriteDelta( idSnapShot & old, int visIndex, idFile * file, int maxLength, int optimalLength = 0 );
 
+	// Writes / reads every object state uncompressed, used for snapshot recordings
+	void WriteToFile( idFile * file ) const;
+	bool ReadFromFile( idFile * file );
+
 	// Adds an object to the state, overwrites any existing object with the same number
 	objectState_t * S_AddObject( int objectNum, uint32 visMask, const idBitMsg & msg, const char * tag = NULL ) { return S_AddObject( objectNum, visMask, msg.GetReadData(), msg.GetSize(), tag ); }
 	objectState_t * S_AddObject( int objectNum, uint32 visMask, const byte * buffer, int size, const char * tag = NULL ) { return S_AddObject( objectNum, visMask, (const char *)buffer, size, tag ); }
 	objectState_t * S_AddObject( int objectNum, uint32 visMask, const char * buffer, int size, const char * tag = NULL );
 	bool CopyObject( const idSnapShot & oldss, int objectNum, bool forceStale = false );
+	// Objects with the same bytes as in oldss take its generation
+	void InheritGenerations( const idSnapShot & oldss );
 	int CompareObject( const idSnapShot * oldss, int objectNum, int start=0, int end=0, int oldStart=0 );
 
 	// returns the number of objects in this snapshot
@@ -167,16 +184,28 @@ public:
 
 	void	RemoveObject( int objId );
 
+	// Bytes of object state held by all snapshots, and the most held at once since ResetPeakBufferMemory
+	static int	GetBufferMemory() { return bufferMemory; }
+	static int	GetPeakBufferMemory() { return peakBufferMemory; }
+	static void	ResetPeakBufferMemory() { peakBufferMemory = bufferMemory; }
+
 private:
+	static int											bufferMemory;
+	static int											peakBufferMemory;
 
 	idList< objectState_t *, TAG_IDLIB_LIST_SNAPSHOT>							objectStates;
-	idBlockAlloc< objectState_t, 16, TAG_NETWORKING >	allocatedObjs;
+	idList< objectState_t *, TAG_IDLIB_LIST_SNAPSHOT>							objectsById;	// Indexed by objectNum, NULL if not in the snap
+	static idConcurrentBlockAlloc< objectState_t, 64, TAG_NETWORKING > &	allocatedObjs;	// Shared by all snapshots, can be used from any thread
 
 	int													time;
 	int													recvTime;
 
 	int				BinarySearch( int objectNum ) const;
 	objectState_t &	FindOrCreateObjectByID( int objectNum );					// objIndex is optional parm for returning the index of the obj
+	void			RebuildObjectsById();
+
+	static uint32	NewGeneration();
+	static bool		UnchangedSinceBase( const objectState_t & newState, const objectState_t & oldState, int visIndex );
 
 	void			SubmitObjectJob(	const submitDeltaJobsInfo_t &	submitDeltaJobsInfo,		// Struct containing parameters originally passed in to SubmitWriteDeltaToJobs
 										objectState_t *					newState,					// New obj state (can be NULL, which means deleted)
@@ -198,4 +227,12 @@ private:
 	void FreeObjectState( int index );
 };
 
+// Parms for running SubmitWriteDeltaToJobs as a job, so the server can encode the snaps of all peers at once
+struct snapWriteDeltaParms_t {
+	idSnapShot *						snap;
+	idSnapShot::submitDeltaJobsInfo_t	info;
+};
+
+void SnapshotWriteDeltaJob( snapWriteDeltaParms_t * parms );
+
 #endif // __SNAPSHOT_H__
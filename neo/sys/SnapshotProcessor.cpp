@@ -48,6 +48,8 @@ idSnapshotProcessor::idSnapshotProcessor() {
 	assert_16_byte_aligned( jobMemory->headers.Ptr() );
 	assert_16_byte_aligned( jobMemory->lzwParms.Ptr() );
 
+	snapCodec = LZW_CODEC_LZW;
+
 	Reset( true );
 }
 
@@ -81,6 +83,7 @@ void idSnapshotProcessor::Reset( bool cstor ) {
 	submittedState.Clear();
 	pendingSnap.Clear();
 	deltas.Clear();
+	deltaGenerations.Clear();
 
 	partialBaseSequence = -1;
 
@@ -116,8 +119,8 @@ void idSnapshotProcessor::PeekDeltaSequence( const char * deltaMem, int deltaSiz
 idSnapshotProcessor::ApplyDeltaToSnapshot
 ========================
 */
-bool idSnapshotProcessor::ApplyDeltaToSnapshot( idSnapShot & snap, const char * deltaMem, int deltaSize, int visIndex ) {
-	return snap.ReadDeltaForJob( deltaMem, deltaSize, visIndex, &templateStates );
+bool idSnapshotProcessor::ApplyDeltaToSnapshot( idSnapShot & snap, const char * deltaMem, int deltaSize, int visIndex, const idSnapShot::objectGeneration_t * generations, int numGenerations ) {
+	return snap.ReadDeltaForJob( deltaMem, deltaSize, visIndex, &templateStates, generations, numGenerations );
 }
 
 #ifdef STRESS_LZW_MEM
@@ -131,7 +134,7 @@ static int g_maxlwMem = 100;
 idSnapshotProcessor::SubmitPendingSnap
 ========================
 */
-void idSnapshotProcessor::SubmitPendingSnap( int visIndex, uint8 * objMemory, int objMemorySize, lzwCompressionData_t * lzwData ) {
+void idSnapshotProcessor::SubmitPendingSnap( int visIndex, uint8 * objMemory, int objMemorySize, lzwCompressionData_t * lzwData, objShareTable_t * share, idParallelJobList * jobList ) {
 
 	assert_16_byte_aligned( objMemory );
 	assert_16_byte_aligned( lzwData );
@@ -157,9 +160,10 @@ void idSnapshotProcessor::SubmitPendingSnap( int visIndex, uint8 * objMemory, in
 	jobMemory->lzwInOutData.optimalLength	= net_optimalSnapDeltaSize.GetInteger();
 	jobMemory->lzwInOutData.snapSequence	= snapSequence;
 	jobMemory->lzwInOutData.lastObjId		= 0;
+	jobMemory->lzwInOutData.codec			= snapCodec;
 	jobMemory->lzwInOutData.lzwData			= lzwData;
 
-	idSnapShot::submitDeltaJobsInfo_t submitInfo;
+	idSnapShot::submitDeltaJobsInfo_t & submitInfo = jobMemory->writeDeltaParms.info;
 
 	submitInfo.objParms			= jobMemory->objParms.Ptr();
 	submitInfo.maxObjParms		= jobMemory->objParms.Num();
@@ -183,6 +187,14 @@ void idSnapshotProcessor::SubmitPendingSnap( int visIndex, uint8 * objMemory, in
 	submitInfo.baseSequence		= baseSequence;
 		
 	submitInfo.lzwInOutData		= &jobMemory->lzwInOutData;
+	submitInfo.share			= share;
+
+	// The copies above have to be made here, the buffer reference counts aren't thread safe
+	if ( jobList != NULL ) {
+		jobMemory->writeDeltaParms.snap = &pendingSnap;
+		jobList->AddJob( (jobRun_t)SnapshotWriteDeltaJob, &jobMemory->writeDeltaParms );
+		return;
+	}
 
 	pendingSnap.SubmitWriteDeltaToJobs( submitInfo );
 }
@@ -249,7 +261,9 @@ int idSnapshotProcessor::GetPendingSnapDelta( byte * outBuffer, int maxLength )
 	// store the delta, since it will just take up space, and just get removed anyways during ApplySnapshotDelta.
 	//	 (and cause lots of spam when it sees the delta's basestate doesn't match the current ack'd one)
 	if ( deltaBaseSequence >= baseSequence ) {	
-		if ( !deltas.Append( snapSequence, deltaData, size ) ) {
+		if ( deltas.Append( snapSequence, deltaData, size ) ) {
+			AppendDeltaGenerations( snapSequence );
+		} else {
 			int resendLength = deltas.ItemLength( deltas.Num() - 1 );
 
 			if ( !verify( resendLength <= maxLength ) ) {
@@ -275,6 +289,27 @@ int idSnapshotProcessor::GetPendingSnapDelta( byte * outBuffer, int maxLength )
 	return size;
 }
 
+/*
+========================
+idSnapshotProcessor::AppendDeltaGenerations
+Saves the generations of the objects the pending snap wrote, so when the delta is ack'd the base
+state objects it rebuilds keep them, and the next snap can skip those objects without comparing
+their bytes. If they don't fit, the objects just get new generations.
+========================
+*/
+void idSnapshotProcessor::AppendDeltaGenerations( int sequence ) {
+	int numGenerations = 0;
+	for ( int i = 0; i < jobMemory->lzwInOutData.numObjParms; i++ ) {
+		const objJobState_t & newState = jobMemory->objParms[i].newState;
+		if ( newState.valid && newState.generation != 0 ) {
+			jobMemory->generations[numGenerations].objectNum = newState.objectNum;
+			jobMemory->generations[numGenerations].generation = newState.generation;
+			numGenerations++;
+		}
+	}
+	deltaGenerations.Append( sequence, (const byte *)jobMemory->generations.Ptr(), numGenerations * sizeof( idSnapShot::objectGeneration_t ) );
+}
+
 /*
 ========================
 idSnapshotProcessor::IsBusyConfirmingPartialSnap
@@ -383,6 +418,7 @@ bool idSnapshotProcessor::ApplySnapshotDelta( int visIndex, int snapshotNumber )
 
 	// dump any deltas older than the acknoweledged snapshot, which should only happen if there is packet loss
 	deltas.RemoveOlderThan( snapshotNumber );
+	deltaGenerations.RemoveOlderThan( snapshotNumber );
 
 	if ( deltas.Num() == 0 || deltas.ItemSequence( 0 ) != snapshotNumber ) {
 		// this means the snapshot was either already acknowledged or came out of order
@@ -424,8 +460,16 @@ bool idSnapshotProcessor::ApplySnapshotDelta( int visIndex, int snapshotNumber )
 		return false;
 	}
 
+	// On the host, the objects this delta rebuilds keep the generations they had in the snap it was written from
+	const idSnapShot::objectGeneration_t * generations = NULL;
+	int numGenerations = 0;
+	if ( deltaGenerations.Num() > 0 && deltaGenerations.ItemSequence( 0 ) == snapshotNumber ) {
+		generations = (const idSnapShot::objectGeneration_t *)deltaGenerations.ItemData( 0 );
+		numGenerations = deltaGenerations.ItemLength( 0 ) / sizeof( idSnapShot::objectGeneration_t );
+	}
+
 	// Apply this delta to our base state
-	if ( ApplyDeltaToSnapshot( baseState, (const char *)deltas.ItemData( 0 ), deltas.ItemLength( 0 ), visIndex ) ) {
+	if ( ApplyDeltaToSnapshot( baseState, (const char *)deltas.ItemData( 0 ), deltas.ItemLength( 0 ), visIndex, generations, numGenerations ) ) {
 		lastFullSnapBaseSequence = deltaSequence;
 	}
 	
@@ -476,7 +520,9 @@ void idSnapshotProcessor::RemoveDeltasForOldBaseSequence() {
 		baseState.PeekDeltaSequence( (const char *)deltas.ItemData( i ), deltas.ItemLength( i ), deltaSequence, deltaBaseSequence );
 		if ( deltaBaseSequence < baseSequence ) {
 			// Remove this delta, and all deltas before this one 
-			deltas.RemoveOlderThan( deltas.ItemSequence( i ) + 1 );
+			const int removeSequence = deltas.ItemSequence( i ) + 1;
+			deltas.RemoveOlderThan( removeSequence );
+			deltaGenerations.RemoveOlderThan( removeSequence );
 			break;
 		}
 	}
@@ -522,3 +568,657 @@ void idSnapshotProcessor::AddSnapObjTemplate( int objID, idBitMsg & msg ) {
 		state->expectedSequence = snapSequence;
 	}
 }
+
+static const int SNAP_RECORD_ID			= ( 'S' << 24 ) | ( 'N' << 16 ) | ( 'P' << 8 ) | 'R';
+static const int SNAP_RECORD_VERSION	= 1;
+
+/*
+========================
+idSnapshotRecorder::Start
+========================
+*/
+bool idSnapshotRecorder::Start( const char * fileName_ ) {
+	Stop();
+
+	file = fileSystem->OpenFileWrite( fileName_ );
+	if ( file == NULL ) {
+		idLib::Warning( "Couldn't open %s to record snapshots", fileName_ );
+		return false;
+	}
+	file->WriteBig( SNAP_RECORD_ID );
+	file->WriteBig( SNAP_RECORD_VERSION );
+
+	fileName = fileName_;
+	numFrames = 0;
+	idLib::Printf( "Recording snapshots to %s\n", fileName.c_str() );
+	return true;
+}
+
+/*
+========================
+idSnapshotRecorder::Stop
+========================
+*/
+void idSnapshotRecorder::Stop() {
+	if ( file == NULL ) {
+		return;
+	}
+	fileSystem->CloseFile( file );
+	file = NULL;
+	frameFile.Clear();
+	idLib::Printf( "Recorded %d snapshots to %s\n", numFrames, fileName.c_str() );
+}
+
+/*
+========================
+idSnapshotRecorder::WriteFrame
+========================
+*/
+void idSnapshotRecorder::WriteFrame( const idSnapShot & ss, const int * visIndexes, int numVisIndexes ) {
+	if ( file == NULL ) {
+		return;
+	}
+	frameFile.Clear( false );
+	frameFile.WriteBig( numVisIndexes );
+	for ( int i = 0; i < numVisIndexes; i++ ) {
+		frameFile.WriteBig( visIndexes[i] );
+	}
+	ss.WriteToFile( &frameFile );
+	file->Write( frameFile.GetDataPtr(), frameFile.Length() );
+	numFrames++;
+}
+
+/*
+========================
+idSnapshotRecorder::ReadHeader
+========================
+*/
+bool idSnapshotRecorder::ReadHeader( idFile * file ) {
+	int id = 0;
+	int version = 0;
+	file->ReadBig( id );
+	file->ReadBig( version );
+	return ( id == SNAP_RECORD_ID && version == SNAP_RECORD_VERSION );
+}
+
+/*
+========================
+idSnapshotRecorder::ReadFrame
+Returns false at the end of the recording, a frame cut short by a crash is dropped
+========================
+*/
+bool idSnapshotRecorder::ReadFrame( idFile * file, idSnapShot & ss, idList< int > & visIndexes ) {
+	int numVisIndexes = 0;
+	if ( file->ReadBig( numVisIndexes ) != sizeof( numVisIndexes ) || numVisIndexes < 0 || numVisIndexes > 32 ) {
+		return false;
+	}
+	visIndexes.SetNum( numVisIndexes );
+	for ( int i = 0; i < numVisIndexes; i++ ) {
+		file->ReadBig( visIndexes[i] );
+		if ( visIndexes[i] < 0 || visIndexes[i] >= 32 ) {
+			return false;
+		}
+	}
+	return ss.ReadFromFile( file );
+}
+
+/*
+================================================
+Snapshot codec benchmark
+================================================
+*/
+
+/*
+========================
+BuildTestSnapshots
+Entity like objects: a few that move every frame, a few that spawn and die, and the rest idle
+========================
+*/
+static void BuildTestSnapshots( idList< idSnapShot > & frames, int numFrames, int numObjects ) {
+	struct testObject_t {
+		float	origin[3];
+		float	velocity[3];
+		uint16	angles[3];
+		uint16	model;
+		int		health;
+		int		flags;
+		byte	pad[16];
+	};
+
+	idRandom random( 0x5ca1ab1e );
+
+	idList< testObject_t > objects;
+	idList< bool > alive;
+	objects.SetNum( numObjects );
+	alive.SetNum( numObjects );
+	memset( objects.Ptr(), 0, objects.Num() * sizeof( testObject_t ) );
+	for ( int i = 0; i < numObjects; i++ ) {
+		testObject_t & obj = objects[i];
+		for ( int j = 0; j < 3; j++ ) {
+			obj.origin[j] = random.CRandomFloat() * 4096.0f;
+			obj.velocity[j] = ( random.RandomInt( 4 ) == 0 ) ? random.CRandomFloat() * 8.0f : 0.0f;
+		}
+		obj.model = (uint16)random.RandomInt( 300 );
+		obj.health = 100;
+		alive[i] = random.RandomInt( 8 ) != 0;
+	}
+
+	frames.SetNum( numFrames );
+	for ( int f = 0; f < numFrames; f++ ) {
+		idSnapShot & frame = frames[f];
+		frame.SetTime( f * 16 );
+		for ( int i = 0; i < numObjects; i++ ) {
+			testObject_t & obj = objects[i];
+			if ( random.RandomInt( 200 ) == 0 ) {
+				alive[i] = !alive[i];
+			}
+			if ( !alive[i] ) {
+				continue;
+			}
+			for ( int j = 0; j < 3; j++ ) {
+				obj.origin[j] += obj.velocity[j];
+			}
+			if ( obj.velocity[0] != 0.0f ) {
+				obj.angles[1] += 91;
+			}
+			if ( random.RandomInt( 50 ) == 0 ) {
+				obj.health -= random.RandomInt( 20 );
+				obj.flags ^= 1 << random.RandomInt( 8 );
+			}
+			frame.S_AddObject( i, ~0U, (const byte *)&obj, sizeof( obj ) );
+		}
+	}
+}
+
+/*
+========================
+CountSnapshotMismatches
+Only the objects the host snap has visible to visIndex have to be on the client
+========================
+*/
+static int CountSnapshotMismatches( const idSnapShot & expected, const idSnapShot & actual, int visIndex ) {
+	int numMismatches = 0;
+	for ( int i = 0; i < expected.NumObjects(); i++ ) {
+		idBitMsg msg;
+		int objectNum = expected.GetObjectMsgByIndex( i, msg );
+		if ( ( expected.FindObjectByID( objectNum )->visMask & ( 1 << visIndex ) ) == 0 ) {
+			continue;
+		}
+		idSnapShot::objectState_t * state = actual.FindObjectByID( objectNum );
+		if ( state == NULL || state->buffer.Size() != msg.GetSize() || memcmp( state->buffer.Ptr(), msg.GetReadData(), msg.GetSize() ) != 0 ) {
+			numMismatches++;
+		}
+	}
+	for ( int i = 0; i < actual.NumObjects(); i++ ) {
+		idBitMsg msg;
+		int objectNum = actual.GetObjectMsgByIndex( i, msg, true );
+		if ( msg.GetSize() > 0 && expected.FindObjectByID( objectNum ) == NULL ) {
+			numMismatches++;
+		}
+	}
+	return numMismatches;
+}
+
+/*
+========================
+testSnapshotCodec
+
+Sends the same snapshots from a host snapshot processor to a client one with each codec, acking
+ackDelay frames late, and then times each codec on its own over the raw bytes of the lzw deltas.
+bytes/snap is capped by net_optimalSnapDeltaSize, packed bytes/snap isn't. ns per byte is per
+uncompressed byte. No network involved.
+========================
+*/
+CONSOLE_COMMAND( testSnapshotCodec, "measures snapshot delta size and codec speed, usage: testSnapshotCodec [numFrames] [numObjects] [ackDelay]", 0 ) {
+	const int numFrames = ( args.Argc() > 1 ) ? idMath::ClampInt( 1, 10000, atoi( args.Argv( 1 ) ) ) : 300;
+	const int numObjects = ( args.Argc() > 2 ) ? idMath::ClampInt( 1, 4096, atoi( args.Argv( 2 ) ) ) : 512;
+	const int ackDelay = ( args.Argc() > 3 ) ? idMath::ClampInt( 0, 32, atoi( args.Argv( 3 ) ) ) : 3;
+	const int numRuns = 10;
+	const int maxDelta = idPacketProcessor::MAX_MSG_SIZE;
+	const int maxStream = 64 * 1024;
+	const char * codecNames[LZW_CODEC_MAX] = { "lzw", "range" };
+
+	idList< idSnapShot > frames;
+	BuildTestSnapshots( frames, numFrames, numObjects );
+
+	uint8 * objMemory = (uint8 *)Mem_Alloc( 128 * 1024, TAG_NETWORKING );
+	lzwCompressionData_t * lzwData = (lzwCompressionData_t *)Mem_Alloc( sizeof( lzwCompressionData_t ), TAG_NETWORKING );
+
+	idList< byte > delta;
+	idList< byte > stream;
+	idList< byte > raw;
+	delta.SetNum( maxDelta );
+	stream.SetNum( maxStream );
+	raw.SetNum( maxStream );
+
+	// Raw bytes of each delta, what the codecs are timed on
+	idList< idList< byte > > rawDeltas;
+
+	int numDeltas[LZW_CODEC_MAX] = { 0 };
+	int deltaBytes[LZW_CODEC_MAX] = { 0 };
+	int numMismatches[LZW_CODEC_MAX] = { 0 };
+
+	for ( int codec = 0; codec < LZW_CODEC_MAX; codec++ ) {
+		idSnapshotProcessor * host = new ( TAG_NETWORKING ) idSnapshotProcessor();
+		idSnapshotProcessor * client = new ( TAG_NETWORKING ) idSnapshotProcessor();
+		host->SetSnapCodec( codec );
+
+		idList< int > acks;
+		acks.SetNum( numFrames );
+		int pendingFrame = 0;
+
+		for ( int f = 0; f < numFrames; f++ ) {
+			acks[f] = -1;
+
+			if ( f >= ackDelay && acks[f - ackDelay] != -1 ) {
+				host->ApplySnapshotDelta( 1, acks[f - ackDelay] );
+			}
+
+			// A partially sent snap is still pending, keep sending that one like idLobby does
+			if ( host->TrySetPendingSnapshot( frames[f] ) ) {
+				pendingFrame = f;
+			}
+			host->SubmitPendingSnap( 1, objMemory, 128 * 1024, lzwData );
+			if ( !host->PendingSnapReadyToSend() ) {
+				continue;
+			}
+			int size = abs( host->GetPendingSnapDelta( delta.Ptr(), maxDelta ) );
+			if ( size == 0 ) {
+				continue;
+			}
+
+			numDeltas[codec]++;
+			deltaBytes[codec] += size;
+
+			if ( codec == LZW_CODEC_LZW ) {
+				idLZWCompressor compressor( lzwData, delta[0] );
+				compressor.Start( delta.Ptr() + SNAP_DELTA_CODEC_SIZE, size - SNAP_DELTA_CODEC_SIZE );
+				idList< byte > & rawDelta = rawDeltas.Alloc();
+				rawDelta.SetNum( compressor.Read( raw.Ptr(), maxStream, true ) );
+				memcpy( rawDelta.Ptr(), raw.Ptr(), rawDelta.Num() );
+			}
+
+			idSnapShot received;
+			int sequence = -1;
+			int baseSequence = -1;
+			bool fullSnap = false;
+			if ( client->ReceiveSnapshotDelta( delta.Ptr(), size, 0, sequence, baseSequence, received, fullSnap ) ) {
+				acks[f] = client->GetLastAppendedSequence();
+				if ( fullSnap ) {
+					numMismatches[codec] += CountSnapshotMismatches( frames[pendingFrame], received, 1 );
+				}
+			}
+		}
+
+		delete host;
+		delete client;
+	}
+
+	idLib::Printf( "%d frames, %d objects, acks %d frames late, %d raw deltas\n", numFrames, numObjects, ackDelay, rawDeltas.Num() );
+	idLib::Printf( "codec   deltas  bytes/snap  raw bytes/snap  packed bytes/snap  encode ns/byte  decode ns/byte\n" );
+
+	for ( int codec = 0; codec < LZW_CODEC_MAX; codec++ ) {
+		idLZWCompressor compressor( lzwData, codec );
+
+		uint64 encodeTime = 0;
+		uint64 decodeTime = 0;
+		int64 rawBytes = 0;
+		int64 packedBytes = 0;
+		int numBad = 0;
+
+		for ( int run = 0; run < numRuns; run++ ) {
+			for ( int i = 0; i < rawDeltas.Num(); i++ ) {
+				const idList< byte > & rawDelta = rawDeltas[i];
+
+				uint64 start = Sys_Microseconds();
+				compressor.Start( stream.Ptr(), maxStream );
+				compressor.Write( rawDelta.Ptr(), rawDelta.Num() );
+				int length = compressor.End();
+				encodeTime += Sys_Microseconds() - start;
+
+				start = Sys_Microseconds();
+				compressor.Start( stream.Ptr(), length );
+				int rawLength = compressor.Read( raw.Ptr(), maxStream, true );
+				decodeTime += Sys_Microseconds() - start;
+
+				rawBytes += rawDelta.Num();
+				packedBytes += length;
+				if ( rawLength != rawDelta.Num() || memcmp( raw.Ptr(), rawDelta.Ptr(), rawLength ) != 0 ) {
+					numBad++;
+				}
+			}
+		}
+
+		const float numPacked = (float)Max( rawDeltas.Num() * numRuns, 1 );
+		idLib::Printf( "%-6s %7d  %10.1f  %14.1f  %17.1f  %14.2f  %14.2f\n", codecNames[codec], numDeltas[codec],
+			deltaBytes[codec] / (float)Max( numDeltas[codec], 1 ), rawBytes / numPacked, packedBytes / numPacked,
+			encodeTime * 1000.0 / Max( rawBytes, (int64)1 ), decodeTime * 1000.0 / Max( rawBytes, (int64)1 ) );
+
+		if ( numBad > 0 ) {
+			idLib::Warning( "testSnapshotCodec: %s failed to round trip %d deltas", codecNames[codec], numBad / numRuns );
+		}
+		if ( numMismatches[codec] > 0 ) {
+			idLib::Warning( "testSnapshotCodec: %d objects differ on the client with %s", numMismatches[codec], codecNames[codec] );
+		}
+	}
+
+	Mem_Free( lzwData );
+	Mem_Free( objMemory );
+}
+
+/*
+========================
+testSnapshotReplay
+
+Replays a net_snapRecord recording: every peer in it gets a host snap processor sending to a client
+one the way idLobby does, acking ackDelay snaps late. Only the snap processors are timed, not
+reading the file. Bandwidth is per peer over the time the recorded snapshots span, peak memory
+is the object states of all snapshots plus what the snap processors always hold.
+========================
+*/
+CONSOLE_COMMAND( testSnapshotReplay, "replays a snapshot recording as fast as possible and measures throughput, bandwidth and peak memory, usage: testSnapshotReplay <file> [codec] [ackDelay]", 0 ) {
+	if ( args.Argc() < 2 ) {
+		idLib::Printf( "usage: testSnapshotReplay <file> [codec] [ackDelay]\n" );
+		return;
+	}
+	const int codec = ( args.Argc() > 2 ) ? idMath::ClampInt( 0, LZW_CODEC_MAX - 1, atoi( args.Argv( 2 ) ) ) : LZW_CODEC_LZW;
+	const int ackDelay = ( args.Argc() > 3 ) ? idMath::ClampInt( 0, 32, atoi( args.Argv( 3 ) ) ) : 3;
+	const int maxDelta = idPacketProcessor::MAX_MSG_SIZE;
+	const int objMemorySize = 128 * 1024;
+	const char * codecNames[LZW_CODEC_MAX] = { "lzw", "range" };
+
+	idFile * file = fileSystem->OpenFileRead( args.Argv( 1 ) );
+	if ( file == NULL ) {
+		idLib::Warning( "testSnapshotReplay: couldn't open %s", args.Argv( 1 ) );
+		return;
+	}
+	if ( !idSnapshotRecorder::ReadHeader( file ) ) {
+		idLib::Warning( "testSnapshotReplay: %s isn't a snapshot recording", args.Argv( 1 ) );
+		fileSystem->CloseFile( file );
+		return;
+	}
+
+	struct replayPeer_t {
+		idSnapshotProcessor *	host;
+		idSnapshotProcessor *	client;
+		idList< int >			acks;		// Sequence the client acked for each delta, -1 if none, oldest first
+	};
+	idArray< replayPeer_t, 32 > peers;
+	for ( int i = 0; i < peers.Num(); i++ ) {
+		peers[i].host = NULL;
+		peers[i].client = NULL;
+	}
+
+	uint8 * objMemory = (uint8 *)Mem_Alloc( objMemorySize, TAG_NETWORKING );
+	lzwCompressionData_t * lzwData = (lzwCompressionData_t *)Mem_Alloc( sizeof( lzwCompressionData_t ), TAG_NETWORKING );
+	idList< byte > delta;
+	delta.SetNum( maxDelta );
+
+	const int startBufferMemory = idSnapShot::GetBufferMemory();
+	idSnapShot::ResetPeakBufferMemory();
+
+	idSnapShot frame;
+	idSnapShot lastFrame;
+	idSnapShot received;
+	idList< int > visIndexes;
+
+	int numFrames = 0;
+	int numPeers = 0;
+	int firstTime = 0;
+	int lastTime = 0;
+	int numDeltas = 0;
+	int numFullSnaps = 0;
+	int numMismatches = 0;
+	int64 deltaBytes = 0;
+	uint64 hostTime = 0;
+	uint64 clientTime = 0;
+
+	while ( idSnapshotRecorder::ReadFrame( file, frame, visIndexes ) ) {
+		if ( numFrames == 0 ) {
+			firstTime = frame.GetTime();
+		}
+		lastTime = frame.GetTime();
+		numFrames++;
+
+		// Like idCommonLocal::SendSnapshots
+		frame.InheritGenerations( lastFrame );
+		lastFrame = frame;
+
+		for ( int i = 0; i < visIndexes.Num(); i++ ) {
+			const int visIndex = visIndexes[i];
+			replayPeer_t & peer = peers[visIndex];
+			if ( peer.host == NULL ) {
+				peer.host = new ( TAG_NETWORKING ) idSnapshotProcessor();
+				peer.client = new ( TAG_NETWORKING ) idSnapshotProcessor();
+				peer.host->SetSnapCodec( codec );
+				numPeers++;
+			}
+
+			uint64 start = Sys_Microseconds();
+			if ( peer.acks.Num() > ackDelay ) {
+				if ( peer.acks[0] != -1 ) {
+					peer.host->ApplySnapshotDelta( visIndex, peer.acks[0] );
+				}
+				peer.acks.RemoveIndex( 0 );
+			}
+			peer.host->TrySetPendingSnapshot( frame );
+			peer.host->SubmitPendingSnap( visIndex, objMemory, objMemorySize, lzwData );
+			int size = 0;
+			if ( peer.host->PendingSnapReadyToSend() ) {
+				size = abs( peer.host->GetPendingSnapDelta( delta.Ptr(), maxDelta ) );
+			}
+			hostTime += Sys_Microseconds() - start;
+
+			if ( size == 0 ) {
+				peer.acks.Append( -1 );
+				continue;
+			}
+			numDeltas++;
+			deltaBytes += size;
+
+			int sequence = -1;
+			int baseSequence = -1;
+			bool fullSnap = false;
+			start = Sys_Microseconds();
+			bool applied = peer.client->ReceiveSnapshotDelta( delta.Ptr(), size, 0, sequence, baseSequence, received, fullSnap );
+			clientTime += Sys_Microseconds() - start;
+
+			peer.acks.Append( applied ? peer.client->GetLastAppendedSequence() : -1 );
+			if ( applied && fullSnap ) {
+				numFullSnaps++;
+				numMismatches += CountSnapshotMismatches( *peer.host->GetPendingSnap(), received, visIndex );
+			}
+		}
+	}
+	fileSystem->CloseFile( file );
+
+	const int peakObjectMemory = idSnapShot::GetPeakBufferMemory() - startBufferMemory;
+	const int processorMemory = numPeers * 2 * idSnapshotProcessor::GetFixedMemorySize();
+	const float seconds = ( lastTime - firstTime ) * 0.001f;
+
+	idLib::Printf( "%d frames to %d peers, %.1f seconds of play, %s, acks %d snaps late\n", numFrames, numPeers, seconds, codecNames[codec], ackDelay );
+	idLib::Printf( "%d deltas, %d full snaps, %.1f bytes/delta\n", numDeltas, numFullSnaps, deltaBytes / (float)Max( numDeltas, 1 ) );
+	idLib::Printf( "host:   %8.1f us/delta  %10.0f deltas/s\n", hostTime / (float)Max( numDeltas, 1 ), numDeltas * 1000000.0 / Max( hostTime, (uint64)1 ) );
+	idLib::Printf( "client: %8.1f us/delta  %10.0f deltas/s\n", clientTime / (float)Max( numDeltas, 1 ), numDeltas * 1000000.0 / Max( clientTime, (uint64)1 ) );
+	if ( seconds > 0.0f && numPeers > 0 ) {
+		idLib::Printf( "bandwidth: %.1f kbit/s per peer\n", deltaBytes * 8.0f / 1000.0f / seconds / numPeers );
+	}
+	idLib::Printf( "peak memory: %d KB, %d KB object states + %d KB in %d snap processors\n", ( peakObjectMemory + processorMemory ) / 1024, peakObjectMemory / 1024, processorMemory / 1024, numPeers * 2 );
+
+	if ( numMismatches > 0 ) {
+		idLib::Warning( "testSnapshotReplay: %d objects differ on the clients", numMismatches );
+	}
+
+	for ( int i = 0; i < peers.Num(); i++ ) {
+		delete peers[i].host;
+		delete peers[i].client;
+	}
+	Mem_Free( lzwData );
+	Mem_Free( objMemory );
+}
+
+/*
+========================
+testSnapshotGenerations
+
+Sends a net_snapRecord recording to every peer in it twice, once comparing the bytes of every
+object against the peer's base state and once skipping the objects that are on the base state's
+generation. The frames inherit generations from each other like idCommonLocal::SendSnapshots
+does, and a client snap processor acks ackDelay snaps late, so the base states are rebuilt by
+ApplySnapshotDelta like on a server. Only writing the deltas is timed.
+========================
+*/
+CONSOLE_COMMAND( testSnapshotGenerations, "measures skipping unchanged snapshot objects by generation on a snapshot recording, usage: testSnapshotGenerations <file> [ackDelay]", 0 ) {
+	extern idCVar net_ssDiffByGeneration;
+
+	if ( args.Argc() < 2 ) {
+		idLib::Printf( "usage: testSnapshotGenerations <file> [ackDelay]\n" );
+		return;
+	}
+	const int ackDelay = ( args.Argc() > 2 ) ? idMath::ClampInt( 0, 32, atoi( args.Argv( 2 ) ) ) : 3;
+	const int maxDelta = idPacketProcessor::MAX_MSG_SIZE;
+	const int objMemorySize = 128 * 1024;
+
+	idFile * file = fileSystem->OpenFileRead( args.Argv( 1 ) );
+	if ( file == NULL ) {
+		idLib::Warning( "testSnapshotGenerations: couldn't open %s", args.Argv( 1 ) );
+		return;
+	}
+	if ( !idSnapshotRecorder::ReadHeader( file ) ) {
+		idLib::Warning( "testSnapshotGenerations: %s isn't a snapshot recording", args.Argv( 1 ) );
+		fileSystem->CloseFile( file );
+		return;
+	}
+
+	// Both passes have to send the same frames
+	idList< idSnapShot > frames;
+	idList< idList< int > > frameVisIndexes;
+	idSnapShot frame;
+	idList< int > visIndexes;
+	while ( idSnapshotRecorder::ReadFrame( file, frame, visIndexes ) ) {
+		if ( frames.Num() > 0 ) {
+			frame.InheritGenerations( frames[frames.Num() - 1] );
+		}
+		frames.Append( frame );
+		frameVisIndexes.Append( visIndexes );
+	}
+	fileSystem->CloseFile( file );
+
+	uint8 * objMemory = (uint8 *)Mem_Alloc( objMemorySize, TAG_NETWORKING );
+	lzwCompressionData_t * lzwData = (lzwCompressionData_t *)Mem_Alloc( sizeof( lzwCompressionData_t ), TAG_NETWORKING );
+	idList< byte > delta;
+	delta.SetNum( maxDelta );
+
+	const bool diffByGeneration = net_ssDiffByGeneration.GetBool();
+
+	uint64 writeTime[2] = { 0, 0 };
+	int numDeltas[2] = { 0, 0 };
+	int64 deltaBytes[2] = { 0, 0 };
+	int64 numObjects = 0;
+	int64 numUnchanged = 0;
+	int64 numOnBaseGeneration = 0;
+	int numMismatches = 0;
+	int numPeers = 0;
+
+	for ( int pass = 0; pass < 2; pass++ ) {
+		net_ssDiffByGeneration.SetBool( pass == 1 );
+
+		struct generationPeer_t {
+			idSnapshotProcessor *	host;
+			idSnapshotProcessor *	client;
+			idList< int >			acks;		// Sequence the client acked for each delta, -1 if none, oldest first
+		};
+		idArray< generationPeer_t, 32 > peers;
+		for ( int i = 0; i < peers.Num(); i++ ) {
+			peers[i].host = NULL;
+			peers[i].client = NULL;
+		}
+		numPeers = 0;
+
+		idSnapShot received;
+
+		for ( int f = 0; f < frames.Num(); f++ ) {
+			for ( int i = 0; i < frameVisIndexes[f].Num(); i++ ) {
+				const int visIndex = frameVisIndexes[f][i];
+				generationPeer_t & peer = peers[visIndex];
+				if ( peer.host == NULL ) {
+					peer.host = new ( TAG_NETWORKING ) idSnapshotProcessor();
+					peer.client = new ( TAG_NETWORKING ) idSnapshotProcessor();
+					numPeers++;
+				}
+
+				if ( peer.acks.Num() > ackDelay ) {
+					if ( peer.acks[0] != -1 ) {
+						peer.host->ApplySnapshotDelta( visIndex, peer.acks[0] );
+					}
+					peer.acks.RemoveIndex( 0 );
+				}
+				peer.host->TrySetPendingSnapshot( frames[f] );
+
+				if ( pass == 1 ) {
+					// How many objects are the same as in the base state, and how many of those the write can skip without looking at their bytes
+					const idSnapShot & pending = *peer.host->GetPendingSnap();
+					const idSnapShot & base = *peer.host->GetBaseState();
+					for ( int j = 0; j < pending.NumObjects(); j++ ) {
+						idBitMsg msg;
+						const int objectNum = pending.GetObjectMsgByIndex( j, msg );
+						idSnapShot::objectState_t * oldState = base.FindObjectByID( objectNum );
+						if ( oldState == NULL || oldState->buffer.Size() != msg.GetSize() || memcmp( oldState->buffer.Ptr(), msg.GetReadData(), msg.GetSize() ) != 0 ) {
+							continue;
+						}
+						numUnchanged++;
+						const uint32 generation = pending.FindObjectByID( objectNum )->generation;
+						if ( generation != 0 && generation == oldState->generation ) {
+							numOnBaseGeneration++;
+						}
+					}
+					numObjects += pending.NumObjects();
+				}
+
+				uint64 start = Sys_Microseconds();
+				peer.host->SubmitPendingSnap( visIndex, objMemory, objMemorySize, lzwData );
+				writeTime[pass] += Sys_Microseconds() - start;
+
+				int size = 0;
+				if ( peer.host->PendingSnapReadyToSend() ) {
+					size = abs( peer.host->GetPendingSnapDelta( delta.Ptr(), maxDelta ) );
+				}
+				if ( size == 0 ) {
+					peer.acks.Append( -1 );
+					continue;
+				}
+				numDeltas[pass]++;
+				deltaBytes[pass] += size;
+
+				int sequence = -1;
+				int baseSequence = -1;
+				bool fullSnap = false;
+				bool applied = peer.client->ReceiveSnapshotDelta( delta.Ptr(), size, 0, sequence, baseSequence, received, fullSnap );
+				peer.acks.Append( applied ? peer.client->GetLastAppendedSequence() : -1 );
+				if ( applied && fullSnap ) {
+					numMismatches += CountSnapshotMismatches( *peer.host->GetPendingSnap(), received, visIndex );
+				}
+			}
+		}
+
+		for ( int i = 0; i < peers.Num(); i++ ) {
+			delete peers[i].host;
+			delete peers[i].client;
+		}
+	}
+
+	net_ssDiffByGeneration.SetBool( diffByGeneration );
+
+	idLib::Printf( "%d frames to %d peers, acks %d snaps late\n", frames.Num(), numPeers, ackDelay );
+	idLib::Printf( "%.1f%% of the objects sent are the same as in the base state, %.1f%% of those are on its generation\n",
+		numUnchanged * 100.0 / Max( numObjects, (int64)1 ), numOnBaseGeneration * 100.0 / Max( numUnchanged, (int64)1 ) );
+	idLib::Printf( "write, compare bytes: %8.1f us/delta  %d deltas  %.1f bytes/delta\n", writeTime[0] / (float)Max( numDeltas[0], 1 ), numDeltas[0], deltaBytes[0] / (float)Max( numDeltas[0], 1 ) );
+	idLib::Printf( "write, by generation: %8.1f us/delta  %d deltas  %.1f bytes/delta\n", writeTime[1] / (float)Max( numDeltas[1], 1 ), numDeltas[1], deltaBytes[1] / (float)Max( numDeltas[1], 1 ) );
+
+	if ( numMismatches > 0 ) {
+		idLib::Warning( "testSnapshotGenerations: %d objects differ on the clients", numMismatches );
+	}
+
+	Mem_Free( lzwData );
+	Mem_Free( objMemory );
+}
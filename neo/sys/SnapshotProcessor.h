@@ -49,10 +49,12 @@ public:
 	// Peek into delta to get deltaSequence, and deltaBaseSequence
 	void PeekDeltaSequence( const char * deltaMem, int deltaSize, int & deltaSequence, int & deltaBaseSequence );
 	// Apply a delta to the supplied snapshot
-	bool ApplyDeltaToSnapshot( idSnapShot & snap, const char * deltaMem, int deltaSize, int visIndex );
+	bool ApplyDeltaToSnapshot( idSnapShot & snap, const char * deltaMem, int deltaSize, int visIndex, const idSnapShot::objectGeneration_t * generations = NULL, int numGenerations = 0 );
 	// Attempts to write the currently pending snap to the supplied buffer, which can then be sent as an unreliable msg.
 	// SubmitPendingSnap will submit the pending snap to a job, so that it can be retrieved later for sending.
-	void SubmitPendingSnap( int visIndex, uint8 * objMemory, int objMemorySize, lzwCompressionData_t * lzwData );
+	// When jobList is NULL the snap is written right away, otherwise it is written once the jobList is waited on.
+	// objMemory and lzwData can't be shared with any other snap processor on the same jobList.
+	void SubmitPendingSnap( int visIndex, uint8 * objMemory, int objMemorySize, lzwCompressionData_t * lzwData, objShareTable_t * share = NULL, idParallelJobList * jobList = NULL );
 	// GetPendingSnapDelta
 	int GetPendingSnapDelta( byte * outBuffer, int maxLength );
 	// If PendingSnapReadyToSend is true, then GetPendingSnapDelta will return something to send
@@ -89,6 +91,13 @@ public:
 
 	void AddSnapObjTemplate( int objID, idBitMsg & msg );
 
+	// lzwCodec_t the deltas we write are compressed with, deltas we read carry their own
+	void SetSnapCodec( int codec ) { snapCodec = codec; }
+	int GetSnapCodec() const { return snapCodec; }
+
+	// Memory a snap processor always holds, not counting the object states of its snapshots
+	static int GetFixedMemorySize() { return sizeof( idSnapshotProcessor ) + sizeof( jobMemory_t ); }
+
 	static const int MAX_SNAPSHOT_QUEUE		= 64;
 
 private:
@@ -106,9 +115,11 @@ private:
 
 	idSnapShot		baseState;			// known snapshot base on the client
 	idDataQueue< MAX_SNAPSHOT_QUEUE, MAX_SNAPSHOT_QUEUE_MEM >	deltas;		// list of unacknowledged snapshot deltas
+	idDataQueue< MAX_SNAPSHOT_QUEUE, MAX_SNAPSHOT_QUEUE_MEM >	deltaGenerations;	// objectGeneration_t of the objects each delta in deltas was written from (host only)
 
 	idSnapShot		pendingSnap;		// Current snap waiting to be fully sent
 	bool			hasPendingSnap;		// true if pendingSnap is still waiting to be sent
+	int				snapCodec;
 		
 	struct jobMemory_t {
 		static const int MAX_LZW_DELTAS		= 1;			// FIXME: cleanup the old multiple delta support completely
@@ -133,8 +144,14 @@ private:
 		idArray<byte, MAX_LZW_MEM>		lzwMem;				// Memory for output from lzw jobs
 	
 		lzwInOutData_t	lzwInOutData;						// In/Out data used so lzw data can persist across lzw jobs
+
+		snapWriteDeltaParms_t	writeDeltaParms;			// Parms when the snap is written on a jobList
+
+		idArray<idSnapShot::objectGeneration_t, MAX_OBJ_PARMS>	generations;	// Put together here before going into deltaGenerations
 	};
 
+	void			AppendDeltaGenerations( int sequence );
+
 	jobMemory_t *	jobMemory;
 
 	idSnapShot		submittedState;
@@ -145,4 +162,33 @@ private:
 	int				partialBaseSequence;
 };
 
+/*
+================================================
+idSnapshotRecorder
+Writes every snapshot the host sends, and the visIndex of each peer it is sent to, to a file so
+the same traffic can be replayed without a session (testSnapshotReplay)
+================================================
+*/
+class idSnapshotRecorder {
+public:
+	idSnapshotRecorder() : file( NULL ), numFrames( 0 ), frameFile( "snapshotRecorderFrame" ) { }
+	~idSnapshotRecorder() { Stop(); }
+
+	bool	Start( const char * fileName );
+	void	Stop();
+	bool	IsRecording() const { return file != NULL; }
+
+	void	WriteFrame( const idSnapShot & ss, const int * visIndexes, int numVisIndexes );
+
+	// Reads the header of a recording, then ReadFrame reads one frame at a time until it returns false
+	static bool	ReadHeader( idFile * file );
+	static bool	ReadFrame( idFile * file, idSnapShot & ss, idList< int > & visIndexes );
+
+private:
+	idFile *		file;
+	idStr			fileName;
+	int				numFrames;
+	idFile_Memory	frameFile;		// Each frame is put together here and written with a single write
+};
+
 #endif /* !__SNAP_PROCESSOR_H__ */
@@ -62,6 +62,102 @@ ID_INLINE bool ObjectsSame( objJobState_t & newState, objJobState_t & oldState )
 	return false;			// Not the same
 }
 
+/*
+========================
+ResetObjShareTable
+========================
+*/
+void ResetObjShareTable( objShareTable_t & table ) {
+	assert( ( table.numEntries & ( table.numEntries - 1 ) ) == 0 );
+	for ( int i = 0; i < table.numEntries; i++ ) {
+		table.entries[i].state = OBJ_SHARE_EMPTY;
+	}
+	table.memUsed		= 0;
+	table.numShared		= 0;
+	table.numEncoded	= 0;
+}
+
+/*
+========================
+CopySharedObject
+Copies the output of an encode another peer did from the same new state and the same old bytes
+========================
+*/
+static bool CopySharedObject( objShareTable_t * share, const objJobState_t & newState, const objJobState_t & oldState, objHeader_t * header ) {
+	if ( share == NULL ) {
+		return false;
+	}
+
+	objShareEntry_t & entry = share->entries[ newState.objectNum & ( share->numEntries - 1 ) ];
+
+	if ( Sys_InterlockedCompareExchange( entry.state, OBJ_SHARE_READY, OBJ_SHARE_READY ) != OBJ_SHARE_READY ) {
+		return false;
+	}
+
+	if ( entry.objectNum != newState.objectNum || entry.newData != newState.data || entry.newSize != newState.size ) {
+		return false;
+	}
+
+	if ( !oldState.valid ) {
+		if ( entry.oldData != NULL ) {
+			return false;
+		}
+	} else {
+		if ( entry.oldData == NULL || entry.oldSize != oldState.size ) {
+			return false;
+		}
+		// Each peer has its own copy of its base state, so the bytes usually have to be compared
+		if ( entry.oldData != oldState.data && memcmp( entry.oldData, oldState.data, oldState.size ) != 0 ) {
+			return false;
+		}
+	}
+
+	header->csize = entry.csize;
+	memcpy( header->data, entry.data, ( entry.csize != -1 ) ? entry.csize : newState.size );
+
+	Sys_InterlockedIncrement( share->numShared );
+	return true;
+}
+
+/*
+========================
+ShareObject
+Publishes the output of an encode so other peers can copy it, the first peer to encode an object wins
+========================
+*/
+static void ShareObject( objShareTable_t * share, const objJobState_t & newState, const objJobState_t & oldState, const objHeader_t * header ) {
+	if ( share == NULL ) {
+		return;
+	}
+
+	Sys_InterlockedIncrement( share->numEncoded );
+
+	objShareEntry_t & entry = share->entries[ newState.objectNum & ( share->numEntries - 1 ) ];
+
+	if ( Sys_InterlockedCompareExchange( entry.state, OBJ_SHARE_EMPTY, OBJ_SHARE_BUSY ) != OBJ_SHARE_EMPTY ) {
+		return;
+	}
+
+	const int length = ( header->csize != -1 ) ? header->csize : newState.size;
+	const int end = Sys_InterlockedAdd( share->memUsed, OBJ_DEST_SIZE_ALIGN16( length ) );
+
+	if ( end > share->maxMem ) {
+		return;		// Out of memory for this frame, leave the entry busy so nobody else tries
+	}
+
+	entry.objectNum	= newState.objectNum;
+	entry.newData	= newState.data;
+	entry.newSize	= newState.size;
+	entry.oldData	= oldState.valid ? oldState.data : NULL;
+	entry.oldSize	= oldState.valid ? oldState.size : 0;
+	entry.csize		= header->csize;
+	entry.data		= share->mem + end - OBJ_DEST_SIZE_ALIGN16( length );
+
+	memcpy( entry.data, header->data, length );
+
+	Sys_InterlockedExchange( entry.state, OBJ_SHARE_READY );
+}
+
 /*
 ========================
 SnapshotObjectJob
@@ -148,14 +244,17 @@ void SnapshotObjectJob( objParms_t * parms ) {
 	} else if ( !oldState.valid ) {
 		// New object, write out full state
 		assert( newState.valid );
-		// delta against an empty snap
-		rleCompressor.Start( dataStart, NULL, OBJ_DEST_SIZE_ALIGN16( newState.size ) );
-		rleCompressor.WriteBytes( newState.data, newState.size );
-		header->csize = rleCompressor.End();
 		header->flags |= OBJ_NEW;
-		if ( header->csize == -1 ) {
-			// Not enough space, don't compress, have lzw job do zrle compression instead
-			memcpy( dataStart, newState.data, newState.size );
+		if ( !CopySharedObject( parms->share, newState, oldState, header ) ) {
+			// delta against an empty snap
+			rleCompressor.Start( dataStart, NULL, OBJ_DEST_SIZE_ALIGN16( newState.size ) );
+			rleCompressor.WriteBytes( newState.data, newState.size );
+			header->csize = rleCompressor.End();
+			if ( header->csize == -1 ) {
+				// Not enough space, don't compress, have lzw job do zrle compression instead
+				memcpy( dataStart, newState.data, newState.size );
+			}
+			ShareObject( parms->share, newState, oldState, header );
 		}
 	} else {
 		// Compare to same obj id in different snapshot
@@ -167,7 +266,7 @@ void SnapshotObjectJob( objParms_t * parms ) {
 			header->flags |= visSendState ? OBJ_VIS_NOT_STALE : OBJ_VIS_STALE;
 		}
 	
-		if ( !visChange || visSendState ) {			
+		if ( ( !visChange || visSendState ) && !CopySharedObject( parms->share, newState, oldState, header ) ) {
 			int compareSize = Min( newState.size, oldState.size );
 			rleCompressor.Start( dataStart, NULL, OBJ_DEST_SIZE_ALIGN16( newState.size ) );
 			for ( int b = 0; b < compareSize; b++ ) {
@@ -195,6 +294,8 @@ void SnapshotObjectJob( objParms_t * parms ) {
 					memcpy( dataStart, newState.data + compareSize, leftOver );
 				}
 			}
+
+			ShareObject( parms->share, newState, oldState, header );
 		}
 	}
 
@@ -230,7 +331,7 @@ static void FinishLZWStream( lzwParm_t * parm, idLZWCompressor * lzwCompressor )
 		return;
 	}
 
-	int size = lzwCompressor->Length();
+	int size = SNAP_DELTA_CODEC_SIZE + lzwCompressor->Length();
 	
 	pendingDelta.offset			= parm->ioData->lzwBytes;		// Remember offset into buffer
 	pendingDelta.size			= size;							// Remember size
@@ -247,9 +348,12 @@ NewLZWStream
 */
 static void NewLZWStream( lzwParm_t * parm, idLZWCompressor * lzwCompressor ) {
 	
+	// Tag the delta with the codec, so readers don't need to be told what the host picked
+	parm->ioData->lzwMem[parm->ioData->lzwBytes] = (uint8)lzwCompressor->GetCodec();
+
 	// Reset compressor
-	int maxSize = parm->ioData->maxlzwMem - parm->ioData->lzwBytes;
-	lzwCompressor->Start( &parm->ioData->lzwMem[parm->ioData->lzwBytes], maxSize );
+	int maxSize = parm->ioData->maxlzwMem - parm->ioData->lzwBytes - SNAP_DELTA_CODEC_SIZE;
+	lzwCompressor->Start( &parm->ioData->lzwMem[parm->ioData->lzwBytes + SNAP_DELTA_CODEC_SIZE], maxSize );
 	
 	parm->ioData->lastObjId = 0;
 
@@ -267,8 +371,8 @@ ContinueLZWStream
 */
 static void ContinueLZWStream( lzwParm_t * parm, idLZWCompressor * lzwCompressor ) {
 	// Continue compressor where we left off
-	int maxSize = parm->ioData->maxlzwMem - parm->ioData->lzwBytes;
-	lzwCompressor->Start( &parm->ioData->lzwMem[parm->ioData->lzwBytes], maxSize, true );
+	int maxSize = parm->ioData->maxlzwMem - parm->ioData->lzwBytes - SNAP_DELTA_CODEC_SIZE;
+	lzwCompressor->Start( &parm->ioData->lzwMem[parm->ioData->lzwBytes + SNAP_DELTA_CODEC_SIZE], maxSize, true );
 }
 
 /*
@@ -295,7 +399,7 @@ void LZWJobInternal( lzwParm_t * parm, unsigned int dmaTag ) {
 
 	dmaTag = dmaTag;
 
-	ALIGN16( idLZWCompressor lzwCompressor( parm->ioData->lzwData ) );
+	ALIGN16( idLZWCompressor lzwCompressor( parm->ioData->lzwData, parm->ioData->codec ) );
 
 	if ( parm->fragmented ) {
 		// This packet was partially written out, we need to continue writing, using previous lzw dictionary values
@@ -408,7 +512,7 @@ void LZWJobInternal( lzwParm_t * parm, unsigned int dmaTag ) {
 		// the compressor did some work, wrote data to lzwMem, but since we didn't call FinishLZWStream to end the compression,
 		// we need to figure how much needs to be DMA'ed back out
 		assert( parm->ioData->lzwBytes == 0 ); // I don't think we ever hit this with lzwBytes != 0, but adding it just in case
-		parm->ioData->lzwDmaOut = parm->ioData->lzwBytes + lzwCompressor.Length();
+		parm->ioData->lzwDmaOut = parm->ioData->lzwBytes + SNAP_DELTA_CODEC_SIZE + lzwCompressor.Length();
 	}
 
 	assert( parm->ioData->lzwBytes < parm->ioData->maxlzwMem );
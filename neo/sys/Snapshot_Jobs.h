@@ -61,12 +61,42 @@ struct ALIGNTYPE16 objHeader_t {
 #endif
 };
 
+// Entry in the table that lets the object jobs of different peers share delta + zrle output.
+// The output of an encode only depends on the new and old bytes, not on the peer's visibility,
+// so any peer whose old state holds the same bytes for the same new state can copy it.
+struct objShareEntry_t {
+	interlockedInt_t	state;					// OBJ_SHARE_EMPTY -> OBJ_SHARE_BUSY -> OBJ_SHARE_READY
+	int32				objectNum;
+	const uint8 *		newData;				// New state buffer (shared between the peers' pending snaps)
+	const uint8 *		oldData;				// Old state the output was encoded against (NULL for new objects)
+	uint16				newSize;
+	uint16				oldSize;
+	int32				csize;					// Same meaning as objHeader_t::csize
+	uint8 *				data;					// Copy of the encoded output in the table's memory
+};
+
+static const interlockedInt_t OBJ_SHARE_EMPTY	= 0;
+static const interlockedInt_t OBJ_SHARE_BUSY	= 1;
+static const interlockedInt_t OBJ_SHARE_READY	= 2;
+
+// Reset on the main thread before the object jobs of a server frame are submitted
+struct objShareTable_t {
+	objShareEntry_t *	entries;				// Indexed by objectNum & ( numEntries - 1 )
+	int					numEntries;				// Must be a power of two
+	uint8 *				mem;					// Memory for the shared output
+	int					maxMem;
+	interlockedInt_t	memUsed;
+	interlockedInt_t	numShared;				// Number of encodes copied from another peer
+	interlockedInt_t	numEncoded;				// Number of encodes done
+};
+
 struct objJobState_t {
 	uint8				valid;
 	uint8 *				data;
 	uint16				size;
 	uint16				objectNum;
 	uint32				visMask;
+	uint32				generation;
 };
 
 // Input to initial jobs that produce delta'd zrle compressed versions of all the snap obj's
@@ -80,8 +110,13 @@ struct ALIGNTYPE16 objParms_t {
 	// Output
 	objHeader_t	*		destHeader;
 	uint8 *				dest;
+
+	objShareTable_t *	share;					// Optional, lets peers share encodes
 };
 	
+// Every delta starts with a byte holding the lzwCodec_t that wrote the rest of it
+static const int SNAP_DELTA_CODEC_SIZE = 1;
+
 // Output from the job that takes the results of the delta'd zrle obj's.
 // This struct contains the start of where the final delta packet data is within lzwMem
 struct ALIGNTYPE16 lzwDelta_t { 
@@ -103,7 +138,9 @@ struct ALIGNTYPE16 lzwInOutData_t {
 	int						optimalLength;			// Optimal length of lzw streams
 	int						snapSequence;
 	uint16					lastObjId;				// Last obj id written out
+	int						codec;					// lzwCodec_t new deltas are written with
 	lzwCompressionData_t *	lzwData;
+	int						numObjParms;			// Object jobs SubmitWriteDeltaToJobs submitted for the snap
 };
 
 // Input to the job that takes the results of the delta'd zrle obj's, and turns them into lzw delta packets
@@ -122,6 +159,7 @@ struct ALIGNTYPE16 lzwParm_t {
 };
 
 extern void SnapshotObjectJob( objParms_t * parms );
+extern void ResetObjShareTable( objShareTable_t & table );
 extern void LZWJob( lzwParm_t * parm );
 
 #endif // __SNAPSHOT_JOBS_H__
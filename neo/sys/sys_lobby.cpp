@@ -31,6 +31,7 @@ If you have questions concerning this license or the applicable additional terms
 
 extern idCVar net_connectTimeoutInSeconds;
 extern idCVar net_headlessServer;
+extern idCVar net_snapCodec;
 
 idCVar net_checkVersion( "net_checkVersion", "0", CVAR_INTEGER, "Check for matching version when clients connect. 0: normal rules, 1: force check, otherwise no check (pass always)" );
 idCVar net_peerTimeoutInSeconds( "net_peerTimeoutInSeconds", "30", CVAR_INTEGER, "If the host hasn't received a response from a peer in this amount of time (in seconds), the peer will be disconnected." );
@@ -65,7 +66,9 @@ idLobby::idLobby() {
 	sessionCB				= NULL;
 
 	localReadSS				= NULL;
-	objMemory				= NULL;
+	snapJobList				= NULL;
+	memset( &snapShareTable, 0, sizeof( snapShareTable ) );
+	snapCodec				= LZW_CODEC_LZW;
 	haveSubmittedSnaps		= false;
 
 	state					= STATE_IDLE;	
@@ -126,8 +129,7 @@ void idLobby::Initialize( lobbyType_t sessionType_, idSessionCallbacks * callbac
 
 	if ( lobbyType == GetActingGameStateLobbyType() ) {
 		// only needed in multiplayer mode
-		objMemory		= (uint8*)Mem_Alloc( SNAP_OBJ_JOB_MEMORY, TAG_NETWORKING );
-		lzwData			= (lzwCompressionData_t*)Mem_Alloc( sizeof( lzwCompressionData_t ), TAG_NETWORKING );
+		AllocSnapJobMemory();
 	}
 }
 
@@ -1127,6 +1129,7 @@ void idLobby::SetPeerConnectionState( int p, connectionState_t newState, bool sk
 		if ( lobbyType == actingGameStateLobbyType ) {
 			assert( peer.snapProc == NULL );
 			peer.snapProc = new ( TAG_NETWORKING )idSnapshotProcessor();
+			peer.snapProc->SetSnapCodec( snapCodec );
 		}
 
 		//mem.PopHeap();
@@ -1826,6 +1829,10 @@ void idLobby::InitStateLobbyHost() {
 	// We will be the host
 	isHost = true;
 
+	// Peers read whichever codec each delta is tagged with, so the host picks it alone.
+	// Latch it so it can't change under peers that are already connected.
+	snapCodec = net_snapCodec.GetInteger();
+
 	if ( net_headlessServer.GetBool() ) {
 		return;		// Don't add any players to headless server
 	}
@@ -3695,25 +3702,18 @@ bool idLobby::SendAnotherFragment( int p ) {
 	
 	peer.lastFragmentSendTime = time;
 
-	bool sentFragment = false;
-	
-	while ( true ) {
-		idBitMsg msg;
-		// We use the final packet size here because it has been processed, and no more headers will be added
-		byte buffer[ idPacketProcessor::MAX_FINAL_PACKET_SIZE ];	
-		msg.InitWrite( buffer, sizeof( buffer ) );
-		
-		if ( !peers[p].packetProc->GetSendFragment( time, peers[p].sessionID, msg ) ) {
-			break;
-		}
-
-		const bool useDirectPort = ( lobbyType == TYPE_GAME_STATE );
+	if ( sendBatch.IsFull() ) {
+		FlushSendBatch();
+	}
 
-		msg.BeginReading();
-		sessionCB->SendRawPacket( peers[p].address, msg.GetReadData(), msg.GetSize(), useDirectPort ); 
-		sentFragment = true;
-		break;		// Comment this out to send all fragments in one burst
+	// The fragment goes out with the fragments of the other peers on the next FlushSendBatch
+	const int first = sendBatch.Num();
+	const int maxFragments = 1;		// Raise this to send all fragments in one burst
+	const int numFragments = peer.packetProc->GetSendFragments( time, peer.sessionID, sendBatch, p, maxFragments );
+	for ( int i = first; i < first + numFragments; i++ ) {
+		sendBatchAddresses[i] = peer.address;
 	}
+	const bool sentFragment = ( numFragments > 0 );
 
 	if ( peer.packetProc->HasMoreFragments() ) {
 		NET_VERBOSE_PRINT("More packets left after ::SendAnotherFragment\n");
@@ -3722,6 +3722,22 @@ bool idLobby::SendAnotherFragment( int p ) {
 	return sentFragment;
 }
 
+/*
+========================
+idLobby::FlushSendBatch
+========================
+*/
+void idLobby::FlushSendBatch() {
+	if ( sendBatch.Num() == 0 ) {
+		return;
+	}
+
+	const bool useDirectPort = ( lobbyType == TYPE_GAME_STATE );
+
+	sessionCB->SendRawPackets( sendBatch, sendBatchAddresses, useDirectPort );
+	sendBatch.Clear();
+}
+
 /*
 ========================
 idLobby::CanSendMoreData
@@ -3860,10 +3876,11 @@ void idLobby::PumpPackets() {
 		}
 	}
 
-	// Send any unsent fragments for each peer (do this last)
+	// Send any unsent fragments for each peer (do this last), all peers go out in one batch
 	for ( int p = 0; p < peers.Num(); p++ ) {
 		SendAnotherFragment( p );
 	}
+	FlushSendBatch();
 }
 
 /*
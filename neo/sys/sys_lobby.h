@@ -517,6 +517,7 @@ public:		// Turning this on for now, for the sake of getting this up and running
 	void								HandleHeadsetStateChange( int fromPeer, idBitMsg & msg );
 
 	bool								SendAnotherFragment( int p );
+	void								FlushSendBatch();
 	bool								CanSendMoreData( int p );
 	void								ProcessOutgoingMsg( int p, const void * data, int size, bool isOOB, int userData );
 	void								ResendReliables( int p );
@@ -659,14 +660,16 @@ public:		// Turning this on for now, for the sake of getting this up and running
 	// sys_session_instance_snapshot.cpp
 	//
 	void								UpdateSnaps();
+	bool								AllocSnapJobMemory();
+	objShareTable_t *					GetSnapShareTable();
 	bool								SendCompletedSnaps();
 	bool								SendResources( int p );
-	bool								SubmitPendingSnap( int p );
+	bool								SubmitPendingSnap( int p, int jobMemoryIndex, objShareTable_t * share, idParallelJobList * jobList );
 	void								SendCompletedPendingSnap( int p );
 	void								CheckPeerThrottle( int p );
 	void								ApplySnapshotDelta( int p, int snapshotNumber );
 	bool								ApplySnapshotDeltaInternal( int p, int snapshotNumber );
-	void								SendSnapshotToPeer( idSnapShot & ss, int p );
+	bool								SendSnapshotToPeer( idSnapShot & ss, int p );
 	bool								AllPeersHaveBaseState();
 	void								ThrottleSnapsForXSeconds( int p, int seconds, bool recoverPing );
 	bool								FirstSnapHasBeenSent( int p );
@@ -822,6 +825,9 @@ public:		// Turning this on for now, for the sake of getting this up and running
 
 	idStaticList< peer_t, MAX_PEERS >	peers;							// Unique machines connected to this lobby
 
+	idPacketBatch						sendBatch;						// Fragments of all peers, sent at once by FlushSendBatch
+	lobbyAddress_t						sendBatchAddresses[ idPacketBatch::MAX_PACKETS ];
+
 	uint32								partyToken;
 
 	idMatchParameters					parms;
@@ -836,9 +842,19 @@ public:		// Turning this on for now, for the sake of getting this up and running
 	// Snapshot jobs
 	//------------------------
 	static const int SNAP_OBJ_JOB_MEMORY = 1024 * 128;			// 128k of obj memory
+	static const int SNAP_SHARE_ENTRIES = 4096;					// Must be a power of two
+	static const int SNAP_SHARE_MEMORY = 1024 * 256;			// 256k of shared obj encodes per frame
+
+	struct snapJobMemory_t {
+		uint8 *					objMemory;
+		lzwCompressionData_t *	lzwData;
+	};
 
-	lzwCompressionData_t *				lzwData;				// Shared across all snapshot jobs
-	uint8 *								objMemory;				// Shared across all snapshot jobs
+	// Snaps written one at a time all use the first entry, snaps written at once on snapJobList need one each
+	idStaticList< snapJobMemory_t, MAX_PEERS >	snapJobMemory;
+	idParallelJobList *					snapJobList;
+	objShareTable_t						snapShareTable;			// Lets peers share object encodes within a frame
+	int									snapCodec;				// lzwCodec_t for snaps we host, latched when we become host
 	bool								haveSubmittedSnaps;		// True if we previously submitted snaps to jobs
 	idSnapShot *						localReadSS;
 
@@ -864,6 +880,7 @@ public:
 	virtual int						GetUniquePlayerId() const = 0;
 	virtual idSignInManagerBase	&	GetSignInManager() = 0;
 	virtual	void					SendRawPacket( const lobbyAddress_t & to, const void * data, int size, bool useDirectPort ) = 0;
+	virtual	void					SendRawPackets( const idPacketBatch & batch, const lobbyAddress_t * to, bool useDirectPort ) = 0;
 	
 	virtual bool					BecomingHost( idLobby & lobby ) = 0;			// Called when a lobby is about to become host
 	virtual void					BecameHost( idLobby & lobby ) = 0;				// Called when a lobby becomes a host
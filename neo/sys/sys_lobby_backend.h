@@ -74,6 +74,10 @@ public:
 	bool ReadRawPacket( lobbyAddress_t & from, void * data, int & size, int maxSize  );
 	void SendRawPacket( const lobbyAddress_t & to, const void * data, int size );
 
+	// Many packets at a time, from and to hold an address for each packet of the batch
+	int  ReadRawPackets( idPacketBatch & batch, lobbyAddress_t * from );
+	void SendRawPackets( const idPacketBatch & batch, const lobbyAddress_t * to );
+
 	bool IsOpen();
 	void Close();
 	
@@ -55,6 +55,10 @@ idCVar net_pingRecoveryThrottleTimeInSeconds( "net_pingRecoveryThrottleTimeInSec
 
 idCVar net_peer_timeout_loading( "net_peer_timeout_loading", "90000", CVAR_INTEGER, "time in MS to disconnect clients during loading - production only" );
 
+idCVar net_snapParallel( "net_snapParallel", "1", CVAR_BOOL, "Host writes the snapshots of all peers at once on the job threads" );
+idCVar net_snapShareEncodes( "net_snapShareEncodes", "1", CVAR_BOOL, "Host reuses an object delta encoded for one peer for the other peers with the same base state for that object" );
+idCVar net_snapCodec( "net_snapCodec", "0", CVAR_INTEGER, "Codec a host compresses snapshot deltas with for the rest of the session, 0 = lzw, 1 = range coder", 0, LZW_CODEC_MAX - 1 );
+
 
 /*
 ========================
@@ -79,6 +83,23 @@ void idLobby::UpdateSnaps() {
 		return;
 	}
 
+	// Only the host writes snaps for more than one peer
+	idParallelJobList * jobList = NULL;
+	if ( IsHost() && net_snapParallel.GetBool() ) {
+		if ( snapJobList == NULL ) {
+			snapJobList = parallelJobManager->AllocJobList( JOBLIST_UTILITY, JOBLIST_PRIORITY_MEDIUM, MAX_PEERS, 0, NULL );
+		}
+		jobList = snapJobList;
+	}
+
+	objShareTable_t * share = NULL;
+	if ( IsHost() && net_snapShareEncodes.GetBool() ) {
+		share = GetSnapShareTable();
+		ResetObjShareTable( *share );
+	}
+
+	int numSubmitted = 0;
+
 	for ( int p = 0; p < peers.Num(); p++ ) {
 		peer_t & peer = peers[p];
 	
@@ -87,14 +108,32 @@ void idLobby::UpdateSnaps() {
 		}
 
 		if ( peer.needToSubmitPendingSnap ) {
+			// Snaps on the jobList run at the same time, so each one needs its own memory
+			int jobMemoryIndex = ( jobList != NULL ) ? numSubmitted : 0;
+			if ( jobMemoryIndex >= snapJobMemory.Num() && !AllocSnapJobMemory() ) {
+				// Out of job memory, the rest of the snaps go out with the next update
+				break;
+			}
+
 			// Submit the snap
-			if ( SubmitPendingSnap( p ) ) {
+			if ( SubmitPendingSnap( p, jobMemoryIndex, share, jobList ) ) {
 				peer.needToSubmitPendingSnap = false;	// only clear this if we actually submitted the snap
+				numSubmitted++;
 			}
 			
 		}
 	}
 
+	if ( jobList != NULL && numSubmitted > 0 ) {
+		// Wait right away, like the snaps written one at a time, so nothing on the main thread has to change
+		jobList->Submit();
+		jobList->Wait();
+	}
+
+	if ( share != NULL && numSubmitted > 0 ) {
+		NET_VERBOSESNAPSHOT_PRINT_LEVEL( 3, va( "  UpdateSnaps: %d snaps, %d object encodes, %d shared\n", numSubmitted, share->numEncoded, share->numShared ) );
+	}
+
 #if 0
 	uint64 endTimeMicroSec = Sys_Microseconds();
 
@@ -104,6 +143,37 @@ void idLobby::UpdateSnaps() {
 #endif
 }
 
+/*
+========================
+idLobby::AllocSnapJobMemory
+Returns false if all MAX_PEERS job memory slots are taken
+========================
+*/
+bool idLobby::AllocSnapJobMemory() {
+	snapJobMemory_t * jobMemory = snapJobMemory.Alloc();
+	if ( jobMemory == NULL ) {
+		return false;
+	}
+	jobMemory->objMemory	= (uint8*)Mem_Alloc( SNAP_OBJ_JOB_MEMORY, TAG_NETWORKING );
+	jobMemory->lzwData		= (lzwCompressionData_t*)Mem_Alloc( sizeof( lzwCompressionData_t ), TAG_NETWORKING );
+	return true;
+}
+
+/*
+========================
+idLobby::GetSnapShareTable
+========================
+*/
+objShareTable_t * idLobby::GetSnapShareTable() {
+	if ( snapShareTable.entries == NULL ) {
+		snapShareTable.entries		= (objShareEntry_t*)Mem_Alloc( SNAP_SHARE_ENTRIES * sizeof( objShareEntry_t ), TAG_NETWORKING );
+		snapShareTable.numEntries	= SNAP_SHARE_ENTRIES;
+		snapShareTable.mem			= (uint8*)Mem_Alloc( SNAP_SHARE_MEMORY, TAG_NETWORKING );
+		snapShareTable.maxMem		= SNAP_SHARE_MEMORY;
+	}
+	return &snapShareTable;
+}
+
 /*
 ========================
 idLobby::SendCompletedSnaps
@@ -161,7 +231,7 @@ bool idLobby::SendResources( int p ) {
 idLobby::SubmitPendingSnap
 ========================
 */
-bool idLobby::SubmitPendingSnap( int p ) {
+bool idLobby::SubmitPendingSnap( int p, int jobMemoryIndex, objShareTable_t * share, idParallelJobList * jobList ) {
 	
 	assert( lobbyType == GetActingGameStateLobbyType() );
 
@@ -198,7 +268,8 @@ bool idLobby::SubmitPendingSnap( int p ) {
 	assert( !peer.snapProc->PendingSnapReadyToSend() );
 	
 	// Submit snapshot delta to jobs
-	peer.snapProc->SubmitPendingSnap( p + 1, objMemory, SNAP_OBJ_JOB_MEMORY, lzwData );
+	snapJobMemory_t & jobMemory = snapJobMemory[ jobMemoryIndex ];
+	peer.snapProc->SubmitPendingSnap( p + 1, jobMemory.objMemory, SNAP_OBJ_JOB_MEMORY, jobMemory.lzwData, share, jobList );
 
 	NET_VERBOSESNAPSHOT_PRINT_LEVEL( 2, va("  Submitted snapshot to jobList for peer %d. Since last jobsub: %d\n", p, timeFromLastSub ) );
 	
@@ -486,21 +557,22 @@ bool idLobby::ApplySnapshotDeltaInternal( int p, int snapshotNumber ) {
 /*
 ========================
 idLobby::SendSnapshotToPeer
+Returns true if ss was queued to be sent to the peer
 ========================
 */
 idCVar net_forceDropSnap( "net_forceDropSnap", "0", CVAR_BOOL, "wait on snaps" );
-void idLobby::SendSnapshotToPeer( idSnapShot & ss, int p ) {
+bool idLobby::SendSnapshotToPeer( idSnapShot & ss, int p ) {
 	assert( lobbyType == GetActingGameStateLobbyType() );
 
 	peer_t & peer = peers[p];
 
 	if ( net_forceDropSnap.GetBool() ) {
 		net_forceDropSnap.SetBool( false );
-		return;
+		return false;
 	}
 
 	if ( peer.pauseSnapshots ) {
-		return;
+		return false;
 	}
 
 	int time = Sys_Milliseconds();
@@ -514,7 +586,7 @@ void idLobby::SendSnapshotToPeer( idSnapShot & ss, int p ) {
 		if ( time - peer.lastSnapJobTime < peer.throttledSnapRate / 1000 ) { // fixme /1000
 			// This peer is throttled, skip his snap shot
 			NET_VERBOSESNAPSHOT_PRINT_LEVEL( 2, va( "NET: Throttling peer %d.Skipping snapshot. Time elapsed: %d peer snap rate: %d\n", p, ( time - peer.lastSnapJobTime ), peer.throttledSnapRate ) );
-			return;
+			return false;
 		}
 	}
 
@@ -524,14 +596,15 @@ void idLobby::SendSnapshotToPeer( idSnapShot & ss, int p ) {
 
 	if ( peer.maxSnapBps >= 0.0f && ( throttleMode == 2 || throttleMode == 3 ) ) {
 		if ( peer.packetProc->GetOutgoingRateBytes() > peer.maxSnapBps ) {
-			return;
+			return false;
 		}
 	}
 
 	// TrySetPendingSnapshot will try to set the new pending snap.
 	// TrySetPendingSnapshot won't do anything until the last snap set was fully sent out.
 
-	if ( peer.snapProc->TrySetPendingSnapshot( ss ) ) {
+	const bool queued = peer.snapProc->TrySetPendingSnapshot( ss );
+	if ( queued ) {
 		NET_VERBOSESNAPSHOT_PRINT_LEVEL( 2, va("  ^8Set next pending snapshot peer %d\n", 0 ) );
 
 		peer.numSnapsSent++;
@@ -548,6 +621,8 @@ void idLobby::SendSnapshotToPeer( idSnapShot & ss, int p ) {
 	// We send out the pending snap, which could be the most recent, or an old one that hasn't fully been sent
 	// We don't send immediately, since we have to coordinate sending snaps for all peers in same place considering jobs.
 	peer.needToSubmitPendingSnap = true;
+
+	return queued;
 }
 
 /*
@@ -56,7 +56,10 @@ enum cpuid_t {
 	CPUID_FTZ							= 0x04000,	// Flush-To-Zero mode (denormal results are flushed to zero)
 	CPUID_DAZ							= 0x08000,	// Denormals-Are-Zero mode (denormal source operands are set to zero)
 	CPUID_XENON							= 0x10000,	// Xbox 360
-	CPUID_CELL							= 0x20000	// PS3
+	CPUID_CELL							= 0x20000,	// PS3
+	CPUID_AVX							= 0x40000,	// Advanced Vector Extensions, including OS support for the ymm registers
+	CPUID_AVX2							= 0x80000,	// Advanced Vector Extensions 2
+	CPUID_FMA3							= 0x100000	// three operand Fused Multiply-Add
 };
 
 enum fpuExceptions_t {
@@ -535,6 +538,10 @@ typedef HANDLE idFileHandle;
 
 
 ID_TIME_T		Sys_FileTimeStamp( idFileHandle fp );
+
+// maps a whole file read only into the address space, returns NULL if the file can't be mapped
+const byte *	Sys_MapFileRead( const char * osPath, int64 & length );
+void			Sys_UnmapFile( const byte * data );
 // NOTE: do we need to guarantee the same output on all platforms?
 const char *	Sys_TimeStampToStr( ID_TIME_T timeStamp );
 const char *	Sys_SecToStr( int sec );
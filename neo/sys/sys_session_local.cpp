@@ -51,6 +51,7 @@ idCVar net_ignoreTitleStorage( "net_ignoreTitleStorage", "0", CVAR_BOOL, "Ignore
 
 idCVar net_maxLoadResourcesTimeInSeconds( "net_maxLoadResourcesTimeInSeconds", "0", CVAR_INTEGER, "How long, in seconds, clients have to load resources. Used for loose asset builds." );
 idCVar net_migrateHost( "net_migrateHost", "-1", CVAR_INTEGER, "Become host of session (0 = party, 1 = game) for testing purposes" );
+idCVar net_snapRecord( "net_snapRecord", "", 0, "Host records every snapshot it sends, and the peers it goes to, to this file for testSnapshotReplay. Empty to stop" );
 extern idCVar net_debugBaseStates;
 
 idCVar net_testPartyMemberConnectFail( "net_testPartyMemberConnectFail", "-1", CVAR_INTEGER, "Force this party member index to fail to connect to games." );
@@ -1426,6 +1427,7 @@ idSessionLocal::Shutdown
 ========================
 */
 void idSessionLocal::Shutdown() {
+	snapRecorder.Stop();
 }
 
 /*
@@ -2074,6 +2076,8 @@ idSessionLocal::SendSnapshot
 ========================
 */
 void idSessionLocal::SendSnapshot( idSnapShot & ss ) {
+	idStaticList< int, idLobby::MAX_PEERS > visIndexes;
+
 	for ( int p = 0; p < GetActingGameStateLobby().peers.Num(); p++ ) {
 		idLobby::peer_t & peer = GetActingGameStateLobby().peers[p];
 	
@@ -2089,8 +2093,19 @@ void idSessionLocal::SendSnapshot( idSnapShot & ss ) {
 			continue;
 		}
 		
-		GetActingGameStateLobby().SendSnapshotToPeer( ss, p );
+		if ( GetActingGameStateLobby().SendSnapshotToPeer( ss, p ) ) {
+			visIndexes.Append( p + 1 );
+		}
+	}
+
+	if ( net_snapRecord.IsModified() ) {
+		net_snapRecord.ClearModified();
+		snapRecorder.Stop();
+		if ( net_snapRecord.GetString()[0] != '\0' ) {
+			snapRecorder.Start( net_snapRecord.GetString() );
+		}
 	}
+	snapRecorder.WriteFrame( ss, visIndexes.Ptr(), visIndexes.Num() );
 }
 
 /*
@@ -2301,45 +2316,48 @@ idSessionLocal::HandlePackets
 bool idSessionLocal::HandlePackets() {
 	SCOPED_PROFILE_EVENT( "Session::HandlePackets" );
 
-	byte				packetBuffer[ idPacketProcessor::MAX_FINAL_PACKET_SIZE ];
-	lobbyAddress_t		remoteAddress;
-	int					recvSize = 0;
-	bool				fromDedicated = false;
+	int numPackets = 0;
+	while ( ( numPackets = ReadRawPackets( recvBatch, recvBatchAddresses ) ) > 0 ) {
+		for ( int i = 0; i < numPackets; i++ ) {
+			lobbyAddress_t & remoteAddress = recvBatchAddresses[i];
+			const int recvSize = recvBatch[i].size;
+			if ( recvSize <= 0 ) {
+				continue;
+			}
 
-	while ( ReadRawPacket( remoteAddress, packetBuffer, recvSize, fromDedicated, sizeof( packetBuffer ) ) && recvSize > 0 ) {
-		
-		// fragMsg will hold the raw packet
-		idBitMsg fragMsg;
-		fragMsg.InitRead( packetBuffer, recvSize );
+			// fragMsg will hold the raw packet
+			idBitMsg fragMsg;
+			fragMsg.InitRead( recvBatch[i].data, recvSize );
 
-		// Peek at the session ID
-		idPacketProcessor::sessionId_t sessionID = idPacketProcessor::GetSessionID( fragMsg );
+			// Peek at the session ID
+			idPacketProcessor::sessionId_t sessionID = idPacketProcessor::GetSessionID( fragMsg );
 
-		// idLib::Printf( "NET: HandlePackets - session %d, size %d \n", sessionID, recvSize );
+			// idLib::Printf( "NET: HandlePackets - session %d, size %d \n", sessionID, recvSize );
 
-		// Make sure it's valid
-		if ( sessionID == idPacketProcessor::SESSION_ID_INVALID ) {
-			idLib::Printf( "NET: Invalid sessionID %s.\n", remoteAddress.ToString() );
-			continue;
-		}
+			// Make sure it's valid
+			if ( sessionID == idPacketProcessor::SESSION_ID_INVALID ) {
+				idLib::Printf( "NET: Invalid sessionID %s.\n", remoteAddress.ToString() );
+				continue;
+			}
 
-		//
-		// Distribute the packet to the proper lobby
-		//
+			//
+			// Distribute the packet to the proper lobby
+			//
 
-		const int maskedType = sessionID & idPacketProcessor::LOBBY_TYPE_MASK;
+			const int maskedType = sessionID & idPacketProcessor::LOBBY_TYPE_MASK;
 
-		if ( !verify( maskedType > 0 ) ) {
-			continue;
-		}
+			if ( !verify( maskedType > 0 ) ) {
+				continue;
+			}
 
-		idLobby::lobbyType_t lobbyType = (idLobby::lobbyType_t)( maskedType - 1 );
+			idLobby::lobbyType_t lobbyType = (idLobby::lobbyType_t)( maskedType - 1 );
 
-		switch ( lobbyType ) {
-			case idLobby::TYPE_PARTY:		GetPartyLobby().HandlePacket( remoteAddress, fragMsg, sessionID );		break;
-			case idLobby::TYPE_GAME:		GetGameLobby().HandlePacket( remoteAddress, fragMsg, sessionID );		break;
-			case idLobby::TYPE_GAME_STATE:	GetGameStateLobby().HandlePacket( remoteAddress, fragMsg, sessionID );	break;
-			default:						assert( 0 );
+			switch ( lobbyType ) {
+				case idLobby::TYPE_PARTY:		GetPartyLobby().HandlePacket( remoteAddress, fragMsg, sessionID );		break;
+				case idLobby::TYPE_GAME:		GetGameLobby().HandlePacket( remoteAddress, fragMsg, sessionID );		break;
+				case idLobby::TYPE_GAME_STATE:	GetGameStateLobby().HandlePacket( remoteAddress, fragMsg, sessionID );	break;
+				default:						assert( 0 );
+			}
 		}
 	}
 
@@ -2675,6 +2693,52 @@ bool idSessionLocal::ReadRawPacket( lobbyAddress_t & from, void * data, int & si
 	return ReadRawPacketFromQueue( now, from, data, size, outDedicated, maxSize );
 }
 
+/*
+========================
+idSessionLocal::SendRawPackets
+========================
+*/
+void idSessionLocal::SendRawPackets( const idPacketBatch & batch, const lobbyAddress_t * to, bool dedicated ) {
+	if ( net_forceUpstream.GetFloat() == 0.0f && net_forceLatency.GetInteger() == 0 && sendQueue.IsEmpty() ) {
+		// short path, nothing simulated so the whole batch goes straight to the port
+		GetPort( dedicated ).SendRawPackets( batch, to );
+		return;
+	}
+
+	for ( int i = 0; i < batch.Num(); i++ ) {
+		SendRawPacket( to[i], batch[i].data, batch[i].size, dedicated );
+	}
+}
+
+/*
+========================
+idSessionLocal::ReadRawPackets
+
+Clears the batch and fills it with the packets that are ready, returns how many were read.
+========================
+*/
+int idSessionLocal::ReadRawPackets( idPacketBatch & batch, lobbyAddress_t * from ) {
+	SCOPED_PROFILE_EVENT( "Session::ReadRawPackets" );
+
+	batch.Clear();
+
+	if ( net_forceLatency.GetInteger() == 0 && sendQueue.IsEmpty() && recvQueue.IsEmpty() ) {
+		// short path, nothing simulated so the port can fill the whole batch
+		// BRIAN_FIXME: Dedicated servers fuck up running 2 instances on the same machine
+		return GetPort( false ).ReadRawPackets( batch, from );
+	}
+
+	bool dedicated = false;
+	while ( !batch.IsFull() ) {
+		idPacketBatch::packet_t & packet = batch.Alloc();
+		if ( !ReadRawPacket( from[ batch.Num() - 1 ], packet.data, packet.size, dedicated, sizeof( packet.data ) ) ) {
+			batch.RemoveLast();
+			break;
+		}
+	}
+	return batch.Num();
+}
+
 /*
 ========================
 idSessionLocal::ConnectAndMoveToLobby
@@ -3848,6 +3912,44 @@ void idNetSessionPort::SendRawPacket( const lobbyAddress_t & to, const void * da
 	UDP.SendPacket( to.netAddr, data, size );
 }
 
+/*
+========================
+idNetSessionPort::ReadRawPackets
+
+Winsock has no recvmmsg, so this loops recvfrom, but the batch lets the session hand all
+the waiting packets to the lobbies at once. Returns how many packets were added.
+========================
+*/
+int idNetSessionPort::ReadRawPackets( idPacketBatch & batch, lobbyAddress_t * from ) {
+	static idRandom2 random( Sys_Milliseconds() );
+
+	const int first = batch.Num();
+	while ( !batch.IsFull() ) {
+		idPacketBatch::packet_t & packet = batch.Alloc();
+		if ( !UDP.GetPacket( from[ batch.Num() - 1 ].netAddr, packet.data, packet.size, sizeof( packet.data ) ) ) {
+			batch.RemoveLast();
+			break;
+		}
+		if ( net_forceDrop.GetInteger() != 0 && net_forceDrop.GetInteger() >= random.RandomInt( 100 ) ) {
+			batch.RemoveLast();
+		}
+	}
+	return batch.Num() - first;
+}
+
+/*
+========================
+idNetSessionPort::SendRawPackets
+
+Winsock has no sendmmsg, so this loops sendto.
+========================
+*/
+void idNetSessionPort::SendRawPackets( const idPacketBatch & batch, const lobbyAddress_t * to ) {
+	for ( int i = 0; i < batch.Num(); i++ ) {
+		SendRawPacket( to[i], batch[i].data, batch[i].size );
+	}
+}
+
 /*
 ========================
 idNetSessionPort::IsOpen
@@ -541,6 +541,9 @@ protected:
 	idQueue< idQueuePacket,&idQueuePacket::queueNode >	sendQueue;
 	idQueue< idQueuePacket,&idQueuePacket::queueNode >	recvQueue;
 
+	idPacketBatch										recvBatch;				// HandlePackets reads the ports into this
+	lobbyAddress_t										recvBatchAddresses[ idPacketBatch::MAX_PACKETS ];
+
 	float												upstreamDropRate;		// instant rate in B/s at which we are dropping packets due to simulated upstream saturation
 	int													upstreamDropRateTime;
 
@@ -549,6 +552,8 @@ protected:
 
 	int													queuedBytes;
 
+	idSnapshotRecorder									snapRecorder;			// net_snapRecord
+
 	int													waitingOnGameStateMembersToLeaveTime;
 	int													waitingOnGameStateMembersToJoinTime;
 
@@ -560,6 +565,9 @@ protected:
 	void	SendRawPacket( const lobbyAddress_t & to, const void * data, int size, bool dedicated );
 	bool	ReadRawPacket( lobbyAddress_t & from, void * data, int & size, bool & outDedicated, int maxSize );
 
+	void	SendRawPackets( const idPacketBatch & batch, const lobbyAddress_t * to, bool dedicated );
+	int		ReadRawPackets( idPacketBatch & batch, lobbyAddress_t * from );
+
 	void	ConnectAndMoveToLobby( idLobby & lobby, const lobbyConnectInfo_t & connectInfo, bool fromInvite );
 	void	GoodbyeFromHost( idLobby & lobby, int peerNum, const lobbyAddress_t & remoteAddress, int msgType );
 
@@ -650,6 +658,7 @@ public:
 	virtual int						GetUniquePlayerId() const { return sessionLocal->currentID++; }
 	virtual idSignInManagerBase	&	GetSignInManager() { return *sessionLocal->signInManager; }
 	virtual	void					SendRawPacket( const lobbyAddress_t & to, const void * data, int size, bool useDirectPort ) { sessionLocal->SendRawPacket( to, data, size, useDirectPort ); }
+	virtual	void					SendRawPackets( const idPacketBatch & batch, const lobbyAddress_t * to, bool useDirectPort ) { sessionLocal->SendRawPackets( batch, to, useDirectPort ); }
 	
 	virtual bool					BecomingHost( idLobby & lobby );
 	virtual void					BecameHost( idLobby & lobby );
@@ -337,6 +337,74 @@ static bool HasSSE3() {
 	return false;
 }
 
+/*
+================
+HasAVX
+================
+*/
+static bool HasAVX() {
+	unsigned regs[4];
+
+	// get CPU feature bits
+	CPUID( 1, regs );
+
+	// bit 28 of ECX denotes AVX existence and bit 27 that the OS uses XSAVE
+	if ( ( regs[_REG_ECX] & ( 1 << 28 ) ) == 0 || ( regs[_REG_ECX] & ( 1 << 27 ) ) == 0 ) {
+		return false;
+	}
+
+	// the OS must save both the xmm and the ymm registers on context switches
+	return ( _xgetbv( 0 ) & 6 ) == 6;
+}
+
+/*
+================
+HasAVX2
+================
+*/
+static bool HasAVX2() {
+	int regs[4];
+
+	if ( !HasAVX() ) {
+		return false;
+	}
+
+	// the extended features need leaf 7
+	__cpuid( regs, 0 );
+	if ( regs[_REG_EAX] < 7 ) {
+		return false;
+	}
+
+	// bit 5 of EBX of leaf 7, sub-leaf 0 denotes AVX2 existence
+	__cpuidex( regs, 7, 0 );
+	if ( regs[_REG_EBX] & ( 1 << 5 ) ) {
+		return true;
+	}
+	return false;
+}
+
+/*
+================
+HasFMA3
+================
+*/
+static bool HasFMA3() {
+	unsigned regs[4];
+
+	if ( !HasAVX() ) {
+		return false;
+	}
+
+	// get CPU feature bits
+	CPUID( 1, regs );
+
+	// bit 12 of ECX denotes FMA3 existence
+	if ( regs[_REG_ECX] & ( 1 << 12 ) ) {
+		return true;
+	}
+	return false;
+}
+
 /*
 ================
 LogicalProcPerPhysicalProc
@@ -746,6 +814,21 @@ cpuid_t Sys_GetCPUId() {
 		flags |= CPUID_SSE3;
 	}
 
+	// check for Advanced Vector Extensions
+	if ( HasAVX() ) {
+		flags |= CPUID_AVX;
+	}
+
+	// check for Advanced Vector Extensions 2
+	if ( HasAVX2() ) {
+		flags |= CPUID_AVX2;
+	}
+
+	// check for Fused Multiply-Add
+	if ( HasFMA3() ) {
+		flags |= CPUID_FMA3;
+	}
+
 	// check for Hyper-Threading Technology
 	if ( HasHTT() ) {
 		flags |= CPUID_HTT;